@@ -0,0 +1,182 @@
+#ifndef COMPRESSED_NVS_DELEGATE_H
+#define COMPRESSED_NVS_DELEGATE_H
+
+#include <MultiPrinterLoggerInterface.hpp>
+#include <string.h>
+
+#include "NVSDelegateInterface.hpp"
+
+#define COMPRESSED_NVS_DELEGATE_MIN_LENGTH 64      /**< Values shorter than this are stored verbatim. */
+#define COMPRESSED_NVS_DELEGATE_FORMAT_LZ4 0x4C    /**< Header flag of a value compressed as an LZ4 block. */
+#define COMPRESSED_NVS_DELEGATE_HEADER_LENGTH 3    /**< Format flag, then the value length as 2 little-endian bytes. */
+
+/**
+ * @brief NVSDelegateInterface that compresses large string values.
+ *
+ * This delegate wraps another one. A string value of at least COMPRESSED_NVS_DELEGATE_MIN_LENGTH
+ * characters is compressed as an LZ4 block and stored as a blob behind a 3-byte header:
+ * the format flag and the length of the value. A value that does not shrink is stored as
+ * a plain string, so existing namespaces read as before and only string values are
+ * ever compressed. get_str decompresses straight into the caller's buffer; reading
+ * the length of a compressed value reads its blob.
+ */
+class CompressedNVSDelegate : public NVSDelegateInterface
+{
+public:
+    /**
+     * @brief Constructor for CompressedNVSDelegate.
+     *
+     * @param nvsDelegate Pointer to the delegate storing the values.
+     * @param logger Pointer to the logger interface.
+     */
+    CompressedNVSDelegate(NVSDelegateInterface *const nvsDelegate, MultiPrinterLoggerInterface *const logger = nullptr);
+
+    /**
+     * @brief Destructor for CompressedNVSDelegate.
+     */
+    ~CompressedNVSDelegate();
+
+    /**
+     * @brief Opens a namespace of the wrapped delegate.
+     */
+    NVSDelegateError_t open(
+        char const *const name, NVSDelegateOpenMode_t const open_mode,
+        NVSDelegateHandle_t *out_handle) const override;
+
+    /**
+     * @brief Closes a namespace of the wrapped delegate.
+     */
+    void close(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Sets a string value, compressed if it is long enough and shrinks.
+     *
+     * NVS keeps a key of each type apart, so a value changing between compressed and
+     * verbatim is written first, then the entries of the other type are erased through
+     * NVSDelegateUtils::eraseOtherType. A crash in between leaves a value.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the string value.
+     * @param value The string value to set.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid value.
+     *         - NVS_DELEGATE_READONLY: Attempt to write in READONLY mode.
+     *         - NVS_DELEGATE_NOT_ENOUGH_SPACE: Not enough space in the storage.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    NVSDelegateError_t set_str(
+        NVSDelegateHandle_t handle, char const *const key,
+        char const *const value) const override;
+
+    /**
+     * @brief Gets a string value, decompressing it into the caller's buffer.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the string value.
+     * @param out_value Buffer to store the value, nullptr to only query the length.
+     * @param length Pointer to the length of the buffer; updated with the length of the value, including the null terminator.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid length pointer, or buffer too small for a compressed value.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found, or not a string.
+     *         - NVS_DELEGATE_NOT_ENOUGH_SPACE: Not enough heap to read a compressed value.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error, or a corrupted compressed value.
+     */
+    NVSDelegateError_t get_str(
+        NVSDelegateHandle_t handle, char const *const key,
+        char *out_value, size_t *length) const override;
+
+    /**
+     * @brief Sets an integer value in the wrapped delegate.
+     */
+    NVSDelegateError_t set_i64(
+        NVSDelegateHandle_t handle, char const *const key, int64_t const value) const override;
+
+    /**
+     * @brief Gets an integer value from the wrapped delegate.
+     */
+    NVSDelegateError_t get_i64(
+        NVSDelegateHandle_t handle, char const *const key, int64_t *out_value) const override;
+
+    /**
+     * @brief Sets a binary value in the wrapped delegate.
+     */
+    NVSDelegateError_t set_blob(
+        NVSDelegateHandle_t handle, char const *const key,
+        void const *const value, size_t const length) const override;
+
+    /**
+     * @brief Gets a binary value from the wrapped delegate.
+     */
+    NVSDelegateError_t get_blob(
+        NVSDelegateHandle_t handle, char const *const key,
+        void *out_value, size_t *length) const override;
+
+    /**
+     * @brief Erases a key of the wrapped delegate, compressed or not.
+     */
+    NVSDelegateError_t erase_key(
+        NVSDelegateHandle_t handle, char const *const key) const override;
+
+    /**
+     * @brief Erases a namespace of the wrapped delegate.
+     */
+    NVSDelegateError_t erase_all(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Erases every namespace of the wrapped delegate.
+     */
+    NVSDelegateError_t erase_flash_all() const override;
+
+    /**
+     * @brief Commits a namespace of the wrapped delegate.
+     */
+    NVSDelegateError_t commit(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Lists the keys of a namespace of the wrapped delegate.
+     */
+    NVSDelegateError_t list_keys(
+        char const *const name, NVSDelegateKeyCallback_t callback, void *context) const override;
+
+    /**
+     * @brief Gets the entry usage of the wrapped delegate.
+     */
+    NVSDelegateError_t get_stats(NVSDelegateStats_t *out_stats) const override;
+
+    /**
+     * @brief Gets the entries used by a namespace of the wrapped delegate.
+     */
+    NVSDelegateError_t get_used_entries(NVSDelegateHandle_t handle, size_t *out_entries) const override;
+
+private:
+    NVSDelegateInterface *const m_nvsDelegate;   /**< Delegate storing the values. */
+    MultiPrinterLoggerInterface *const m_logger; /**< Pointer to the logger interface. */
+
+    /**
+     * @brief Compresses a value behind its header.
+     *
+     * @param value The value.
+     * @param valueLength The length of the value, without the null terminator.
+     * @param out_length Pointer to receive the length of the compressed value, header included.
+     * @return The compressed value to free, or nullptr if it would not shrink or the heap is short.
+     */
+    uint8_t *compressValue(char const *const value, size_t const valueLength, size_t *out_length) const;
+
+    /**
+     * @brief Prints an error message and returns the error.
+     */
+    NVSDelegateError_t printAndReturnError(NVSDelegateError_t const error) const;
+
+    /**
+     * @brief Checks if the given key is valid.
+     */
+    bool isKeyValid(char const *const key) const;
+};
+
+#endif // COMPRESSED_NVS_DELEGATE_H
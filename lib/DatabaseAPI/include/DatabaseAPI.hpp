@@ -2,13 +2,54 @@
 #define DATABASE_API_H
 
 #include <MultiPrinterLoggerInterface.hpp>
+#include <atomic>
 #include <string.h>
 
 #include "NVSDelegateInterface.hpp"
 #include "DatabaseAPIInterface.hpp"
+#include "DatabaseMutex.hpp"
+#include "DatabaseSnapshot.hpp"
+#include "DatabaseCounters.hpp"
+#include "DatabaseExpiry.hpp"
+#include "DatabaseFingerprints.hpp"
+#include "DatabaseBatch.hpp"
+#include "DatabaseImage.hpp"
+#include "DatabaseDefaults.hpp"
+#include "DatabaseSubscriptions.hpp"
+#include "DatabaseJob.hpp"
+#include "DatabaseLatency.hpp"
+
+#define DATABASE_VERSION_ABSENT 0 /**< Version token of a key that does not exist. */
+#define DATABASE_EXPIRY_KEY "~ttl" /**< Reserved key holding the expiry table of the namespace. */
+#define DATABASE_JOURNAL_KEY "~jnl" /**< Reserved key holding the journal of an atomic commit in progress. */
+#define DATABASE_GENERATION_KEY "~gen" /**< Reserved key of the base namespace selecting the active generation. */
+#define DATABASE_SHADOW_SUFFIX "~1" /**< Suffix of the namespace holding the alternate generation. */
+#define DATABASE_PAGE_ENTRIES 126 /**< Entries of an NVS page; NVS keeps one page free for garbage collection. */
+#define DATABASE_MAX_INSTANCES 16 /**< DatabaseAPI instances that may exist at once. */
+
+/**
+ * @brief Storage used by the namespace of a DatabaseAPI, in NVS entries of 32 bytes.
+ */
+struct DatabaseNamespaceUsage_t
+{
+    size_t keys;         /**< Keys of the active generation, reserved keys excluded. */
+    size_t entries;      /**< Entries used by the active generation, reserved keys included. */
+    size_t staleEntries; /**< Entries still used by the generation left behind by replaceAll. */
+};
+
+/**
+ * @brief Visitor of the keys listed by DatabaseAPI::listKeys.
+ *
+ * @param key The key.
+ * @param context The context given to listKeys.
+ * @return true to continue with the next key, false to stop.
+ */
+typedef bool (*DatabaseKeyVisitor_t)(char const *const key, void *context);
 
 /**
  * @brief Implementation of DatabaseAPIInterface for interacting with non-volatile storage using NVSDelegate.
+ *
+ * Keys starting with '~' are reserved for the metadata of the library.
  */
 class DatabaseAPI : public DatabaseAPIInterface
 {
@@ -16,6 +57,14 @@ public:
     /**
      * @brief Constructor for DatabaseAPI.
      *
+     * The generation written last by replaceAll is selected, and an atomic commit interrupted
+     * by a reset is completed from its journal here, see commit.
+     *
+     * A namespace is served by a single instance per delegate: the active generation, the
+     * counters, the fingerprints and the expiry table are held in RAM and never re-read. An
+     * instance constructed for a namespace another one has open through the same delegate, or
+     * beyond DATABASE_MAX_INSTANCES, logs an error and fails every operation until destroyed.
+     *
      * @param nvsDelegate Pointer to the NVSDelegateInterface instance.
      * @param nvsNamespace The namespace to use in non-volatile storage.
      */
@@ -57,6 +106,25 @@ public:
      */
     DatabaseError_t set(char const *const key, char const *const value) override;
 
+    /**
+     * @brief Sets the value for the specified key, which expires after the given number of seconds.
+     *
+     * An expired key is reported as not found by reads, and removed from NVS by sweepExpired.
+     * Setting a key without a TTL, by either set, removes its expiry, also one given before a
+     * reset. The expiry table is loaded when the DatabaseAPI is constructed, see enableExpiry.
+     *
+     * @param key The key for the value.
+     * @param value The value to set.
+     * @param ttlSeconds Seconds until the key expires, 0 for a key that does not expire.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_VALUE_INVALID: Invalid value.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap or storage for the value or the expiry table.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t set(char const *const key, char const *const value, uint32_t const ttlSeconds);
+
     /**
      * @brief Removes the specified key and its associated value from the database.
      *
@@ -69,6 +137,106 @@ public:
      */
     DatabaseError_t remove(char const *const key) override;
 
+    /**
+     * @brief Sets a value within a time budget, or not at all.
+     *
+     * The write is skipped when waiting for another writer, plus the latency predicted from
+     * the history of the previous writes, see DatabaseLatency, would exceed the budget; e.g.
+     * after an NVS page garbage collection stalled a write. Without history the write runs.
+     * The prediction can be wrong, so a write may still overrun.
+     *
+     * @param key The key for the value.
+     * @param value The value to set.
+     * @param budgetUs The time budget in microseconds.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_TIMEOUT: Not written, the budget would be exceeded.
+     *         - Any error of set.
+     */
+    DatabaseError_t setWithin(char const *const key, char const *const value, uint32_t const budgetUs);
+
+    /**
+     * @brief Removes a key within a time budget, or not at all, see setWithin.
+     *
+     * @param key The key to remove.
+     * @param budgetUs The time budget in microseconds.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_TIMEOUT: Not removed, the budget would be exceeded.
+     *         - Any error of remove.
+     */
+    DatabaseError_t removeWithin(char const *const key, uint32_t const budgetUs);
+
+    /**
+     * @brief Returns the latency predicted for the next write of an operation, 0 without history.
+     *
+     * @param operation The operation.
+     * @return The prediction in microseconds.
+     */
+    uint32_t getPredictedLatency(DatabaseOperation_t const operation) const;
+
+    /**
+     * @brief Returns the milliseconds elapsed since the last write was requested.
+     *
+     * Every set, remove, commit, replaceAll, eraseAll and counter change counts, whether or
+     * not it reached flash; sweepExpired, eraseStaleGeneration and flushCounters do not, so
+     * that maintenance run while the database is idle keeps it idle.
+     */
+    uint32_t getIdleTime() const;
+
+    /**
+     * @brief Reads the entry usage of the whole storage, see NVSDelegateInterface::get_stats.
+     *
+     * @param stats Pointer to receive the usage.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_VALUE_INVALID: Invalid stats pointer.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t getSpaceStats(NVSDelegateStats_t *stats) const;
+
+    /**
+     * @brief Returns the entries writes can still take, garbage collection included.
+     *
+     * Erased entries come back once NVS garbage collects their page, so the available entries
+     * are the ones not used, less the page NVS keeps free for collecting.
+     *
+     * @param entries Pointer to receive the number of entries.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_VALUE_INVALID: Invalid entries pointer.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t getAvailableEntries(size_t *entries) const;
+
+    /**
+     * @brief Computes the NVS entries a commit of a batch would write, without touching the flash.
+     *
+     * A string value takes a header and one entry per 32 bytes, terminator included; the
+     * journal of an atomic commit is a blob, which takes an index more. Removes take nothing
+     * until garbage collection; values already stored are counted again, as NVS writes the
+     * new entries before erasing the old ones.
+     *
+     * @param batch The staged operations.
+     * @param atomic true to count the journal, as commit(batch, true) writes it.
+     * @param entries Pointer to receive the number of entries.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_VALUE_INVALID: Invalid entries pointer.
+     */
+    DatabaseError_t estimateEntries(DatabaseBatch const &batch, bool const atomic, size_t *entries) const;
+
+    /**
+     * @brief Reports the entries and keys of the namespace, for capacity monitoring.
+     *
+     * @param usage Pointer to receive the usage.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful, zeros for a namespace never written.
+     *         - DATABASE_VALUE_INVALID: Invalid usage pointer.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t getNamespaceUsage(DatabaseNamespaceUsage_t *usage) const;
+
     /**
      * @brief Checks if the specified key exists in the database.
      *
@@ -81,6 +249,21 @@ public:
      */
     DatabaseError_t isExist(char const *const key) const override;
 
+    /**
+     * @brief Lists the keys of the namespace, leaving out reserved and expired keys.
+     *
+     * The keys are collected first, so the visitor may read and write the database.
+     *
+     * @param visitor The visitor, called once per key in no particular order.
+     * @param context Pointer passed unchanged to the visitor.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful, including for a namespace never written.
+     *         - DATABASE_VALUE_INVALID: Invalid visitor.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap to collect the keys.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t listKeys(DatabaseKeyVisitor_t const visitor, void *const context) const;
+
     /**
      * @brief Retrieves the length of the value associated with the specified key.
      *
@@ -112,10 +295,666 @@ public:
      */
     DatabaseError_t eraseFlashAll() override;
 
+    /**
+     * @brief Sets the value for the specified key only if the key does not exist yet.
+     *
+     * The lookup and the write share one handle and one commit, and no other write
+     * of this DatabaseAPI can run in between.
+     *
+     * @param key The key for the value.
+     * @param value The value to set.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_VALUE_INVALID: Invalid value.
+     *         - DATABASE_KEY_ALREADY_EXISTS: Key already exists, nothing was written.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t setIfAbsent(char const *const key, char const *const value);
+
+    /**
+     * @brief Replaces the value of the specified key only if it currently equals the expected value.
+     *
+     * @param key The key for the value.
+     * @param expectedValue The value the key must currently hold.
+     * @param newValue The value to set.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_VALUE_INVALID: Invalid expected or new value.
+     *         - DATABASE_KEY_NOT_FOUND: Key not found.
+     *         - DATABASE_CONFLICT: Key holds another value, nothing was written.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t compareAndSet(
+        char const *const key, char const *const expectedValue, char const *const newValue);
+
+    /**
+     * @brief Retrieves the version token of the value associated with the specified key.
+     *
+     * The token is a hash of the value, so it changes whenever the value changes.
+     * A missing key has version DATABASE_VERSION_ABSENT.
+     *
+     * @param key The key for the value.
+     * @param version Pointer to store the version token.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful, including a missing key.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_VALUE_INVALID: Invalid version pointer.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t getVersion(char const *const key, uint32_t *version) const;
+
+    /**
+     * @brief Retrieves the value associated with the specified key together with its version token.
+     *
+     * The token is computed from the value returned, so both always match.
+     *
+     * @param key The key for the value.
+     * @param value Buffer to store the retrieved value.
+     * @param maxValueLength The maximum length of the buffer.
+     * @param version Pointer to store the version token.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_VALUE_INVALID: Invalid value buffer or version pointer.
+     *         - DATABASE_KEY_NOT_FOUND: Key not found.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t get(
+        char const *const key, char *value, size_t maxValueLength, uint32_t *version) const;
+
+    /**
+     * @brief Sets the value for the specified key only if its version token is still the given one.
+     *
+     * Pass DATABASE_VERSION_ABSENT to require that the key does not exist.
+     *
+     * @param key The key for the value.
+     * @param version The version token read with get or getVersion.
+     * @param value The value to set.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_VALUE_INVALID: Invalid value.
+     *         - DATABASE_CONFLICT: Value changed since the version was read, nothing was written.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap to read the current value.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t setIfVersion(char const *const key, uint32_t const version, char const *const value);
+
+    /**
+     * @brief Applies the operations of a batch under one lock, all of them or, after a reset, none.
+     *
+     * An atomic commit first writes the batch as a journal under the reserved key "~jnl" and
+     * commits it, then applies the operations and commits, then erases the journal. A reset
+     * before the journal is committed leaves every key unchanged; a reset after it is completed
+     * by the constructor, which replays the journal. With atomic false, the operations are
+     * applied under a single commit with no journal, like plain batched writes.
+     * The keys of the batch lose their expiry, as with set without a TTL.
+     * Before any write, the entries of the batch, see estimateEntries, are checked against the
+     * available entries; if short, the generation left behind by replaceAll is erased first.
+     * Delegates reporting no statistics are not checked.
+     *
+     * @param batch The staged operations.
+     * @param atomic true to journal the batch, false to apply it directly.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful, including for an empty batch.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap or storage for the journal or the values;
+     *           nothing is written when the check finds the storage short.
+     *         - DATABASE_ERROR: General database error. Once the journal is committed, a failed
+     *           batch is rolled forward once more; if that fails too, the journal is dropped and
+     *           the keys keep what reached the flash. A reset before that is completed by the
+     *           next construction.
+     */
+    DatabaseError_t commit(DatabaseBatch const &batch, bool const atomic = true);
+
+    /**
+     * @brief Replaces the whole content of the namespace by the values of a batch, in one flip.
+     *
+     * The namespace has two generations: the base namespace and a shadow namespace named after
+     * it with the suffix DATABASE_SHADOW_SUFFIX; a base namespace longer than 13 characters is
+     * shortened to its first 4, '~' and the hash of its full name first. The new generation
+     * is written into the one not in use, then the reserved key "~gen" of the base namespace is
+     * set to point to it, in a single write and commit. Readers see the previous generation, whole,
+     * until the flip and the new one, whole, after it; a reset before the flip keeps the previous
+     * one. Counters and expiries belong to a generation and are not carried over. Remove
+     * operations of the batch are ignored. The previous generation stays in flash until
+     * eraseStaleGeneration or the next replaceAll. Once the unused generation is erased, the
+     * entries of the batch are checked against the available entries before any value is written.
+     *
+     * @param batch The values of the new generation.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap or storage for the new generation.
+     *         - DATABASE_ERROR: General database error, the previous generation is still active.
+     */
+    DatabaseError_t replaceAll(DatabaseBatch const &batch);
+
+    /**
+     * @brief Erases the generation left behind by replaceAll, freeing its flash.
+     *
+     * Meant to be called in the background, e.g. from a low-priority task or an idle loop, once
+     * the readers started before the flip are done. Does nothing if no generation is left behind.
+     *
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful, including when nothing was left behind.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap to list the keys of the base namespace.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t eraseStaleGeneration();
+
+    /**
+     * @brief Writes the string values of the namespace as an image, see DatabaseImage.
+     *
+     * Counters, reserved keys and expired keys are not exported. Writes of this DatabaseAPI
+     * wait until the export is over, so the image is consistent.
+     *
+     * @param writer The writer receiving the image.
+     * @param context The context pointer passed to the writer.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_VALUE_INVALID: Invalid writer.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap to list the keys or read a value.
+     *         - DATABASE_ERROR: General database error, or the writer failed.
+     */
+    DatabaseError_t exportNamespace(DatabaseImageWriter_t const writer, void *const context) const;
+
+    /**
+     * @brief Reads an image and writes its values in one bulk batched write.
+     *
+     * The whole image is read into RAM and validated, format, CRC, keys and values, before
+     * anything is written, so a truncated or corrupted image changes nothing. The values are
+     * then written under a single commit, see commit, or with replace as a new generation
+     * replacing the whole namespace, see replaceAll.
+     *
+     * @param reader The reader providing the image.
+     * @param context The context pointer passed to the reader.
+     * @param replace true to replace the whole namespace, false to add to it.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_INVALID: A key of the image is invalid or reserved.
+     *         - DATABASE_VALUE_INVALID: Invalid reader, or a truncated, malformed or corrupted image.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap for the image or storage for the values.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t importNamespace(DatabaseImageReader_t const reader, void *const context, bool const replace = false);
+
+    /**
+     * @brief Prepares a job erasing the namespace in slices, see DatabaseJob.
+     *
+     * The keys are listed here; each step removes some of them, and the last one erases the
+     * namespace, clearing the reserved keys and what was written in between. eraseFlashAll
+     * is a single erase of the partition and has no step-wise form.
+     *
+     * @param job The job to prepare, replacing the one it held.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: The job is ready to step.
+     *         - DATABASE_VALUE_INVALID: Invalid job pointer.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap to list the keys.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t startEraseAll(DatabaseJob *const job);
+
+    /**
+     * @brief Prepares a job applying a batch in slices, see DatabaseJob.
+     *
+     * The operations are copied into the job and applied in order, one key at a time, as
+     * commit does with atomic false but under one commit per key. The storage is checked
+     * for the whole batch first, as by commit.
+     *
+     * @param batch The operations to apply.
+     * @param job The job to prepare, replacing the one it held.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: The job is ready to step.
+     *         - DATABASE_VALUE_INVALID: Invalid job pointer.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap to copy the batch, or not enough storage for it.
+     */
+    DatabaseError_t startCommit(DatabaseBatch const &batch, DatabaseJob *const job);
+
+    /**
+     * @brief Reads and validates an image, then prepares a job writing its values in slices, see DatabaseJob.
+     *
+     * As with importNamespace, a truncated or corrupted image is rejected before anything is
+     * written; replacing the whole namespace has no step-wise form.
+     *
+     * @param reader The reader providing the image.
+     * @param context The context pointer passed to the reader.
+     * @param job The job to prepare, replacing the one it held.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: The job is ready to step.
+     *         - DATABASE_KEY_INVALID: A key of the image is invalid or reserved.
+     *         - DATABASE_VALUE_INVALID: Invalid reader or job pointer, or a truncated, malformed or corrupted image.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap for the image, or not enough storage for its values.
+     */
+    DatabaseError_t startImport(DatabaseImageReader_t const reader, void *const context, DatabaseJob *const job);
+
+    /**
+     * @brief Adds a delta to a counter stored as a native 64-bit integer.
+     *
+     * The counter is served from RAM and persisted according to setCounterPersistPolicy,
+     * so a crash loses at most the changes the policy allows. A missing counter starts at 0.
+     * Counters are read with getCounter, not with get.
+     *
+     * @param key The key of the counter.
+     * @param delta The value to add, may be negative.
+     * @param value Optional pointer to receive the new value of the counter.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap or storage; a change already applied in RAM is kept and persisted later.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t increment(char const *const key, int64_t const delta = 1, int64_t *value = nullptr);
+
+    /**
+     * @brief Subtracts a delta from a counter, see increment.
+     *
+     * @param key The key of the counter.
+     * @param delta The value to subtract.
+     * @param value Optional pointer to receive the new value of the counter.
+     * @return DatabaseError_t, as for increment.
+     */
+    DatabaseError_t decrement(char const *const key, int64_t const delta = 1, int64_t *value = nullptr);
+
+    /**
+     * @brief Retrieves the current value of a counter, including changes not persisted yet.
+     *
+     * @param key The key of the counter.
+     * @param value Pointer to receive the value of the counter.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_VALUE_INVALID: Invalid value pointer.
+     *         - DATABASE_KEY_NOT_FOUND: Counter not found.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t getCounter(char const *const key, int64_t *value);
+
+    /**
+     * @brief Sets when counter changes are written to NVS.
+     *
+     * Pending changes of every counter are persisted together, under one commit, as soon as
+     * one counter has maxPendingChanges unpersisted changes, or when a counter operation finds
+     * a change older than maxPendingMs. The age is only checked on the next counter operation:
+     * counters left idle stay pending until flushCounters, e.g. from DatabaseMaintenance.
+     * 0 disables a condition; with both disabled, counters are only persisted by flushCounters
+     * and the destructor. The default persists every change. Setting or removing the key of a
+     * counter drops its pending changes.
+     *
+     * @param maxPendingChanges Number of changes of a counter that may be lost on a crash.
+     * @param maxPendingMs Age in milliseconds of the oldest change that may be lost on a crash.
+     */
+    void setCounterPersistPolicy(uint32_t const maxPendingChanges, uint32_t const maxPendingMs);
+
+    /**
+     * @brief Persists the pending changes of every counter under one commit.
+     *
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful, including when nothing was pending.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough space in the storage.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t flushCounters();
+
+    /**
+     * @brief Enables expiry, loading the expiry table of the namespace into RAM.
+     *
+     * The constructor loads the table, so keys given a TTL before a reboot are filtered from
+     * the first read; call it only to retry after the table failed to load. While enabled,
+     * reads check the table in RAM, with no extra flash access, and report expired keys as
+     * not found. Calling it while enabled does nothing.
+     *
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap for the table.
+     *         - DATABASE_ERROR: General database error, or a malformed table.
+     */
+    DatabaseError_t enableExpiry();
+
+    /**
+     * @brief Removes at most maxKeys expired keys from NVS, under one commit.
+     *
+     * Meant to be called periodically, e.g. from a timer or an idle loop, so the cost of
+     * each step stays bounded.
+     *
+     * @param maxKeys The maximum number of keys to remove in this step.
+     * @param removed Optional pointer to receive the number of keys removed.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful, including when nothing expired.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap or storage for the expiry table.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t sweepExpired(size_t const maxKeys, size_t *removed = nullptr);
+
+    /**
+     * @brief Sets the clock keys expire by, time(nullptr) by default.
+     *
+     * Expiry times are persisted, so the clock must keep counting across reboots, e.g. a
+     * system time set by SNTP. Set it before any other call.
+     *
+     * @param clock Function returning the current time in seconds.
+     */
+    void setClock(DatabaseClock_t const clock);
+
+    /**
+     * @brief Enables write elision: set skips the write and the commit of a value already stored.
+     *
+     * A fingerprint of each value, its hash and length, is kept in RAM. The fingerprint of a key
+     * is taken on its first set after boot, by reading the stored value once; from then on an
+     * unchanged value costs no flash access. Writes that change an expiry are never elided.
+     * Fingerprints are never checked against the flash again, so every write to the namespace
+     * must go through this instance: a value written straight through a delegate would make a
+     * later set of the previous value a no-op. Two different values of the same length with the
+     * same 32-bit hash would be taken as equal, so do not enable it where such a collision
+     * cannot be tolerated.
+     */
+    void enableWriteElision();
+
+    /**
+     * @brief Disables write elision and frees the fingerprints.
+     */
+    void disableWriteElision();
+
+    /**
+     * @brief Returns the number of writes skipped by write elision since construction.
+     */
+    uint32_t getElidedWriteCount() const;
+
+    /**
+     * @brief Enables snapshot mode, loading the whole namespace into an immutable in-RAM table.
+     *
+     * While enabled, get, isExist and getValueLength are served from the snapshot
+     * without locking or flash access. Once a key has a TTL, reads also check the expiry
+     * table under its lock. Writes go through to NVS and publish a new
+     * snapshot; the previous one is freed once no reader uses it anymore.
+     * Calling it while enabled reloads the snapshot from NVS.
+     *
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap for the snapshot.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t enableSnapshot();
+
+    /**
+     * @brief Disables snapshot mode and frees the snapshot. Reads go to NVS again.
+     */
+    void disableSnapshot();
+
+    /**
+     * @brief Checks if snapshot mode is enabled.
+     *
+     * @return true if reads are served from a snapshot, false otherwise.
+     */
+    bool isSnapshotEnabled() const;
+
+    /**
+     * @brief Sets the table of compiled-in defaults, consulted before NVS.
+     *
+     * A key with a default and no stored value reads as its default, served from the table
+     * without accessing the flash or logging a missing key. A set overrides the default and
+     * a remove, or an expiry, restores it. The keys overriding their defaults are found once
+     * here, by listing the namespace, then tracked by every write. getVersion, setIfAbsent,
+     * compareAndSet and setIfVersion see a key left at its default as holding the default.
+     *
+     * @param defaults The table, which must outlive the DatabaseAPI, see DatabaseDefaults.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap for the override bits.
+     *         - DATABASE_ERROR: The namespace could not be listed.
+     */
+    template <size_t N>
+    DatabaseError_t setDefaults(DatabaseDefaults<N> const &defaults)
+    {
+        return setDefaults(DatabaseDefaultsTable(defaults));
+    }
+
+    /**
+     * @brief Sets the table of compiled-in defaults, see above; an empty table removes the defaults.
+     */
+    DatabaseError_t setDefaults(DatabaseDefaultsTable const &defaults);
+
+    /**
+     * @brief Subscribes a callback to the changes of a key, or of the keys starting with a prefix.
+     *
+     * The callback runs on a delivery task after set, remove, commit, an expiry sweep, eraseAll
+     * or replaceAll succeeded; the writer only queues the key and never waits for a subscriber.
+     * eraseAll and replaceAll deliver DATABASE_CHANGE_ERASED to every subscription, and changes
+     * dropped while the queue was full are reported as DATABASE_CHANGE_OVERFLOW. Counters
+     * change in RAM and are not published.
+     *
+     * @param pattern The key, or a prefix followed by '*'; "*" matches every key.
+     * @param callback The callback, which may use the database and unsubscribe.
+     * @param context Pointer passed unchanged to the callback.
+     * @param out_id Optional pointer to receive the id of the subscription, for unsubscribe.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_INVALID: Invalid pattern.
+     *         - DATABASE_VALUE_INVALID: Invalid callback.
+     *         - DATABASE_NOT_ENOUGH_SPACE: DATABASE_MAX_SUBSCRIPTIONS reached, or the delivery task could not be started.
+     */
+    DatabaseError_t subscribe(
+        char const *const pattern, DatabaseChangeCallback_t const callback, void *const context = nullptr,
+        uint32_t *out_id = nullptr);
+
+    /**
+     * @brief Removes a subscription. Once it returns, the callback is not called again.
+     *
+     * @param id The id returned by subscribe.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_NOT_FOUND: No subscription has this id.
+     */
+    DatabaseError_t unsubscribe(uint32_t const id);
+
+    /**
+     * @brief Returns the number of changes dropped because the subscription queue was full.
+     */
+    uint32_t droppedChanges() const;
+
 private:
     NVSDelegateInterface *const _nvsDelegate;              /**< Pointer to the NVSDelegateInterface instance. */
     char _nvsNamespace[NVS_DELEGATE_MAX_NAMESPACE_LENGTH]; /**< The namespace to use in non-volatile storage. */
     MultiPrinterLoggerInterface *const _logger;            /**< Pointer to the MultiPrinterLoggerInterface instance. */
+    DatabaseMutex _writeMutex;                             /**< Serializes writes and snapshot publication. */
+    std::atomic<DatabaseSnapshot const *> _snapshot;       /**< Current snapshot, nullptr when snapshot mode is disabled. */
+    std::atomic<uint32_t> _snapshotEpoch;                  /**< Incremented by every publication, its parity selects the reader slot. */
+    mutable std::atomic<uint32_t> _snapshotReaders[2];     /**< Number of readers inside a snapshot, per epoch parity. */
+    DatabaseCounters _counters;                            /**< Counters served from RAM. */
+    uint32_t _counterMaxPendingChanges;                    /**< Changes of a counter that trigger persistence, 0 to disable. */
+    uint32_t _counterMaxPendingMs;                         /**< Age of a change that triggers persistence, 0 to disable. */
+    DatabaseExpiry _expiry;                                /**< Expiry times of the keys given a TTL. */
+    DatabaseMutex _expiryMutex;                            /**< Guards _expiry against concurrent readers. */
+    std::atomic<bool> _expiryEnabled;                      /**< true once the expiry table is loaded. */
+    std::atomic<size_t> _expiringKeys;                     /**< Keys with a TTL, reads skip the expiry check while 0. */
+    DatabaseClock_t _clock;                                /**< Clock keys expire by. */
+    DatabaseFingerprints _fingerprints;                    /**< Fingerprints of the stored values, while write elision is enabled. */
+    bool _writeElision;                                    /**< true while write elision is enabled. */
+    uint32_t _elidedWrites;                                /**< Number of writes skipped by write elision. */
+    char _shadowNamespace[NVS_DELEGATE_MAX_NAMESPACE_LENGTH]; /**< The namespace of the alternate generation. */
+    std::atomic<uint8_t> _generation;                      /**< Active generation, 0 for the base namespace, 1 for the shadow one. */
+    bool _staleGeneration;                                 /**< true while the inactive generation may hold data. */
+    DatabaseDefaultsTable _defaults;                       /**< Compiled-in defaults, consulted before NVS. */
+    uint8_t *_defaultOverrides;                            /**< One bit per default, set while a stored value overrides it. */
+    DatabaseMutex _defaultsMutex;                          /**< Guards _defaults and _defaultOverrides against concurrent readers. */
+    std::atomic<bool> _defaultsEnabled;                    /**< true while a defaults table is set. */
+    DatabaseSubscriptions _subscriptions;                  /**< Subscriptions to the changes, delivered by their own task. */
+    DatabaseLatency _latency;                              /**< Latency history of the writes, guarded by _writeMutex. */
+    std::atomic<uint32_t> _lastWriteMs;                    /**< Tick time of the last write requested, in milliseconds. */
+
+    /**
+     * @brief Returns the namespace of the active generation, the one every operation works on.
+     */
+    char const *activeNamespace() const;
+
+    /**
+     * @brief Returns the namespace of a generation.
+     *
+     * @param generation 0 for the base namespace, 1 for the shadow one.
+     */
+    char const *generationNamespace(uint8_t const generation) const;
+
+    /**
+     * @brief Reads the generation pointer of the base namespace and selects the active generation.
+     *
+     * @return NVS_DELEGATE_OK, NVS_DELEGATE_KEY_NOT_FOUND if the base namespace does not exist,
+     *         or the delegate error.
+     */
+    NVSDelegateError_t loadGeneration();
+
+    /**
+     * @brief Erases every key of a generation, except the generation pointer, under one commit.
+     *        Must be called with _writeMutex held, on the inactive generation only.
+     *
+     * @param generation 0 for the base namespace, 1 for the shadow one.
+     * @return NVS_DELEGATE_OK, NVS_DELEGATE_NOT_ENOUGH_SPACE or the delegate error.
+     */
+    NVSDelegateError_t clearGeneration(uint8_t const generation);
+
+    /**
+     * @brief Checks that a number of entries can be written, erasing the stale generation if short.
+     *        Must be called with _writeMutex held.
+     *
+     * @param needed The number of entries.
+     * @return NVS_DELEGATE_OK, including when the delegate reports no statistics,
+     *         NVS_DELEGATE_NOT_ENOUGH_SPACE or the delegate error.
+     */
+    NVSDelegateError_t reserveEntries(size_t const needed);
+
+    /**
+     * @brief Returns the counter of a key, loading it from NVS on first use.
+     *        Must be called with _writeMutex held.
+     *
+     * @param key The key of the counter.
+     * @param create true to start a missing counter at 0.
+     * @param out_counter Pointer to receive the counter.
+     * @return NVS_DELEGATE_OK, NVS_DELEGATE_KEY_NOT_FOUND, NVS_DELEGATE_NOT_ENOUGH_SPACE or the delegate error.
+     */
+    NVSDelegateError_t loadCounter(
+        char const *const key, bool const create, DatabaseCounters::Counter **out_counter);
+
+    /**
+     * @brief Writes every counter with pending changes under one commit.
+     *        Must be called with _writeMutex held.
+     *
+     * @return NVS_DELEGATE_OK or the delegate error, counters stay pending on failure.
+     */
+    NVSDelegateError_t persistCounters();
+
+    /**
+     * @brief Checks if a key has expired, from the expiry table in RAM.
+     *
+     * @param key The key to check.
+     * @return true if the key has an expiry time that has passed, false otherwise.
+     */
+    bool isExpired(char const *const key) const;
+
+    /**
+     * @brief Finds the default a key reads as, if no stored value overrides it.
+     *
+     * @param key The key.
+     * @param out_value Pointer to receive the default value.
+     * @return true if the key reads as its default, false otherwise.
+     */
+    bool findDefault(char const *const key, char const **out_value) const;
+
+    /**
+     * @brief Records whether a stored value overrides the default of a key, if it has one.
+     *        Must be called with _writeMutex held.
+     *
+     * @param key The key that was written.
+     * @param overridden true if the key now has a stored value, false if it was removed.
+     */
+    void overrideDefault(char const *const key, bool const overridden);
+
+    /**
+     * @brief Records that no stored value overrides any default. Must be called with _writeMutex held.
+     */
+    void clearDefaultOverrides();
+
+    /**
+     * @brief Loads the persisted expiry table and enables expiry, unless already enabled.
+     *        Must be called with _writeMutex held.
+     *
+     * @return NVS_DELEGATE_OK, NVS_DELEGATE_NOT_ENOUGH_SPACE or the delegate error.
+     */
+    NVSDelegateError_t loadExpiry();
+
+    /**
+     * @brief Sets the expiry time of a key and writes the table on an open handle, if it changed.
+     *        Loads the table first if it is not loaded yet. Must be called with _writeMutex held.
+     *
+     * @param handle The handle of the namespace opened in READWRITE mode.
+     * @param key The key.
+     * @param expiresAt Time in seconds from which the key is expired, 0 if it does not expire.
+     * @return NVS_DELEGATE_OK or the delegate error, the table in RAM is left unchanged on failure.
+     */
+    NVSDelegateError_t writeExpiry(NVSDelegateHandle_t const handle, char const *const key, uint32_t const expiresAt);
+
+    /**
+     * @brief Writes the expiry table on an open handle, erasing it once empty.
+     *        Must be called with _writeMutex held.
+     *
+     * @param handle The handle of the namespace opened in READWRITE mode.
+     * @return NVS_DELEGATE_OK, NVS_DELEGATE_NOT_ENOUGH_SPACE or the delegate error.
+     */
+    NVSDelegateError_t storeExpiry(NVSDelegateHandle_t const handle);
+
+    /**
+     * @brief Completes an atomic commit interrupted by a reset: replays a well-formed journal,
+     *        discards a malformed one, then erases it.
+     *
+     * @return NVS_DELEGATE_OK, including when there is no journal, or the delegate error.
+     */
+    NVSDelegateError_t recoverJournal();
+
+    /**
+     * @brief Applies the operations of a batch on an open handle, without committing.
+     *        Must be called with _writeMutex held.
+     *
+     * @param handle The handle of the namespace opened in READWRITE mode.
+     * @param batch The operations to apply.
+     * @return NVS_DELEGATE_OK or the delegate error of the first operation that failed.
+     */
+    NVSDelegateError_t applyBatch(NVSDelegateHandle_t const handle, DatabaseBatch const &batch);
+
+    /**
+     * @brief Updates the snapshot, fingerprints and counters once a batch is committed.
+     *        Must be called with _writeMutex held.
+     *
+     * @param batch The operations committed.
+     */
+    void publishBatch(DatabaseBatch const &batch);
+
+    /**
+     * @brief Reloads the keys of a batch that failed half way into the snapshot, fingerprints,
+     *        defaults and counters, from what reached the flash. Must be called with _writeMutex held.
+     *
+     * @param handle The handle of the open namespace.
+     * @param batch The operations that failed.
+     */
+    void reloadBatch(NVSDelegateHandle_t const handle, DatabaseBatch const &batch);
+
+    /**
+     * @brief Checks if a value is already stored, from its fingerprint. The fingerprint of a key
+     *        not seen yet is taken from the snapshot or the stored value. Must be called with
+     *        _writeMutex held.
+     *
+     * @param handle The handle of the open namespace.
+     * @param key The key.
+     * @param value The value about to be written.
+     * @return true if write elision is enabled and the key holds the same value, false otherwise.
+     */
+    bool isUnchanged(NVSDelegateHandle_t const handle, char const *const key, char const *const value);
+
+    /**
+     * @brief Records the fingerprint of a value just written, while write elision is enabled.
+     *        Must be called with _writeMutex held.
+     *
+     * @param key The key.
+     * @param value The value written, nullptr if the key was removed or its value is unknown.
+     */
+    void rememberValue(char const *const key, char const *const value);
 
     /**
      * @brief Maps the given NVSDelegateError_t value to a DatabaseError_t value.
@@ -132,6 +971,89 @@ private:
      * @return true if the key is valid, false otherwise.
      */
     bool isKeyValid(char const *const key) const;
+
+    /**
+     * @brief Checks if the given value can be stored.
+     *
+     * @param value The value to check.
+     * @return true if the value is valid, false otherwise.
+     */
+    bool isValueValid(char const *const value) const;
+
+    /**
+     * @brief Computes the version token of a value, never DATABASE_VERSION_ABSENT.
+     *
+     * @param value The null-terminated value.
+     * @return The FNV-1a hash of the value.
+     */
+    uint32_t computeVersion(char const *const value) const;
+
+    /**
+     * @brief Reads the value of a key into a new heap buffer.
+     *
+     * @param handle The handle of the open namespace.
+     * @param key The key to read.
+     * @param out_value Pointer to receive the value, to be freed by the caller.
+     * @return NVS_DELEGATE_OK, NVS_DELEGATE_NOT_ENOUGH_SPACE or the delegate error.
+     */
+    NVSDelegateError_t readValue(NVSDelegateHandle_t const handle, char const *const key, char **out_value) const;
+
+    /**
+     * @brief Runs a set or a remove if the budget allows it, see setWithin.
+     *
+     * @param operation DATABASE_OPERATION_SET or DATABASE_OPERATION_REMOVE.
+     * @param key The key, already validated.
+     * @param value The value to set, already validated, nullptr for a remove.
+     * @param budgetUs The time budget in microseconds.
+     * @return DATABASE_TIMEOUT, or the result of the operation.
+     */
+    DatabaseError_t runWithin(
+        DatabaseOperation_t const operation, char const *const key, char const *const value, uint32_t const budgetUs);
+
+    /**
+     * @brief Writes and commits a value on an open handle, then closes it and updates the snapshot.
+     *        Must be called with _writeMutex held.
+     *
+     * @param handle The handle of the namespace opened in READWRITE mode.
+     * @param key The key for the value.
+     * @param value The value to set.
+     * @return DatabaseError_t of the write.
+     */
+    DatabaseError_t commitValue(NVSDelegateHandle_t const handle, char const *const key, char const *const value);
+
+    /**
+     * @brief Enters a snapshot read section. Every call returning a snapshot must be paired
+     *        with releaseSnapshot().
+     *
+     * @param out_slot Pointer to receive the reader slot, to be given to releaseSnapshot().
+     * @return The current snapshot, or nullptr if snapshot mode is disabled.
+     */
+    DatabaseSnapshot const *acquireSnapshot(uint32_t *out_slot) const;
+
+    /**
+     * @brief Leaves a snapshot read section entered with acquireSnapshot().
+     *
+     * @param slot The reader slot returned by acquireSnapshot().
+     */
+    void releaseSnapshot(uint32_t const slot) const;
+
+    /**
+     * @brief Replaces the current snapshot and frees the previous one once the readers that
+     *        may use it have left. Readers entering meanwhile do not delay it.
+     *        Must be called with _writeMutex held.
+     *
+     * @param snapshot The snapshot to publish, nullptr to disable snapshot mode.
+     */
+    void publishSnapshot(DatabaseSnapshot const *const snapshot);
+
+    /**
+     * @brief Publishes the snapshot following a successful write, if snapshot mode is enabled.
+     *        Must be called with _writeMutex held.
+     *
+     * @param key The key that was written.
+     * @param value The new value of the key, nullptr if it was removed.
+     */
+    void updateSnapshot(char const *const key, char const *const value);
 };
 
 #endif // DATABASE_API_H
@@ -17,6 +17,8 @@ enum DatabaseError_t : uint8_t
     DATABASE_NAMESPACE_INVALID,  /**< Invalid namespace. */
     DATABASE_NOT_ENOUGH_SPACE,   /**< Not enough space in the storage. */
     DATABASE_ERROR,              /**< General database error. */
+    DATABASE_CONFLICT,           /**< Value changed since it was read. */
+    DATABASE_TIMEOUT,            /**< Operation would not complete within its time budget, nothing was written. */
 };
 
 /**
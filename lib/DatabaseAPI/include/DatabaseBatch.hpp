@@ -0,0 +1,117 @@
+#ifndef DATABASE_BATCH_H
+#define DATABASE_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "NVSDelegateInterface.hpp"
+#include "DatabaseAPIInterface.hpp"
+
+/**
+ * @brief Writes staged in RAM, to be committed together by DatabaseAPI::commit.
+ *
+ * Staging a key twice keeps the last operation. The batch is serialized as the journal
+ * of an atomic commit: for each operation a 'S' (set) or 'R' (remove) byte, the
+ * null-terminated key and, for a set, the null-terminated value. It is not synchronized.
+ */
+class DatabaseBatch
+{
+public:
+    /**
+     * @brief One staged operation.
+     */
+    struct Operation
+    {
+        char key[NVS_DELEGATE_MAX_KEY_LENGTH]; /**< Null-terminated key. */
+        char *value;                           /**< Value to set, owned by the batch, nullptr to remove the key. */
+    };
+
+    /**
+     * @brief Constructor for DatabaseBatch, no memory is allocated until an operation is staged.
+     */
+    DatabaseBatch();
+
+    /**
+     * @brief Destructor for DatabaseBatch, frees the staged operations.
+     */
+    ~DatabaseBatch();
+
+    /**
+     * @brief Stages setting a value.
+     *
+     * @param key The key for the value, not starting with '~'.
+     * @param value The value to set.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation staged.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_VALUE_INVALID: Invalid value.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap to stage the operation.
+     */
+    DatabaseError_t set(char const *const key, char const *const value);
+
+    /**
+     * @brief Stages removing a key. Removing a key that does not exist is not an error.
+     *
+     * @param key The key to remove, not starting with '~'.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation staged.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap to stage the operation.
+     */
+    DatabaseError_t remove(char const *const key);
+
+    /**
+     * @brief Drops every staged operation and frees the batch.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of staged operations.
+     */
+    size_t count() const;
+
+    /**
+     * @brief Returns the operation at the given position, below count().
+     */
+    Operation const &at(size_t const index) const;
+
+    /**
+     * @brief Returns the length of the serialized batch.
+     */
+    size_t serializedLength() const;
+
+    /**
+     * @brief Serializes the batch.
+     *
+     * @param out Buffer of serializedLength() bytes.
+     */
+    void serialize(uint8_t *out) const;
+
+    /**
+     * @brief Replaces the staged operations with serialized ones.
+     *
+     * @param data The serialized batch.
+     * @param length The length of the serialized batch.
+     * @return true if the data was well formed, false otherwise, leaving the batch empty.
+     */
+    bool deserialize(uint8_t const *const data, size_t const length);
+
+    DatabaseBatch(DatabaseBatch const &) = delete;
+    DatabaseBatch &operator=(DatabaseBatch const &) = delete;
+
+private:
+    Operation *_operations; /**< Staged operations, nullptr while empty. */
+    size_t _count;          /**< Number of staged operations. */
+    size_t _capacity;       /**< Number of operations the table can hold. */
+
+    /**
+     * @brief Stages an operation, replacing a previous one on the same key.
+     *
+     * @param key The key, already validated.
+     * @param value The value, already validated, nullptr to remove the key.
+     * @return true if staged, false if the heap is short.
+     */
+    bool stage(char const *const key, char const *const value);
+};
+
+#endif // DATABASE_BATCH_H
@@ -0,0 +1,86 @@
+#ifndef DATABASE_COUNTERS_H
+#define DATABASE_COUNTERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "NVSDelegateInterface.hpp"
+
+/**
+ * @brief In-RAM table of the counters of a DatabaseAPI, with their unpersisted changes.
+ *
+ * The table grows on demand and is not synchronized; its owner serializes access.
+ */
+class DatabaseCounters
+{
+public:
+    /**
+     * @brief One counter and its persistence state.
+     */
+    struct Counter
+    {
+        char key[NVS_DELEGATE_MAX_KEY_LENGTH]; /**< Null-terminated key. */
+        int64_t value;                         /**< Current value. */
+        uint32_t pending;                      /**< Number of changes not persisted yet, 0 if clean. */
+        uint32_t dirtySinceMs;                 /**< Time of the oldest change not persisted yet. */
+    };
+
+    /**
+     * @brief Constructor for DatabaseCounters, no memory is allocated until a counter is added.
+     */
+    DatabaseCounters();
+
+    /**
+     * @brief Destructor for DatabaseCounters, frees the table.
+     */
+    ~DatabaseCounters();
+
+    /**
+     * @brief Finds a counter.
+     *
+     * @param key The key of the counter.
+     * @return The counter, or nullptr if it is not in the table.
+     */
+    Counter *find(char const *const key);
+
+    /**
+     * @brief Adds a clean counter to the table.
+     *
+     * @param key The key of the counter, not in the table yet.
+     * @param value The persisted value of the counter.
+     * @return The new counter, or nullptr if the table cannot grow.
+     */
+    Counter *add(char const *const key, int64_t const value);
+
+    /**
+     * @brief Removes a counter from the table, if present.
+     *
+     * @param key The key of the counter.
+     */
+    void remove(char const *const key);
+
+    /**
+     * @brief Removes every counter and frees the table.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of counters in the table.
+     */
+    size_t count() const;
+
+    /**
+     * @brief Returns the counter at the given position, below count().
+     */
+    Counter &at(size_t const index);
+
+    DatabaseCounters(DatabaseCounters const &) = delete;
+    DatabaseCounters &operator=(DatabaseCounters const &) = delete;
+
+private:
+    Counter *_counters; /**< Table of counters, nullptr while empty. */
+    size_t _count;      /**< Number of counters in the table. */
+    size_t _capacity;   /**< Number of counters the table can hold. */
+};
+
+#endif // DATABASE_COUNTERS_H
@@ -0,0 +1,431 @@
+#ifndef DATABASE_DEFAULTS_H
+#define DATABASE_DEFAULTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DATABASE_DEFAULTS_EMPTY_SLOT 0xFFFF /**< Slot of a defaults table holding no key. */
+
+/**
+ * @brief A key and its compiled-in default value.
+ */
+struct DatabaseDefault
+{
+    char const *key;   /**< The key. */
+    char const *value; /**< The default value of the key. */
+};
+
+/**
+ * @brief The slots of the keys hashed to one bucket of a defaults table.
+ */
+struct DatabaseDefaultsBucket
+{
+    uint16_t offset; /**< Index of the first slot of the bucket. */
+    uint16_t size;   /**< Number of slots, the square of the number of keys of the bucket. */
+    uint16_t seed;   /**< Seed placing the keys of the bucket in distinct slots. */
+};
+
+/**
+ * @brief Compile-time sequence of indexes, expanded into the arrays of DatabaseDefaults.
+ */
+template <size_t... I>
+struct DatabaseIndexSequence
+{
+};
+
+/**
+ * @brief Concatenates two index sequences, the second shifted past the first.
+ */
+template <typename First, typename Second>
+struct DatabaseConcatIndexSequence;
+
+template <size_t... First, size_t... Second>
+struct DatabaseConcatIndexSequence<DatabaseIndexSequence<First...>, DatabaseIndexSequence<Second...>>
+{
+    typedef DatabaseIndexSequence<First..., (sizeof...(First) + Second)...> type;
+};
+
+/**
+ * @brief The index sequence 0 to N - 1, built by halves so that long tables stay shallow.
+ */
+template <size_t N>
+struct DatabaseMakeIndexSequence
+    : DatabaseConcatIndexSequence<typename DatabaseMakeIndexSequence<N / 2>::type, typename DatabaseMakeIndexSequence<N - N / 2>::type>
+{
+};
+
+template <>
+struct DatabaseMakeIndexSequence<0>
+{
+    typedef DatabaseIndexSequence<> type;
+};
+
+template <>
+struct DatabaseMakeIndexSequence<1>
+{
+    typedef DatabaseIndexSequence<0> type;
+};
+
+/**
+ * @brief Hashing of the keys of defaults tables, shared by the compiler and lookups.
+ */
+class DatabaseDefaultsHash
+{
+public:
+    /**
+     * @brief Hashes a key with a seed, FNV-1a followed by the finalizer of MurmurHash3.
+     */
+    static constexpr uint32_t hash(char const *const key, uint32_t const seed)
+    {
+        return mix(fnv(key, 2166136261u ^ static_cast<uint32_t>(seed * 0x9E3779B9u)));
+    }
+
+    /**
+     * @brief Returns the number of slots of a table of count keys.
+     */
+    static constexpr size_t slotCount(size_t const count)
+    {
+        return 3 * count;
+    }
+
+private:
+    static constexpr uint32_t fnv(char const *const key, uint32_t const hash)
+    {
+        return *key ? fnv(key + 1, static_cast<uint32_t>((hash ^ static_cast<uint8_t>(*key)) * 16777619u)) : hash;
+    }
+
+    static constexpr uint32_t mix(uint32_t const hash)
+    {
+        return mixLast(static_cast<uint32_t>((hash ^ (hash >> 16)) * 0x85EBCA6Bu));
+    }
+
+    static constexpr uint32_t mixLast(uint32_t const hash)
+    {
+        return mixEnd(static_cast<uint32_t>((hash ^ (hash >> 13)) * 0xC2B2AE35u));
+    }
+
+    static constexpr uint32_t mixEnd(uint32_t const hash)
+    {
+        return hash ^ (hash >> 16);
+    }
+};
+
+/*
+ * The layout is computed in stages, each an array the next one reads instead of hashing
+ * again: the bucket of every key, the number of keys of every bucket, the buckets, then
+ * the slot of every key. C++11 constexpr functions cannot keep state, so every stage is
+ * an object built from the previous ones. Recursions go by halves; tables of up to about
+ * 200 keys stay within the default constexpr limits of GCC.
+ */
+
+/**
+ * @brief Layout stage: the bucket of every key for a first-level seed.
+ */
+template <size_t N>
+class DatabaseDefaultsSpread
+{
+public:
+    constexpr DatabaseDefaultsSpread(DatabaseDefault const *const entries, uint32_t const seed)
+        : DatabaseDefaultsSpread(entries, seed, typename DatabaseMakeIndexSequence<N>::type())
+    {
+    }
+
+    /**
+     * @brief Returns the number of keys of a bucket among the keys from first to last - 1.
+     */
+    constexpr size_t keysIn(size_t const bucket, size_t const first, size_t const last) const
+    {
+        return last - first == 0   ? 0
+               : last - first == 1 ? (bucketOf[first] == bucket ? 1 : 0)
+                                   : keysIn(bucket, first, first + (last - first) / 2) + keysIn(bucket, first + (last - first) / 2, last);
+    }
+
+    uint32_t const seed;        /**< The first-level seed. */
+    uint16_t const bucketOf[N]; /**< Bucket of every key. */
+
+private:
+    template <size_t... I>
+    constexpr DatabaseDefaultsSpread(DatabaseDefault const *const entries, uint32_t const seed, DatabaseIndexSequence<I...>)
+        : seed(seed), bucketOf{static_cast<uint16_t>(DatabaseDefaultsHash::hash(entries[I].key, seed) % N)...}
+    {
+    }
+};
+
+/**
+ * @brief Layout stage: the number of keys of every bucket.
+ */
+template <size_t N>
+class DatabaseDefaultsCounts
+{
+public:
+    constexpr explicit DatabaseDefaultsCounts(DatabaseDefaultsSpread<N> const &spread)
+        : DatabaseDefaultsCounts(spread, typename DatabaseMakeIndexSequence<N>::type())
+    {
+    }
+
+    /**
+     * @brief Returns the number of slots of the buckets from first to last - 1, the squares of their numbers of keys.
+     */
+    constexpr size_t slots(size_t const first, size_t const last) const
+    {
+        return last - first == 0   ? 0
+               : last - first == 1 ? static_cast<size_t>(keys[first]) * keys[first]
+                                   : slots(first, first + (last - first) / 2) + slots(first + (last - first) / 2, last);
+    }
+
+    uint16_t const keys[N]; /**< Number of keys of every bucket. */
+
+private:
+    template <size_t... B>
+    constexpr DatabaseDefaultsCounts(DatabaseDefaultsSpread<N> const &spread, DatabaseIndexSequence<B...>)
+        : keys{static_cast<uint16_t>(spread.keysIn(B, 0, N))...}
+    {
+    }
+};
+
+/**
+ * @brief Layout stage: the buckets, with their slots and the seeds placing their keys.
+ */
+template <size_t N>
+class DatabaseDefaultsPlan
+{
+public:
+    constexpr DatabaseDefaultsPlan(DatabaseDefault const *const entries, DatabaseDefaultsSpread<N> const &spread)
+        : DatabaseDefaultsPlan(entries, spread, DatabaseDefaultsCounts<N>(spread), typename DatabaseMakeIndexSequence<N>::type())
+    {
+    }
+
+    /**
+     * @brief Returns the first seed, from seed on, whose buckets fit in DatabaseDefaultsHash::slotCount(N) slots.
+     */
+    static constexpr uint32_t firstSeed(DatabaseDefault const *const entries, uint32_t const seed)
+    {
+        return DatabaseDefaultsCounts<N>(DatabaseDefaultsSpread<N>(entries, seed)).slots(0, N) <= DatabaseDefaultsHash::slotCount(N)
+                   ? seed
+                   : firstSeed(entries, seed + 1);
+    }
+
+    DatabaseDefaultsBucket const buckets[N]; /**< The buckets. */
+
+private:
+    template <size_t... B>
+    constexpr DatabaseDefaultsPlan(
+        DatabaseDefault const *const entries, DatabaseDefaultsSpread<N> const &spread,
+        DatabaseDefaultsCounts<N> const &counts, DatabaseIndexSequence<B...>)
+        : buckets{DatabaseDefaultsBucket{
+              static_cast<uint16_t>(counts.slots(0, B)),
+              static_cast<uint16_t>(counts.slots(B, B + 1)),
+              static_cast<uint16_t>(bucketSeed(entries, spread, B, counts.slots(B, B + 1), 1))}...}
+    {
+    }
+
+    // First seed, from candidate on, placing the keys of a bucket of size slots in distinct slots
+    static constexpr uint32_t bucketSeed(
+        DatabaseDefault const *const entries, DatabaseDefaultsSpread<N> const &spread, size_t const bucket,
+        size_t const size, uint32_t const candidate)
+    {
+        return size <= 1 ? 0
+               : collides(entries, spread, bucket, size, candidate, 0, N)
+                   ? bucketSeed(entries, spread, bucket, size, candidate + 1)
+                   : candidate;
+    }
+
+    // true if two keys of the bucket, the first one from first to last - 1, share a slot
+    static constexpr bool collides(
+        DatabaseDefault const *const entries, DatabaseDefaultsSpread<N> const &spread, size_t const bucket,
+        size_t const size, uint32_t const candidate, size_t const first, size_t const last)
+    {
+        return last - first == 0   ? false
+               : last - first == 1 ? spread.bucketOf[first] == bucket &&
+                                       sharesSlot(entries, spread, bucket, size, candidate,
+                                                  DatabaseDefaultsHash::hash(entries[first].key, candidate) % size, first + 1, N)
+                                   : collides(entries, spread, bucket, size, candidate, first, first + (last - first) / 2) ||
+                                         collides(entries, spread, bucket, size, candidate, first + (last - first) / 2, last);
+    }
+
+    // true if a key of the bucket, from first to last - 1, lands in slot
+    static constexpr bool sharesSlot(
+        DatabaseDefault const *const entries, DatabaseDefaultsSpread<N> const &spread, size_t const bucket,
+        size_t const size, uint32_t const candidate, size_t const slot, size_t const first, size_t const last)
+    {
+        return last - first == 0   ? false
+               : last - first == 1 ? spread.bucketOf[first] == bucket &&
+                                       DatabaseDefaultsHash::hash(entries[first].key, candidate) % size == slot
+                                   : sharesSlot(entries, spread, bucket, size, candidate, slot, first, first + (last - first) / 2) ||
+                                         sharesSlot(entries, spread, bucket, size, candidate, slot, first + (last - first) / 2, last);
+    }
+};
+
+/**
+ * @brief Layout stage: the slot of every key.
+ */
+template <size_t N>
+class DatabaseDefaultsPlaces
+{
+public:
+    constexpr DatabaseDefaultsPlaces(
+        DatabaseDefault const *const entries, DatabaseDefaultsSpread<N> const &spread, DatabaseDefaultsPlan<N> const &plan)
+        : DatabaseDefaultsPlaces(entries, spread, plan, typename DatabaseMakeIndexSequence<N>::type())
+    {
+    }
+
+    /**
+     * @brief Returns the index of the key placed in slot, among the keys from first to last - 1.
+     *
+     * @return The index of the key, or DATABASE_DEFAULTS_EMPTY_SLOT.
+     */
+    constexpr uint16_t keyOf(size_t const slot, size_t const first, size_t const last) const
+    {
+        return last - first == 0   ? DATABASE_DEFAULTS_EMPTY_SLOT
+               : last - first == 1 ? (slotOf[first] == slot ? static_cast<uint16_t>(first) : DATABASE_DEFAULTS_EMPTY_SLOT)
+                                   : either(keyOf(slot, first, first + (last - first) / 2), keyOf(slot, first + (last - first) / 2, last));
+    }
+
+    uint16_t const slotOf[N]; /**< Slot of every key. */
+
+private:
+    template <size_t... I>
+    constexpr DatabaseDefaultsPlaces(
+        DatabaseDefault const *const entries, DatabaseDefaultsSpread<N> const &spread,
+        DatabaseDefaultsPlan<N> const &plan, DatabaseIndexSequence<I...>)
+        : slotOf{static_cast<uint16_t>(
+              plan.buckets[spread.bucketOf[I]].offset +
+              DatabaseDefaultsHash::hash(entries[I].key, plan.buckets[spread.bucketOf[I]].seed) % plan.buckets[spread.bucketOf[I]].size)...}
+    {
+    }
+
+    static constexpr uint16_t either(uint16_t const first, uint16_t const second)
+    {
+        return first != DATABASE_DEFAULTS_EMPTY_SLOT ? first : second;
+    }
+};
+
+class DatabaseDefaultsTable;
+
+/**
+ * @brief Table of compiled-in default values, laid out by the compiler from a single list.
+ *
+ * Keys are placed by two-level perfect hashing: a first seed spreads the N keys over N
+ * buckets, and each bucket of k keys gets k * k slots and a seed of its own placing them
+ * in distinct slots. The first seed is the first one keeping the slots within 3 * N.
+ * The list and the table live in read-only memory:
+ * @code
+ * static constexpr DatabaseDefault FACTORY_DEFAULTS[] = {{"ssid", "office"}, {"mode", "auto"}};
+ * static constexpr DatabaseDefaults<2> factoryDefaults = makeDatabaseDefaults(FACTORY_DEFAULTS);
+ * @endcode
+ * Keys must be distinct. Lookups go through DatabaseDefaultsTable.
+ *
+ * @tparam N The number of defaults.
+ */
+template <size_t N>
+class DatabaseDefaults
+{
+public:
+    /**
+     * @brief Constructor for DatabaseDefaults, hashes the keys of the list.
+     *
+     * @param entries The list of defaults, which must have static storage duration.
+     */
+    constexpr explicit DatabaseDefaults(DatabaseDefault const (&entries)[N])
+        : DatabaseDefaults(entries, DatabaseDefaultsSpread<N>(entries, DatabaseDefaultsPlan<N>::firstSeed(entries, 0)))
+    {
+    }
+
+private:
+    friend class DatabaseDefaultsTable;
+
+    DatabaseDefault const *const _entries;    /**< The list of defaults. */
+    uint32_t const _seed;                     /**< Seed spreading the keys over the buckets. */
+    DatabaseDefaultsBucket const _buckets[N]; /**< The buckets, one per key. */
+    uint16_t const _slots[3 * N];             /**< Index of the key of every slot, or DATABASE_DEFAULTS_EMPTY_SLOT. */
+
+    constexpr DatabaseDefaults(DatabaseDefault const (&entries)[N], DatabaseDefaultsSpread<N> const &spread)
+        : DatabaseDefaults(entries, spread, DatabaseDefaultsPlan<N>(entries, spread))
+    {
+    }
+
+    constexpr DatabaseDefaults(
+        DatabaseDefault const (&entries)[N], DatabaseDefaultsSpread<N> const &spread, DatabaseDefaultsPlan<N> const &plan)
+        : DatabaseDefaults(entries, spread, plan, DatabaseDefaultsPlaces<N>(entries, spread, plan),
+                           typename DatabaseMakeIndexSequence<N>::type(),
+                           typename DatabaseMakeIndexSequence<3 * N>::type())
+    {
+    }
+
+    template <size_t... Bucket, size_t... Slot>
+    constexpr DatabaseDefaults(
+        DatabaseDefault const (&entries)[N], DatabaseDefaultsSpread<N> const &spread, DatabaseDefaultsPlan<N> const &plan,
+        DatabaseDefaultsPlaces<N> const &places, DatabaseIndexSequence<Bucket...>, DatabaseIndexSequence<Slot...>)
+        : _entries(entries), _seed(spread.seed),
+          _buckets{plan.buckets[Bucket]...},
+          _slots{places.keyOf(Slot, 0, N)...}
+    {
+    }
+};
+
+/**
+ * @brief Builds the defaults table of a list, deducing its length.
+ *
+ * @param entries The list of defaults, which must have static storage duration.
+ * @return The table.
+ */
+template <size_t N>
+constexpr DatabaseDefaults<N> makeDatabaseDefaults(DatabaseDefault const (&entries)[N])
+{
+    return DatabaseDefaults<N>(entries);
+}
+
+/**
+ * @brief Lookups into a DatabaseDefaults of any length.
+ *
+ * A lookup hashes the key twice and compares it with a single candidate; nothing is
+ * allocated and the table is not copied.
+ */
+class DatabaseDefaultsTable
+{
+public:
+    /**
+     * @brief Constructor for an empty DatabaseDefaultsTable.
+     */
+    DatabaseDefaultsTable();
+
+    /**
+     * @brief Constructor for DatabaseDefaultsTable, viewing a table which must outlive it.
+     *
+     * @param defaults The table.
+     */
+    template <size_t N>
+    DatabaseDefaultsTable(DatabaseDefaults<N> const &defaults)
+        : _entries(defaults._entries), _count(N), _seed(defaults._seed),
+          _buckets(defaults._buckets), _slots(defaults._slots)
+    {
+    }
+
+    /**
+     * @brief Finds the default of a key.
+     *
+     * @param key The key.
+     * @param out_index Pointer to receive the index of the default in the list.
+     * @return true if the key has a default, false otherwise.
+     */
+    bool find(char const *const key, size_t *out_index) const;
+
+    /**
+     * @brief Returns the default at an index of the list.
+     */
+    DatabaseDefault const &at(size_t const index) const;
+
+    /**
+     * @brief Returns the number of defaults.
+     */
+    size_t count() const;
+
+private:
+    DatabaseDefault const *_entries;        /**< The list of defaults, nullptr while empty. */
+    size_t _count;                          /**< Number of defaults. */
+    uint32_t _seed;                         /**< Seed spreading the keys over the buckets. */
+    DatabaseDefaultsBucket const *_buckets; /**< The buckets, one per key. */
+    uint16_t const *_slots;                 /**< Index of the key of every slot. */
+};
+
+#endif // DATABASE_DEFAULTS_H
@@ -0,0 +1,112 @@
+#ifndef DATABASE_EXPIRY_H
+#define DATABASE_EXPIRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "NVSDelegateInterface.hpp"
+
+/**
+ * @brief Returns the current time in seconds, used to expire keys.
+ */
+typedef uint32_t (*DatabaseClock_t)();
+
+/**
+ * @brief In-RAM table of the keys of a DatabaseAPI that expire, with their expiry time.
+ *
+ * The table is persisted as one blob of packed records: the expiry time as 4 little-endian
+ * bytes followed by the null-terminated key. It grows on demand and is not synchronized;
+ * its owner serializes access.
+ */
+class DatabaseExpiry
+{
+public:
+    /**
+     * @brief One key and the time it expires at.
+     */
+    struct Expiry
+    {
+        char key[NVS_DELEGATE_MAX_KEY_LENGTH]; /**< Null-terminated key. */
+        uint32_t expiresAt;                    /**< Time in seconds from which the key is expired. */
+    };
+
+    /**
+     * @brief Constructor for DatabaseExpiry, no memory is allocated until an expiry is set.
+     */
+    DatabaseExpiry();
+
+    /**
+     * @brief Destructor for DatabaseExpiry, frees the table.
+     */
+    ~DatabaseExpiry();
+
+    /**
+     * @brief Finds the expiry of a key.
+     *
+     * @param key The key.
+     * @return The expiry, or nullptr if the key does not expire.
+     */
+    Expiry const *find(char const *const key) const;
+
+    /**
+     * @brief Sets the expiry time of a key, adding it to the table if needed.
+     *
+     * @param key The key.
+     * @param expiresAt Time in seconds from which the key is expired.
+     * @return true on success, false if the table cannot grow.
+     */
+    bool set(char const *const key, uint32_t const expiresAt);
+
+    /**
+     * @brief Removes a key from the table, if present.
+     *
+     * @param key The key.
+     */
+    void remove(char const *const key);
+
+    /**
+     * @brief Removes every key and frees the table.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of keys in the table.
+     */
+    size_t count() const;
+
+    /**
+     * @brief Returns the expiry at the given position, below count().
+     */
+    Expiry const &at(size_t const index) const;
+
+    /**
+     * @brief Returns the number of bytes written by serialize().
+     */
+    size_t serializedLength() const;
+
+    /**
+     * @brief Writes the packed records of the table.
+     *
+     * @param out Buffer of serializedLength() bytes.
+     */
+    void serialize(uint8_t *out) const;
+
+    /**
+     * @brief Replaces the table with the packed records read from a blob.
+     *
+     * @param data The packed records.
+     * @param length The number of bytes of data.
+     * @return true on success, false if the records are malformed or the table cannot grow.
+     */
+    bool deserialize(uint8_t const *const data, size_t const length);
+
+    DatabaseExpiry(DatabaseExpiry const &) = delete;
+    DatabaseExpiry &operator=(DatabaseExpiry const &) = delete;
+
+private:
+    Expiry *_expiries; /**< Table of expiries, nullptr while empty. */
+    size_t _count;     /**< Number of keys in the table. */
+    size_t _capacity;  /**< Number of keys the table can hold. */
+};
+
+#endif // DATABASE_EXPIRY_H
@@ -0,0 +1,83 @@
+#ifndef DATABASE_FINGERPRINTS_H
+#define DATABASE_FINGERPRINTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "NVSDelegateInterface.hpp"
+
+/**
+ * @brief In-RAM table of the fingerprints of the values a DatabaseAPI has stored.
+ *
+ * A fingerprint is the hash and the length of a value, enough to tell that a write
+ * would store what is already there without reading the flash. The table grows on
+ * demand and is not synchronized; its owner serializes access.
+ */
+class DatabaseFingerprints
+{
+public:
+    /**
+     * @brief One key and the fingerprint of its stored value.
+     */
+    struct Fingerprint
+    {
+        char key[NVS_DELEGATE_MAX_KEY_LENGTH]; /**< Null-terminated key. */
+        uint32_t hash;                         /**< Hash of the value. */
+        uint16_t length;                       /**< Length of the value, without the null terminator. */
+    };
+
+    /**
+     * @brief Constructor for DatabaseFingerprints, no memory is allocated until a fingerprint is set.
+     */
+    DatabaseFingerprints();
+
+    /**
+     * @brief Destructor for DatabaseFingerprints, frees the table.
+     */
+    ~DatabaseFingerprints();
+
+    /**
+     * @brief Finds the fingerprint of a key.
+     *
+     * @param key The key.
+     * @return The fingerprint, or nullptr if it is not in the table.
+     */
+    Fingerprint const *find(char const *const key) const;
+
+    /**
+     * @brief Adds or updates the fingerprint of a key.
+     *
+     * @param key The key.
+     * @param hash The hash of the value.
+     * @param length The length of the value, without the null terminator.
+     * @return true if the fingerprint is stored, false if the table cannot grow.
+     */
+    bool set(char const *const key, uint32_t const hash, size_t const length);
+
+    /**
+     * @brief Removes the fingerprint of a key, if present.
+     *
+     * @param key The key.
+     */
+    void remove(char const *const key);
+
+    /**
+     * @brief Removes every fingerprint and frees the table.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of fingerprints in the table.
+     */
+    size_t count() const;
+
+    DatabaseFingerprints(DatabaseFingerprints const &) = delete;
+    DatabaseFingerprints &operator=(DatabaseFingerprints const &) = delete;
+
+private:
+    Fingerprint *_fingerprints; /**< Table of fingerprints, nullptr while empty. */
+    size_t _count;              /**< Number of fingerprints in the table. */
+    size_t _capacity;           /**< Number of fingerprints the table can hold. */
+};
+
+#endif // DATABASE_FINGERPRINTS_H
@@ -0,0 +1,34 @@
+#ifndef DATABASE_HASH_H
+#define DATABASE_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 32-bit FNV-1a hash, used for keys, namespaces and value versions.
+ *
+ * Fast on short strings and well spread in its low bits, but not collision resistant:
+ * callers that key storage on it must handle two inputs sharing a hash.
+ */
+class DatabaseHash
+{
+public:
+    /**
+     * @brief Hashes a buffer.
+     *
+     * @param data The data to hash.
+     * @param length The length of the data.
+     * @return The FNV-1a hash of the data.
+     */
+    static uint32_t fnv1a(void const *const data, size_t const length);
+
+    /**
+     * @brief Hashes a null-terminated string, without its terminator.
+     *
+     * @param string The string to hash.
+     * @return The FNV-1a hash of the string.
+     */
+    static uint32_t fnv1a(char const *const string);
+};
+
+#endif // DATABASE_HASH_H
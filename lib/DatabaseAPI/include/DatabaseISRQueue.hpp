@@ -0,0 +1,134 @@
+#ifndef DATABASE_ISR_QUEUE_H
+#define DATABASE_ISR_QUEUE_H
+
+#include <atomic>
+#include <esp_attr.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <MultiPrinterLoggerInterface.hpp>
+
+#include "DatabaseAPIInterface.hpp"
+#include "DatabaseMutex.hpp"
+#include "NVSDelegateInterface.hpp"
+
+#define DATABASE_ISR_QUEUE_MAX_VALUE_LENGTH 32
+
+/**
+ * @brief Wait-free single-producer queue for recording values from interrupt handlers.
+ *
+ * The producer (an ISR) copies key/value pairs into fixed-size slots that are
+ * preallocated at construction. A consumer task drains the slots into the
+ * database, writing only the newest value of every key found in the queue.
+ */
+class DatabaseISRQueue
+{
+public:
+    /**
+     * @brief Constructor for DatabaseISRQueue.
+     *
+     * @param database Pointer to the database that receives the drained values.
+     * @param capacity Number of slots preallocated for pending values.
+     * @param logger Pointer to the MultiPrinterLoggerInterface instance.
+     */
+    DatabaseISRQueue(
+        DatabaseAPIInterface *const database, size_t const capacity,
+        MultiPrinterLoggerInterface *const logger = nullptr);
+
+    /**
+     * @brief Destructor for DatabaseISRQueue, stops the drain task and flushes pending values.
+     */
+    ~DatabaseISRQueue();
+
+    /**
+     * @brief Queues a value for the specified key. Safe to call from an ISR.
+     *
+     * Only one producer may call this method at a time. It never blocks, never
+     * allocates and never logs.
+     *
+     * @param key The key for the value.
+     * @param value The value to set, shorter than DATABASE_ISR_QUEUE_MAX_VALUE_LENGTH.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Value queued.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_VALUE_INVALID: Invalid value.
+     *         - DATABASE_NOT_ENOUGH_SPACE: All slots are pending, the value was dropped.
+     */
+    DatabaseError_t IRAM_ATTR enqueueFromISR(char const *const key, char const *const value);
+
+    /**
+     * @brief Writes every pending value to the database, coalescing values by key.
+     *
+     * @param appliedCount Optional pointer to receive the number of values written.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: All pending values were written.
+     *         - Otherwise the last error returned by the database; the failed values are discarded.
+     */
+    DatabaseError_t drain(size_t *appliedCount = nullptr);
+
+    /**
+     * @brief Starts a background task that drains the queue periodically.
+     *
+     * @param periodMs Delay between two drains, in milliseconds.
+     * @param stackSize Stack size of the task, in bytes.
+     * @param priority FreeRTOS priority of the task.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Task started, or already running.
+     *         - DATABASE_ERROR: The task could not be created.
+     */
+    DatabaseError_t startDrainTask(
+        uint32_t const periodMs = 100, uint32_t const stackSize = 4096,
+        UBaseType_t const priority = 1);
+
+    /**
+     * @brief Stops the background task after a final drain. Does nothing if no task is running.
+     */
+    void stopDrainTask();
+
+    /**
+     * @brief Returns the number of values dropped because the queue was full.
+     */
+    uint32_t droppedCount() const;
+
+private:
+    /**
+     * @brief Fixed-size storage for one queued value.
+     */
+    struct Slot
+    {
+        char key[NVS_DELEGATE_MAX_KEY_LENGTH];            /**< Null-terminated key. */
+        char value[DATABASE_ISR_QUEUE_MAX_VALUE_LENGTH]; /**< Null-terminated value. */
+    };
+
+    DatabaseAPIInterface *const _database;   /**< Pointer to the database receiving drained values. */
+    Slot *const _slots;                      /**< Preallocated slots. */
+    size_t const _capacity;                  /**< Number of slots, zero if the allocation failed. */
+    std::atomic<uint32_t> _head;             /**< Free-running count of enqueued values, written by the producer. */
+    std::atomic<uint32_t> _tail;             /**< Free-running count of drained values, written by the consumer. */
+    std::atomic<uint32_t> _dropped;          /**< Number of values dropped because the queue was full. */
+    DatabaseMutex _drainMutex;               /**< Serializes consumers. */
+    TaskHandle_t _drainTask;                 /**< Handle of the background drain task, if running. */
+    uint32_t _drainPeriodMs;                 /**< Delay between two drains of the background task. */
+    std::atomic<bool> _stopRequested;        /**< Asks the background task to exit. */
+    SemaphoreHandle_t _drainTaskStopped;     /**< Given by the background task when it exits. */
+    MultiPrinterLoggerInterface *const _logger; /**< Pointer to the MultiPrinterLoggerInterface instance. */
+
+    /**
+     * @brief Entry point of the background drain task.
+     *
+     * @param arg Pointer to the owning DatabaseISRQueue.
+     */
+    static void drainTaskEntry(void *arg);
+
+    /**
+     * @brief Copies a null-terminated string into a fixed-size buffer. Safe to call from an ISR.
+     *
+     * @param destination The buffer to copy into.
+     * @param source The string to copy.
+     * @param size The size of the destination buffer.
+     * @return true if the string is non-empty and fits with its terminator, false otherwise.
+     */
+    static bool IRAM_ATTR copyBounded(char *destination, char const *const source, size_t const size);
+};
+
+#endif // DATABASE_ISR_QUEUE_H
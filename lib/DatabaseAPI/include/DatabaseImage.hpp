@@ -0,0 +1,126 @@
+#ifndef DATABASE_IMAGE_H
+#define DATABASE_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "DatabaseAPIInterface.hpp"
+#include "DatabaseBatch.hpp"
+
+#define DATABASE_IMAGE_MAGIC "DBI" /**< First bytes of an image. */
+#define DATABASE_IMAGE_VERSION 1   /**< Version of the image format written. */
+
+/**
+ * @brief Writes bytes of an image, e.g. to a file or a serial port.
+ *
+ * @param data The bytes to write.
+ * @param length The number of bytes.
+ * @param context The context pointer given along with the writer.
+ * @return true if every byte was written, false to abort.
+ */
+typedef bool (*DatabaseImageWriter_t)(uint8_t const *const data, size_t const length, void *context);
+
+/**
+ * @brief Reads bytes of an image, e.g. from a file or a serial port.
+ *
+ * @param data Buffer to receive the bytes.
+ * @param length The exact number of bytes to read.
+ * @param context The context pointer given along with the reader.
+ * @return true if length bytes were read, false at the end of the input or on failure.
+ */
+typedef bool (*DatabaseImageReader_t)(uint8_t *data, size_t const length, void *context);
+
+/**
+ * @brief Compact, versioned and CRC-checked binary image of the string values of a namespace.
+ *
+ * All integers are little-endian. The image is the 3 bytes of DATABASE_IMAGE_MAGIC and
+ * a version byte; then, for each value, the key length on 1 byte, the key, the value length
+ * on 2 bytes and the value, both without terminator; then a 0 byte, the number of values on
+ * 2 bytes and the CRC-32 (IEEE, as zlib) of all the preceding bytes on 4 bytes. The image
+ * is streamed: an instance writes one image, read() parses one into a batch.
+ * tools/database_image.py builds and inspects images on the host.
+ */
+class DatabaseImage
+{
+public:
+    /**
+     * @brief Constructor for DatabaseImage, writing an image through the given writer.
+     *
+     * @param writer The writer receiving the bytes.
+     * @param context The context pointer passed to the writer.
+     */
+    DatabaseImage(DatabaseImageWriter_t const writer, void *const context);
+
+    /**
+     * @brief Writes the header. Must be called first.
+     *
+     * @return true if written, false if the writer failed.
+     */
+    bool begin();
+
+    /**
+     * @brief Writes one value.
+     *
+     * @param key The key, shorter than NVS_DELEGATE_MAX_KEY_LENGTH.
+     * @param value The value, shorter than NVS_DELEGATE_MAX_VALUE_LENGTH.
+     * @return true if written, false if the writer failed or the entry does not fit the format.
+     */
+    bool add(char const *const key, char const *const value);
+
+    /**
+     * @brief Writes the trailer. Must be called last.
+     *
+     * @return true if written, false if the writer failed.
+     */
+    bool end();
+
+    /**
+     * @brief Returns the number of values written.
+     */
+    size_t count() const;
+
+    /**
+     * @brief Reads a whole image and stages its values as set operations, checking the CRC.
+     *
+     * @param reader The reader providing the bytes.
+     * @param context The context pointer passed to the reader.
+     * @param batch The batch receiving the values, left empty on failure.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: The image is well formed and every value is staged.
+     *         - DATABASE_KEY_INVALID: A key of the image is invalid or reserved.
+     *         - DATABASE_VALUE_INVALID: The image is truncated, malformed, of another version,
+     *           or does not match its CRC.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap to stage the values.
+     */
+    static DatabaseError_t read(DatabaseImageReader_t const reader, void *const context, DatabaseBatch *const batch);
+
+    /**
+     * @brief Continues a CRC-32 (IEEE, as zlib) over more bytes.
+     *
+     * @param crc The CRC of the previous bytes, 0 to start.
+     * @param data The bytes.
+     * @param length The number of bytes.
+     * @return The CRC of all the bytes.
+     */
+    static uint32_t crc32(uint32_t const crc, uint8_t const *const data, size_t const length);
+
+    DatabaseImage(DatabaseImage const &) = delete;
+    DatabaseImage &operator=(DatabaseImage const &) = delete;
+
+private:
+    DatabaseImageWriter_t const _writer; /**< Writer receiving the bytes. */
+    void *const _context;                /**< Context pointer passed to the writer. */
+    uint32_t _crc;                       /**< CRC of the bytes written so far. */
+    size_t _count;                       /**< Number of values written. */
+
+    /**
+     * @brief Writes bytes and adds them to the CRC.
+     *
+     * @param data The bytes.
+     * @param length The number of bytes.
+     * @return true if written, false if the writer failed.
+     */
+    bool write(uint8_t const *const data, size_t const length);
+};
+
+#endif // DATABASE_IMAGE_H
@@ -0,0 +1,76 @@
+#ifndef DATABASE_JOB_H
+#define DATABASE_JOB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "DatabaseAPIInterface.hpp"
+#include "DatabaseBatch.hpp"
+
+class DatabaseAPI;
+
+/**
+ * @brief A long DatabaseAPI operation run in bounded slices, for cooperative loop() scheduling.
+ *
+ * DatabaseAPI::startEraseAll, startCommit and startImport prepare the job, without writing;
+ * then every call to step() writes keys one at a time until its time budget is spent, and
+ * always at least one, so a step lasts at most its budget plus a single-key write. Other
+ * writes may run between two steps, and a reset in between leaves the keys written so far.
+ * The job is not synchronized: start and step it from one task.
+ */
+class DatabaseJob
+{
+public:
+    /**
+     * @brief Constructor for DatabaseJob, done with nothing to do.
+     */
+    DatabaseJob();
+
+    /**
+     * @brief Runs the job for about budgetUs microseconds.
+     *
+     * @param budgetUs Time after which no further key is written, 0 to write a single key.
+     * @return DatabaseError_t indicating the success or failure of the step.
+     *         - DATABASE_OK: The step succeeded, or the job was already done.
+     *         - Any error of DatabaseAPI::set, remove or eraseAll: The job stopped with it, see result().
+     */
+    DatabaseError_t step(uint32_t const budgetUs);
+
+    /**
+     * @brief Checks if the job is over, completed or stopped by an error.
+     */
+    bool isDone() const;
+
+    /**
+     * @brief Returns the result of the job, DATABASE_OK while it runs.
+     */
+    DatabaseError_t result() const;
+
+    /**
+     * @brief Returns the number of keys left to write.
+     */
+    size_t remaining() const;
+
+    DatabaseJob(DatabaseJob const &) = delete;
+    DatabaseJob &operator=(DatabaseJob const &) = delete;
+
+private:
+    friend class DatabaseAPI;
+
+    DatabaseAPI *_database;  /**< The database written, nullptr before the first start. */
+    DatabaseBatch _batch;    /**< The keys to write or remove, in order. */
+    size_t _next;            /**< Index of the next operation of _batch. */
+    bool _eraseAll;          /**< true to erase the namespace once _batch is applied. */
+    bool _done;              /**< true once the job is over. */
+    DatabaseError_t _result; /**< The result of the job. */
+
+    /**
+     * @brief Prepares the job to apply its batch, called by DatabaseAPI once the batch is staged.
+     *
+     * @param database The database to write.
+     * @param eraseAll true to erase the namespace after the batch, clearing what is left of it.
+     */
+    void start(DatabaseAPI *const database, bool const eraseAll);
+};
+
+#endif // DATABASE_JOB_H
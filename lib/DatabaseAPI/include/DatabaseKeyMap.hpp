@@ -0,0 +1,222 @@
+#ifndef DATABASE_KEY_MAP_H
+#define DATABASE_KEY_MAP_H
+
+#include <MultiPrinterLoggerInterface.hpp>
+#include <stdint.h>
+
+#include "DatabaseAPI.hpp"
+#include "DatabasePrefixedStore.hpp"
+
+#define DATABASE_KEY_MAP_MAX_KEY_LENGTH 64    /**< Size of the longest key, terminator included. */
+#define DATABASE_KEY_MAP_MAX_SLOTS 10         /**< Keys sharing one hash at most, numbering their extra slots with 1 digit. */
+#define DATABASE_KEY_MAP_MAX_COLLISIONS 32    /**< Keys stored in an extra slot at most, listed in the collision table. */
+#define DATABASE_KEY_MAP_TABLE_SUFFIX "~col"  /**< Suffix of the key holding the collision table, after the prefix. */
+
+/**
+ * @brief Visitor of the keys and values listed by DatabaseKeyMap::forEach.
+ *
+ * @param key The original key.
+ * @param value The value.
+ * @param context The context given to forEach.
+ * @return true to continue with the next key, false to stop.
+ */
+typedef bool (*DatabaseKeyMapVisitor_t)(char const *const key, char const *const value, void *context);
+
+/**
+ * @brief Stores values under keys longer than NVS allows, e.g. "wifi/backup/2/password".
+ *
+ * A key is stored under the prefix followed by the 8 hex digits of its FNV-1a hash, as
+ * "<length>:<key><value>". The original key kept in front of the value lets get check that
+ * the record is its own, in the single read of the value, and lets forEach list the keys.
+ * A key whose hash slot holds another key goes to an extra slot, the hash key followed by
+ * one digit, and is listed in the collision table stored under the prefix followed by
+ * DATABASE_KEY_MAP_TABLE_SUFFIX. The table is read by begin() and kept in RAM, so a key
+ * without collision is read from flash once, as any DatabaseAPI key.
+ */
+class DatabaseKeyMap : public DatabasePrefixedStore
+{
+public:
+    /**
+     * @brief Constructor for DatabaseKeyMap. Nothing is read until begin().
+     *
+     * @param database Pointer to the DatabaseAPI storing the values.
+     * @param prefix The prefix of the hashed keys, at most 6 characters, used by no other key.
+     * @param maxValueLength The length of the longest value.
+     * @param logger Pointer to the logger interface.
+     */
+    DatabaseKeyMap(
+        DatabaseAPI *const database, char const *const prefix = "#", size_t const maxValueLength = 256,
+        MultiPrinterLoggerInterface *const logger = nullptr);
+
+    /**
+     * @brief Destructor for DatabaseKeyMap. Every value is already stored.
+     */
+    ~DatabaseKeyMap();
+
+    /**
+     * @brief Reads the collision table.
+     *
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful, also for a map never written.
+     *         - DATABASE_KEY_INVALID: Invalid prefix.
+     *         - DATABASE_VALUE_INVALID: Invalid value length.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap for the buffers.
+     *         - DATABASE_ERROR: The collision table is corrupted, or general database error.
+     */
+    DatabaseError_t begin();
+
+    /**
+     * @brief Retrieves the value of a key.
+     *
+     * @param key The key, shorter than DATABASE_KEY_MAP_MAX_KEY_LENGTH.
+     * @param value Buffer to receive the value.
+     * @param maxValueLength The size of the buffer.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_VALUE_INVALID: Invalid buffer, or buffer too small.
+     *         - DATABASE_KEY_NOT_FOUND: Key not found.
+     *         - DATABASE_ERROR: begin() did not succeed, or general database error.
+     */
+    DatabaseError_t get(char const *const key, char *value, size_t const maxValueLength) const;
+
+    /**
+     * @brief Sets the value of a key.
+     *
+     * A key colliding with a stored one is written together with the collision table,
+     * under one atomic commit.
+     *
+     * @param key The key, shorter than DATABASE_KEY_MAP_MAX_KEY_LENGTH.
+     * @param value The value, at most maxValueLength characters.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_VALUE_INVALID: Invalid or too long value.
+     *         - DATABASE_NOT_ENOUGH_SPACE: No slot or table entry is left for a colliding key, or no storage is left.
+     *         - DATABASE_ERROR: begin() did not succeed, or general database error.
+     */
+    DatabaseError_t set(char const *const key, char const *const value);
+
+    /**
+     * @brief Removes a key.
+     *
+     * @param key The key.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_KEY_NOT_FOUND: Key not found.
+     *         - DATABASE_ERROR: begin() did not succeed, or general database error.
+     */
+    DatabaseError_t remove(char const *const key);
+
+    /**
+     * @brief Checks if a key exists.
+     *
+     * @param key The key.
+     * @return DatabaseError_t as get, DATABASE_OK if the key exists.
+     */
+    DatabaseError_t isExist(char const *const key) const;
+
+    /**
+     * @brief Lists the keys and values of the map, in no particular order.
+     *
+     * @param visitor The visitor. It must not use the map.
+     * @param context Pointer passed unchanged to the visitor.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_VALUE_INVALID: Invalid visitor.
+     *         - DATABASE_ERROR: begin() did not succeed, or general database error.
+     */
+    DatabaseError_t forEach(DatabaseKeyMapVisitor_t const visitor, void *const context) const;
+
+    /**
+     * @brief Returns the number of keys stored in an extra slot.
+     */
+    size_t collisions() const;
+
+    DatabaseKeyMap(DatabaseKeyMap const &) = delete;
+    DatabaseKeyMap &operator=(DatabaseKeyMap const &) = delete;
+
+private:
+    /**
+     * @brief Key stored in an extra slot of its hash.
+     */
+    struct Collision
+    {
+        uint32_t hash;                             /**< Hash of the key. */
+        uint8_t slot;                              /**< Extra slot, 1 to DATABASE_KEY_MAP_MAX_SLOTS - 1. */
+        char key[DATABASE_KEY_MAP_MAX_KEY_LENGTH]; /**< Null-terminated key. */
+    };
+
+    size_t const _maxValueLength;               /**< Length of the longest value. */
+    char *_text;                                /**< Text of a record or of the collision table, as stored. */
+    Collision *_collisions;                     /**< Collision table, DATABASE_KEY_MAP_MAX_COLLISIONS entries. */
+    size_t _collisionCount;                     /**< Entries used in the collision table. */
+
+    /**
+     * @brief Returns the length of the text buffer, enough for the longest record and the collision table.
+     */
+    size_t textLength() const;
+
+    /**
+     * @brief Returns true if the key can be stored in the map.
+     */
+    static bool isKeyValid(char const *const key);
+
+    /**
+     * @brief Writes the NVS key of a slot into out_key, slot 0 being the hash key itself.
+     */
+    void slotKey(uint32_t const hash, uint8_t const slot, char *out_key) const;
+
+    /**
+     * @brief Returns the collision table entry of a key, nullptr if it is stored in its hash slot.
+     */
+    Collision const *findCollision(char const *const key, uint32_t const hash) const;
+
+    /**
+     * @brief Reads the record of a slot into _text.
+     *
+     * @param nvsKey The NVS key of the slot.
+     * @param out_key Pointer to receive the original key, inside _text and followed by the value.
+     * @param out_keyLength Pointer to receive the length of the original key.
+     * @return DatabaseError_t of the read, DATABASE_KEY_NOT_FOUND if the slot holds no record.
+     */
+    DatabaseError_t load(char const *const nvsKey, char const **out_key, size_t *out_keyLength) const;
+
+    /**
+     * @brief Finds the slot of a key, reading its hash slot unless the key is in the collision table.
+     *
+     * @param key The key.
+     * @param out_nvsKey Buffer of NVS_DELEGATE_MAX_KEY_LENGTH bytes to receive the NVS key of the slot.
+     * @param out_value Optional pointer to receive the value, inside _text, nullptr if the key is not stored.
+     * @return DatabaseError_t of the read, DATABASE_KEY_NOT_FOUND if the key is not stored.
+     */
+    DatabaseError_t locate(char const *const key, char *out_nvsKey, char const **out_value) const;
+
+    /**
+     * @brief Writes the collision table into _text.
+     */
+    void encodeTable() const;
+
+    /**
+     * @brief Parses the collision table held in _text.
+     *
+     * @return true if the table is valid.
+     */
+    bool decodeTable();
+
+    /**
+     * @brief Stages writing the collision table in a batch, or removing it once empty.
+     *
+     * @param batch The batch.
+     * @return DatabaseError_t of the staging.
+     */
+    DatabaseError_t stageTable(DatabaseBatch &batch) const;
+
+    /**
+     * @brief NVS key visitor handing the records of the map to a forEach visitor.
+     */
+    static bool visitRecord(char const *const nvsKey, void *context);
+};
+
+#endif // DATABASE_KEY_MAP_H
@@ -0,0 +1,43 @@
+#ifndef DATABASE_LZ4_H
+#define DATABASE_LZ4_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DATABASE_LZ4_HASH_BITS 10 /**< log2 of the match table size of the compressor, 2 bytes per slot. */
+
+/**
+ * @brief Compressor and decompressor for the LZ4 block format.
+ *
+ * A greedy single-pass compressor with a small heap table of recent positions, and a
+ * decompressor that checks every length and offset against both buffers, so corrupted
+ * input fails instead of overrunning. Inputs are limited to 64 KiB, positions being
+ * stored in 16 bits. Both are reentrant.
+ */
+class DatabaseLZ4
+{
+public:
+    /**
+     * @brief Compresses a buffer.
+     *
+     * @param source The data to compress, at most 65535 bytes.
+     * @param sourceLength The length of the data.
+     * @param destination Buffer to receive the compressed data.
+     * @param capacity The size of the destination buffer.
+     * @return The compressed length, or 0 if it does not fit the destination or the table cannot be allocated.
+     */
+    static size_t compress(uint8_t const *const source, size_t const sourceLength, uint8_t *const destination, size_t const capacity);
+
+    /**
+     * @brief Decompresses a buffer of known decompressed length.
+     *
+     * @param source The compressed data.
+     * @param sourceLength The length of the compressed data.
+     * @param destination Buffer to receive the data.
+     * @param length The decompressed length, exactly this many bytes are written.
+     * @return true if the data was well formed and decompressed to exactly length bytes.
+     */
+    static bool decompress(uint8_t const *const source, size_t const sourceLength, uint8_t *const destination, size_t const length);
+};
+
+#endif // DATABASE_LZ4_H
@@ -0,0 +1,75 @@
+#ifndef DATABASE_LATENCY_H
+#define DATABASE_LATENCY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Operations of a DatabaseAPI whose latency is tracked.
+ */
+enum DatabaseOperation_t : uint8_t
+{
+    DATABASE_OPERATION_SET,    /**< Writing and committing one value. */
+    DATABASE_OPERATION_REMOVE, /**< Erasing and committing one key. */
+    DATABASE_OPERATION_COUNT,  /**< Number of tracked operations. */
+};
+
+/**
+ * @brief Latency history of the flash writes of a DatabaseAPI, predicting the next one.
+ *
+ * Each operation keeps a smoothed latency and a smoothed deviation, as TCP estimates its
+ * retransmission timeout: the prediction is the smoothed latency plus four deviations.
+ * An NVS page garbage collection shows up as a spike that raises the deviation, so the
+ * predictions stay pessimistic for a while after one, and decay as normal writes follow.
+ * The history is not synchronized; its owner serializes access.
+ */
+class DatabaseLatency
+{
+public:
+    /**
+     * @brief Constructor for DatabaseLatency, with no history.
+     */
+    DatabaseLatency();
+
+    /**
+     * @brief Adds the latency of a completed operation to its history.
+     *
+     * @param operation The operation.
+     * @param latencyUs Its latency in microseconds.
+     */
+    void record(DatabaseOperation_t const operation, uint32_t const latencyUs);
+
+    /**
+     * @brief Returns the predicted latency of the next operation, 0 without history.
+     *
+     * @param operation The operation.
+     * @return The prediction in microseconds.
+     */
+    uint32_t predict(DatabaseOperation_t const operation) const;
+
+    /**
+     * @brief Returns the longest latency recorded for an operation.
+     */
+    uint32_t worst(DatabaseOperation_t const operation) const;
+
+    /**
+     * @brief Returns the number of latencies recorded for an operation.
+     */
+    uint32_t samples(DatabaseOperation_t const operation) const;
+
+private:
+    /**
+     * @brief The history of one operation, in microseconds.
+     */
+    struct History
+    {
+        uint32_t smoothed;  /**< Smoothed latency, times 8. */
+        uint32_t deviation; /**< Smoothed deviation, times 4. */
+        uint32_t worst;     /**< Longest latency recorded. */
+        uint32_t samples;   /**< Number of latencies recorded. */
+    };
+
+    History _history[DATABASE_OPERATION_COUNT]; /**< The history of each operation. */
+};
+
+#endif // DATABASE_LATENCY_H
@@ -0,0 +1,159 @@
+#ifndef DATABASE_MAINTENANCE_H
+#define DATABASE_MAINTENANCE_H
+
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <MultiPrinterLoggerInterface.hpp>
+
+#include "DatabaseAPI.hpp"
+#include "DatabaseMutex.hpp"
+
+#define DATABASE_MAINTENANCE_MIN_FREE_ENTRIES 126 /**< Default watermark, one NVS page of entries. */
+#define DATABASE_MAINTENANCE_IDLE_MS 1000         /**< Default time without writes after which the database is idle. */
+#define DATABASE_MAINTENANCE_SWEEP_KEYS 4         /**< Expired keys removed per step. */
+
+/**
+ * @brief Callback telling whether the application is idle enough for maintenance writes.
+ *
+ * @param database The database being maintained.
+ * @param context The context pointer passed to setIdleDetector.
+ * @return true if maintenance may write now.
+ */
+typedef bool (*DatabaseIdleDetector_t)(DatabaseAPI *const database, void *context);
+
+/**
+ * @brief Reclaims flash for a DatabaseAPI while it is idle, before a write has to.
+ *
+ * NVS garbage collects a page when a write finds no free entry, so the write that runs
+ * short of space pays for it. Each step run while the idle detector reports idle persists
+ * the pending counters, the hot keys whose writes would otherwise land on a later write or
+ * be lost on a crash. Once the free entries reported by DatabaseAPI::getSpaceStats drop
+ * below a watermark, it also does one bounded piece of work, in turn: erase the generation
+ * left behind by replaceAll, or remove a few expired keys. Any page collection these
+ * writes cause happens now. The idle detector defaults to no write requested for
+ * DATABASE_MAINTENANCE_IDLE_MS.
+ *
+ * Steps are run by calling step, e.g. from an idle loop, or by a background task.
+ */
+class DatabaseMaintenance
+{
+public:
+    /**
+     * @brief Constructor for DatabaseMaintenance.
+     *
+     * @param database Pointer to the database to maintain, which must outlive the maintenance.
+     * @param logger Pointer to the MultiPrinterLoggerInterface instance.
+     */
+    DatabaseMaintenance(DatabaseAPI *const database, MultiPrinterLoggerInterface *const logger = nullptr);
+
+    /**
+     * @brief Destructor for DatabaseMaintenance, stops the background task.
+     */
+    ~DatabaseMaintenance();
+
+    /**
+     * @brief Sets the number of free entries below which space is reclaimed.
+     *
+     * @param minFreeEntries The watermark, DATABASE_MAINTENANCE_MIN_FREE_ENTRIES by default.
+     */
+    void setWatermark(size_t const minFreeEntries);
+
+    /**
+     * @brief Sets the time without writes after which the default idle detector reports idle.
+     *
+     * @param idleMs The time in milliseconds, DATABASE_MAINTENANCE_IDLE_MS by default.
+     */
+    void setIdleTime(uint32_t const idleMs);
+
+    /**
+     * @brief Replaces the idle detector, e.g. with one watching the network or the CPU load.
+     *
+     * @param detector The detector, nullptr to restore the default one.
+     * @param context Pointer passed unchanged to the detector.
+     */
+    void setIdleDetector(DatabaseIdleDetector_t const detector, void *const context = nullptr);
+
+    /**
+     * @brief Returns true if the idle detector reports idle.
+     */
+    bool isIdle() const;
+
+    /**
+     * @brief Persists the pending counters if the database is idle, then runs one piece of
+     *        reclamation if it is also short of free entries.
+     *
+     * @param worked Optional pointer set to true if a piece of reclamation ran.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful, including when nothing had to run.
+     *         - Any error of flushCounters, getSpaceStats or of the reclamation run.
+     */
+    DatabaseError_t step(bool *worked = nullptr);
+
+    /**
+     * @brief Starts a background task that runs a step periodically.
+     *
+     * @param periodMs Delay between two steps, in milliseconds.
+     * @param stackSize Stack size of the task, in bytes.
+     * @param priority FreeRTOS priority of the task.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Task started, or already running.
+     *         - DATABASE_ERROR: The task could not be created.
+     */
+    DatabaseError_t start(
+        uint32_t const periodMs = 1000, uint32_t const stackSize = 4096,
+        UBaseType_t const priority = 1);
+
+    /**
+     * @brief Stops the background task, woken from its wait, once its current step is done.
+     *        Does nothing if no task is running.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the number of steps that ran a piece of reclamation.
+     */
+    uint32_t reclaimCount() const;
+
+private:
+    /**
+     * @brief Pieces of reclamation, run in turn.
+     */
+    enum Stage : uint8_t
+    {
+        STAGE_STALE_GENERATION, /**< Erase the generation left behind by replaceAll. */
+        STAGE_EXPIRED_KEYS,     /**< Remove expired keys, a few at a time. */
+        STAGE_COUNT,            /**< Number of stages. */
+    };
+
+    DatabaseAPI *const _database;           /**< Pointer to the database to maintain. */
+    std::atomic<size_t> _minFreeEntries;    /**< Free entries below which space is reclaimed. */
+    std::atomic<uint32_t> _idleMs;          /**< Time without writes the default idle detector waits for. */
+    DatabaseIdleDetector_t _detector;       /**< Custom idle detector, nullptr for the default one. */
+    void *_detectorContext;                 /**< Context of the custom idle detector. */
+    Stage _stage;                           /**< Next piece of reclamation to run. */
+    std::atomic<uint32_t> _reclaimCount;    /**< Number of steps that ran a piece of reclamation. */
+    DatabaseMutex _stepMutex;               /**< Serializes steps and guards the detector. */
+    TaskHandle_t _task;                     /**< Handle of the background task, if running. */
+    uint32_t _periodMs;                     /**< Delay between two steps of the background task. */
+    std::atomic<bool> _stopRequested;       /**< Asks the background task to exit. */
+    SemaphoreHandle_t _taskStopped;         /**< Given by the background task when it exits. */
+    MultiPrinterLoggerInterface *const _logger; /**< Pointer to the MultiPrinterLoggerInterface instance. */
+
+    /**
+     * @brief Runs the current stage and selects the next one.
+     *
+     * @return DatabaseError_t returned by the reclamation run.
+     */
+    DatabaseError_t runStage();
+
+    /**
+     * @brief Entry point of the background task.
+     *
+     * @param arg Pointer to the owning DatabaseMaintenance.
+     */
+    static void taskEntry(void *arg);
+};
+
+#endif // DATABASE_MAINTENANCE_H
@@ -0,0 +1,170 @@
+#ifndef DATABASE_MAPPED_IMAGE_H
+#define DATABASE_MAPPED_IMAGE_H
+
+#include <MultiPrinterLoggerInterface.hpp>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "DatabaseAPIInterface.hpp"
+#include "DatabaseMutex.hpp"
+
+class DatabaseMappedImage;
+
+/**
+ * @brief Read-only view of a value inside a DatabaseMappedImage, valid as long as the view lives.
+ *
+ * The view points straight into the mapped image: nothing is copied, and the value is not
+ * null-terminated. The image stays mapped while any view holds a value, so a view must not
+ * outlive its image object.
+ */
+class DatabaseMappedView
+{
+public:
+    /**
+     * @brief Constructor for DatabaseMappedView, holding no value.
+     */
+    DatabaseMappedView();
+
+    /**
+     * @brief Destructor for DatabaseMappedView, releases the value.
+     */
+    ~DatabaseMappedView();
+
+    /**
+     * @brief Returns the bytes of the value, nullptr if the view holds none.
+     */
+    char const *data() const;
+
+    /**
+     * @brief Returns the length of the value, 0 if the view holds none.
+     */
+    size_t length() const;
+
+    /**
+     * @brief Releases the value, letting the image be unmapped.
+     */
+    void release();
+
+    DatabaseMappedView(DatabaseMappedView const &) = delete;
+    DatabaseMappedView &operator=(DatabaseMappedView const &) = delete;
+
+private:
+    friend class DatabaseMappedImage;
+
+    DatabaseMappedImage const *_image; /**< The image holding the value, nullptr if none. */
+    char const *_data;                 /**< The bytes of the value in the image. */
+    size_t _length;                    /**< The length of the value. */
+};
+
+/**
+ * @brief Zero-copy read access to a DatabaseImage stored in a raw flash region.
+ *
+ * The image, as written by DatabaseImage or tools/database_image.py, is mapped into the
+ * address space once: on the device a data partition is mapped with esp_partition_mmap,
+ * on the host a file is mapped with mmap. begin() checks the image and its CRC, then get()
+ * returns views straight into the mapping, for read-mostly large values such as certificates
+ * or lookup tables that would otherwise be copied to RAM on every read. An image already in
+ * memory, e.g. embedded in the firmware, can be read the same way.
+ */
+class DatabaseMappedImage
+{
+public:
+    /**
+     * @brief Constructor for DatabaseMappedImage, reading a partition or a file. Nothing is mapped before begin().
+     *
+     * @param source The label of the data partition on the device, the path of the file on the host. Not copied.
+     * @param logger Pointer to the logger interface.
+     */
+    explicit DatabaseMappedImage(char const *const source, MultiPrinterLoggerInterface *const logger = nullptr);
+
+    /**
+     * @brief Constructor for DatabaseMappedImage, reading an image already in memory. It is not copied and must outlive the object.
+     *
+     * @param image The image.
+     * @param length The length of the region holding the image, which may be followed by unused bytes.
+     * @param logger Pointer to the logger interface.
+     */
+    DatabaseMappedImage(uint8_t const *const image, size_t const length, MultiPrinterLoggerInterface *const logger = nullptr);
+
+    /**
+     * @brief Destructor for DatabaseMappedImage, unmaps the image.
+     */
+    ~DatabaseMappedImage();
+
+    /**
+     * @brief Maps the image and checks it.
+     *
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: The image is mapped and valid.
+     *         - DATABASE_KEY_NOT_FOUND: No such partition or file.
+     *         - DATABASE_VALUE_INVALID: The image is truncated, malformed, of another version, or does not match its CRC.
+     *         - DATABASE_ERROR: The region could not be mapped.
+     */
+    DatabaseError_t begin();
+
+    /**
+     * @brief Unmaps the image, unless a view still holds one of its values.
+     *
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: The image is unmapped, or was not mapped.
+     *         - DATABASE_ERROR: A view still holds a value.
+     */
+    DatabaseError_t end();
+
+    /**
+     * @brief Looks up a value, without copying it.
+     *
+     * @param key The key.
+     * @param view The view receiving the value, releasing the one it held.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: The view holds the value.
+     *         - DATABASE_KEY_INVALID: Invalid key.
+     *         - DATABASE_VALUE_INVALID: Invalid view pointer.
+     *         - DATABASE_KEY_NOT_FOUND: The image has no such key.
+     *         - DATABASE_ERROR: The image is not mapped.
+     */
+    DatabaseError_t get(char const *const key, DatabaseMappedView *const view) const;
+
+    /**
+     * @brief Returns the number of values of the image, 0 before begin().
+     */
+    size_t count() const;
+
+    DatabaseMappedImage(DatabaseMappedImage const &) = delete;
+    DatabaseMappedImage &operator=(DatabaseMappedImage const &) = delete;
+
+private:
+    friend class DatabaseMappedView;
+
+    char const *const _source;                     /**< Partition label or file path, nullptr for an image in memory. */
+    uint8_t const *_region;                        /**< Start of the mapped region, nullptr while unmapped. */
+    size_t _regionLength;                          /**< Length of the mapped region. */
+    size_t _imageLength;                           /**< Length of the image, trailer included, 0 while unchecked. */
+    size_t _count;                                 /**< Number of values of the image. */
+    uint32_t _mapping;                             /**< Handle of the partition mapping on the device. */
+    mutable std::atomic<uint32_t> _views;          /**< Number of views holding a value. */
+    DatabaseMutex _mutex;                          /**< Serializes mapping, unmapping and new views. */
+    MultiPrinterLoggerInterface *const _logger;    /**< Pointer to the logger interface. */
+
+    /**
+     * @brief Maps the partition or the file.
+     *
+     * @return DATABASE_OK, DATABASE_KEY_NOT_FOUND if it does not exist, or DATABASE_ERROR.
+     */
+    DatabaseError_t map();
+
+    /**
+     * @brief Unmaps the partition or the file.
+     */
+    void unmap();
+
+    /**
+     * @brief Walks the values of the mapped region, checking the trailer and the CRC.
+     *
+     * @return true if the region starts with a valid image, with _imageLength and _count set.
+     */
+    bool check();
+};
+
+#endif // DATABASE_MAPPED_IMAGE_H
@@ -0,0 +1,76 @@
+#ifndef DATABASE_MUTEX_H
+#define DATABASE_MUTEX_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+/**
+ * @brief Recursive FreeRTOS mutex owned for the lifetime of the object.
+ *
+ * The semaphore is created in the constructor and deleted in the destructor,
+ * so no heap is held once the owner is destroyed.
+ */
+class DatabaseMutex
+{
+public:
+    /**
+     * @brief Constructor for DatabaseMutex, creates the underlying semaphore.
+     */
+    DatabaseMutex();
+
+    /**
+     * @brief Destructor for DatabaseMutex, deletes the underlying semaphore.
+     */
+    ~DatabaseMutex();
+
+    /**
+     * @brief Blocks until the mutex is acquired by the calling task.
+     */
+    void lock() const;
+
+    /**
+     * @brief Acquires the mutex, waiting at most the given time.
+     *
+     * @param timeoutMs Longest wait in milliseconds, 0 to only try.
+     * @return true if the mutex is acquired, to be released with unlock().
+     */
+    bool tryLock(uint32_t const timeoutMs) const;
+
+    /**
+     * @brief Releases the mutex held by the calling task.
+     */
+    void unlock() const;
+
+    DatabaseMutex(DatabaseMutex const &) = delete;
+    DatabaseMutex &operator=(DatabaseMutex const &) = delete;
+
+private:
+    SemaphoreHandle_t const _handle; /**< Handle of the recursive FreeRTOS semaphore. */
+};
+
+/**
+ * @brief Scoped lock over a DatabaseMutex, released when it goes out of scope.
+ */
+class DatabaseLockGuard
+{
+public:
+    /**
+     * @brief Constructor for DatabaseLockGuard, acquires the mutex.
+     *
+     * @param mutex The mutex to hold for the lifetime of the guard.
+     */
+    explicit DatabaseLockGuard(DatabaseMutex const &mutex);
+
+    /**
+     * @brief Destructor for DatabaseLockGuard, releases the mutex.
+     */
+    ~DatabaseLockGuard();
+
+    DatabaseLockGuard(DatabaseLockGuard const &) = delete;
+    DatabaseLockGuard &operator=(DatabaseLockGuard const &) = delete;
+
+private:
+    DatabaseMutex const &_mutex; /**< The mutex held by this guard. */
+};
+
+#endif // DATABASE_MUTEX_H
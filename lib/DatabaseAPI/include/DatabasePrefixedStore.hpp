@@ -0,0 +1,60 @@
+#ifndef DATABASE_PREFIXED_STORE_H
+#define DATABASE_PREFIXED_STORE_H
+
+#include <MultiPrinterLoggerInterface.hpp>
+#include <stddef.h>
+
+#include "DatabaseAPI.hpp"
+#include "DatabaseMutex.hpp"
+
+/**
+ * @brief Base of the structures kept in DatabaseAPI keys sharing a prefix: DatabaseQueue,
+ *        DatabaseRingBuffer and DatabaseKeyMap.
+ *
+ * Holds the prefix, checked by the constructor, and the checks of begin() and of every
+ * operation that needs it to have succeeded. Nothing is read until the derived begin().
+ */
+class DatabasePrefixedStore
+{
+protected:
+    /**
+     * @brief Constructor for DatabasePrefixedStore.
+     *
+     * @param database Pointer to the DatabaseAPI storing the keys.
+     * @param prefix The prefix of the keys, kept empty if invalid and reported by validate().
+     * @param maxPrefixLength The length of the longest prefix, leaving room for the key suffixes.
+     * @param name The name of the structure in log messages, e.g. "Queue".
+     * @param logger Pointer to the logger interface.
+     */
+    DatabasePrefixedStore(
+        DatabaseAPI *const database, char const *const prefix, size_t const maxPrefixLength,
+        char const *const name, MultiPrinterLoggerInterface *const logger);
+
+    ~DatabasePrefixedStore() = default;
+
+    /**
+     * @brief Checks the configuration, first thing in begin().
+     *
+     * @param valueValid false if a setting of the derived structure is out of range.
+     * @return DatabaseError_t indicating the first invalid setting.
+     *         - DATABASE_OK: The configuration is valid.
+     *         - DATABASE_KEY_INVALID: Invalid or reserved prefix.
+     *         - DATABASE_VALUE_INVALID: valueValid is false.
+     *         - DATABASE_ERROR: No database.
+     */
+    DatabaseError_t validate(bool const valueValid) const;
+
+    /**
+     * @brief Returns true once begin() succeeded, logs an error otherwise. Must be called with _mutex held.
+     */
+    bool isStarted() const;
+
+    DatabaseAPI *const _database;               /**< DatabaseAPI storing the keys. */
+    char _prefix[NVS_DELEGATE_MAX_KEY_LENGTH];  /**< Prefix of the keys, empty if invalid. */
+    char const *const _name;                    /**< Name of the structure in log messages. */
+    MultiPrinterLoggerInterface *const _logger; /**< Pointer to the logger interface. */
+    mutable DatabaseMutex _mutex;               /**< Guards the state of the derived structure. */
+    bool _begun;                                /**< true once begin() succeeded. */
+};
+
+#endif // DATABASE_PREFIXED_STORE_H
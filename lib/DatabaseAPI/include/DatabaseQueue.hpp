@@ -0,0 +1,184 @@
+#ifndef DATABASE_QUEUE_H
+#define DATABASE_QUEUE_H
+
+#include <MultiPrinterLoggerInterface.hpp>
+#include <stdint.h>
+
+#include "DatabaseAPI.hpp"
+#include "DatabasePrefixedStore.hpp"
+
+#define DATABASE_QUEUE_MAX_CAPACITY 1000 /**< Messages a queue holds at most, numbering its slot keys with 3 digits. */
+
+/**
+ * @brief Consumer of the messages dequeued from a DatabaseQueue.
+ *
+ * @param message The message, oldest first.
+ * @param context The context given to dequeue.
+ * @return true once the message is handled, e.g. published, false to leave it and the following ones queued.
+ */
+typedef bool (*DatabaseQueueConsumer_t)(char const *const message, void *context);
+
+/**
+ * @brief Persistent FIFO queue of string messages, e.g. outbound messages buffered while offline.
+ *
+ * Messages are stored in capacity slot keys, prefix0 to prefixN-1, the message with sequence
+ * number s in slot s % capacity, as "<s>:<message>". Each message carries its sequence number,
+ * so begin() recovers the head and the tail by scanning the slots and no index key is rewritten
+ * by enqueue or dequeue. A batched enqueue, and the acknowledgement of the messages handled by a
+ * dequeue, are each applied under one commit, in queue order: a reset in the middle leaves a
+ * contiguous queue, and a message handled but not yet acknowledged is delivered again.
+ */
+class DatabaseQueue : public DatabasePrefixedStore
+{
+public:
+    /**
+     * @brief Constructor for DatabaseQueue. Nothing is read until begin().
+     *
+     * @param database Pointer to the DatabaseAPI storing the messages.
+     * @param prefix The prefix of the slot keys, at most 12 characters.
+     * @param capacity The number of messages the queue holds, 1 to DATABASE_QUEUE_MAX_CAPACITY.
+     * @param maxMessageLength The length of the longest message.
+     * @param logger Pointer to the logger interface.
+     */
+    DatabaseQueue(
+        DatabaseAPI *const database, char const *const prefix, uint16_t const capacity,
+        size_t const maxMessageLength = 256, MultiPrinterLoggerInterface *const logger = nullptr);
+
+    /**
+     * @brief Destructor for DatabaseQueue. Every queued message is already stored.
+     */
+    ~DatabaseQueue();
+
+    /**
+     * @brief Recovers the head and the tail of the queue by scanning the slots.
+     *
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful, also for a queue never written.
+     *         - DATABASE_KEY_INVALID: Invalid prefix.
+     *         - DATABASE_VALUE_INVALID: Invalid capacity or message length.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap for the message buffer.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t begin();
+
+    /**
+     * @brief Appends a message, written under its own commit.
+     *
+     * @param message The message.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_VALUE_INVALID: Invalid or too long message.
+     *         - DATABASE_NOT_ENOUGH_SPACE: The queue is full, or no storage is left.
+     *         - DATABASE_ERROR: begin() did not succeed, or general database error.
+     */
+    DatabaseError_t enqueue(char const *const message);
+
+    /**
+     * @brief Appends messages under a single commit, all of them or none if the queue lacks room.
+     *
+     * @param messages The messages, in queue order.
+     * @param count The number of messages.
+     * @return DatabaseError_t as enqueue of a single message.
+     */
+    DatabaseError_t enqueue(char const *const *const messages, size_t const count);
+
+    /**
+     * @brief Reads a queued message without removing it.
+     *
+     * @param index The position of the message, 0 for the oldest.
+     * @param message Buffer to receive the message.
+     * @param maxLength The size of the buffer.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_VALUE_INVALID: Invalid buffer, or buffer too small.
+     *         - DATABASE_KEY_NOT_FOUND: Fewer messages are queued, or the message is missing.
+     *         - DATABASE_ERROR: begin() did not succeed, or general database error.
+     */
+    DatabaseError_t peek(size_t const index, char *message, size_t const maxLength) const;
+
+    /**
+     * @brief Hands the oldest messages to a consumer, then removes those it handled under one commit.
+     *
+     * @param consumer The consumer, returning false to stop at a message it could not handle. It must not use the queue.
+     * @param context Pointer passed unchanged to the consumer.
+     * @param maxCount The number of messages to hand over at most.
+     * @param out_count Optional pointer to receive the number of messages removed, also when a read fails.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful, including for an empty queue.
+     *         - DATABASE_VALUE_INVALID: Invalid consumer.
+     *         - DATABASE_ERROR: begin() did not succeed, the messages could not be removed and
+     *           are handed over again, or a message could not be read. The messages handled
+     *           before it are removed.
+     */
+    DatabaseError_t dequeue(
+        DatabaseQueueConsumer_t const consumer, void *const context, size_t const maxCount,
+        size_t *out_count = nullptr);
+
+    /**
+     * @brief Removes the oldest messages under one commit, e.g. after peeking and sending them.
+     *
+     * @param count The number of messages to remove, at most size().
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_VALUE_INVALID: Fewer messages are queued.
+     *         - DATABASE_ERROR: begin() did not succeed, or general database error.
+     */
+    DatabaseError_t ack(size_t const count);
+
+    /**
+     * @brief Returns the number of queued messages.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the number of messages the queue holds at most.
+     */
+    size_t capacity() const;
+
+    DatabaseQueue(DatabaseQueue const &) = delete;
+    DatabaseQueue &operator=(DatabaseQueue const &) = delete;
+
+private:
+    uint16_t const _capacity;                   /**< Number of slots. */
+    size_t const _maxMessageLength;             /**< Length of the longest message. */
+    char *_text;                                /**< Text of a slot, as stored. */
+    uint32_t _head;                             /**< Sequence number of the oldest message. */
+    uint32_t _tail;                             /**< Sequence number the next message gets. */
+
+    /**
+     * @brief Returns the length of the text buffer, enough for the longest message.
+     */
+    size_t textLength() const;
+
+    /**
+     * @brief Writes the key of the slot holding a sequence number into key.
+     */
+    void slotKey(uint32_t const sequence, char *key) const;
+
+    /**
+     * @brief Reads the message with a sequence number into _text.
+     *
+     * @param sequence The sequence number.
+     * @param out_message Pointer to receive the message, inside _text.
+     * @return DatabaseError_t of the read, DATABASE_KEY_NOT_FOUND if the slot holds another message.
+     */
+    DatabaseError_t load(uint32_t const sequence, char const **out_message) const;
+
+    /**
+     * @brief Parses the sequence number stored in front of a message.
+     *
+     * @return A pointer to the message, nullptr if the text is not a valid slot.
+     */
+    static char const *decode(char const *const text, uint32_t *out_sequence);
+
+    /**
+     * @brief Stages removing the oldest messages in a batch.
+     *
+     * @param batch The batch.
+     * @param count The number of messages.
+     * @return DatabaseError_t of the staging.
+     */
+    DatabaseError_t stageRemoval(DatabaseBatch &batch, size_t const count) const;
+};
+
+#endif // DATABASE_QUEUE_H
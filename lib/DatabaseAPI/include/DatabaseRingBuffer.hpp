@@ -0,0 +1,178 @@
+#ifndef DATABASE_RING_BUFFER_H
+#define DATABASE_RING_BUFFER_H
+
+#include <MultiPrinterLoggerInterface.hpp>
+#include <stdint.h>
+
+#include "DatabaseAPI.hpp"
+#include "DatabasePrefixedStore.hpp"
+
+#define DATABASE_RING_BUFFER_MAX_RECORDS_PER_SLOT 64 /**< Records packed into one slot at most, keeping a slot below 1 KB. */
+
+/**
+ * @brief Visitor of the records of a DatabaseRingBuffer.
+ *
+ * @param sequence The sequence number of the record, counting every record ever appended.
+ * @param value The value of the record.
+ * @param context The context given to the iteration.
+ * @return true to continue, false to stop the iteration.
+ */
+typedef bool (*DatabaseRingBufferVisitor_t)(uint32_t const sequence, int32_t const value, void *context);
+
+/**
+ * @brief Fixed-capacity log of numeric records, e.g. sensor samples or fault codes, kept in NVS.
+ *
+ * Records are packed into slots stored under the keys prefix0 to prefixN-1, with N the number
+ * of slots. The slot being filled is held in RAM and written once full, or by flush(), so a
+ * slot is written once per lap instead of one key being rewritten per record. Appends rotate
+ * across the slots and the oldest slot is overwritten. Each slot stores its own sequence
+ * number, and begin() finds the newest slot by scanning them, so no index key is rewritten.
+ * With delta encoding, each record after the first of a slot is stored as its difference to
+ * the previous one, which keeps slowly changing samples short.
+ *
+ * Records appended since the last write of a slot are lost on a reset; call flush() before
+ * deep sleep or a planned restart.
+ */
+class DatabaseRingBuffer : public DatabasePrefixedStore
+{
+public:
+    /**
+     * @brief Constructor for DatabaseRingBuffer. Nothing is read until begin().
+     *
+     * @param database Pointer to the DatabaseAPI storing the slots.
+     * @param prefix The prefix of the slot keys, at most 12 characters.
+     * @param slotCount The number of slots, at least 2.
+     * @param recordsPerSlot The number of records packed into a slot, 1 to DATABASE_RING_BUFFER_MAX_RECORDS_PER_SLOT.
+     * @param deltaEncoding true to store records as differences to the previous record.
+     * @param logger Pointer to the logger interface.
+     */
+    DatabaseRingBuffer(
+        DatabaseAPI *const database, char const *const prefix, uint8_t const slotCount, uint8_t const recordsPerSlot,
+        bool const deltaEncoding = false, MultiPrinterLoggerInterface *const logger = nullptr);
+
+    /**
+     * @brief Destructor for DatabaseRingBuffer, writes the slot being filled.
+     */
+    ~DatabaseRingBuffer();
+
+    /**
+     * @brief Finds the newest slot by scanning the slots, and loads it to continue appending.
+     *
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful, also for a log never written.
+     *         - DATABASE_KEY_INVALID: Invalid prefix.
+     *         - DATABASE_VALUE_INVALID: Invalid slot or record count.
+     *         - DATABASE_NOT_ENOUGH_SPACE: Not enough heap for the slot buffers.
+     *         - DATABASE_ERROR: General database error.
+     */
+    DatabaseError_t begin();
+
+    /**
+     * @brief Appends a record, writing the slot once it is full.
+     *
+     * @param value The value of the record.
+     * @param sequence Optional pointer to receive the sequence number of the record.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_ERROR: begin() did not succeed, or the slot could not be written.
+     */
+    DatabaseError_t append(int32_t const value, uint32_t *sequence = nullptr);
+
+    /**
+     * @brief Writes the slot being filled, if it holds records not written yet.
+     *
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_ERROR: begin() did not succeed, or the slot could not be written.
+     */
+    DatabaseError_t flush();
+
+    /**
+     * @brief Visits the records from the newest to the oldest.
+     *
+     * @param visitor The visitor, returning false to stop.
+     * @param context Pointer passed unchanged to the visitor.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_VALUE_INVALID: Invalid visitor.
+     *         - DATABASE_ERROR: begin() did not succeed.
+     */
+    DatabaseError_t forEachNewest(DatabaseRingBufferVisitor_t const visitor, void *const context) const;
+
+    /**
+     * @brief Reads the records from a sequence number on, from the oldest to the newest.
+     *
+     * Records older than the log holds are skipped, so first = 0 reads from the oldest record.
+     *
+     * @param first The sequence number of the first record to read.
+     * @param out_values Buffer to receive the values.
+     * @param maxCount The number of values the buffer holds.
+     * @param out_count Pointer to receive the number of values read.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_VALUE_INVALID: Invalid buffer or count pointer.
+     *         - DATABASE_ERROR: begin() did not succeed.
+     */
+    DatabaseError_t read(uint32_t const first, int32_t *out_values, size_t const maxCount, size_t *out_count) const;
+
+    /**
+     * @brief Returns the sequence number the next appended record gets.
+     */
+    uint32_t nextSequence() const;
+
+    /**
+     * @brief Returns the number of records the log holds at most.
+     */
+    size_t capacity() const;
+
+    DatabaseRingBuffer(DatabaseRingBuffer const &) = delete;
+    DatabaseRingBuffer &operator=(DatabaseRingBuffer const &) = delete;
+
+private:
+    uint8_t const _slotCount;                   /**< Number of slots. */
+    uint8_t const _recordsPerSlot;              /**< Number of records packed into a slot. */
+    bool const _deltaEncoding;                  /**< true to store differences to the previous record. */
+    int32_t *_head;                             /**< Records of the slot being filled. */
+    int32_t *_records;                          /**< Records of a slot read from NVS. */
+    char *_text;                                /**< Text of a slot, as stored. */
+    uint32_t _headSlot;                         /**< Sequence number of the slot being filled. */
+    uint8_t _headCount;                         /**< Number of records in the slot being filled. */
+    bool _headDirty;                            /**< true while the slot being filled holds records not written yet. */
+
+    /**
+     * @brief Returns the length of the text buffer, enough for a full slot.
+     */
+    size_t textLength() const;
+
+    /**
+     * @brief Writes the key of the slot holding a slot sequence number into key.
+     */
+    void slotKey(uint32_t const slot, char *key) const;
+
+    /**
+     * @brief Reads a slot from NVS into _records.
+     *
+     * @param slot The sequence number of the slot.
+     * @param out_count Pointer to receive the number of records.
+     * @return true if the slot holds this sequence number, false if it is missing, older or corrupt.
+     */
+    bool loadSlot(uint32_t const slot, uint8_t *out_count) const;
+
+    /**
+     * @brief Parses the text of a slot.
+     *
+     * @param text The text of the slot.
+     * @param out_slot Pointer to receive the sequence number of the slot.
+     * @param out_values Buffer of _recordsPerSlot values to receive the records.
+     * @param out_count Pointer to receive the number of records.
+     * @return true if the text is a valid slot, false otherwise.
+     */
+    bool decode(char const *text, uint32_t *out_slot, int32_t *out_values, uint8_t *out_count) const;
+
+    /**
+     * @brief Oldest slot sequence number held, given the slot being filled.
+     */
+    uint32_t oldestSlot() const;
+};
+
+#endif // DATABASE_RING_BUFFER_H
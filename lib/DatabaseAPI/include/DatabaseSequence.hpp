@@ -0,0 +1,71 @@
+#ifndef DATABASE_SEQUENCE_H
+#define DATABASE_SEQUENCE_H
+
+#include <MultiPrinterLoggerInterface.hpp>
+#include <atomic>
+#include <stdint.h>
+
+#include "DatabaseAPI.hpp"
+#include "DatabaseMutex.hpp"
+
+/**
+ * @brief Persistent generator of unique, increasing IDs that reserves them in blocks.
+ *
+ * The end of the reserved block is stored as a DatabaseAPI counter and persisted once per
+ * block. IDs inside the block are handed out from RAM with a lock-free fetch-add. After a
+ * reboot the unused rest of the last block is skipped, so an ID is never handed out twice.
+ */
+class DatabaseSequence
+{
+public:
+    /**
+     * @brief Constructor for DatabaseSequence. Nothing is reserved until the first ID is requested.
+     *
+     * @param database Pointer to the DatabaseAPI storing the sequence.
+     * @param key The key of the counter holding the end of the reserved block.
+     * @param blockSize The number of IDs reserved per flash write.
+     * @param logger Pointer to the logger interface.
+     */
+    DatabaseSequence(
+        DatabaseAPI *const database, char const *const key, uint32_t const blockSize = 1000,
+        MultiPrinterLoggerInterface *const logger = nullptr);
+
+    /**
+     * @brief Destructor for DatabaseSequence. The unused rest of the block is lost.
+     */
+    ~DatabaseSequence();
+
+    /**
+     * @brief Hands out the next ID, reserving a new block when the current one is used up.
+     *
+     * @param id Pointer to receive the ID.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_INVALID: Invalid sequence key.
+     *         - DATABASE_VALUE_INVALID: Invalid ID pointer or block size.
+     *         - DATABASE_NOT_ENOUGH_SPACE: The block could not be persisted.
+     *         - DATABASE_ERROR: General database error, or the 32-bit ID range is exhausted.
+     */
+    DatabaseError_t next(uint32_t *id);
+
+    DatabaseSequence(DatabaseSequence const &) = delete;
+    DatabaseSequence &operator=(DatabaseSequence const &) = delete;
+
+private:
+    DatabaseAPI *const _database;               /**< DatabaseAPI storing the end of the reserved block. */
+    char _key[NVS_DELEGATE_MAX_KEY_LENGTH];     /**< Key of the counter, empty if invalid. */
+    uint32_t const _blockSize;                  /**< Number of IDs reserved at once. */
+    MultiPrinterLoggerInterface *const _logger; /**< Pointer to the logger interface. */
+    DatabaseMutex _reserveMutex;                /**< Serializes block reservations. */
+    std::atomic<uint32_t> _next;                /**< Next ID to hand out. */
+    std::atomic<uint32_t> _limit;               /**< End of the reserved block, exclusive. */
+
+    /**
+     * @brief Reserves and persists a new block, once the current one is used up.
+     *
+     * @return DatabaseError_t of the reservation.
+     */
+    DatabaseError_t reserveBlock();
+};
+
+#endif // DATABASE_SEQUENCE_H
@@ -0,0 +1,107 @@
+#ifndef DATABASE_SNAPSHOT_H
+#define DATABASE_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "NVSDelegateInterface.hpp"
+
+/**
+ * @brief Immutable in-RAM copy of a namespace, sorted by key.
+ *
+ * The header, the entry table and the string pool live in a single allocation.
+ * A snapshot is never modified once built; changes produce a new snapshot.
+ */
+class DatabaseSnapshot
+{
+public:
+    /**
+     * @brief Loads every string value of a namespace into a new snapshot.
+     *
+     * @param nvsDelegate Pointer to the NVSDelegateInterface instance.
+     * @param nvsNamespace The namespace to load.
+     * @param err Pointer to receive the delegate error, NVS_DELEGATE_OK on success.
+     * @return The new snapshot, or nullptr on failure.
+     */
+    static DatabaseSnapshot *load(
+        NVSDelegateInterface const *const nvsDelegate, char const *const nvsNamespace,
+        NVSDelegateError_t *err);
+
+    /**
+     * @brief Builds a snapshot equal to another one with a single key changed.
+     *
+     * @param base The snapshot to copy, nullptr for an empty one.
+     * @param key The key to change.
+     * @param value The new value of the key, nullptr to remove the key.
+     * @return The new snapshot, or nullptr if the allocation failed.
+     */
+    static DatabaseSnapshot *withValue(
+        DatabaseSnapshot const *const base, char const *const key, char const *const value);
+
+    /**
+     * @brief Frees a snapshot built by this class.
+     *
+     * @param snapshot The snapshot to free, may be nullptr.
+     */
+    static void destroy(DatabaseSnapshot const *const snapshot);
+
+    /**
+     * @brief Looks up the value of a key.
+     *
+     * @param key The key to look up.
+     * @param length Optional pointer to receive the length of the value, including the null terminator.
+     * @return The null-terminated value, or nullptr if the key is not in the snapshot.
+     */
+    char const *find(char const *const key, size_t *length) const;
+
+    /**
+     * @brief Returns the number of keys in the snapshot.
+     */
+    size_t count() const;
+
+private:
+    /**
+     * @brief Location of one key/value pair in the string pool.
+     */
+    struct Entry
+    {
+        uint32_t keyOffset;   /**< Offset of the null-terminated key. */
+        uint32_t valueOffset; /**< Offset of the null-terminated value. */
+        uint16_t valueLength; /**< Length of the value, including the null terminator. */
+    };
+
+    struct LoadContext;
+
+    size_t const _count;   /**< Number of entries. */
+    Entry *const _entries; /**< Entries sorted by key. */
+    char *const _pool;     /**< Keys and values, null-terminated. */
+
+    /**
+     * @brief Constructor for DatabaseSnapshot, only used on a block sized by allocate().
+     */
+    DatabaseSnapshot(size_t const count, Entry *const entries, char *const pool);
+
+    /**
+     * @brief Allocates a snapshot block holding the given number of entries and pool bytes.
+     *
+     * @return The new, unsorted snapshot, or nullptr if the allocation failed.
+     */
+    static DatabaseSnapshot *allocate(size_t const count, size_t const poolSize);
+
+    /**
+     * @brief NVSDelegateKeyCallback_t used by load() to measure, then copy, every string entry.
+     */
+    static bool loadKey(char const *const key, void *context);
+
+    /**
+     * @brief Returns the key of an entry.
+     */
+    char const *keyAt(size_t const index) const;
+
+    /**
+     * @brief Sorts the entries by key.
+     */
+    void sort();
+};
+
+#endif // DATABASE_SNAPSHOT_H
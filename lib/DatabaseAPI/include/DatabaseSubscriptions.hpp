@@ -0,0 +1,184 @@
+#ifndef DATABASE_SUBSCRIPTIONS_H
+#define DATABASE_SUBSCRIPTIONS_H
+
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <MultiPrinterLoggerInterface.hpp>
+
+#include "DatabaseAPIInterface.hpp"
+#include "DatabaseMutex.hpp"
+#include "NVSDelegateInterface.hpp"
+
+#ifndef DATABASE_MAX_SUBSCRIPTIONS
+#define DATABASE_MAX_SUBSCRIPTIONS 8 /**< Number of subscriptions a database holds at most. */
+#endif
+
+#ifndef DATABASE_SUBSCRIPTION_QUEUE_LENGTH
+#define DATABASE_SUBSCRIPTION_QUEUE_LENGTH 16 /**< Number of changes waiting for delivery at most. */
+#endif
+
+#ifndef DATABASE_SUBSCRIPTION_STACK_SIZE
+#define DATABASE_SUBSCRIPTION_STACK_SIZE 4096 /**< Stack size of the delivery task, in bytes. */
+#endif
+
+#ifndef DATABASE_SUBSCRIPTION_PRIORITY
+#define DATABASE_SUBSCRIPTION_PRIORITY 1 /**< FreeRTOS priority of the delivery task. */
+#endif
+
+/**
+ * @brief Kind of change delivered to a subscriber.
+ */
+typedef enum
+{
+    DATABASE_CHANGE_SET,      ///< The key was set.
+    DATABASE_CHANGE_REMOVED,  ///< The key was removed, or expired and swept.
+    DATABASE_CHANGE_ERASED,   ///< Every key may have changed (eraseAll, replaceAll); the key is empty.
+    DATABASE_CHANGE_OVERFLOW, ///< Changes were dropped while the queue was full; the key is empty.
+} DatabaseChange_t;
+
+/**
+ * @brief Callback receiving the changes of the keys a subscription matches, from the delivery task.
+ *
+ * @param key The key that changed, empty for DATABASE_CHANGE_ERASED and DATABASE_CHANGE_OVERFLOW.
+ * @param change The kind of change.
+ * @param context The context given to subscribe.
+ */
+typedef void (*DatabaseChangeCallback_t)(char const *const key, DatabaseChange_t const change, void *context);
+
+/**
+ * @brief Subscriptions to the changes of a database, delivered asynchronously.
+ *
+ * Writers publish a change by queuing the key, which never blocks: when the queue is full
+ * the change is dropped, and subscribers later receive DATABASE_CHANGE_OVERFLOW to read
+ * their keys again. A task started with the first subscription delivers queued changes to
+ * the matching callbacks, so a slow subscriber only delays other subscribers. Values are
+ * not queued; subscribers read the keys they need.
+ */
+class DatabaseSubscriptions
+{
+public:
+    /**
+     * @brief Constructor for DatabaseSubscriptions, nothing is allocated until the first subscription.
+     *
+     * @param logger Pointer to the MultiPrinterLoggerInterface instance.
+     */
+    explicit DatabaseSubscriptions(MultiPrinterLoggerInterface *const logger = nullptr);
+
+    /**
+     * @brief Destructor for DatabaseSubscriptions, stops the delivery task, see stop.
+     */
+    ~DatabaseSubscriptions();
+
+    /**
+     * @brief Subscribes a callback to the changes of a key, or of the keys starting with a prefix.
+     *
+     * @param pattern The key, or a prefix followed by '*'; "*" matches every key.
+     * @param callback The callback, called from the delivery task.
+     * @param context Pointer passed unchanged to the callback.
+     * @param out_id Optional pointer to receive the id of the subscription, for unsubscribe.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_INVALID: Invalid pattern.
+     *         - DATABASE_VALUE_INVALID: Invalid callback.
+     *         - DATABASE_NOT_ENOUGH_SPACE: DATABASE_MAX_SUBSCRIPTIONS reached, or the queue or the task could not be created.
+     */
+    DatabaseError_t subscribe(
+        char const *const pattern, DatabaseChangeCallback_t const callback, void *const context,
+        uint32_t *out_id = nullptr);
+
+    /**
+     * @brief Removes a subscription. Once it returns, the callback is not called again.
+     *
+     * @param id The id of the subscription.
+     * @return DatabaseError_t indicating the success or failure of the operation.
+     *         - DATABASE_OK: Operation successful.
+     *         - DATABASE_KEY_NOT_FOUND: No subscription has this id.
+     */
+    DatabaseError_t unsubscribe(uint32_t const id);
+
+    /**
+     * @brief Queues a change for delivery. Never blocks; does nothing without subscriptions.
+     *
+     * @param key The key that changed, nullptr for DATABASE_CHANGE_ERASED.
+     * @param change The kind of change.
+     */
+    void publish(char const *const key, DatabaseChange_t const change);
+
+    /**
+     * @brief Returns the number of changes dropped because the queue was full.
+     */
+    uint32_t droppedCount() const;
+
+    /**
+     * @brief Removes every subscription and stops the delivery task, discarding the queued changes.
+     *
+     * Waits for a delivery in progress, so it must not be called from a callback.
+     */
+    void stop();
+
+    DatabaseSubscriptions(DatabaseSubscriptions const &) = delete;
+    DatabaseSubscriptions &operator=(DatabaseSubscriptions const &) = delete;
+
+private:
+    /**
+     * @brief One subscription.
+     */
+    struct Subscription
+    {
+        char pattern[NVS_DELEGATE_MAX_KEY_LENGTH]; /**< The key, or a prefix followed by '*'. */
+        DatabaseChangeCallback_t callback;         /**< The callback, nullptr for a free entry. */
+        void *context;                             /**< Pointer passed unchanged to the callback. */
+        uint32_t id;                               /**< Id of the subscription. */
+    };
+
+    /**
+     * @brief One queued change.
+     */
+    struct Event
+    {
+        char key[NVS_DELEGATE_MAX_KEY_LENGTH]; /**< The key, empty for changes of every key. */
+        uint8_t change;                        /**< DatabaseChange_t, or 0xFF asking the task to exit. */
+    };
+
+    Subscription _subscriptions[DATABASE_MAX_SUBSCRIPTIONS]; /**< The subscriptions. */
+    std::atomic<uint32_t> _count;            /**< Number of subscriptions, checked by publish without the lock; 0 once stopped. */
+    uint32_t _nextId;                        /**< Id of the next subscription. */
+    DatabaseMutex _mutex;                    /**< Guards the subscriptions; held while delivering. */
+    QueueHandle_t _queue;                    /**< Changes waiting for delivery, created with the first subscription. */
+    TaskHandle_t _task;                      /**< Handle of the delivery task, if running. */
+    SemaphoreHandle_t _taskStopped;          /**< Given by the delivery task when it exits. */
+    std::atomic<bool> _overflowed;           /**< true when changes were dropped since the last overflow delivery. */
+    std::atomic<uint32_t> _dropped;          /**< Number of changes dropped because the queue was full. */
+    MultiPrinterLoggerInterface *const _logger; /**< Pointer to the MultiPrinterLoggerInterface instance. */
+
+    /**
+     * @brief Creates the queue and starts the delivery task, if not done yet. Must be called with _mutex held.
+     *
+     * @return true if the task is running, false otherwise.
+     */
+    bool start();
+
+    /**
+     * @brief Calls the callbacks matching a change.
+     *
+     * @param event The change.
+     */
+    void deliver(Event const &event);
+
+    /**
+     * @brief Entry point of the delivery task.
+     *
+     * @param arg Pointer to the owning DatabaseSubscriptions.
+     */
+    static void taskEntry(void *arg);
+
+    /**
+     * @brief Checks if a key matches a pattern.
+     */
+    static bool matches(char const *const pattern, char const *const key);
+};
+
+#endif // DATABASE_SUBSCRIPTIONS_H
@@ -0,0 +1,360 @@
+#ifndef MEMORY_NVS_DELEGATE_H
+#define MEMORY_NVS_DELEGATE_H
+
+#include <atomic>
+#include <string.h>
+#include <MultiPrinterLoggerInterface.hpp>
+
+#include "DatabaseMutex.hpp"
+#include "NVSDelegateInterface.hpp"
+
+#define MEMORY_NVS_DELEGATE_MAX_NAMESPACES 16
+#define MEMORY_NVS_DELEGATE_SHARD_COUNT 8
+// Entries reported by get_stats: five pages of 126, as the 20 KB partition of the default tables
+#ifndef MEMORY_NVS_DELEGATE_TOTAL_ENTRIES
+#define MEMORY_NVS_DELEGATE_TOTAL_ENTRIES 630
+#endif
+
+/**
+ * @brief Concurrent in-RAM implementation of NVSDelegateInterface.
+ *
+ * Every namespace is split into hash-sharded buckets, each guarded by its own
+ * lock, so operations on different keys rarely contend. Handles carry no state,
+ * so any number of them may be open at the same time. Nothing is persisted.
+ */
+class MemoryNVSDelegate : public NVSDelegateInterface
+{
+public:
+    /**
+     * @brief Constructor for MemoryNVSDelegate.
+     *
+     * @param logger Pointer to the logger interface.
+     */
+    MemoryNVSDelegate(MultiPrinterLoggerInterface *const logger = nullptr);
+
+    /**
+     * @brief Destructor for MemoryNVSDelegate, frees every namespace and value.
+     */
+    ~MemoryNVSDelegate();
+
+    /**
+     * @brief Opens a namespace with the specified name and mode, creating it in READWRITE mode.
+     *
+     * @param name The name of the namespace to open.
+     * @param open_mode The mode in which to open the namespace (READWRITE or READONLY).
+     * @param out_handle Pointer to receive the handle for the opened namespace.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_NAMESPACE_INVALID: Invalid namespace name.
+     *         - NVS_DELEGATE_NOT_ENOUGH_SPACE: No namespace slot or heap left.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Namespace not found in READONLY mode.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid handle pointer.
+     */
+    NVSDelegateError_t open(
+        char const *const name, NVSDelegateOpenMode_t const open_mode,
+        NVSDelegateHandle_t *out_handle) const override;
+
+    /**
+     * @brief Closes the specified namespace handle. Handles hold no resources.
+     *
+     * @param handle The handle of the namespace to close.
+     */
+    void close(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Sets a string value for the specified key in the given namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the string value.
+     * @param value The string value to set.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid value.
+     *         - NVS_DELEGATE_READONLY: Attempt to write in READONLY mode.
+     *         - NVS_DELEGATE_NOT_ENOUGH_SPACE: Not enough heap for the value.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     */
+    NVSDelegateError_t set_str(
+        NVSDelegateHandle_t handle, char const *const key,
+        char const *const value) const override;
+
+    /**
+     * @brief Gets the string value for the specified key from the given namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the string value.
+     * @param out_value Buffer to store the value, or nullptr to only query its length.
+     * @param length Pointer to the length of the buffer; updated with the length of the value, including the null terminator.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid length pointer, or buffer too small.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found.
+     */
+    NVSDelegateError_t get_str(
+        NVSDelegateHandle_t handle, char const *const key,
+        char *out_value, size_t *length) const override;
+
+    /**
+     * @brief Sets a signed 64-bit integer value for the specified key in the given non-volatile storage namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the integer value.
+     * @param value The integer value to set.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_READONLY: Attempt to write in READONLY mode.
+     *         - NVS_DELEGATE_NOT_ENOUGH_SPACE: Not enough space in the storage.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    NVSDelegateError_t set_i64(
+        NVSDelegateHandle_t handle, char const *const key, int64_t const value) const override;
+
+    /**
+     * @brief Gets the signed 64-bit integer value for the specified key from the given non-volatile storage namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the integer value.
+     * @param out_value Pointer to receive the integer value.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid value pointer.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found, or not holding an integer.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    NVSDelegateError_t get_i64(
+        NVSDelegateHandle_t handle, char const *const key, int64_t *out_value) const override;
+
+    /**
+     * @brief Sets a binary value for the specified key in the given namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the binary value.
+     * @param value Pointer to the bytes to set.
+     * @param length The number of bytes to set, greater than 0.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid value or length.
+     *         - NVS_DELEGATE_READONLY: Attempt to write in READONLY mode.
+     *         - NVS_DELEGATE_NOT_ENOUGH_SPACE: Not enough heap for the value.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     */
+    NVSDelegateError_t set_blob(
+        NVSDelegateHandle_t handle, char const *const key,
+        void const *const value, size_t const length) const override;
+
+    /**
+     * @brief Gets the binary value for the specified key from the given namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the binary value.
+     * @param out_value Buffer to store the bytes, nullptr to only query the length.
+     * @param length Pointer to the length of the buffer; updated with the length of the value.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid length pointer, or buffer too small.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found, or not holding a binary value.
+     */
+    NVSDelegateError_t get_blob(
+        NVSDelegateHandle_t handle, char const *const key,
+        void *out_value, size_t *length) const override;
+
+    /**
+     * @brief Erases the key and its associated value from the given namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key to erase.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found.
+     *         - NVS_DELEGATE_READONLY: Attempt to erase in READONLY mode.
+     */
+    NVSDelegateError_t erase_key(
+        NVSDelegateHandle_t handle, char const *const key) const override;
+
+    /**
+     * @brief Erases all keys and values from the given namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_READONLY: Attempt to erase in READONLY mode.
+     */
+    NVSDelegateError_t erase_all(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Erases all keys and values from all namespaces.
+     *
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     */
+    NVSDelegateError_t erase_flash_all() const override;
+
+    /**
+     * @brief Validates the handle; writes are visible as soon as they return.
+     *
+     * @param handle The handle of the namespace.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_READONLY: Attempt to commit in READONLY mode.
+     */
+    NVSDelegateError_t commit(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Lists the keys stored in the specified namespace.
+     *
+     * @param name The name of the namespace to list.
+     * @param callback The callback invoked for every key, until it returns false.
+     * @param context Pointer passed unchanged to the callback.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful, including an empty or missing namespace.
+     *         - NVS_DELEGATE_NAMESPACE_INVALID: Invalid namespace name.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid callback.
+     */
+    NVSDelegateError_t list_keys(
+        char const *const name, NVSDelegateKeyCallback_t callback, void *context) const override;
+
+    /**
+     * @brief Gets the entries the stored values would use in NVS, out of MEMORY_NVS_DELEGATE_TOTAL_ENTRIES.
+     *
+     * Entries are counted as ESP-IDF NVS lays them out: one per namespace and per integer, a
+     * header and one span per 32 bytes for a string, an index more for a blob. Nothing is
+     * ever left erased, so the entries not used are free.
+     *
+     * @param out_stats Pointer to receive the usage.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid stats pointer.
+     */
+    NVSDelegateError_t get_stats(NVSDelegateStats_t *out_stats) const override;
+
+    /**
+     * @brief Gets the entries the values of a namespace would use in NVS, counted as by get_stats.
+     *
+     * @param handle The handle of the namespace.
+     * @param out_entries Pointer to receive the number of entries.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid entries pointer.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     */
+    NVSDelegateError_t get_used_entries(NVSDelegateHandle_t handle, size_t *out_entries) const override;
+
+private:
+    /**
+     * @brief One key/value pair, chained inside a shard.
+     */
+    struct Entry
+    {
+        Entry *next;                           /**< Next entry of the shard. */
+        char key[NVS_DELEGATE_MAX_KEY_LENGTH]; /**< Null-terminated key. */
+        char *value;                           /**< Heap copy of the null-terminated value or of the bytes, nullptr if the entry holds an integer. */
+        size_t length;                         /**< Length of the value, including the null terminator of a string. */
+        bool blob;                             /**< true if value holds bytes set with set_blob. */
+        int64_t integer;                       /**< Integer value, used when value is nullptr. */
+    };
+
+    /**
+     * @brief A bucket of entries guarded by its own lock.
+     */
+    struct Shard
+    {
+        DatabaseMutex mutex; /**< Guards the entries of the shard. */
+        Entry *entries;      /**< Head of the entry chain. */
+    };
+
+    /**
+     * @brief A namespace and its shards.
+     */
+    struct Namespace
+    {
+        char name[NVS_DELEGATE_MAX_NAMESPACE_LENGTH]; /**< Null-terminated namespace name. */
+        std::atomic<bool> exists;                     /**< false until first opened in READWRITE mode, and after erase_flash_all. */
+        Shard shards[MEMORY_NVS_DELEGATE_SHARD_COUNT]; /**< Hash-sharded buckets. */
+    };
+
+    MultiPrinterLoggerInterface *const m_logger;                         /**< Pointer to the logger interface. */
+    DatabaseMutex m_namespaceMutex;                                      /**< Serializes namespace creation. */
+    mutable Namespace *m_namespaces[MEMORY_NVS_DELEGATE_MAX_NAMESPACES]; /**< Namespaces, never removed before destruction. */
+    mutable std::atomic<size_t> m_namespaceCount;                        /**< Number of published namespaces. */
+
+    /**
+     * @brief Resolves a handle into its namespace.
+     *
+     * @param handle The handle to resolve.
+     * @param writable true if the operation modifies the namespace.
+     * @param out_namespace Pointer to receive the namespace.
+     * @return NVS_DELEGATE_OK, NVS_DELEGATE_HANDLE_INVALID or NVS_DELEGATE_READONLY.
+     */
+    NVSDelegateError_t resolve(NVSDelegateHandle_t const handle, bool const writable, Namespace **out_namespace) const;
+
+    /**
+     * @brief Finds a published namespace by name.
+     *
+     * @return The namespace, or nullptr if it was never created.
+     */
+    Namespace *findNamespace(char const *const name) const;
+
+    /**
+     * @brief Returns the shard holding the given key.
+     */
+    Shard &shardOf(Namespace *const ns, char const *const key) const;
+
+    /**
+     * @brief Finds the entry of a key in a shard. Must be called with the shard lock held.
+     *
+     * @param shard The shard holding the key.
+     * @param key The key to find.
+     * @param create true to add an empty entry if the key is missing.
+     * @return The entry, or nullptr if missing and not created.
+     */
+    Entry *findEntry(Shard &shard, char const *const key, bool const create) const;
+
+    /**
+     * @brief Frees every entry of a namespace.
+     */
+    void clearNamespace(Namespace *const ns) const;
+
+    /**
+     * @brief Returns the NVS entries the values of a namespace would use, see get_stats.
+     */
+    size_t countEntries(Namespace *const ns) const;
+
+    /**
+     * @brief Prints the given error and returns it.
+     *
+     * @param error The error to print and return.
+     * @return The given error.
+     */
+    NVSDelegateError_t printAndReturnError(NVSDelegateError_t const error) const;
+
+    /**
+     * @brief Checks if the given namespace name is valid.
+     */
+    bool isNamespaceValid(char const *const name) const;
+
+    /**
+     * @brief Checks if the given key is valid.
+     */
+    bool isKeyValid(char const *const key) const;
+
+    /**
+     * @brief Checks if the given value is valid.
+     */
+    bool isValueValid(char const *const value) const;
+};
+
+#endif // MEMORY_NVS_DELEGATE_H
@@ -1,6 +1,7 @@
 #ifndef NVS_DELEGATE_H
 #define NVS_DELEGATE_H
 
+#include <esp_idf_version.h>
 #include <nvs.h>
 #include <nvs_flash.h>
 #include <string.h>
@@ -88,6 +89,79 @@ public:
         NVSDelegateHandle_t handle, char const *const key,
         char *out_value, size_t *length) const override;
 
+    /**
+     * @brief Sets a signed 64-bit integer value for the specified key in the given non-volatile storage namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the integer value.
+     * @param value The integer value to set.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_READONLY: Attempt to write in READONLY mode.
+     *         - NVS_DELEGATE_NOT_ENOUGH_SPACE: Not enough space in the storage.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    NVSDelegateError_t set_i64(
+        NVSDelegateHandle_t handle, char const *const key, int64_t const value) const override;
+
+    /**
+     * @brief Gets the signed 64-bit integer value for the specified key from the given non-volatile storage namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the integer value.
+     * @param out_value Pointer to receive the integer value.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid value pointer.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found, or not holding an integer.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    NVSDelegateError_t get_i64(
+        NVSDelegateHandle_t handle, char const *const key, int64_t *out_value) const override;
+
+    /**
+     * @brief Sets a binary value for the specified key in the given non-volatile storage namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the binary value.
+     * @param value Pointer to the bytes to set.
+     * @param length The number of bytes to set, greater than 0.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid value or length.
+     *         - NVS_DELEGATE_READONLY: Attempt to write in READONLY mode.
+     *         - NVS_DELEGATE_NOT_ENOUGH_SPACE: Not enough space in the storage.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    NVSDelegateError_t set_blob(
+        NVSDelegateHandle_t handle, char const *const key,
+        void const *const value, size_t const length) const override;
+
+    /**
+     * @brief Gets the binary value for the specified key from the given non-volatile storage namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the binary value.
+     * @param out_value Buffer to store the bytes, nullptr to only query the length.
+     * @param length Pointer to the length of the buffer; updated with the length of the value.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid length pointer.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found, or not holding a binary value.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error, including a buffer too small for the value.
+     */
+    NVSDelegateError_t get_blob(
+        NVSDelegateHandle_t handle, char const *const key,
+        void *out_value, size_t *length) const override;
+
     /**
      * @brief Erases the key and its associated value from the specified non-volatile storage namespace.
      *
@@ -137,6 +211,45 @@ public:
      */
     NVSDelegateError_t commit(NVSDelegateHandle_t handle) const override;
 
+    /**
+     * @brief Lists the keys stored in the specified non-volatile storage namespace.
+     *
+     * @param name The name of the namespace to list.
+     * @param callback The callback invoked for every key, until it returns false.
+     * @param context Pointer passed unchanged to the callback.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful, including an empty or missing namespace.
+     *         - NVS_DELEGATE_NAMESPACE_INVALID: Invalid namespace name.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid callback.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    NVSDelegateError_t list_keys(
+        char const *const name, NVSDelegateKeyCallback_t callback, void *context) const override;
+
+    /**
+     * @brief Gets the entry usage of the default NVS partition, as nvs_get_stats reports it.
+     *
+     * @param out_stats Pointer to receive the usage.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid stats pointer.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    NVSDelegateError_t get_stats(NVSDelegateStats_t *out_stats) const override;
+
+    /**
+     * @brief Gets the number of entries used by the values of a namespace, as nvs_get_used_entry_count reports it.
+     *
+     * @param handle The handle of the namespace.
+     * @param out_entries Pointer to receive the number of entries.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid entries pointer.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    NVSDelegateError_t get_used_entries(NVSDelegateHandle_t handle, size_t *out_entries) const override;
+
 private:
     /**
      * @brief Pointer to the logger interface.
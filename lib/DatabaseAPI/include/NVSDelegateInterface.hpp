@@ -5,7 +5,11 @@
 #include <stddef.h>
 
 #define NVS_DELEGATE_MAX_KEY_LENGTH 16
+// Values longer than the 4 KB NVS limit only fit a delegate storing them elsewhere, e.g.
+// TieredNVSDelegate; at most 65535
+#ifndef NVS_DELEGATE_MAX_VALUE_LENGTH
 #define NVS_DELEGATE_MAX_VALUE_LENGTH 4096
+#endif
 #define NVS_DELEGATE_MAX_NAMESPACE_LENGTH 16
 
 /**
@@ -39,6 +43,29 @@ enum class NVSDelegateOpenMode_t : uint8_t
  */
 typedef uint32_t NVSDelegateHandle_t;
 
+/**
+ * @brief Callback invoked for every key listed by NVSDelegateInterface::list_keys.
+ *
+ * @param key The null-terminated key.
+ * @param context The context pointer passed to list_keys.
+ * @return true to continue listing, false to stop.
+ */
+typedef bool (*NVSDelegateKeyCallback_t)(char const *const key, void *context);
+
+/**
+ * @brief Entry usage of the storage, as reported by NVSDelegateInterface::get_stats.
+ *
+ * NVS stores values in 32-byte entries. Entries neither used nor free hold erased values, and
+ * only become free again when NVS garbage collects their page.
+ */
+struct NVSDelegateStats_t
+{
+    size_t usedEntries;    /**< Entries holding a value, a namespace or a part of either. */
+    size_t freeEntries;    /**< Entries never written since their page was erased. */
+    size_t totalEntries;   /**< All the entries of the storage. */
+    size_t namespaceCount; /**< Number of namespaces. */
+};
+
 /**
  * @brief Interface for non-volatile storage operations.
  */
@@ -112,6 +139,79 @@ public:
         NVSDelegateHandle_t handle, char const *const key,
         char *out_value, size_t *length) const = 0;
 
+    /**
+     * @brief Sets a signed 64-bit integer value for the specified key in the given non-volatile storage namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the integer value.
+     * @param value The integer value to set.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_READONLY: Attempt to write in READONLY mode.
+     *         - NVS_DELEGATE_NOT_ENOUGH_SPACE: Not enough space in the storage.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    virtual NVSDelegateError_t set_i64(
+        NVSDelegateHandle_t handle, char const *const key, int64_t const value) const = 0;
+
+    /**
+     * @brief Gets the signed 64-bit integer value for the specified key from the given non-volatile storage namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the integer value.
+     * @param out_value Pointer to receive the integer value.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid value pointer.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found, or not holding an integer.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    virtual NVSDelegateError_t get_i64(
+        NVSDelegateHandle_t handle, char const *const key, int64_t *out_value) const = 0;
+
+    /**
+     * @brief Sets a binary value for the specified key in the given non-volatile storage namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the binary value.
+     * @param value Pointer to the bytes to set.
+     * @param length The number of bytes to set, greater than 0.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid value or length.
+     *         - NVS_DELEGATE_READONLY: Attempt to write in READONLY mode.
+     *         - NVS_DELEGATE_NOT_ENOUGH_SPACE: Not enough space in the storage.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    virtual NVSDelegateError_t set_blob(
+        NVSDelegateHandle_t handle, char const *const key,
+        void const *const value, size_t const length) const = 0;
+
+    /**
+     * @brief Gets the binary value for the specified key from the given non-volatile storage namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the binary value.
+     * @param out_value Buffer to store the bytes, nullptr to only query the length.
+     * @param length Pointer to the length of the buffer; updated with the length of the value.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid length pointer.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found, or not holding a binary value.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error, including a buffer too small for the value.
+     */
+    virtual NVSDelegateError_t get_blob(
+        NVSDelegateHandle_t handle, char const *const key,
+        void *out_value, size_t *length) const = 0;
+
     /**
      * @brief Erases the key and its associated value from the specified non-volatile storage namespace.
      *
@@ -160,6 +260,45 @@ public:
      *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
      */
     virtual NVSDelegateError_t commit(NVSDelegateHandle_t handle) const = 0;
+
+    /**
+     * @brief Lists the keys stored in the specified non-volatile storage namespace.
+     *
+     * @param name The name of the namespace to list.
+     * @param callback The callback invoked for every key, until it returns false.
+     * @param context Pointer passed unchanged to the callback.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful, including an empty or missing namespace.
+     *         - NVS_DELEGATE_NAMESPACE_INVALID: Invalid namespace name.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid callback.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    virtual NVSDelegateError_t list_keys(
+        char const *const name, NVSDelegateKeyCallback_t callback, void *context) const = 0;
+
+    /**
+     * @brief Gets the entry usage of the whole storage.
+     *
+     * @param out_stats Pointer to receive the usage.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid stats pointer.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    virtual NVSDelegateError_t get_stats(NVSDelegateStats_t *out_stats) const = 0;
+
+    /**
+     * @brief Gets the number of entries used by the values of the specified namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param out_entries Pointer to receive the number of entries.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid entries pointer.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    virtual NVSDelegateError_t get_used_entries(NVSDelegateHandle_t handle, size_t *out_entries) const = 0;
 };
 
 #endif // NVS_DELEGATE_INTERFACE_H
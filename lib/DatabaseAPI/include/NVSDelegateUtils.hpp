@@ -0,0 +1,62 @@
+#ifndef NVS_DELEGATE_UTILS_H
+#define NVS_DELEGATE_UTILS_H
+
+#include <stddef.h>
+
+#include "NVSDelegateInterface.hpp"
+
+#define NVS_DELEGATE_UTILS_MAX_ERASES 4 /**< Erases tried before an entry of the other type is reported as stuck. */
+
+/**
+ * @brief Helpers shared by the NVSDelegateInterface implementations.
+ */
+class NVSDelegateUtils
+{
+public:
+    /**
+     * @brief Erases the entries of a key stored with the other type, once the new entry is written.
+     *
+     * NVS keeps one entry per key and type, so a string and a blob of the same key can both be
+     * stored, and erase_key drops whichever it finds first. Writing the new entry first leaves the
+     * key with a value if a failure or a reset comes in between. Entries of the other type are then
+     * erased until a read no longer finds one, and the new entry is written again only if one of
+     * those erases dropped it.
+     *
+     * @param nvsDelegate The delegate storing the key.
+     * @param handle The handle of the namespace.
+     * @param key The key.
+     * @param blob true if the new entry is a blob, false if it is a string.
+     * @param value The new value, a null-terminated string if blob is false.
+     * @param length The length of a blob value, ignored for a string.
+     * @return NVS_DELEGATE_OK if only the new entry is left, or the delegate error.
+     */
+    static NVSDelegateError_t eraseOtherType(
+        NVSDelegateInterface const *const nvsDelegate, NVSDelegateHandle_t const handle, char const *const key,
+        bool const blob, void const *const value, size_t const length);
+
+    /**
+     * @brief Tells whether the buffer given to get_str can take a string value.
+     *
+     * Same convention as nvs_get_str: a null buffer only queries the length, so it always fits,
+     * and a buffer must otherwise hold the value and its null terminator.
+     *
+     * @param out_value The buffer of the caller, nullptr to query the length.
+     * @param length The size of the buffer.
+     * @param valueLength The length of the value, without the null terminator.
+     * @return true if the value can be returned.
+     */
+    static bool fitsString(char const *const out_value, size_t const length, size_t const valueLength);
+
+    /**
+     * @brief Returns a string value through the buffer given to get_str, see fitsString.
+     * @param value The value, not necessarily null-terminated.
+     * @param valueLength The length of the value, without the null terminator.
+     * @param out_value The buffer of the caller, nullptr to query the length.
+     * @param length The size of the buffer, set to valueLength + 1 if the value is returned.
+     * @return NVS_DELEGATE_OK, or NVS_DELEGATE_VALUE_INVALID if the buffer is too small.
+     */
+    static NVSDelegateError_t copyString(
+        char const *const value, size_t const valueLength, char *out_value, size_t *length);
+};
+
+#endif // NVS_DELEGATE_UTILS_H
@@ -0,0 +1,264 @@
+#ifndef NVS_IMAGE_DELEGATE_H
+#define NVS_IMAGE_DELEGATE_H
+
+#include <string.h>
+#include <MultiPrinterLoggerInterface.hpp>
+
+#include "NVSDelegateInterface.hpp"
+
+#define NVS_IMAGE_DELEGATE_PAGE_SIZE 4096 /**< Size of an NVS page. */
+
+/**
+ * @brief Read-only implementation of NVSDelegateInterface over an NVS partition image in memory.
+ *
+ * The image uses the page format of ESP-IDF NVS, as written by the device or by
+ * tools/nvs_partition.py: pages of 4096 bytes with a header, an entry state bitmap and
+ * 126 entries of 32 bytes. Strings, signed 64-bit integers and blobs are read, with their
+ * CRCs checked; items with a wrong CRC are ignored, as NVS does. On the host it verifies
+ * generated images; on the device it can read a partition mapped into memory.
+ * Every write returns NVS_DELEGATE_READONLY.
+ */
+class NVSImageDelegate : public NVSDelegateInterface
+{
+public:
+    /**
+     * @brief Constructor for NVSImageDelegate. The image is not copied and must outlive the delegate.
+     *
+     * @param image The partition image.
+     * @param length The length of the image, a multiple of NVS_IMAGE_DELEGATE_PAGE_SIZE.
+     * @param logger Pointer to the logger interface.
+     */
+    NVSImageDelegate(
+        uint8_t const *const image, size_t const length,
+        MultiPrinterLoggerInterface *const logger = nullptr);
+
+    /**
+     * @brief Opens a namespace of the image in READONLY mode.
+     *
+     * @param name The name of the namespace to open.
+     * @param open_mode The mode, only READONLY is supported.
+     * @param out_handle Pointer to receive the handle for the opened namespace.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_NAMESPACE_INVALID: Invalid namespace name.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid handle pointer.
+     *         - NVS_DELEGATE_READONLY: READWRITE mode requested.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Namespace not found in the image.
+     */
+    NVSDelegateError_t open(
+        char const *const name, NVSDelegateOpenMode_t const open_mode,
+        NVSDelegateHandle_t *out_handle) const override;
+
+    /**
+     * @brief Closes the specified namespace handle. Handles hold no resources.
+     *
+     * @param handle The handle of the namespace to close.
+     */
+    void close(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Not supported, the image is read-only.
+     *
+     * @return NVS_DELEGATE_READONLY.
+     */
+    NVSDelegateError_t set_str(
+        NVSDelegateHandle_t handle, char const *const key,
+        char const *const value) const override;
+
+    /**
+     * @brief Gets the string value for the specified key from the given namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the string value.
+     * @param out_value Buffer to store the value, or nullptr to only query its length.
+     * @param length Pointer to the length of the buffer; updated with the length of the value, including the null terminator.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid length pointer, or buffer too small.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found, or not holding a string.
+     */
+    NVSDelegateError_t get_str(
+        NVSDelegateHandle_t handle, char const *const key,
+        char *out_value, size_t *length) const override;
+
+    /**
+     * @brief Not supported, the image is read-only.
+     *
+     * @return NVS_DELEGATE_READONLY.
+     */
+    NVSDelegateError_t set_i64(
+        NVSDelegateHandle_t handle, char const *const key, int64_t const value) const override;
+
+    /**
+     * @brief Gets the signed 64-bit integer value for the specified key from the given namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the integer value.
+     * @param out_value Pointer to receive the integer value.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid value pointer.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found, or not holding a signed 64-bit integer.
+     */
+    NVSDelegateError_t get_i64(
+        NVSDelegateHandle_t handle, char const *const key, int64_t *out_value) const override;
+
+    /**
+     * @brief Not supported, the image is read-only.
+     *
+     * @return NVS_DELEGATE_READONLY.
+     */
+    NVSDelegateError_t set_blob(
+        NVSDelegateHandle_t handle, char const *const key,
+        void const *const value, size_t const length) const override;
+
+    /**
+     * @brief Gets the binary value for the specified key from the given namespace, joining its chunks.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the binary value.
+     * @param out_value Buffer to store the bytes, nullptr to only query the length.
+     * @param length Pointer to the length of the buffer; updated with the length of the value.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid length pointer, or buffer too small.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found, not holding a binary value, or a chunk is missing.
+     */
+    NVSDelegateError_t get_blob(
+        NVSDelegateHandle_t handle, char const *const key,
+        void *out_value, size_t *length) const override;
+
+    /**
+     * @brief Not supported, the image is read-only.
+     *
+     * @return NVS_DELEGATE_READONLY.
+     */
+    NVSDelegateError_t erase_key(
+        NVSDelegateHandle_t handle, char const *const key) const override;
+
+    /**
+     * @brief Not supported, the image is read-only.
+     *
+     * @return NVS_DELEGATE_READONLY.
+     */
+    NVSDelegateError_t erase_all(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Not supported, the image is read-only.
+     *
+     * @return NVS_DELEGATE_READONLY.
+     */
+    NVSDelegateError_t erase_flash_all() const override;
+
+    /**
+     * @brief Not supported, the image is read-only.
+     *
+     * @return NVS_DELEGATE_READONLY.
+     */
+    NVSDelegateError_t commit(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Lists the keys stored in the specified namespace, each once.
+     *
+     * @param name The name of the namespace to list.
+     * @param callback The callback invoked for every key, until it returns false.
+     * @param context Pointer passed unchanged to the callback.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful, including an empty or missing namespace.
+     *         - NVS_DELEGATE_NAMESPACE_INVALID: Invalid namespace name.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid callback.
+     */
+    NVSDelegateError_t list_keys(
+        char const *const name, NVSDelegateKeyCallback_t callback, void *context) const override;
+
+    /**
+     * @brief Gets the entry usage of the image, read from the entry state bitmap of every page.
+     *
+     * @param out_stats Pointer to receive the usage.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid stats pointer.
+     */
+    NVSDelegateError_t get_stats(NVSDelegateStats_t *out_stats) const override;
+
+    /**
+     * @brief Gets the entries spanned by the valid items of a namespace.
+     *
+     * @param handle The handle of the namespace.
+     * @param out_entries Pointer to receive the number of entries.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid entries pointer.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     */
+    NVSDelegateError_t get_used_entries(NVSDelegateHandle_t handle, size_t *out_entries) const override;
+
+private:
+    uint8_t const *const m_image;                /**< The partition image. */
+    size_t const m_pageCount;                    /**< Number of whole pages in the image. */
+    MultiPrinterLoggerInterface *const m_logger; /**< Pointer to the logger interface. */
+
+    /**
+     * @brief Returns the next written item with a valid CRC, walking every page in order.
+     *
+     * @param position Index of the entry to start from, over all pages; updated past the item and its data.
+     * @return The 32 bytes of the item, or nullptr once the image is over.
+     */
+    uint8_t const *nextItem(size_t *position) const;
+
+    /**
+     * @brief Finds an item of a namespace by key, type and chunk index.
+     *
+     * @param namespaceIndex The index of the namespace, 0 for namespace definitions.
+     * @param type The NVS item type.
+     * @param key The key.
+     * @param chunkIndex The chunk index of a blob chunk, 0xFF for other items.
+     * @return The 32 bytes of the item, or nullptr if not found.
+     */
+    uint8_t const *findItem(uint8_t const namespaceIndex, uint8_t const type, char const *const key, uint8_t const chunkIndex) const;
+
+    /**
+     * @brief Returns the data following a string or blob chunk item, if its length and CRC are valid.
+     *
+     * @param item The item.
+     * @param out_length Pointer to receive the length of the data.
+     * @return The data, or nullptr if invalid.
+     */
+    uint8_t const *variableData(uint8_t const *const item, size_t *out_length) const;
+
+    /**
+     * @brief Returns the index of a namespace, 0 if the image does not define it.
+     */
+    uint8_t findNamespace(char const *const name) const;
+
+    /**
+     * @brief Prints the given error and returns it.
+     *
+     * @param error The error to print and return.
+     * @return The given error.
+     */
+    NVSDelegateError_t printAndReturnError(NVSDelegateError_t const error) const;
+
+    /**
+     * @brief Checks if the given namespace name is valid.
+     */
+    bool isNamespaceValid(char const *const name) const;
+
+    /**
+     * @brief Checks if the given key is valid.
+     */
+    bool isKeyValid(char const *const key) const;
+
+    /**
+     * @brief Checks if the given handle designates a namespace.
+     */
+    bool isHandleValid(NVSDelegateHandle_t const handle) const;
+};
+
+#endif // NVS_IMAGE_DELEGATE_H
@@ -0,0 +1,358 @@
+#ifndef PACKED_NVS_DELEGATE_H
+#define PACKED_NVS_DELEGATE_H
+
+#include <MultiPrinterLoggerInterface.hpp>
+#include <string.h>
+
+#include "DatabaseMutex.hpp"
+#include "NVSDelegateInterface.hpp"
+
+#define PACKED_NVS_DELEGATE_BUCKET_COUNT 16         /**< Default number of buckets per namespace, must not change once data is written. */
+#define PACKED_NVS_DELEGATE_MAX_BUCKET_COUNT 64     /**< Largest number of buckets per namespace, numbered with 2 digits. */
+#define PACKED_NVS_DELEGATE_MAX_VALUE_LENGTH 16     /**< Values shorter than this are packed. */
+#define PACKED_NVS_DELEGATE_MAX_BUCKET_LENGTH 480   /**< Size limit of a bucket blob, 15 NVS data spans. */
+#define PACKED_NVS_DELEGATE_BUCKET_PREFIX "~pk"     /**< Prefix of the reserved bucket keys. */
+#define PACKED_NVS_DELEGATE_LOCK_COUNT 8            /**< Locks shared by the buckets, bucket i taking lock i modulo the count. */
+#define PACKED_NVS_DELEGATE_MAX_NAMESPACES 4        /**< Namespaces whose bucket filters are kept in RAM, others read every bucket. */
+#define PACKED_NVS_DELEGATE_MAX_OPEN_HANDLES 16     /**< Handles open at once whose namespace is known, needed by the filters. */
+
+/**
+ * @brief Storage used by the keys of a namespace, in NVS entries of 32 bytes.
+ */
+struct PackedNVSDelegateReport_t
+{
+    size_t logicalKeys;     /**< Number of keys seen by the user. */
+    size_t packedKeys;      /**< Number of those keys held in buckets. */
+    size_t buckets;         /**< Number of bucket blobs. */
+    size_t entries;         /**< NVS entries used by the namespace. */
+    size_t unpackedEntries; /**< NVS entries the same keys would use without packing. */
+};
+
+/**
+ * @brief NVSDelegateInterface that packs small string values into shared blob buckets.
+ *
+ * Every NVS string entry costs at least two 32-byte entries, a header and a data span,
+ * however short the value. This delegate wraps another one and stores string values
+ * shorter than PACKED_NVS_DELEGATE_MAX_VALUE_LENGTH as records of hashed bucket blobs,
+ * "~pk00", "~pk01" and so on, each a count followed by key and value records. Longer values,
+ * full buckets, integers and blobs go to the wrapped delegate unchanged. Keys behave
+ * the same whichever way they are stored, so DatabaseAPI works on top of it as is.
+ *
+ * An update rewrites the bucket of its key, so more buckets mean shorter rewrites. Buckets
+ * are locked by stripes of PACKED_NVS_DELEGATE_LOCK_COUNT, so keys of different buckets are
+ * read and written concurrently. For each bucket read once, a 64-bit filter of the hashes of
+ * its keys is kept in RAM: a key whose bit is clear is not in the bucket, and is read from
+ * the wrapped delegate without reading the bucket. The buckets must only be written through
+ * this delegate while it exists.
+ */
+class PackedNVSDelegate : public NVSDelegateInterface
+{
+public:
+    /**
+     * @brief Constructor for PackedNVSDelegate.
+     *
+     * @param nvsDelegate Pointer to the delegate storing the buckets and the other values.
+     * @param bucketCount Number of buckets per namespace, 1 to PACKED_NVS_DELEGATE_MAX_BUCKET_COUNT,
+     *                    PACKED_NVS_DELEGATE_BUCKET_COUNT otherwise. It must not change once data is written.
+     * @param logger Pointer to the logger interface.
+     */
+    PackedNVSDelegate(
+        NVSDelegateInterface *const nvsDelegate, size_t const bucketCount = PACKED_NVS_DELEGATE_BUCKET_COUNT,
+        MultiPrinterLoggerInterface *const logger = nullptr);
+
+    /**
+     * @brief Destructor for PackedNVSDelegate, frees the bucket filters.
+     */
+    ~PackedNVSDelegate();
+
+    /**
+     * @brief Opens a namespace of the wrapped delegate, remembering the namespace of the handle.
+     */
+    NVSDelegateError_t open(
+        char const *const name, NVSDelegateOpenMode_t const open_mode,
+        NVSDelegateHandle_t *out_handle) const override;
+
+    /**
+     * @brief Closes a namespace of the wrapped delegate.
+     */
+    void close(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Sets a string value, packed into its bucket if it is short enough and fits.
+     *
+     * The new copy is written before the previous one is removed, so a crash in between
+     * leaves the key readable.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the string value.
+     * @param value The string value to set.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid value.
+     *         - NVS_DELEGATE_READONLY: Attempt to write in READONLY mode.
+     *         - NVS_DELEGATE_NOT_ENOUGH_SPACE: Not enough space in the storage.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error, or a malformed bucket.
+     */
+    NVSDelegateError_t set_str(
+        NVSDelegateHandle_t handle, char const *const key,
+        char const *const value) const override;
+
+    /**
+     * @brief Gets a string value from its bucket, or from the wrapped delegate.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the string value.
+     * @param out_value Buffer to store the value, nullptr to only query the length.
+     * @param length Pointer to the length of the buffer; updated with the length of the value, including the null terminator.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid length pointer, or buffer too small for a packed value.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error, or a malformed bucket.
+     */
+    NVSDelegateError_t get_str(
+        NVSDelegateHandle_t handle, char const *const key,
+        char *out_value, size_t *length) const override;
+
+    /**
+     * @brief Sets an integer value in the wrapped delegate.
+     */
+    NVSDelegateError_t set_i64(
+        NVSDelegateHandle_t handle, char const *const key, int64_t const value) const override;
+
+    /**
+     * @brief Gets an integer value from the wrapped delegate.
+     */
+    NVSDelegateError_t get_i64(
+        NVSDelegateHandle_t handle, char const *const key, int64_t *out_value) const override;
+
+    /**
+     * @brief Sets a binary value in the wrapped delegate.
+     */
+    NVSDelegateError_t set_blob(
+        NVSDelegateHandle_t handle, char const *const key,
+        void const *const value, size_t const length) const override;
+
+    /**
+     * @brief Gets a binary value from the wrapped delegate.
+     */
+    NVSDelegateError_t get_blob(
+        NVSDelegateHandle_t handle, char const *const key,
+        void *out_value, size_t *length) const override;
+
+    /**
+     * @brief Erases a key from its bucket, or from the wrapped delegate.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key to erase.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found.
+     *         - NVS_DELEGATE_READONLY: Attempt to erase in READONLY mode.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error, or a malformed bucket.
+     */
+    NVSDelegateError_t erase_key(
+        NVSDelegateHandle_t handle, char const *const key) const override;
+
+    /**
+     * @brief Erases a namespace of the wrapped delegate, buckets and their filters included.
+     */
+    NVSDelegateError_t erase_all(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Erases every namespace of the wrapped delegate, and every bucket filter.
+     */
+    NVSDelegateError_t erase_flash_all() const override;
+
+    /**
+     * @brief Commits a namespace of the wrapped delegate.
+     */
+    NVSDelegateError_t commit(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Lists the keys of a namespace, packed keys included and bucket keys excluded.
+     *
+     * @param name The name of the namespace to list.
+     * @param callback The callback invoked for every key, until it returns false.
+     * @param context Pointer passed unchanged to the callback.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful, including an empty or missing namespace.
+     *         - NVS_DELEGATE_NAMESPACE_INVALID: Invalid namespace name.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid callback.
+     *         - NVS_DELEGATE_NOT_ENOUGH_SPACE: Not enough heap to copy a bucket.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    NVSDelegateError_t list_keys(
+        char const *const name, NVSDelegateKeyCallback_t callback, void *context) const override;
+
+    /**
+     * @brief Gets the entry usage of the wrapped delegate, buckets counted as stored.
+     */
+    NVSDelegateError_t get_stats(NVSDelegateStats_t *out_stats) const override;
+
+    /**
+     * @brief Gets the entries used by a namespace of the wrapped delegate, buckets counted as stored.
+     */
+    NVSDelegateError_t get_used_entries(NVSDelegateHandle_t handle, size_t *out_entries) const override;
+
+    /**
+     * @brief Reports the NVS entries used by a namespace, and what they would be without packing.
+     *
+     * Entries are counted as ESP-IDF NVS lays them out: a string takes a header and one
+     * span per 32 bytes, a blob an index, a header and its spans, an integer one entry.
+     *
+     * @param name The name of the namespace.
+     * @param out_report Pointer to receive the report.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful, including an empty or missing namespace.
+     *         - NVS_DELEGATE_NAMESPACE_INVALID: Invalid namespace name.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid report pointer.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    NVSDelegateError_t getSpaceReport(char const *const name, PackedNVSDelegateReport_t *out_report) const;
+
+private:
+    /**
+     * @brief Keys a bucket may hold, kept in RAM once the bucket is read.
+     */
+    struct BucketFilter
+    {
+        uint64_t keys; /**< Bit of the hash of every key of the bucket, and maybe of keys removed since. */
+        bool known;    /**< true once keys covers the bucket as stored. */
+    };
+
+    /**
+     * @brief Bucket filters of a namespace.
+     */
+    struct NamespaceFilters
+    {
+        char name[NVS_DELEGATE_MAX_NAMESPACE_LENGTH]; /**< Name of the namespace, empty if the slot is free. */
+        BucketFilter *buckets;                        /**< One filter per bucket, guarded by the lock of the bucket. */
+    };
+
+    /**
+     * @brief Namespace of an open handle.
+     */
+    struct OpenHandle
+    {
+        NVSDelegateHandle_t handle;                   /**< Handle returned by the wrapped delegate. */
+        char name[NVS_DELEGATE_MAX_NAMESPACE_LENGTH]; /**< Name of the namespace, empty if the slot is free. */
+    };
+
+    NVSDelegateInterface *const m_nvsDelegate;                 /**< Delegate storing the buckets and the other values. */
+    size_t const m_bucketCount;                                /**< Number of buckets per namespace. */
+    MultiPrinterLoggerInterface *const m_logger;               /**< Pointer to the logger interface. */
+    DatabaseMutex m_bucketMutexes[PACKED_NVS_DELEGATE_LOCK_COUNT]; /**< Serialize the reads and rewrites of the buckets of a stripe. */
+    DatabaseMutex m_handleMutex;                               /**< Guards m_handles and the slots of m_filters. */
+    mutable OpenHandle m_handles[PACKED_NVS_DELEGATE_MAX_OPEN_HANDLES];         /**< Namespaces of the open handles. */
+    mutable NamespaceFilters m_filters[PACKED_NVS_DELEGATE_MAX_NAMESPACES];     /**< Bucket filters of the namespaces used. */
+
+    /**
+     * @brief Returns the bucket of a hash.
+     */
+    size_t bucketOf(uint32_t const hash) const;
+
+    /**
+     * @brief Returns the filter bit of a hash.
+     */
+    uint64_t filterBitOf(uint32_t const hash) const;
+
+    /**
+     * @brief Writes the bucket key of a bucket.
+     *
+     * @param bucket The bucket.
+     * @param out_bucketKey Buffer of NVS_DELEGATE_MAX_KEY_LENGTH bytes.
+     */
+    void bucketKeyOf(size_t const bucket, char *out_bucketKey) const;
+
+    /**
+     * @brief Returns the lock of a bucket.
+     */
+    DatabaseMutex const &bucketMutexOf(size_t const bucket) const;
+
+    /**
+     * @brief Returns the filter of a bucket of the namespace of a handle, taking a free slot for
+     *        a namespace not seen yet.
+     *
+     * @param handle The handle of the namespace.
+     * @param bucket The bucket.
+     * @return The filter, to be used with the lock of the bucket held, or nullptr if the namespace
+     *         of the handle is unknown or no slot is left.
+     */
+    BucketFilter *filterOf(NVSDelegateHandle_t const handle, size_t const bucket) const;
+
+    /**
+     * @brief Rebuilds a filter from the bucket as stored. Must be called with the lock of the bucket held.
+     */
+    void refreshFilter(BucketFilter *const filter, uint8_t const *const bucket, size_t const length) const;
+
+    /**
+     * @brief Forgets every filter of a namespace, or of every namespace.
+     *
+     * @param name The namespace, nullptr for every namespace.
+     */
+    void forgetFilters(char const *const name) const;
+
+    /**
+     * @brief Reads a bucket, a missing bucket is empty. Must be called with the lock of the bucket held.
+     *
+     * @param handle The handle of the namespace.
+     * @param bucketKey The bucket key.
+     * @param bucket Buffer of PACKED_NVS_DELEGATE_MAX_BUCKET_LENGTH bytes to receive the bucket.
+     * @param out_length Pointer to receive the length of the bucket.
+     * @return NVS_DELEGATE_OK, NVS_DELEGATE_UNKOWN_ERROR for a malformed bucket, or the delegate error.
+     */
+    NVSDelegateError_t loadBucket(
+        NVSDelegateHandle_t const handle, char const *const bucketKey, uint8_t *bucket, size_t *out_length) const;
+
+    /**
+     * @brief Writes a bucket, erasing it once empty. Must be called with the lock of the bucket held.
+     *
+     * @param handle The handle of the namespace.
+     * @param bucketKey The bucket key.
+     * @param bucket The bucket.
+     * @param length The length of the bucket.
+     * @return NVS_DELEGATE_OK or the delegate error.
+     */
+    NVSDelegateError_t storeBucket(
+        NVSDelegateHandle_t const handle, char const *const bucketKey, uint8_t const *const bucket, size_t const length) const;
+
+    /**
+     * @brief Finds the record of a key in a bucket.
+     *
+     * @param bucket The bucket.
+     * @param length The length of the bucket.
+     * @param key The key.
+     * @param out_recordLength Pointer to receive the length of the record.
+     * @return Offset of the record, or 0 if the key is not in the bucket.
+     */
+    size_t findRecord(uint8_t const *const bucket, size_t const length, char const *const key, size_t *out_recordLength) const;
+
+    /**
+     * @brief Checks that every record of a bucket lies within it.
+     */
+    bool isBucketValid(uint8_t const *const bucket, size_t const length) const;
+
+    /**
+     * @brief Checks if a key is a bucket key.
+     */
+    bool isBucketKey(char const *const key) const;
+
+    /**
+     * @brief Prints an error message and returns the error.
+     */
+    NVSDelegateError_t printAndReturnError(NVSDelegateError_t const error) const;
+
+    /**
+     * @brief Checks if the given key is valid.
+     */
+    bool isKeyValid(char const *const key) const;
+};
+
+#endif // PACKED_NVS_DELEGATE_H
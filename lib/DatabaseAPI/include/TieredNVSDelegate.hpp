@@ -0,0 +1,259 @@
+#ifndef TIERED_NVS_DELEGATE_H
+#define TIERED_NVS_DELEGATE_H
+
+#include <MultiPrinterLoggerInterface.hpp>
+#include <string.h>
+
+#include "DatabaseMutex.hpp"
+#include "NVSDelegateInterface.hpp"
+
+#define TIERED_NVS_DELEGATE_DEFAULT_THRESHOLD 1024  /**< Values at least this long go to a file by default. */
+#define TIERED_NVS_DELEGATE_MAX_DIRECTORY_LENGTH 32 /**< Length of the directory path, terminator included. */
+#define TIERED_NVS_DELEGATE_FORMAT_FILE 0x46        /**< Format flag of a pointer record. */
+#define TIERED_NVS_DELEGATE_POINTER_LENGTH 13       /**< Format flag, then file id, value length and CRC-32 as 4 little-endian bytes each. */
+#define TIERED_NVS_DELEGATE_MAX_OPEN_HANDLES 16     /**< Handles open at once whose namespace is known, needed to write files. */
+
+/**
+ * @brief NVSDelegateInterface that moves large string values to files.
+ *
+ * This delegate wraps another one. A string value of at least the threshold length is written
+ * to a file in a directory of a mounted filesystem, e.g. LittleFS on the device or a plain
+ * directory on the host, and the key keeps a 13-byte pointer record blob: the format flag,
+ * the id of the file, the length of the value and its CRC-32. Shorter values stay in the
+ * wrapped delegate, so both tiers share one key space. get_str reads a file straight into
+ * the caller's buffer.
+ *
+ * A file is named after its id, unique in the directory, and starts with the namespace and
+ * the key it belongs to. A new value is written to a new file before the pointer record is
+ * switched to it, and a value moving between the tiers is written before the entry of the other
+ * tier is erased, so a reset keeps either the old or the new value; the file it leaves behind
+ * is removed by removeOrphans(). Values may exceed the 4 KB NVS limit when
+ * NVS_DELEGATE_MAX_VALUE_LENGTH is raised, up to 65535.
+ */
+class TieredNVSDelegate : public NVSDelegateInterface
+{
+public:
+    /**
+     * @brief Constructor for TieredNVSDelegate, creates the directory if it is missing.
+     *
+     * @param nvsDelegate Pointer to the delegate storing the short values and the pointer records.
+     * @param directory Path of the directory holding the files, e.g. "/littlefs/tier", at most 31 characters.
+     * @param threshold Length from which a value is written to a file.
+     * @param logger Pointer to the logger interface.
+     */
+    TieredNVSDelegate(
+        NVSDelegateInterface *const nvsDelegate, char const *const directory,
+        size_t const threshold = TIERED_NVS_DELEGATE_DEFAULT_THRESHOLD, MultiPrinterLoggerInterface *const logger = nullptr);
+
+    /**
+     * @brief Destructor for TieredNVSDelegate.
+     */
+    ~TieredNVSDelegate();
+
+    /**
+     * @brief Opens a namespace of the wrapped delegate, remembering the namespace of the handle.
+     */
+    NVSDelegateError_t open(
+        char const *const name, NVSDelegateOpenMode_t const open_mode,
+        NVSDelegateHandle_t *out_handle) const override;
+
+    /**
+     * @brief Closes a namespace of the wrapped delegate, forgetting the namespace of the handle.
+     */
+    void close(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Sets a string value, in a file if it reaches the threshold.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the string value.
+     * @param value The string value to set.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid value.
+     *         - NVS_DELEGATE_READONLY: Attempt to write in READONLY mode.
+     *         - NVS_DELEGATE_NOT_ENOUGH_SPACE: Not enough space in the storage or the filesystem.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle, or more than
+     *           TIERED_NVS_DELEGATE_MAX_OPEN_HANDLES handles open for a value written to a file.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error.
+     */
+    NVSDelegateError_t set_str(
+        NVSDelegateHandle_t handle, char const *const key,
+        char const *const value) const override;
+
+    /**
+     * @brief Gets a string value, reading a file straight into the caller's buffer.
+     *
+     * @param handle The handle of the namespace.
+     * @param key The key for the string value.
+     * @param out_value Buffer to store the value, nullptr to only query the length.
+     * @param length Pointer to the length of the buffer; updated with the length of the value, including the null terminator.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_KEY_INVALID: Invalid key.
+     *         - NVS_DELEGATE_VALUE_INVALID: Invalid length pointer, or buffer too small for a value in a file.
+     *         - NVS_DELEGATE_HANDLE_INVALID: Invalid namespace handle.
+     *         - NVS_DELEGATE_KEY_NOT_FOUND: Key not found, or not a string.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: Unknown error, or a missing or corrupted file.
+     */
+    NVSDelegateError_t get_str(
+        NVSDelegateHandle_t handle, char const *const key,
+        char *out_value, size_t *length) const override;
+
+    /**
+     * @brief Sets an integer value in the wrapped delegate.
+     */
+    NVSDelegateError_t set_i64(
+        NVSDelegateHandle_t handle, char const *const key, int64_t const value) const override;
+
+    /**
+     * @brief Gets an integer value from the wrapped delegate.
+     */
+    NVSDelegateError_t get_i64(
+        NVSDelegateHandle_t handle, char const *const key, int64_t *out_value) const override;
+
+    /**
+     * @brief Sets a binary value in the wrapped delegate.
+     */
+    NVSDelegateError_t set_blob(
+        NVSDelegateHandle_t handle, char const *const key,
+        void const *const value, size_t const length) const override;
+
+    /**
+     * @brief Gets a binary value from the wrapped delegate.
+     */
+    NVSDelegateError_t get_blob(
+        NVSDelegateHandle_t handle, char const *const key,
+        void *out_value, size_t *length) const override;
+
+    /**
+     * @brief Erases a key of the wrapped delegate, and its file if it has one.
+     */
+    NVSDelegateError_t erase_key(
+        NVSDelegateHandle_t handle, char const *const key) const override;
+
+    /**
+     * @brief Erases a namespace of the wrapped delegate, then the files no key points to any more.
+     */
+    NVSDelegateError_t erase_all(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Erases every namespace of the wrapped delegate and every file of the directory.
+     */
+    NVSDelegateError_t erase_flash_all() const override;
+
+    /**
+     * @brief Commits a namespace of the wrapped delegate.
+     */
+    NVSDelegateError_t commit(NVSDelegateHandle_t handle) const override;
+
+    /**
+     * @brief Lists the keys of a namespace of the wrapped delegate, in both tiers.
+     */
+    NVSDelegateError_t list_keys(
+        char const *const name, NVSDelegateKeyCallback_t callback, void *context) const override;
+
+    /**
+     * @brief Gets the entry usage of the wrapped delegate; values kept in files are not counted.
+     */
+    NVSDelegateError_t get_stats(NVSDelegateStats_t *out_stats) const override;
+
+    /**
+     * @brief Gets the entries used by a namespace of the wrapped delegate; values kept in files are not counted.
+     */
+    NVSDelegateError_t get_used_entries(NVSDelegateHandle_t handle, size_t *out_entries) const override;
+
+    /**
+     * @brief Removes the files no pointer record refers to, left behind by a reset during a write.
+     *
+     * @param out_removed Optional pointer to receive the number of files removed.
+     * @return NVSDelegateError_t indicating the success or failure of the operation.
+     *         - NVS_DELEGATE_OK: Operation successful.
+     *         - NVS_DELEGATE_UNKOWN_ERROR: The directory could not be read.
+     */
+    NVSDelegateError_t removeOrphans(size_t *out_removed = nullptr) const;
+
+private:
+    NVSDelegateInterface *const m_nvsDelegate;                  /**< Delegate storing the short values and the pointer records. */
+    char m_directory[TIERED_NVS_DELEGATE_MAX_DIRECTORY_LENGTH]; /**< Directory holding the files, empty if invalid. */
+    size_t const m_threshold;                                   /**< Length from which a value is written to a file. */
+    MultiPrinterLoggerInterface *const m_logger;                /**< Pointer to the logger interface. */
+    DatabaseMutex m_fileMutex;                                  /**< Serializes file writes, removals and id allocation. */
+    mutable uint32_t m_lastId;                                  /**< Highest file id in the directory, guarded by m_fileMutex. */
+    mutable bool m_lastIdLoaded;                                /**< true once m_lastId is read from the directory. */
+    DatabaseMutex m_handleMutex;                                /**< Guards m_handles. */
+
+    /**
+     * @brief The namespace of an open handle.
+     */
+    struct OpenHandle
+    {
+        NVSDelegateHandle_t handle;                  /**< The handle. */
+        char name[NVS_DELEGATE_MAX_NAMESPACE_LENGTH]; /**< Its namespace, empty for a free entry. */
+    };
+
+    mutable OpenHandle m_handles[TIERED_NVS_DELEGATE_MAX_OPEN_HANDLES]; /**< Namespaces of the open handles. */
+
+    /**
+     * @brief A pointer record, decoded.
+     */
+    struct Pointer
+    {
+        uint32_t id;     /**< Id of the file. */
+        uint32_t length; /**< Length of the value, without the null terminator. */
+        uint32_t crc;    /**< CRC-32 of the value. */
+    };
+
+    /**
+     * @brief Reads the pointer record of a key.
+     *
+     * @return NVS_DELEGATE_OK with the record, NVS_DELEGATE_KEY_NOT_FOUND if the key has none, or the delegate error.
+     */
+    NVSDelegateError_t readPointer(NVSDelegateHandle_t const handle, char const *const key, Pointer *out_pointer) const;
+
+    /**
+     * @brief Finds the namespace of an open handle.
+     *
+     * @return true with the namespace copied into name, false if the handle is unknown.
+     */
+    bool namespaceOf(NVSDelegateHandle_t const handle, char *name) const;
+
+    /**
+     * @brief Writes a value to a new file, behind a header naming its namespace and key.
+     *
+     * @return NVS_DELEGATE_OK with the id of the file, or NVS_DELEGATE_NOT_ENOUGH_SPACE.
+     */
+    NVSDelegateError_t writeFile(
+        char const *const name, char const *const key, char const *const value, size_t const length,
+        uint32_t *out_id) const;
+
+    /**
+     * @brief Checks if a file is still referred to by the pointer record of the key in its header.
+     *
+     * @return true if it is, or if that cannot be decided; false for an orphan.
+     */
+    bool isReferenced(uint32_t const id) const;
+
+    /**
+     * @brief Writes the path of the file with an id into path.
+     */
+    void filePath(uint32_t const id, char *path) const;
+
+    /**
+     * @brief Removes the file with an id, if it exists.
+     */
+    void removeFile(uint32_t const id) const;
+
+    /**
+     * @brief Prints an error message and returns the error.
+     */
+    NVSDelegateError_t printAndReturnError(NVSDelegateError_t const error) const;
+
+    /**
+     * @brief Checks if the given key is valid.
+     */
+    bool isKeyValid(char const *const key) const;
+};
+
+#endif // TIERED_NVS_DELEGATE_H
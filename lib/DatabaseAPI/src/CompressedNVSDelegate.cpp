@@ -0,0 +1,236 @@
+#include "CompressedNVSDelegate.hpp"
+
+#include <stdlib.h>
+
+#include "DatabaseLZ4.hpp"
+#include "NVSDelegateUtils.hpp"
+
+CompressedNVSDelegate::CompressedNVSDelegate(NVSDelegateInterface *const nvsDelegate, MultiPrinterLoggerInterface *const logger)
+    : m_nvsDelegate(nvsDelegate), m_logger(logger)
+{
+    Log_Debug(m_logger, "CompressedNVSDelegate created");
+}
+
+CompressedNVSDelegate::~CompressedNVSDelegate()
+{
+    Log_Debug(m_logger, "CompressedNVSDelegate destroyed");
+}
+
+NVSDelegateError_t CompressedNVSDelegate::open(
+    char const *const name, NVSDelegateOpenMode_t const open_mode,
+    NVSDelegateHandle_t *out_handle) const
+{
+    return m_nvsDelegate->open(name, open_mode, out_handle);
+}
+
+void CompressedNVSDelegate::close(NVSDelegateHandle_t handle) const
+{
+    m_nvsDelegate->close(handle);
+}
+
+NVSDelegateError_t CompressedNVSDelegate::set_str(
+    NVSDelegateHandle_t handle, char const *const key,
+    char const *const value) const
+{
+    // Check if the key and value are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (value == nullptr || strlen(value) == 0 || strlen(value) >= NVS_DELEGATE_MAX_VALUE_LENGTH)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    size_t const valueLength = strlen(value);
+    size_t compressedLength = 0;
+    uint8_t *const compressed = valueLength >= COMPRESSED_NVS_DELEGATE_MIN_LENGTH
+                                    ? compressValue(value, valueLength, &compressedLength)
+                                    : nullptr;
+
+    // The new representation is written before the other one is erased
+    if (compressed == nullptr)
+    {
+        Log_Verbose(m_logger, "CompressedNVSDelegate setting key '%s' verbatim", key);
+        NVSDelegateError_t err = m_nvsDelegate->set_str(handle, key, value);
+        if (err == NVS_DELEGATE_OK)
+            err = NVSDelegateUtils::eraseOtherType(m_nvsDelegate, handle, key, false, value, 0);
+        return err;
+    }
+
+    Log_Verbose(m_logger, "CompressedNVSDelegate setting key '%s', %zu bytes compressed to %zu", key, valueLength, compressedLength);
+    NVSDelegateError_t err = m_nvsDelegate->set_blob(handle, key, compressed, compressedLength);
+    if (err == NVS_DELEGATE_OK)
+        err = NVSDelegateUtils::eraseOtherType(m_nvsDelegate, handle, key, true, compressed, compressedLength);
+    free(compressed);
+    return err;
+}
+
+NVSDelegateError_t CompressedNVSDelegate::get_str(
+    NVSDelegateHandle_t handle, char const *const key,
+    char *out_value, size_t *length) const
+{
+    // Check if the key and the length pointer are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (length == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    // Values stored verbatim are the common case
+    NVSDelegateError_t err = m_nvsDelegate->get_str(handle, key, out_value, length);
+    if (err != NVS_DELEGATE_KEY_NOT_FOUND)
+        return err;
+
+    size_t blobLength = 0;
+    err = m_nvsDelegate->get_blob(handle, key, nullptr, &blobLength);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+    if (blobLength <= COMPRESSED_NVS_DELEGATE_HEADER_LENGTH)
+        return NVS_DELEGATE_KEY_NOT_FOUND;
+
+    uint8_t *const blob = static_cast<uint8_t *>(malloc(blobLength));
+    if (blob == nullptr)
+        return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+
+    err = m_nvsDelegate->get_blob(handle, key, blob, &blobLength);
+
+    // A blob without the header is not a string
+    if (err == NVS_DELEGATE_OK && (blobLength <= COMPRESSED_NVS_DELEGATE_HEADER_LENGTH || blob[0] != COMPRESSED_NVS_DELEGATE_FORMAT_LZ4))
+        err = NVS_DELEGATE_KEY_NOT_FOUND;
+    if (err != NVS_DELEGATE_OK)
+    {
+        free(blob);
+        return err;
+    }
+
+    Log_Verbose(m_logger, "CompressedNVSDelegate getting compressed value for key '%s'", key);
+
+    size_t const valueLength = blob[1] | (blob[2] << 8);
+    if (!NVSDelegateUtils::fitsString(out_value, *length, valueLength))
+        err = printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+    else if (out_value != nullptr)
+    {
+        if (!DatabaseLZ4::decompress(blob + COMPRESSED_NVS_DELEGATE_HEADER_LENGTH, blobLength - COMPRESSED_NVS_DELEGATE_HEADER_LENGTH,
+                                          reinterpret_cast<uint8_t *>(out_value), valueLength))
+            err = printAndReturnError(NVS_DELEGATE_UNKOWN_ERROR);
+        else
+            out_value[valueLength] = '\0';
+    }
+    free(blob);
+
+    if (err == NVS_DELEGATE_OK)
+        *length = valueLength + 1;
+    return err;
+}
+
+NVSDelegateError_t CompressedNVSDelegate::set_i64(
+    NVSDelegateHandle_t handle, char const *const key, int64_t const value) const
+{
+    return m_nvsDelegate->set_i64(handle, key, value);
+}
+
+NVSDelegateError_t CompressedNVSDelegate::get_i64(
+    NVSDelegateHandle_t handle, char const *const key, int64_t *out_value) const
+{
+    return m_nvsDelegate->get_i64(handle, key, out_value);
+}
+
+NVSDelegateError_t CompressedNVSDelegate::set_blob(
+    NVSDelegateHandle_t handle, char const *const key,
+    void const *const value, size_t const length) const
+{
+    return m_nvsDelegate->set_blob(handle, key, value, length);
+}
+
+NVSDelegateError_t CompressedNVSDelegate::get_blob(
+    NVSDelegateHandle_t handle, char const *const key,
+    void *out_value, size_t *length) const
+{
+    return m_nvsDelegate->get_blob(handle, key, out_value, length);
+}
+
+NVSDelegateError_t CompressedNVSDelegate::erase_key(
+    NVSDelegateHandle_t handle, char const *const key) const
+{
+    return m_nvsDelegate->erase_key(handle, key);
+}
+
+NVSDelegateError_t CompressedNVSDelegate::erase_all(NVSDelegateHandle_t handle) const
+{
+    return m_nvsDelegate->erase_all(handle);
+}
+
+NVSDelegateError_t CompressedNVSDelegate::erase_flash_all() const
+{
+    return m_nvsDelegate->erase_flash_all();
+}
+
+NVSDelegateError_t CompressedNVSDelegate::commit(NVSDelegateHandle_t handle) const
+{
+    return m_nvsDelegate->commit(handle);
+}
+
+NVSDelegateError_t CompressedNVSDelegate::list_keys(
+    char const *const name, NVSDelegateKeyCallback_t callback, void *context) const
+{
+    return m_nvsDelegate->list_keys(name, callback, context);
+}
+
+NVSDelegateError_t CompressedNVSDelegate::get_stats(NVSDelegateStats_t *out_stats) const
+{
+    return m_nvsDelegate->get_stats(out_stats);
+}
+
+NVSDelegateError_t CompressedNVSDelegate::get_used_entries(NVSDelegateHandle_t handle, size_t *out_entries) const
+{
+    return m_nvsDelegate->get_used_entries(handle, out_entries);
+}
+
+uint8_t *CompressedNVSDelegate::compressValue(char const *const value, size_t const valueLength, size_t *out_length) const
+{
+    // The blob must come out shorter than the string it replaces, terminator included
+    uint8_t *const compressed = static_cast<uint8_t *>(malloc(valueLength));
+    if (compressed == nullptr)
+        return nullptr;
+
+    size_t const length = DatabaseLZ4::compress(reinterpret_cast<uint8_t const *>(value), valueLength,
+                                                compressed + COMPRESSED_NVS_DELEGATE_HEADER_LENGTH,
+                                                valueLength - COMPRESSED_NVS_DELEGATE_HEADER_LENGTH);
+    if (length == 0)
+    {
+        free(compressed);
+        return nullptr;
+    }
+
+    compressed[0] = COMPRESSED_NVS_DELEGATE_FORMAT_LZ4;
+    compressed[1] = static_cast<uint8_t>(valueLength);
+    compressed[2] = static_cast<uint8_t>(valueLength >> 8);
+    *out_length = COMPRESSED_NVS_DELEGATE_HEADER_LENGTH + length;
+    return compressed;
+}
+
+NVSDelegateError_t CompressedNVSDelegate::printAndReturnError(NVSDelegateError_t const error) const
+{
+    switch (error)
+    {
+    case NVS_DELEGATE_OK:
+        break;
+    case NVS_DELEGATE_KEY_INVALID:
+        Log_Error(m_logger, "Invalid key");
+        break;
+    case NVS_DELEGATE_VALUE_INVALID:
+        Log_Error(m_logger, "Invalid value");
+        break;
+    case NVS_DELEGATE_NOT_ENOUGH_SPACE:
+        Log_Error(m_logger, "Not enough space");
+        break;
+    default:
+        Log_Error(m_logger, "Unknown error");
+        break;
+    }
+
+    return error;
+}
+
+bool CompressedNVSDelegate::isKeyValid(const char *const key) const
+{
+    return key && strlen(key) > 0 && strlen(key) < NVS_DELEGATE_MAX_KEY_LENGTH;
+}
@@ -1,23 +1,219 @@
 #include "DatabaseAPI.hpp"
 
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "DatabaseHash.hpp"
+
+// Default clock keys expire by, the system time in seconds
+static uint32_t systemClock()
+{
+    return static_cast<uint32_t>(time(nullptr));
+}
+
+// Namespace open through a DatabaseAPI, claimed by its constructor and released by its destructor
+struct DatabaseOpenNamespace
+{
+    NVSDelegateInterface const *delegate;
+    char name[NVS_DELEGATE_MAX_NAMESPACE_LENGTH];
+};
+
+static DatabaseMutex openNamespacesMutex;
+static DatabaseOpenNamespace openNamespaces[DATABASE_MAX_INSTANCES];
+
+// The namespace given to the constructor, or "DEFAULT_NVS" if it is invalid
+static char const *validNamespace(char const *const nvsNamespace)
+{
+    if (nvsNamespace == nullptr || strlen(nvsNamespace) >= NVS_DELEGATE_MAX_NAMESPACE_LENGTH || strlen(nvsNamespace) == 0)
+        return "DEFAULT_NVS";
+    return nvsNamespace;
+}
+
+// Returns the delegate if no other DatabaseAPI has the namespace open through it, nullptr otherwise
+static NVSDelegateInterface *claimNamespace(NVSDelegateInterface *const nvsDelegate, char const *const name)
+{
+    if (nvsDelegate == nullptr)
+        return nullptr;
+
+    DatabaseLockGuard guard(openNamespacesMutex);
+    DatabaseOpenNamespace *slot = nullptr;
+    for (size_t i = 0; i < DATABASE_MAX_INSTANCES; ++i)
+    {
+        if (openNamespaces[i].delegate == nullptr)
+        {
+            if (slot == nullptr)
+                slot = &openNamespaces[i];
+        }
+        else if (openNamespaces[i].delegate == nvsDelegate && strcmp(openNamespaces[i].name, name) == 0)
+            return nullptr;
+    }
+    if (slot == nullptr)
+        return nullptr;
+
+    slot->delegate = nvsDelegate;
+    strcpy(slot->name, name);
+    return nvsDelegate;
+}
+
+static void releaseNamespace(NVSDelegateInterface const *const nvsDelegate, char const *const name)
+{
+    DatabaseLockGuard guard(openNamespacesMutex);
+    for (size_t i = 0; i < DATABASE_MAX_INSTANCES; ++i)
+    {
+        if (openNamespaces[i].delegate == nvsDelegate && strcmp(openNamespaces[i].name, name) == 0)
+        {
+            openNamespaces[i].delegate = nullptr;
+            return;
+        }
+    }
+}
+
+// Keys of a namespace collected by collectKey, erased once the listing is over
+struct DatabaseKeyList
+{
+    char (*keys)[NVS_DELEGATE_MAX_KEY_LENGTH];
+    size_t count;
+    size_t capacity;
+    bool failed;
+};
+
+// NVS entries used by a string or a blob of the given length, see estimateEntries
+#define DATABASE_STRING_ENTRIES(length) (1 + ((length) + 31) / 32)
+#define DATABASE_BLOB_ENTRIES(length) (2 + ((length) + 31) / 32)
+
+// Entries not used, less the page NVS keeps free for garbage collection
+static size_t availableEntries(NVSDelegateStats_t const &stats)
+{
+    size_t const reserved = stats.usedEntries + DATABASE_PAGE_ENTRIES;
+    return stats.totalEntries > reserved ? stats.totalEntries - reserved : 0;
+}
+
+// NVSDelegateKeyCallback_t counting the keys not reserved by the library
+static bool countUserKey(char const *const key, void *context)
+{
+    if (key[0] != '~')
+        (*static_cast<size_t *>(context))++;
+    return true;
+}
+
+// NVSDelegateKeyCallback_t appending every key to a DatabaseKeyList
+static bool collectKey(char const *const key, void *context)
+{
+    DatabaseKeyList *const list = static_cast<DatabaseKeyList *>(context);
+    if (list->count == list->capacity)
+    {
+        size_t const capacity = list->capacity ? list->capacity * 2 : 8;
+        char(*keys)[NVS_DELEGATE_MAX_KEY_LENGTH] = static_cast<char(*)[NVS_DELEGATE_MAX_KEY_LENGTH]>(
+            realloc(list->keys, capacity * NVS_DELEGATE_MAX_KEY_LENGTH));
+        if (keys == nullptr)
+        {
+            list->failed = true;
+            return false;
+        }
+        list->keys = keys;
+        list->capacity = capacity;
+    }
+
+    strncpy(list->keys[list->count], key, NVS_DELEGATE_MAX_KEY_LENGTH - 1);
+    list->keys[list->count][NVS_DELEGATE_MAX_KEY_LENGTH - 1] = '\0';
+    list->count++;
+    return true;
+}
+
+// Defaults and their override bits, filled by markOverride
+struct DatabaseDefaultsScan
+{
+    DatabaseDefaultsTable const *defaults;
+    uint8_t *overrides;
+};
+
+// NVSDelegateKeyCallback_t marking the default of every stored key as overridden
+static bool markOverride(char const *const key, void *context)
+{
+    DatabaseDefaultsScan *const scan = static_cast<DatabaseDefaultsScan *>(context);
+    size_t index;
+    if (scan->defaults->find(key, &index))
+        scan->overrides[index / 8] |= 1 << (index % 8);
+    return true;
+}
+
 // Constructor for DatabaseAPI
 DatabaseAPI::DatabaseAPI(
     NVSDelegateInterface *const nvsDelegate, char const *const nvsNamespace,
     MultiPrinterLoggerInterface *const logger)
-    : _nvsDelegate(nvsDelegate), _logger(logger)
+    : _nvsDelegate(claimNamespace(nvsDelegate, validNamespace(nvsNamespace))), _logger(logger), _snapshot(nullptr), _snapshotEpoch(0),
+      _counterMaxPendingChanges(1), _counterMaxPendingMs(0), _expiryEnabled(false), _expiringKeys(0), _clock(systemClock),
+      _writeElision(false), _elidedWrites(0), _generation(0), _staleGeneration(false),
+      _defaultOverrides(nullptr), _defaultsEnabled(false), _subscriptions(logger),
+      _lastWriteMs(xTaskGetTickCount() * portTICK_PERIOD_MS)
 {
+    _snapshotReaders[0].store(0);
+    _snapshotReaders[1].store(0);
+
     // If the provided namespace is invalid, use the default namespace "DEFAULT_NVS"
-    if (nvsNamespace == nullptr || strlen(nvsNamespace) >= NVS_DELEGATE_MAX_NAMESPACE_LENGTH || strlen(nvsNamespace) == 0)
-        strcpy(_nvsNamespace, "DEFAULT_NVS");
+    strcpy(_nvsNamespace, validNamespace(nvsNamespace));
+
+    // The alternate generation lives in a namespace derived from the base one. A base namespace
+    // too long for the suffix is identified by the FNV-1a hash of its full name, so that
+    // namespaces sharing their first characters never share a shadow namespace.
+    size_t const length = strlen(_nvsNamespace);
+    if (length < NVS_DELEGATE_MAX_NAMESPACE_LENGTH - strlen(DATABASE_SHADOW_SUFFIX))
+    {
+        memcpy(_shadowNamespace, _nvsNamespace, length);
+        strcpy(_shadowNamespace + length, DATABASE_SHADOW_SUFFIX);
+    }
     else
-        strcpy(_nvsNamespace, nvsNamespace);
+    {
+        snprintf(_shadowNamespace, sizeof(_shadowNamespace), "%.4s~%08" PRIx32 DATABASE_SHADOW_SUFFIX,
+                 _nvsNamespace, DatabaseHash::fnv1a(_nvsNamespace));
+    }
+
+    // The generation and the caches in RAM are not shared, a second instance is left without a delegate
+    if (nvsDelegate && !_nvsDelegate)
+        Log_Error(_logger, "Namespace '%s' is already open through another DatabaseAPI, or too many are", _nvsNamespace);
 
     Log_Debug(_logger, "DatabaseAPI created for namespace '%s'", _nvsNamespace);
+
+    // Select the active generation, then complete an atomic commit interrupted by a reset
+    // before anything reads the namespace. A namespace never written has neither.
+    if (_nvsDelegate)
+    {
+        NVSDelegateError_t err = loadGeneration();
+        if (err == NVS_DELEGATE_OK)
+            err = recoverJournal();
+
+        // Keys given a TTL before the reset are filtered from the first read
+        if (err == NVS_DELEGATE_OK)
+            err = loadExpiry();
+        else if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+            _expiryEnabled.store(true);
+        if (err != NVS_DELEGATE_OK && err != NVS_DELEGATE_KEY_NOT_FOUND)
+            Log_Error(_logger, "Namespace '%s' could not be recovered", _nvsNamespace);
+    }
 }
 
 // Destructor for DatabaseAPI
 DatabaseAPI::~DatabaseAPI()
 {
+    // No callback may run into a database being destroyed
+    _subscriptions.stop();
+
+    // Counter changes still pending are written on a clean shutdown
+    if (_nvsDelegate)
+    {
+        DatabaseLockGuard guard(_writeMutex);
+        persistCounters();
+    }
+
+    DatabaseSnapshot::destroy(_snapshot.load());
+    free(_defaultOverrides);
+    if (_nvsDelegate)
+        releaseNamespace(_nvsDelegate, _nvsNamespace);
     Log_Debug(_logger, "DatabaseAPI destroyed");
 }
 
@@ -35,25 +231,66 @@ DatabaseError_t DatabaseAPI::get(
     if (value == nullptr || maxValueLength == 0)
         return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
 
+    // A key left at its default is served from the defaults table, without reading the flash
+    char const *defaultValue;
+    if (findDefault(key, &defaultValue))
+    {
+        size_t const length = strlen(defaultValue) + 1;
+        if (length > maxValueLength)
+            return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+        memcpy(value, defaultValue, length);
+
+        Log_Verbose(_logger, "Key '%s' retrieved from defaults", key);
+        return DATABASE_OK;
+    }
+
+    // An expired key is not found, without reading the flash
+    if (isExpired(key))
+        return mapErrorAndPrint(NVS_DELEGATE_KEY_NOT_FOUND);
+
+    // Serve the value from the snapshot when snapshot mode is enabled
+    uint32_t slot;
+    DatabaseSnapshot const *const snapshot = acquireSnapshot(&slot);
+    if (snapshot)
+    {
+        size_t length = 0;
+        char const *const found = snapshot->find(key, &length);
+        if (found && length <= maxValueLength)
+            memcpy(value, found, length);
+        releaseSnapshot(slot);
+
+        if (found == nullptr)
+            return mapErrorAndPrint(NVS_DELEGATE_KEY_NOT_FOUND);
+        if (length > maxValueLength)
+            return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+        Log_Verbose(_logger, "Key '%s' retrieved from snapshot", key);
+        return DATABASE_OK;
+    }
+
     // Open the NVS namespace in READONLY mode
     NVSDelegateHandle_t handle;
-    NVSDelegateError_t err = _nvsDelegate->open(_nvsNamespace, NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
 
     // Handle specific errors and return appropriate DatabaseError_t value
     if (err != NVS_DELEGATE_OK)
         return mapErrorAndPrint(err);
 
     // Check the length of the value associated with the key
-    err = _nvsDelegate->get_str(handle, key, nullptr, &maxValueLength);
+    size_t valueLength = 0;
+    err = _nvsDelegate->get_str(handle, key, nullptr, &valueLength);
 
     // Handle specific errors and return appropriate DatabaseError_t value
+    if (err == NVS_DELEGATE_OK && valueLength > maxValueLength)
+        err = NVS_DELEGATE_VALUE_INVALID;
     if (err != NVS_DELEGATE_OK)
     {
         _nvsDelegate->close(handle);
         return mapErrorAndPrint(err);
     }
 
-    // Retrieve the value associated with the key
+    // Retrieve the value associated with the key, bounded by the caller's buffer since
+    // the value may have been rewritten by another task after its length was read
     err = _nvsDelegate->get_str(handle, key, value, &maxValueLength);
 
     // Close the NVS namespace
@@ -69,6 +306,12 @@ DatabaseError_t DatabaseAPI::get(
 
 // Sets the value for the specified key in the database
 DatabaseError_t DatabaseAPI::set(char const *const key, char const *const value)
+{
+    return set(key, value, 0);
+}
+
+// Sets the value for the specified key, expiring after ttlSeconds
+DatabaseError_t DatabaseAPI::set(char const *const key, char const *const value, uint32_t const ttlSeconds)
 {
     // Ensure that the Delegate is initialized
     if (!_nvsDelegate)
@@ -80,32 +323,68 @@ DatabaseError_t DatabaseAPI::set(char const *const key, char const *const value)
     if (value == nullptr || strlen(value) >= NVS_DELEGATE_MAX_VALUE_LENGTH || strlen(value) == 0)
         return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
 
+    DatabaseLockGuard guard(_writeMutex);
+    _lastWriteMs.store(xTaskGetTickCount() * portTICK_PERIOD_MS);
+
+    // A pending counter of the key would later be flushed over the string
+    _counters.remove(key);
+
+    // The persisted expiry table is loaded first, so that writing it keeps the other keys and
+    // a plain set clears the expiry the key was given before a reset
+    NVSDelegateError_t err = loadExpiry();
+    if (err != NVS_DELEGATE_OK)
+        return mapErrorAndPrint(err);
+
     // Open the NVS namespace in READWRITE mode
     NVSDelegateHandle_t handle;
-    NVSDelegateError_t err = _nvsDelegate->open(_nvsNamespace, NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+    err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
 
     // Handle specific errors and return appropriate DatabaseError_t value
     if (err != NVS_DELEGATE_OK)
         return mapErrorAndPrint(err);
 
+    // A value already stored, with no expiry to change, is neither written nor committed
+    if (ttlSeconds == 0 && !(_expiringKeys.load() && _expiry.find(key)) && isUnchanged(handle, key, value))
+    {
+        _nvsDelegate->close(handle);
+        _elidedWrites++;
+        Log_Verbose(_logger, "Key '%s' unchanged, write elided", key);
+        return DATABASE_OK;
+    }
+
+    // Write the expiry before the value, a crash in between can only expire the previous value
+    int64_t const started = esp_timer_get_time();
+    err = writeExpiry(handle, key, ttlSeconds > 0 ? _clock() + ttlSeconds : 0);
+
     // Set the value for the specified key
-    err = _nvsDelegate->set_str(handle, key, value);
+    if (err == NVS_DELEGATE_OK)
+        err = _nvsDelegate->set_str(handle, key, value);
 
     // Handle specific errors and return appropriate DatabaseError_t value
     if (err != NVS_DELEGATE_OK)
     {
         _nvsDelegate->close(handle);
+        rememberValue(key, nullptr);
         return mapErrorAndPrint(err);
     }
 
     err = _nvsDelegate->commit(handle);
+    _latency.record(DATABASE_OPERATION_SET, static_cast<uint32_t>(esp_timer_get_time() - started));
 
     // Close the NVS namespace
     _nvsDelegate->close(handle);
 
     // Handle specific errors and return appropriate DatabaseError_t value
     if (err != NVS_DELEGATE_OK)
+    {
+        rememberValue(key, nullptr);
         return mapErrorAndPrint(err);
+    }
+
+    updateSnapshot(key, value);
+    rememberValue(key, value);
+    overrideDefault(key, true);
+    _subscriptions.publish(key, DATABASE_CHANGE_SET);
 
     Log_Verbose(_logger, "Key '%s' set successfully", key);
     return DATABASE_OK;
@@ -122,16 +401,30 @@ DatabaseError_t DatabaseAPI::remove(char const *const key)
     if (!isKeyValid(key))
         return mapErrorAndPrint(NVS_DELEGATE_KEY_INVALID);
 
+    DatabaseLockGuard guard(_writeMutex);
+    _lastWriteMs.store(xTaskGetTickCount() * portTICK_PERIOD_MS);
+
+    // A counter leaves the RAM table too, even if it was never persisted
+    DatabaseCounters::Counter const *const counter = _counters.find(key);
+    bool const pendingCounter = counter && counter->pending > 0;
+    _counters.remove(key);
+    rememberValue(key, nullptr);
+
     // Open the NVS namespace in READWRITE mode
     NVSDelegateHandle_t handle;
-    NVSDelegateError_t err = _nvsDelegate->open(_nvsNamespace, NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
 
     // Handle specific errors and return appropriate DatabaseError_t value
     if (err != NVS_DELEGATE_OK)
         return mapErrorAndPrint(err);
 
-    // Erase the key and its associated value
-    err = _nvsDelegate->erase_key(handle, key);
+    // Erase the key and its associated value, and its expiry if any
+    int64_t const started = esp_timer_get_time();
+    err = writeExpiry(handle, key, 0);
+    if (err == NVS_DELEGATE_OK)
+        err = _nvsDelegate->erase_key(handle, key);
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND && pendingCounter)
+        err = NVS_DELEGATE_OK;
 
     // Handle specific errors and return appropriate DatabaseError_t value
     if (err != NVS_DELEGATE_OK)
@@ -141,6 +434,7 @@ DatabaseError_t DatabaseAPI::remove(char const *const key)
     }
 
     err = _nvsDelegate->commit(handle);
+    _latency.record(DATABASE_OPERATION_REMOVE, static_cast<uint32_t>(esp_timer_get_time() - started));
 
     // Close the NVS namespace
     _nvsDelegate->close(handle);
@@ -149,10 +443,179 @@ DatabaseError_t DatabaseAPI::remove(char const *const key)
     if (err != NVS_DELEGATE_OK)
         return mapErrorAndPrint(err);
 
+    updateSnapshot(key, nullptr);
+    overrideDefault(key, false);
+    _subscriptions.publish(key, DATABASE_CHANGE_REMOVED);
+
     Log_Verbose(_logger, "Key '%s' removed successfully", key);
     return DATABASE_OK;
 }
 
+// Sets a value unless the predicted latency exceeds the budget
+DatabaseError_t DatabaseAPI::setWithin(char const *const key, char const *const value, uint32_t const budgetUs)
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    // Validate input parameters
+    if (!isKeyValid(key))
+        return mapErrorAndPrint(NVS_DELEGATE_KEY_INVALID);
+    if (value == nullptr || strlen(value) >= NVS_DELEGATE_MAX_VALUE_LENGTH || strlen(value) == 0)
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    return runWithin(DATABASE_OPERATION_SET, key, value, budgetUs);
+}
+
+// Removes a key unless the predicted latency exceeds the budget
+DatabaseError_t DatabaseAPI::removeWithin(char const *const key, uint32_t const budgetUs)
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    // Validate input parameters
+    if (!isKeyValid(key))
+        return mapErrorAndPrint(NVS_DELEGATE_KEY_INVALID);
+
+    return runWithin(DATABASE_OPERATION_REMOVE, key, nullptr, budgetUs);
+}
+
+// Returns the latency predicted for the next write of an operation
+uint32_t DatabaseAPI::getPredictedLatency(DatabaseOperation_t const operation) const
+{
+    DatabaseLockGuard guard(_writeMutex);
+    return _latency.predict(operation);
+}
+
+// Returns the time since the last write was requested
+uint32_t DatabaseAPI::getIdleTime() const
+{
+    return xTaskGetTickCount() * portTICK_PERIOD_MS - _lastWriteMs.load();
+}
+
+// Reads the entry usage of the storage
+DatabaseError_t DatabaseAPI::getSpaceStats(NVSDelegateStats_t *stats) const
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    if (stats == nullptr)
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    return mapErrorAndPrint(_nvsDelegate->get_stats(stats));
+}
+
+// Returns the entries writes can still take
+DatabaseError_t DatabaseAPI::getAvailableEntries(size_t *entries) const
+{
+    if (entries == nullptr)
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    NVSDelegateStats_t stats;
+    DatabaseError_t const err = getSpaceStats(&stats);
+    if (err != DATABASE_OK)
+        return err;
+
+    *entries = availableEntries(stats);
+    return DATABASE_OK;
+}
+
+// Computes the entries a commit of a batch would write
+DatabaseError_t DatabaseAPI::estimateEntries(DatabaseBatch const &batch, bool const atomic, size_t *entries) const
+{
+    if (entries == nullptr)
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    size_t count = 0;
+    for (size_t i = 0; i < batch.count(); ++i)
+        if (batch.at(i).value)
+            count += DATABASE_STRING_ENTRIES(strlen(batch.at(i).value) + 1);
+
+    if (atomic && batch.count() > 0)
+        count += DATABASE_BLOB_ENTRIES(batch.serializedLength());
+
+    *entries = count;
+    return DATABASE_OK;
+}
+
+// Lists the keys of the namespace
+DatabaseError_t DatabaseAPI::listKeys(DatabaseKeyVisitor_t const visitor, void *const context) const
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    if (visitor == nullptr)
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    // Collect the keys first, the visitor runs once the listing is over
+    DatabaseKeyList list = {nullptr, 0, 0, false};
+    NVSDelegateError_t err;
+    {
+        DatabaseLockGuard guard(_writeMutex);
+        err = _nvsDelegate->list_keys(activeNamespace(), collectKey, &list);
+    }
+    if (err == NVS_DELEGATE_OK && list.failed)
+        err = NVS_DELEGATE_NOT_ENOUGH_SPACE;
+
+    for (size_t i = 0; i < list.count && err == NVS_DELEGATE_OK; ++i)
+    {
+        char const *const key = list.keys[i];
+        if (key[0] == '~' || isExpired(key))
+            continue;
+        if (!visitor(key, context))
+            break;
+    }
+    free(list.keys);
+
+    return mapErrorAndPrint(err);
+}
+
+// Reports the entries and keys of the namespace
+DatabaseError_t DatabaseAPI::getNamespaceUsage(DatabaseNamespaceUsage_t *usage) const
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    if (usage == nullptr)
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    usage->keys = 0;
+    usage->entries = 0;
+    usage->staleEntries = 0;
+
+    DatabaseLockGuard guard(_writeMutex);
+
+    // A namespace never written uses nothing
+    NVSDelegateHandle_t handle;
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+    if (err == NVS_DELEGATE_OK)
+    {
+        err = _nvsDelegate->get_used_entries(handle, &usage->entries);
+        _nvsDelegate->close(handle);
+    }
+    if (err == NVS_DELEGATE_OK)
+        err = _nvsDelegate->list_keys(activeNamespace(), countUserKey, &usage->keys);
+
+    // The previous generation counts until it is erased
+    if (err == NVS_DELEGATE_OK && _staleGeneration)
+    {
+        err = _nvsDelegate->open(generationNamespace(_generation.load() ? 0 : 1), NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+        if (err == NVS_DELEGATE_OK)
+        {
+            err = _nvsDelegate->get_used_entries(handle, &usage->staleEntries);
+            _nvsDelegate->close(handle);
+        }
+    }
+
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+        err = NVS_DELEGATE_OK;
+    return mapErrorAndPrint(err);
+}
+
 // Checks if the specified key exists in the database
 DatabaseError_t DatabaseAPI::isExist(char const *const key) const
 {
@@ -164,9 +627,36 @@ DatabaseError_t DatabaseAPI::isExist(char const *const key) const
     if (!isKeyValid(key))
         return mapErrorAndPrint(NVS_DELEGATE_KEY_INVALID);
 
+    // A key left at its default exists, without reading the flash
+    char const *defaultValue;
+    if (findDefault(key, &defaultValue))
+    {
+        Log_Verbose(_logger, "Key '%s' exists in defaults", key);
+        return DATABASE_OK;
+    }
+
+    // An expired key is not found, without reading the flash
+    if (isExpired(key))
+        return mapErrorAndPrint(NVS_DELEGATE_KEY_NOT_FOUND);
+
+    // Look the key up in the snapshot when snapshot mode is enabled
+    uint32_t slot;
+    DatabaseSnapshot const *const snapshot = acquireSnapshot(&slot);
+    if (snapshot)
+    {
+        bool const found = snapshot->find(key, nullptr) != nullptr;
+        releaseSnapshot(slot);
+
+        if (!found)
+            return mapErrorAndPrint(NVS_DELEGATE_KEY_NOT_FOUND);
+
+        Log_Verbose(_logger, "Key '%s' exists in snapshot", key);
+        return DATABASE_OK;
+    }
+
     // Open the NVS namespace in READONLY mode
     NVSDelegateHandle_t handle;
-    NVSDelegateError_t err = _nvsDelegate->open(_nvsNamespace, NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
 
     // Handle specific errors and return appropriate DatabaseError_t value
     if (err != NVS_DELEGATE_OK)
@@ -206,9 +696,37 @@ DatabaseError_t DatabaseAPI::getValueLength(
     if (requiredLength == nullptr)
         return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
 
+    // A key left at its default has the length of its default, without reading the flash
+    char const *defaultValue;
+    if (findDefault(key, &defaultValue))
+    {
+        *requiredLength = strlen(defaultValue) + 1;
+        Log_Verbose(_logger, "Length of default value for key '%s' is %zu", key, *requiredLength);
+        return DATABASE_OK;
+    }
+
+    // An expired key is not found, without reading the flash
+    if (isExpired(key))
+        return mapErrorAndPrint(NVS_DELEGATE_KEY_NOT_FOUND);
+
+    // Read the length from the snapshot when snapshot mode is enabled
+    uint32_t slot;
+    DatabaseSnapshot const *const snapshot = acquireSnapshot(&slot);
+    if (snapshot)
+    {
+        bool const found = snapshot->find(key, requiredLength) != nullptr;
+        releaseSnapshot(slot);
+
+        if (!found)
+            return mapErrorAndPrint(NVS_DELEGATE_KEY_NOT_FOUND);
+
+        Log_Verbose(_logger, "Length of value for key '%s' is %zu", key, *requiredLength);
+        return DATABASE_OK;
+    }
+
     // Open the NVS namespace in READONLY mode
     NVSDelegateHandle_t handle;
-    NVSDelegateError_t err = _nvsDelegate->open(_nvsNamespace, NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
 
     // Handle specific errors and return appropriate DatabaseError_t value
     if (err != NVS_DELEGATE_OK)
@@ -235,9 +753,12 @@ DatabaseError_t DatabaseAPI::eraseAll()
     if (!_nvsDelegate)
         return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
 
+    DatabaseLockGuard guard(_writeMutex);
+    _lastWriteMs.store(xTaskGetTickCount() * portTICK_PERIOD_MS);
+
     // Open the NVS namespace in READWRITE mode
     NVSDelegateHandle_t handle;
-    NVSDelegateError_t err = _nvsDelegate->open(_nvsNamespace, NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
 
     // Handle specific errors and return appropriate DatabaseError_t value
     if (err != NVS_DELEGATE_OK)
@@ -262,6 +783,19 @@ DatabaseError_t DatabaseAPI::eraseAll()
     if (err != NVS_DELEGATE_OK)
         return mapErrorAndPrint(err);
 
+    // Readers of the snapshot now see an empty namespace
+    if (isSnapshotEnabled())
+        publishSnapshot(DatabaseSnapshot::withValue(nullptr, "", nullptr));
+    _counters.clear();
+    _fingerprints.clear();
+    {
+        DatabaseLockGuard expiryGuard(_expiryMutex);
+        _expiry.clear();
+        _expiringKeys.store(0);
+    }
+    clearDefaultOverrides();
+    _subscriptions.publish(nullptr, DATABASE_CHANGE_ERASED);
+
     Log_Verbose(_logger, "All keys and values erased successfully");
     return DATABASE_OK;
 }
@@ -273,6 +807,8 @@ DatabaseError_t DatabaseAPI::eraseFlashAll()
     if (!_nvsDelegate)
         return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
 
+    DatabaseLockGuard guard(_writeMutex);
+
     // Erase the entire Flash partition
     NVSDelegateError_t err = _nvsDelegate->erase_flash_all();
 
@@ -280,49 +816,1722 @@ DatabaseError_t DatabaseAPI::eraseFlashAll()
     if (err != NVS_DELEGATE_OK)
         return mapErrorAndPrint(err);
 
+    // Readers of the snapshot now see an empty namespace
+    if (isSnapshotEnabled())
+        publishSnapshot(DatabaseSnapshot::withValue(nullptr, "", nullptr));
+    _counters.clear();
+    _fingerprints.clear();
+    {
+        DatabaseLockGuard expiryGuard(_expiryMutex);
+        _expiry.clear();
+        _expiringKeys.store(0);
+    }
+    _generation.store(0);
+    _staleGeneration = false;
+    clearDefaultOverrides();
+    _subscriptions.publish(nullptr, DATABASE_CHANGE_ERASED);
+
     Log_Verbose(_logger, "Flash partition erased successfully");
     return DATABASE_OK;
 }
 
-DatabaseError_t const DatabaseAPI::mapErrorAndPrint(NVSDelegateError_t const err) const
+// Sets the value for the specified key only if the key does not exist yet
+DatabaseError_t DatabaseAPI::setIfAbsent(char const *const key, char const *const value)
 {
-    switch (err)
-    {
-    case NVS_DELEGATE_OK:
-        return DATABASE_OK;
-    case NVS_DELEGATE_KEY_INVALID:
-        Log_Error(_logger, "Invalid key");
-        return DATABASE_KEY_INVALID;
-    case NVS_DELEGATE_NOT_ENOUGH_SPACE:
-        Log_Error(_logger, "Not enough space");
-        return DATABASE_NOT_ENOUGH_SPACE;
-    case NVS_DELEGATE_NAMESPACE_INVALID:
-        Log_Error(_logger, "Invalid namespace name");
-        return DATABASE_NAMESPACE_INVALID;
-    case NVS_DELEGATE_HANDLE_INVALID:
-        Log_Error(_logger, "Invalid namespace handle");
-        return DATABASE_ERROR;
-    case NVS_DELEGATE_READONLY:
-        Log_Error(_logger, "Attempt to modify in READONLY mode");
-        return DATABASE_ERROR;
-    case NVS_DELEGATE_VALUE_INVALID:
-        Log_Error(_logger, "Invalid value");
-        return DATABASE_VALUE_INVALID;
-    case NVS_DELEGATE_KEY_NOT_FOUND:
-        Log_Error(_logger, "Key not found");
-        return DATABASE_KEY_NOT_FOUND;
-    case NVS_DELEGATE_KEY_ALREADY_EXISTS:
-        Log_Error(_logger, "Key already exists");
-        return DATABASE_KEY_ALREADY_EXISTS;
-    default:
-        break;
-    }
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
 
-    Log_Error(_logger, "Unknown error");
-    return DATABASE_ERROR;
-}
+    // Validate input parameters
+    if (!isKeyValid(key))
+        return mapErrorAndPrint(NVS_DELEGATE_KEY_INVALID);
+    if (!isValueValid(value))
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
 
-bool DatabaseAPI::isKeyValid(char const *const key) const
-{
-    return key && strlen(key) > 0 && strlen(key) < NVS_DELEGATE_MAX_KEY_LENGTH;
+    DatabaseLockGuard guard(_writeMutex);
+
+    // A key left at its default exists, as isExist reports
+    char const *defaultValue;
+    if (findDefault(key, &defaultValue))
+        return mapErrorAndPrint(NVS_DELEGATE_KEY_ALREADY_EXISTS);
+
+    // Open the NVS namespace in READWRITE mode
+    NVSDelegateHandle_t handle;
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+        return mapErrorAndPrint(err);
+
+    // Only a missing or expired key may be written
+    size_t length = 0;
+    err = _nvsDelegate->get_str(handle, key, nullptr, &length);
+    if (err == NVS_DELEGATE_OK)
+        err = isExpired(key) ? NVS_DELEGATE_OK : NVS_DELEGATE_KEY_ALREADY_EXISTS;
+    else if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+        err = NVS_DELEGATE_OK;
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+    {
+        _nvsDelegate->close(handle);
+        return mapErrorAndPrint(err);
+    }
+
+    return commitValue(handle, key, value);
+}
+
+// Replaces the value of the specified key only if it holds the expected value
+DatabaseError_t DatabaseAPI::compareAndSet(
+    char const *const key, char const *const expectedValue, char const *const newValue)
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    // Validate input parameters
+    if (!isKeyValid(key))
+        return mapErrorAndPrint(NVS_DELEGATE_KEY_INVALID);
+    if (!isValueValid(expectedValue) || !isValueValid(newValue))
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    // A buffer the size of the expected value is enough to compare
+    size_t const expectedLength = strlen(expectedValue) + 1;
+    char *const current = static_cast<char *>(malloc(expectedLength));
+    if (current == nullptr)
+        return mapErrorAndPrint(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+
+    DatabaseLockGuard guard(_writeMutex);
+
+    // A key left at its default holds the default, an expired key no value to compare with
+    char const *defaultValue;
+    bool const atDefault = findDefault(key, &defaultValue);
+    if (!atDefault && isExpired(key))
+    {
+        free(current);
+        return mapErrorAndPrint(NVS_DELEGATE_KEY_NOT_FOUND);
+    }
+
+    // Open the NVS namespace in READWRITE mode
+    NVSDelegateHandle_t handle;
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+    {
+        free(current);
+        return mapErrorAndPrint(err);
+    }
+
+    // Read the current value; a longer value does not fit the buffer and fails the read
+    size_t length = expectedLength;
+    bool matches;
+    if (atDefault)
+        matches = strcmp(defaultValue, expectedValue) == 0;
+    else
+    {
+        err = _nvsDelegate->get_str(handle, key, current, &length);
+        matches = err == NVS_DELEGATE_OK && strcmp(current, expectedValue) == 0;
+    }
+    free(current);
+
+    if (err != NVS_DELEGATE_OK && err != NVS_DELEGATE_KEY_NOT_FOUND)
+    {
+        // Tell a value that does not fit apart from a failing read
+        length = 0;
+        if (_nvsDelegate->get_str(handle, key, nullptr, &length) == NVS_DELEGATE_OK && length != expectedLength)
+            err = NVS_DELEGATE_OK;
+    }
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+    {
+        _nvsDelegate->close(handle);
+        return mapErrorAndPrint(err);
+    }
+
+    if (!matches)
+    {
+        _nvsDelegate->close(handle);
+        Log_Debug(_logger, "Key '%s' does not hold the expected value", key);
+        return DATABASE_CONFLICT;
+    }
+
+    return commitValue(handle, key, newValue);
+}
+
+// Retrieves the version token of the value associated with the specified key
+DatabaseError_t DatabaseAPI::getVersion(char const *const key, uint32_t *version) const
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    // Validate input parameters
+    if (!isKeyValid(key))
+        return mapErrorAndPrint(NVS_DELEGATE_KEY_INVALID);
+    if (version == nullptr)
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    // A key left at its default has the version of the default, as get returns it
+    char const *defaultValue;
+    if (findDefault(key, &defaultValue))
+    {
+        *version = computeVersion(defaultValue);
+        return DATABASE_OK;
+    }
+
+    // An expired key has no version
+    if (isExpired(key))
+    {
+        *version = DATABASE_VERSION_ABSENT;
+        return DATABASE_OK;
+    }
+
+    // Hash the value from the snapshot when snapshot mode is enabled
+    uint32_t slot;
+    DatabaseSnapshot const *const snapshot = acquireSnapshot(&slot);
+    if (snapshot)
+    {
+        char const *const found = snapshot->find(key, nullptr);
+        *version = found ? computeVersion(found) : DATABASE_VERSION_ABSENT;
+        releaseSnapshot(slot);
+        return DATABASE_OK;
+    }
+
+    // Open the NVS namespace in READONLY mode, a namespace never written holds no key
+    NVSDelegateHandle_t handle;
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+    {
+        *version = DATABASE_VERSION_ABSENT;
+        return DATABASE_OK;
+    }
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+        return mapErrorAndPrint(err);
+
+    char *value = nullptr;
+    err = readValue(handle, key, &value);
+
+    // Close the NVS namespace
+    _nvsDelegate->close(handle);
+
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+    {
+        *version = DATABASE_VERSION_ABSENT;
+        return DATABASE_OK;
+    }
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+        return mapErrorAndPrint(err);
+
+    *version = computeVersion(value);
+    free(value);
+
+    Log_Verbose(_logger, "Version of key '%s' is %08x", key, *version);
+    return DATABASE_OK;
+}
+
+// Retrieves the value associated with the specified key and its version token
+DatabaseError_t DatabaseAPI::get(
+    char const *const key, char *value, size_t maxValueLength, uint32_t *version) const
+{
+    // Validate input parameters
+    if (version == nullptr)
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    DatabaseError_t err = get(key, value, maxValueLength);
+    if (err != DATABASE_OK)
+        return err;
+
+    // Hash the bytes returned, so the token matches the value even if the key changed since
+    *version = computeVersion(value);
+    return DATABASE_OK;
+}
+
+// Sets the value for the specified key only if its version token did not change
+DatabaseError_t DatabaseAPI::setIfVersion(char const *const key, uint32_t const version, char const *const value)
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    // Validate input parameters
+    if (!isKeyValid(key))
+        return mapErrorAndPrint(NVS_DELEGATE_KEY_INVALID);
+    if (!isValueValid(value))
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    DatabaseLockGuard guard(_writeMutex);
+
+    // Open the NVS namespace in READWRITE mode
+    NVSDelegateHandle_t handle;
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+        return mapErrorAndPrint(err);
+
+    // Compute the version of the current value: a key left at its default has the version of
+    // the default, an expired key has none
+    char *current = nullptr;
+    uint32_t currentVersion = DATABASE_VERSION_ABSENT;
+    char const *defaultValue;
+    if (findDefault(key, &defaultValue))
+        currentVersion = computeVersion(defaultValue);
+    else
+        err = isExpired(key) ? NVS_DELEGATE_KEY_NOT_FOUND : readValue(handle, key, &current);
+    if (err == NVS_DELEGATE_OK && current)
+    {
+        currentVersion = computeVersion(current);
+        free(current);
+    }
+    else if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+        err = NVS_DELEGATE_OK;
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+    {
+        _nvsDelegate->close(handle);
+        return mapErrorAndPrint(err);
+    }
+
+    if (currentVersion != version)
+    {
+        _nvsDelegate->close(handle);
+        Log_Debug(_logger, "Key '%s' changed since version %08x was read", key, version);
+        return DATABASE_CONFLICT;
+    }
+
+    return commitValue(handle, key, value);
+}
+
+// Applies the operations of a batch together, through a journal if atomic
+DatabaseError_t DatabaseAPI::commit(DatabaseBatch const &batch, bool const atomic)
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    if (batch.count() == 0)
+        return DATABASE_OK;
+
+    // Serialize the journal before taking the lock
+    uint8_t *journal = nullptr;
+    size_t journalLength = 0;
+    if (atomic)
+    {
+        journalLength = batch.serializedLength();
+        journal = static_cast<uint8_t *>(malloc(journalLength));
+        if (journal == nullptr)
+            return mapErrorAndPrint(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+        batch.serialize(journal);
+    }
+
+    DatabaseLockGuard guard(_writeMutex);
+    _lastWriteMs.store(xTaskGetTickCount() * portTICK_PERIOD_MS);
+
+    // Reject a batch the storage cannot hold before any key is written
+    size_t needed = 0;
+    estimateEntries(batch, atomic, &needed);
+    NVSDelegateError_t err = reserveEntries(needed);
+    if (err != NVS_DELEGATE_OK)
+    {
+        free(journal);
+        return mapErrorAndPrint(err);
+    }
+
+    // Open the NVS namespace in READWRITE mode
+    NVSDelegateHandle_t handle;
+    err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+
+    // The batch cannot be lost halfway once its journal is committed
+    if (err == NVS_DELEGATE_OK && atomic)
+    {
+        err = _nvsDelegate->set_blob(handle, DATABASE_JOURNAL_KEY, journal, journalLength);
+        if (err == NVS_DELEGATE_OK)
+            err = _nvsDelegate->commit(handle);
+        if (err != NVS_DELEGATE_OK)
+            _nvsDelegate->close(handle);
+    }
+    free(journal);
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+        return mapErrorAndPrint(err);
+
+    // Apply every operation under one commit
+    err = applyBatch(handle, batch);
+    if (err == NVS_DELEGATE_OK)
+        err = _nvsDelegate->commit(handle);
+
+    // Roll a journaled batch forward once more, operations applied before the failure are idempotent
+    if (err != NVS_DELEGATE_OK && atomic)
+    {
+        Log_Error(_logger, "Batch of %zu operations failed, rolling forward", batch.count());
+        err = applyBatch(handle, batch);
+        if (err == NVS_DELEGATE_OK)
+            err = _nvsDelegate->commit(handle);
+    }
+
+    // The batch cannot complete: drop its journal, which a later boot would replay over newer
+    // writes, and make the RAM state of its keys match what reached the flash
+    if (err != NVS_DELEGATE_OK)
+    {
+        if (atomic && _nvsDelegate->erase_key(handle, DATABASE_JOURNAL_KEY) == NVS_DELEGATE_OK)
+            _nvsDelegate->commit(handle);
+        reloadBatch(handle, batch);
+        _nvsDelegate->close(handle);
+        return mapErrorAndPrint(err);
+    }
+
+    publishBatch(batch);
+
+    // The batch is applied, drop its journal
+    if (atomic)
+    {
+        err = _nvsDelegate->erase_key(handle, DATABASE_JOURNAL_KEY);
+        if (err == NVS_DELEGATE_OK)
+            err = _nvsDelegate->commit(handle);
+    }
+
+    // Close the NVS namespace
+    _nvsDelegate->close(handle);
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+        return mapErrorAndPrint(err);
+
+    Log_Verbose(_logger, "Batch of %zu operations committed", batch.count());
+    return DATABASE_OK;
+}
+
+// Writes a whole new generation into the inactive namespace, then flips to it
+DatabaseError_t DatabaseAPI::replaceAll(DatabaseBatch const &batch)
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    DatabaseLockGuard guard(_writeMutex);
+    _lastWriteMs.store(xTaskGetTickCount() * portTICK_PERIOD_MS);
+    uint8_t const target = _generation.load() ? 0 : 1;
+
+    // The target still holds the previous generation, or what an interrupted replacement left
+    NVSDelegateError_t err = clearGeneration(target);
+    if (err == NVS_DELEGATE_OK)
+        _staleGeneration = false;
+
+    // The values and the flip of the generation pointer must fit before any value is written
+    size_t needed = 0;
+    estimateEntries(batch, false, &needed);
+    if (err == NVS_DELEGATE_OK)
+        err = reserveEntries(needed + 1);
+
+    // Write the new generation where no reader looks yet
+    NVSDelegateHandle_t handle;
+    if (err == NVS_DELEGATE_OK)
+        err = _nvsDelegate->open(generationNamespace(target), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+    if (err == NVS_DELEGATE_OK)
+    {
+        for (size_t i = 0; i < batch.count() && err == NVS_DELEGATE_OK; ++i)
+            if (batch.at(i).value)
+                err = _nvsDelegate->set_str(handle, batch.at(i).key, batch.at(i).value);
+        if (err == NVS_DELEGATE_OK)
+            err = _nvsDelegate->commit(handle);
+        _nvsDelegate->close(handle);
+    }
+
+    // The flip is the single write readers switch on, a reset before it keeps the current generation
+    if (err == NVS_DELEGATE_OK)
+        err = _nvsDelegate->open(_nvsNamespace, NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+    if (err == NVS_DELEGATE_OK)
+    {
+        err = _nvsDelegate->set_i64(handle, DATABASE_GENERATION_KEY, target);
+        if (err == NVS_DELEGATE_OK)
+            err = _nvsDelegate->commit(handle);
+        _nvsDelegate->close(handle);
+    }
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+        return mapErrorAndPrint(err);
+
+    _generation.store(target);
+    _staleGeneration = true;
+
+    // Nothing held in RAM for the previous generation applies to the new one
+    _counters.clear();
+    _fingerprints.clear();
+    {
+        DatabaseLockGuard expiryGuard(_expiryMutex);
+        _expiry.clear();
+        _expiringKeys.store(0);
+    }
+    clearDefaultOverrides();
+    for (size_t i = 0; i < batch.count(); ++i)
+        if (batch.at(i).value)
+            overrideDefault(batch.at(i).key, true);
+    _subscriptions.publish(nullptr, DATABASE_CHANGE_ERASED);
+    if (isSnapshotEnabled())
+    {
+        DatabaseSnapshot *const snapshot = DatabaseSnapshot::load(_nvsDelegate, activeNamespace(), &err);
+        if (snapshot == nullptr)
+            Log_Error(_logger, "Snapshot of the new generation could not be loaded, snapshot mode disabled");
+        publishSnapshot(snapshot);
+    }
+
+    Log_Verbose(_logger, "Namespace '%s' replaced by a generation of %zu keys", _nvsNamespace, batch.count());
+    return DATABASE_OK;
+}
+
+// Erases the generation left behind by the last replaceAll
+DatabaseError_t DatabaseAPI::eraseStaleGeneration()
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    DatabaseLockGuard guard(_writeMutex);
+    if (!_staleGeneration)
+        return DATABASE_OK;
+
+    NVSDelegateError_t const err = clearGeneration(_generation.load() ? 0 : 1);
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+        return mapErrorAndPrint(err);
+
+    _staleGeneration = false;
+
+    Log_Verbose(_logger, "Stale generation of namespace '%s' erased", _nvsNamespace);
+    return DATABASE_OK;
+}
+
+// Writes the string values of the namespace as an image
+DatabaseError_t DatabaseAPI::exportNamespace(DatabaseImageWriter_t const writer, void *const context) const
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    if (writer == nullptr)
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    DatabaseLockGuard guard(_writeMutex);
+
+    // List the keys first, values are read once the listing is over
+    DatabaseKeyList list = {nullptr, 0, 0, false};
+    NVSDelegateError_t err = _nvsDelegate->list_keys(activeNamespace(), collectKey, &list);
+    if (err == NVS_DELEGATE_OK && list.failed)
+        err = NVS_DELEGATE_NOT_ENOUGH_SPACE;
+
+    // A namespace never written exports as an empty image
+    NVSDelegateHandle_t handle;
+    bool opened = false;
+    if (err == NVS_DELEGATE_OK && list.count > 0)
+    {
+        err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+        opened = err == NVS_DELEGATE_OK;
+    }
+
+    DatabaseImage image(writer, context);
+    bool written = err == NVS_DELEGATE_OK && image.begin();
+    for (size_t i = 0; i < list.count && written; ++i)
+    {
+        // Reserved keys, expired keys and values of other types are left out
+        char const *const key = list.keys[i];
+        if (key[0] == '~' || isExpired(key))
+            continue;
+
+        char *value = nullptr;
+        err = readValue(handle, key, &value);
+        if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+        {
+            err = NVS_DELEGATE_OK;
+            continue;
+        }
+        written = err == NVS_DELEGATE_OK && image.add(key, value);
+        free(value);
+    }
+    written = written && image.end();
+
+    if (opened)
+        _nvsDelegate->close(handle);
+    free(list.keys);
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+        return mapErrorAndPrint(err);
+    if (!written)
+    {
+        Log_Error(_logger, "Image writer failed");
+        return DATABASE_ERROR;
+    }
+
+    Log_Verbose(_logger, "Namespace '%s' exported with %zu values", _nvsNamespace, image.count());
+    return DATABASE_OK;
+}
+
+// Reads and validates a whole image, then writes its values together
+DatabaseError_t DatabaseAPI::importNamespace(DatabaseImageReader_t const reader, void *const context, bool const replace)
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    if (reader == nullptr)
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    // Nothing is written unless the whole image is valid
+    DatabaseBatch batch;
+    DatabaseError_t const err = DatabaseImage::read(reader, context, &batch);
+    if (err != DATABASE_OK)
+    {
+        Log_Error(_logger, "Image rejected with error %d", err);
+        return err;
+    }
+
+    Log_Verbose(_logger, "Importing %zu values into namespace '%s'", batch.count(), _nvsNamespace);
+    return replace ? replaceAll(batch) : commit(batch, false);
+}
+
+// Lists the keys of the namespace into a job removing them in slices
+DatabaseError_t DatabaseAPI::startEraseAll(DatabaseJob *const job)
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    if (job == nullptr)
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    job->_batch.clear();
+    job->_done = true;
+
+    DatabaseLockGuard guard(_writeMutex);
+
+    DatabaseKeyList list = {nullptr, 0, 0, false};
+    NVSDelegateError_t err = _nvsDelegate->list_keys(activeNamespace(), collectKey, &list);
+    if (err == NVS_DELEGATE_OK && list.failed)
+        err = NVS_DELEGATE_NOT_ENOUGH_SPACE;
+
+    // Reserved keys are left to the final erase of the namespace
+    for (size_t i = 0; i < list.count && err == NVS_DELEGATE_OK; ++i)
+    {
+        if (list.keys[i][0] != '~' && job->_batch.remove(list.keys[i]) != DATABASE_OK)
+            err = NVS_DELEGATE_NOT_ENOUGH_SPACE;
+    }
+    free(list.keys);
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+    {
+        job->_batch.clear();
+        return mapErrorAndPrint(err);
+    }
+
+    job->start(this, true);
+
+    Log_Verbose(_logger, "Erasing %zu keys of namespace '%s' step by step", job->_batch.count(), _nvsNamespace);
+    return DATABASE_OK;
+}
+
+// Copies a batch into a job applying it in slices
+DatabaseError_t DatabaseAPI::startCommit(DatabaseBatch const &batch, DatabaseJob *const job)
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    if (job == nullptr)
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    job->_batch.clear();
+    job->_done = true;
+
+    // Reject a batch the storage cannot hold before any step writes
+    size_t needed = 0;
+    estimateEntries(batch, false, &needed);
+    {
+        DatabaseLockGuard guard(_writeMutex);
+        NVSDelegateError_t const err = reserveEntries(needed);
+        if (err != NVS_DELEGATE_OK)
+            return mapErrorAndPrint(err);
+    }
+
+    for (size_t i = 0; i < batch.count(); ++i)
+    {
+        DatabaseBatch::Operation const &operation = batch.at(i);
+        DatabaseError_t const err = operation.value ? job->_batch.set(operation.key, operation.value)
+                                                    : job->_batch.remove(operation.key);
+        if (err != DATABASE_OK)
+        {
+            job->_batch.clear();
+            Log_Error(_logger, "Not enough memory to copy the batch");
+            return err;
+        }
+    }
+
+    job->start(this, false);
+
+    Log_Verbose(_logger, "Committing %zu operations into namespace '%s' step by step", batch.count(), _nvsNamespace);
+    return DATABASE_OK;
+}
+
+// Reads and validates a whole image into a job writing its values in slices
+DatabaseError_t DatabaseAPI::startImport(DatabaseImageReader_t const reader, void *const context, DatabaseJob *const job)
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    if (reader == nullptr || job == nullptr)
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    job->_done = true;
+
+    // Nothing is written unless the whole image is valid
+    DatabaseError_t const err = DatabaseImage::read(reader, context, &job->_batch);
+    if (err != DATABASE_OK)
+    {
+        Log_Error(_logger, "Image rejected with error %d", err);
+        return err;
+    }
+
+    // Nor unless the storage can hold it
+    size_t needed = 0;
+    estimateEntries(job->_batch, false, &needed);
+    {
+        DatabaseLockGuard guard(_writeMutex);
+        NVSDelegateError_t const reserveErr = reserveEntries(needed);
+        if (reserveErr != NVS_DELEGATE_OK)
+        {
+            job->_batch.clear();
+            return mapErrorAndPrint(reserveErr);
+        }
+    }
+
+    job->start(this, false);
+
+    Log_Verbose(_logger, "Importing %zu values into namespace '%s' step by step", job->_batch.count(), _nvsNamespace);
+    return DATABASE_OK;
+}
+
+// Adds a delta to a counter served from RAM
+DatabaseError_t DatabaseAPI::increment(char const *const key, int64_t const delta, int64_t *value)
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    // Validate input parameters
+    if (!isKeyValid(key))
+        return mapErrorAndPrint(NVS_DELEGATE_KEY_INVALID);
+
+    DatabaseLockGuard guard(_writeMutex);
+    _lastWriteMs.store(xTaskGetTickCount() * portTICK_PERIOD_MS);
+
+    // Load the counter on first use, a missing counter starts at 0
+    DatabaseCounters::Counter *counter;
+    NVSDelegateError_t err = loadCounter(key, true, &counter);
+    if (err != NVS_DELEGATE_OK)
+        return mapErrorAndPrint(err);
+
+    // Wrap around on overflow instead of invoking undefined behavior
+    uint32_t const now = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    counter->value = static_cast<int64_t>(static_cast<uint64_t>(counter->value) + static_cast<uint64_t>(delta));
+    if (counter->pending++ == 0)
+        counter->dirtySinceMs = now;
+    if (value)
+        *value = counter->value;
+
+    // Persist every pending counter together as soon as one of them reaches the policy
+    bool persist = false;
+    for (size_t i = 0; i < _counters.count() && !persist; ++i)
+    {
+        DatabaseCounters::Counter const &pending = _counters.at(i);
+        if (pending.pending == 0)
+            continue;
+        persist = (_counterMaxPendingChanges && pending.pending >= _counterMaxPendingChanges) ||
+                  (_counterMaxPendingMs && now - pending.dirtySinceMs >= _counterMaxPendingMs);
+    }
+    if (persist)
+    {
+        err = persistCounters();
+        if (err != NVS_DELEGATE_OK)
+            return mapErrorAndPrint(err);
+    }
+
+    Log_Verbose(_logger, "Counter '%s' changed by %lld", key, (long long)delta);
+    return DATABASE_OK;
+}
+
+// Subtracts a delta from a counter served from RAM
+DatabaseError_t DatabaseAPI::decrement(char const *const key, int64_t const delta, int64_t *value)
+{
+    return increment(key, static_cast<int64_t>(0 - static_cast<uint64_t>(delta)), value);
+}
+
+// Retrieves the current value of a counter
+DatabaseError_t DatabaseAPI::getCounter(char const *const key, int64_t *value)
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    // Validate input parameters
+    if (!isKeyValid(key))
+        return mapErrorAndPrint(NVS_DELEGATE_KEY_INVALID);
+    if (value == nullptr)
+        return mapErrorAndPrint(NVS_DELEGATE_VALUE_INVALID);
+
+    DatabaseLockGuard guard(_writeMutex);
+
+    DatabaseCounters::Counter *counter;
+    NVSDelegateError_t err = loadCounter(key, false, &counter);
+    if (err != NVS_DELEGATE_OK)
+        return mapErrorAndPrint(err);
+
+    *value = counter->value;
+    return DATABASE_OK;
+}
+
+void DatabaseAPI::setCounterPersistPolicy(uint32_t const maxPendingChanges, uint32_t const maxPendingMs)
+{
+    DatabaseLockGuard guard(_writeMutex);
+    _counterMaxPendingChanges = maxPendingChanges;
+    _counterMaxPendingMs = maxPendingMs;
+
+    Log_Debug(_logger, "Counters persisted every %u changes or %u ms", maxPendingChanges, maxPendingMs);
+}
+
+// Persists the pending changes of every counter
+DatabaseError_t DatabaseAPI::flushCounters()
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    DatabaseLockGuard guard(_writeMutex);
+    return mapErrorAndPrint(persistCounters());
+}
+
+// Loads the expiry table and filters expired keys from reads
+DatabaseError_t DatabaseAPI::enableExpiry()
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    DatabaseLockGuard guard(_writeMutex);
+    return mapErrorAndPrint(loadExpiry());
+}
+
+// Removes a bounded number of expired keys
+DatabaseError_t DatabaseAPI::sweepExpired(size_t const maxKeys, size_t *removed)
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    if (removed)
+        *removed = 0;
+
+    DatabaseLockGuard guard(_writeMutex);
+
+    // Nothing can have expired while expiry is disabled
+    if (_expiringKeys.load() == 0 || maxKeys == 0)
+        return DATABASE_OK;
+
+    // Nothing to open if no key has expired yet
+    uint32_t const now = _clock();
+    bool expired = false;
+    for (size_t i = 0; i < _expiry.count() && !expired; ++i)
+        expired = _expiry.at(i).expiresAt <= now;
+    if (!expired)
+        return DATABASE_OK;
+
+    // Open the NVS namespace in READWRITE mode
+    NVSDelegateHandle_t handle;
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+        return mapErrorAndPrint(err);
+
+    // Erase expired keys one by one, the table shrinks as they go
+    size_t count = 0;
+    size_t i = 0;
+    while (count < maxKeys && i < _expiry.count() && err == NVS_DELEGATE_OK)
+    {
+        if (_expiry.at(i).expiresAt > now)
+        {
+            ++i;
+            continue;
+        }
+
+        char key[NVS_DELEGATE_MAX_KEY_LENGTH];
+        strcpy(key, _expiry.at(i).key);
+
+        // A key erased by a crash between two writes is already gone
+        err = _nvsDelegate->erase_key(handle, key);
+        if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+            err = NVS_DELEGATE_OK;
+        if (err != NVS_DELEGATE_OK)
+            break;
+
+        {
+            DatabaseLockGuard expiryGuard(_expiryMutex);
+            _expiry.remove(key);
+            _expiringKeys.store(_expiry.count());
+        }
+        updateSnapshot(key, nullptr);
+        rememberValue(key, nullptr);
+        overrideDefault(key, false);
+        _subscriptions.publish(key, DATABASE_CHANGE_REMOVED);
+        count++;
+    }
+
+    // Write the smaller table and commit every erase together
+    if (count > 0)
+    {
+        NVSDelegateError_t const storeErr = storeExpiry(handle);
+        if (err == NVS_DELEGATE_OK)
+            err = storeErr;
+        if (err == NVS_DELEGATE_OK)
+            err = _nvsDelegate->commit(handle);
+    }
+    _nvsDelegate->close(handle);
+
+    if (removed)
+        *removed = count;
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+        return mapErrorAndPrint(err);
+
+    Log_Verbose(_logger, "%zu expired keys removed", count);
+    return DATABASE_OK;
+}
+
+void DatabaseAPI::setClock(DatabaseClock_t const clock)
+{
+    _clock = clock ? clock : systemClock;
+}
+
+void DatabaseAPI::enableWriteElision()
+{
+    DatabaseLockGuard guard(_writeMutex);
+    _writeElision = true;
+}
+
+void DatabaseAPI::disableWriteElision()
+{
+    DatabaseLockGuard guard(_writeMutex);
+    _writeElision = false;
+    _fingerprints.clear();
+}
+
+uint32_t DatabaseAPI::getElidedWriteCount() const
+{
+    DatabaseLockGuard guard(_writeMutex);
+    return _elidedWrites;
+}
+
+// Loads the namespace into a snapshot and serves reads from it
+DatabaseError_t DatabaseAPI::enableSnapshot()
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    DatabaseLockGuard guard(_writeMutex);
+
+    // Load the whole namespace, the current snapshot stays in place on failure
+    NVSDelegateError_t err;
+    DatabaseSnapshot *const snapshot = DatabaseSnapshot::load(_nvsDelegate, activeNamespace(), &err);
+    if (snapshot == nullptr)
+        return mapErrorAndPrint(err);
+
+    publishSnapshot(snapshot);
+
+    Log_Debug(_logger, "Snapshot of namespace '%s' loaded with %zu keys", activeNamespace(), snapshot->count());
+    return DATABASE_OK;
+}
+
+// Frees the snapshot and serves reads from NVS again
+void DatabaseAPI::disableSnapshot()
+{
+    DatabaseLockGuard guard(_writeMutex);
+    publishSnapshot(nullptr);
+
+    Log_Debug(_logger, "Snapshot mode disabled");
+}
+
+bool DatabaseAPI::isSnapshotEnabled() const
+{
+    return _snapshot.load() != nullptr;
+}
+
+// Sets the compiled-in defaults and finds the keys overriding them
+DatabaseError_t DatabaseAPI::setDefaults(DatabaseDefaultsTable const &defaults)
+{
+    // Ensure that the Delegate is initialized
+    if (!_nvsDelegate)
+        return mapErrorAndPrint(NVS_DELEGATE_UNKOWN_ERROR);
+
+    DatabaseLockGuard guard(_writeMutex);
+
+    // One bit per default, set for every key already stored
+    uint8_t *overrides = nullptr;
+    NVSDelegateError_t err = NVS_DELEGATE_OK;
+    if (defaults.count() > 0)
+    {
+        overrides = static_cast<uint8_t *>(calloc((defaults.count() + 7) / 8, 1));
+        if (overrides == nullptr)
+            return mapErrorAndPrint(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+
+        DatabaseDefaultsScan scan = {&defaults, overrides};
+        err = _nvsDelegate->list_keys(activeNamespace(), markOverride, &scan);
+    }
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+    {
+        free(overrides);
+        return mapErrorAndPrint(err);
+    }
+
+    {
+        DatabaseLockGuard defaultsGuard(_defaultsMutex);
+        free(_defaultOverrides);
+        _defaults = defaults;
+        _defaultOverrides = overrides;
+    }
+    _defaultsEnabled.store(defaults.count() > 0);
+
+    Log_Debug(_logger, "%zu defaults set for namespace '%s'", defaults.count(), activeNamespace());
+    return DATABASE_OK;
+}
+
+DatabaseError_t DatabaseAPI::subscribe(
+    char const *const pattern, DatabaseChangeCallback_t const callback, void *const context, uint32_t *out_id)
+{
+    DatabaseError_t const err = _subscriptions.subscribe(pattern, callback, context, out_id);
+    if (err != DATABASE_OK)
+        Log_Error(_logger, "Subscription to '%s' failed", pattern ? pattern : "");
+    return err;
+}
+
+DatabaseError_t DatabaseAPI::unsubscribe(uint32_t const id)
+{
+    return _subscriptions.unsubscribe(id);
+}
+
+uint32_t DatabaseAPI::droppedChanges() const
+{
+    return _subscriptions.droppedCount();
+}
+
+NVSDelegateError_t DatabaseAPI::loadCounter(
+    char const *const key, bool const create, DatabaseCounters::Counter **out_counter)
+{
+    *out_counter = _counters.find(key);
+    if (*out_counter)
+        return NVS_DELEGATE_OK;
+
+    // Read the persisted value, a namespace never written holds no counter
+    int64_t stored = 0;
+    NVSDelegateHandle_t handle;
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+    if (err == NVS_DELEGATE_OK)
+    {
+        err = _nvsDelegate->get_i64(handle, key, &stored);
+        _nvsDelegate->close(handle);
+    }
+
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND && create)
+    {
+        stored = 0;
+        err = NVS_DELEGATE_OK;
+    }
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    *out_counter = _counters.add(key, stored);
+    return *out_counter ? NVS_DELEGATE_OK : NVS_DELEGATE_NOT_ENOUGH_SPACE;
+}
+
+NVSDelegateError_t DatabaseAPI::persistCounters()
+{
+    // Nothing to write if every counter is clean
+    bool pending = false;
+    for (size_t i = 0; i < _counters.count() && !pending; ++i)
+        pending = _counters.at(i).pending > 0;
+    if (!pending)
+        return NVS_DELEGATE_OK;
+
+    // Open the NVS namespace in READWRITE mode
+    NVSDelegateHandle_t handle;
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    // Write every pending counter, then commit them together
+    for (size_t i = 0; i < _counters.count() && err == NVS_DELEGATE_OK; ++i)
+        if (_counters.at(i).pending > 0)
+            err = _nvsDelegate->set_i64(handle, _counters.at(i).key, _counters.at(i).value);
+
+    if (err == NVS_DELEGATE_OK)
+        err = _nvsDelegate->commit(handle);
+    _nvsDelegate->close(handle);
+
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    for (size_t i = 0; i < _counters.count(); ++i)
+        _counters.at(i).pending = 0;
+
+    Log_Verbose(_logger, "Counters persisted");
+    return NVS_DELEGATE_OK;
+}
+
+bool DatabaseAPI::isExpired(char const *const key) const
+{
+    // No lock and no table lookup while no key has a TTL
+    if (_expiringKeys.load() == 0)
+        return false;
+
+    DatabaseLockGuard guard(_expiryMutex);
+    DatabaseExpiry::Expiry const *const expiry = _expiry.find(key);
+    return expiry && expiry->expiresAt <= _clock();
+}
+
+bool DatabaseAPI::findDefault(char const *const key, char const **out_value) const
+{
+    // No lock and no table lookup unless defaults are set
+    if (!_defaultsEnabled.load())
+        return false;
+
+    bool overridden;
+    {
+        DatabaseLockGuard guard(_defaultsMutex);
+        size_t index;
+        if (!_defaults.find(key, &index))
+            return false;
+        overridden = _defaultOverrides[index / 8] & (1 << (index % 8));
+        *out_value = _defaults.at(index).value;
+    }
+
+    // An expired value no longer overrides the default
+    return !overridden || isExpired(key);
+}
+
+void DatabaseAPI::overrideDefault(char const *const key, bool const overridden)
+{
+    if (!_defaultsEnabled.load())
+        return;
+
+    DatabaseLockGuard guard(_defaultsMutex);
+    size_t index;
+    if (!_defaults.find(key, &index))
+        return;
+    if (overridden)
+        _defaultOverrides[index / 8] |= 1 << (index % 8);
+    else
+        _defaultOverrides[index / 8] &= ~(1 << (index % 8));
+}
+
+void DatabaseAPI::clearDefaultOverrides()
+{
+    if (!_defaultsEnabled.load())
+        return;
+
+    DatabaseLockGuard guard(_defaultsMutex);
+    memset(_defaultOverrides, 0, (_defaults.count() + 7) / 8);
+}
+
+NVSDelegateError_t DatabaseAPI::loadExpiry()
+{
+    if (_expiryEnabled.load())
+        return NVS_DELEGATE_OK;
+
+    // A namespace never written, or without a table, has no expiring key
+    NVSDelegateHandle_t handle;
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+    {
+        _expiryEnabled.store(true);
+        return NVS_DELEGATE_OK;
+    }
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    size_t length = 0;
+    err = _nvsDelegate->get_blob(handle, DATABASE_EXPIRY_KEY, nullptr, &length);
+    uint8_t *data = nullptr;
+    if (err == NVS_DELEGATE_OK)
+    {
+        data = static_cast<uint8_t *>(malloc(length));
+        err = data ? _nvsDelegate->get_blob(handle, DATABASE_EXPIRY_KEY, data, &length) : NVS_DELEGATE_NOT_ENOUGH_SPACE;
+    }
+    _nvsDelegate->close(handle);
+
+    if (err == NVS_DELEGATE_OK)
+    {
+        DatabaseLockGuard expiryGuard(_expiryMutex);
+        if (!_expiry.deserialize(data, length))
+            err = NVS_DELEGATE_UNKOWN_ERROR;
+        _expiringKeys.store(_expiry.count());
+    }
+    free(data);
+
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+        err = NVS_DELEGATE_OK;
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    _expiryEnabled.store(true);
+    Log_Debug(_logger, "Expiry table of namespace '%s' loaded with %zu keys", activeNamespace(), _expiry.count());
+    return NVS_DELEGATE_OK;
+}
+
+NVSDelegateError_t DatabaseAPI::writeExpiry(
+    NVSDelegateHandle_t const handle, char const *const key, uint32_t const expiresAt)
+{
+    // The table failed to load at construction, an entry of the key may still be persisted
+    NVSDelegateError_t err = loadExpiry();
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    // Nothing to write if the key keeps its expiry
+    DatabaseExpiry::Expiry const *const current = _expiry.find(key);
+    uint32_t const previous = current ? current->expiresAt : 0;
+    if (previous == expiresAt)
+        return NVS_DELEGATE_OK;
+
+    {
+        DatabaseLockGuard expiryGuard(_expiryMutex);
+        if (expiresAt == 0)
+            _expiry.remove(key);
+        else if (!_expiry.set(key, expiresAt))
+            return NVS_DELEGATE_NOT_ENOUGH_SPACE;
+        _expiringKeys.store(_expiry.count());
+    }
+
+    err = storeExpiry(handle);
+    if (err == NVS_DELEGATE_OK)
+        return NVS_DELEGATE_OK;
+
+    // Restore the previous expiry, which stays persisted
+    DatabaseLockGuard expiryGuard(_expiryMutex);
+    if (previous == 0)
+        _expiry.remove(key);
+    else
+        _expiry.set(key, previous);
+    _expiringKeys.store(_expiry.count());
+    return err;
+}
+
+NVSDelegateError_t DatabaseAPI::storeExpiry(NVSDelegateHandle_t const handle)
+{
+    // An empty table is erased rather than stored
+    size_t const length = _expiry.serializedLength();
+    if (length == 0)
+    {
+        NVSDelegateError_t const err = _nvsDelegate->erase_key(handle, DATABASE_EXPIRY_KEY);
+        return err == NVS_DELEGATE_KEY_NOT_FOUND ? NVS_DELEGATE_OK : err;
+    }
+
+    uint8_t *const data = static_cast<uint8_t *>(malloc(length));
+    if (data == nullptr)
+        return NVS_DELEGATE_NOT_ENOUGH_SPACE;
+
+    _expiry.serialize(data);
+    NVSDelegateError_t const err = _nvsDelegate->set_blob(handle, DATABASE_EXPIRY_KEY, data, length);
+    free(data);
+    return err;
+}
+
+DatabaseError_t const DatabaseAPI::mapErrorAndPrint(NVSDelegateError_t const err) const
+{
+    switch (err)
+    {
+    case NVS_DELEGATE_OK:
+        return DATABASE_OK;
+    case NVS_DELEGATE_KEY_INVALID:
+        Log_Error(_logger, "Invalid key");
+        return DATABASE_KEY_INVALID;
+    case NVS_DELEGATE_NOT_ENOUGH_SPACE:
+        Log_Error(_logger, "Not enough space");
+        return DATABASE_NOT_ENOUGH_SPACE;
+    case NVS_DELEGATE_NAMESPACE_INVALID:
+        Log_Error(_logger, "Invalid namespace name");
+        return DATABASE_NAMESPACE_INVALID;
+    case NVS_DELEGATE_HANDLE_INVALID:
+        Log_Error(_logger, "Invalid namespace handle");
+        return DATABASE_ERROR;
+    case NVS_DELEGATE_READONLY:
+        Log_Error(_logger, "Attempt to modify in READONLY mode");
+        return DATABASE_ERROR;
+    case NVS_DELEGATE_VALUE_INVALID:
+        Log_Error(_logger, "Invalid value");
+        return DATABASE_VALUE_INVALID;
+    case NVS_DELEGATE_KEY_NOT_FOUND:
+        Log_Error(_logger, "Key not found");
+        return DATABASE_KEY_NOT_FOUND;
+    case NVS_DELEGATE_KEY_ALREADY_EXISTS:
+        Log_Error(_logger, "Key already exists");
+        return DATABASE_KEY_ALREADY_EXISTS;
+    default:
+        break;
+    }
+
+    Log_Error(_logger, "Unknown error");
+    return DATABASE_ERROR;
+}
+
+bool DatabaseAPI::isKeyValid(char const *const key) const
+{
+    // Keys starting with '~' hold the metadata of the library
+    return key && strlen(key) > 0 && strlen(key) < NVS_DELEGATE_MAX_KEY_LENGTH && key[0] != '~';
+}
+
+bool DatabaseAPI::isValueValid(char const *const value) const
+{
+    return value && strlen(value) > 0 && strlen(value) < NVS_DELEGATE_MAX_VALUE_LENGTH;
+}
+
+uint32_t DatabaseAPI::computeVersion(char const *const value) const
+{
+    // 0 is reserved for a missing key
+    uint32_t const hash = DatabaseHash::fnv1a(value);
+    return hash == DATABASE_VERSION_ABSENT ? 1 : hash;
+}
+
+NVSDelegateError_t DatabaseAPI::recoverJournal()
+{
+    // A namespace never written has no journal
+    NVSDelegateHandle_t handle;
+    NVSDelegateError_t err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+        return NVS_DELEGATE_OK;
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    size_t length = 0;
+    uint8_t *journal = nullptr;
+    err = _nvsDelegate->get_blob(handle, DATABASE_JOURNAL_KEY, nullptr, &length);
+    if (err == NVS_DELEGATE_OK && length > 0)
+    {
+        journal = static_cast<uint8_t *>(malloc(length));
+        err = journal ? _nvsDelegate->get_blob(handle, DATABASE_JOURNAL_KEY, journal, &length) : NVS_DELEGATE_NOT_ENOUGH_SPACE;
+    }
+    _nvsDelegate->close(handle);
+
+    if (err != NVS_DELEGATE_OK || journal == nullptr)
+    {
+        free(journal);
+        return err == NVS_DELEGATE_KEY_NOT_FOUND ? NVS_DELEGATE_OK : err;
+    }
+
+    // A journal that does not parse was never committed whole, nothing of it was applied
+    DatabaseBatch batch;
+    bool const replay = batch.deserialize(journal, length);
+    free(journal);
+
+    DatabaseLockGuard guard(_writeMutex);
+
+    // The keys of the batch lose their expiry, which needs the persisted table
+    err = replay ? loadExpiry() : NVS_DELEGATE_OK;
+    if (err == NVS_DELEGATE_OK)
+        err = _nvsDelegate->open(activeNamespace(), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    // Operations are idempotent, replaying those applied before the reset is harmless
+    if (replay)
+        err = applyBatch(handle, batch);
+    if (err == NVS_DELEGATE_OK)
+        err = _nvsDelegate->commit(handle);
+    if (err == NVS_DELEGATE_OK)
+        err = _nvsDelegate->erase_key(handle, DATABASE_JOURNAL_KEY);
+    if (err == NVS_DELEGATE_OK)
+        err = _nvsDelegate->commit(handle);
+    _nvsDelegate->close(handle);
+
+    if (err == NVS_DELEGATE_OK && replay)
+        Log_Debug(_logger, "Journal of %zu operations replayed", batch.count());
+    else if (err == NVS_DELEGATE_OK)
+        Log_Error(_logger, "Malformed journal discarded");
+    return err;
+}
+
+NVSDelegateError_t DatabaseAPI::applyBatch(NVSDelegateHandle_t const handle, DatabaseBatch const &batch)
+{
+    for (size_t i = 0; i < batch.count(); ++i)
+    {
+        DatabaseBatch::Operation const &operation = batch.at(i);
+
+        // Drop the expiry first, a reset in between is replayed from the journal anyway
+        NVSDelegateError_t err = writeExpiry(handle, operation.key, 0);
+        if (err == NVS_DELEGATE_OK && operation.value)
+            err = _nvsDelegate->set_str(handle, operation.key, operation.value);
+        else if (err == NVS_DELEGATE_OK)
+        {
+            err = _nvsDelegate->erase_key(handle, operation.key);
+            if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+                err = NVS_DELEGATE_OK;
+        }
+
+        if (err != NVS_DELEGATE_OK)
+            return err;
+    }
+
+    return NVS_DELEGATE_OK;
+}
+
+void DatabaseAPI::publishBatch(DatabaseBatch const &batch)
+{
+    for (size_t i = 0; i < batch.count(); ++i)
+    {
+        DatabaseBatch::Operation const &operation = batch.at(i);
+        _counters.remove(operation.key);
+        updateSnapshot(operation.key, operation.value);
+        rememberValue(operation.key, operation.value);
+        overrideDefault(operation.key, operation.value != nullptr);
+        _subscriptions.publish(operation.key, operation.value ? DATABASE_CHANGE_SET : DATABASE_CHANGE_REMOVED);
+    }
+}
+
+void DatabaseAPI::reloadBatch(NVSDelegateHandle_t const handle, DatabaseBatch const &batch)
+{
+    for (size_t i = 0; i < batch.count(); ++i)
+    {
+        DatabaseBatch::Operation const &operation = batch.at(i);
+        _counters.remove(operation.key);
+        rememberValue(operation.key, nullptr);
+
+        // A key that cannot be read back leaves no snapshot to trust
+        char *value = nullptr;
+        NVSDelegateError_t const err = readValue(handle, operation.key, &value);
+        if (err != NVS_DELEGATE_OK && err != NVS_DELEGATE_KEY_NOT_FOUND)
+        {
+            if (_snapshot.load())
+            {
+                Log_Error(_logger, "Key '%s' could not be reloaded, snapshot mode disabled", operation.key);
+                publishSnapshot(nullptr);
+            }
+            continue;
+        }
+
+        updateSnapshot(operation.key, value);
+        overrideDefault(operation.key, value != nullptr);
+
+        // Subscribers hear of the operations that reached the flash
+        bool const applied = operation.value ? value && strcmp(value, operation.value) == 0 : value == nullptr;
+        if (applied)
+            _subscriptions.publish(operation.key, operation.value ? DATABASE_CHANGE_SET : DATABASE_CHANGE_REMOVED);
+        free(value);
+    }
+}
+
+char const *DatabaseAPI::activeNamespace() const
+{
+    return generationNamespace(_generation.load());
+}
+
+char const *DatabaseAPI::generationNamespace(uint8_t const generation) const
+{
+    return generation ? _shadowNamespace : _nvsNamespace;
+}
+
+NVSDelegateError_t DatabaseAPI::loadGeneration()
+{
+    // The pointer lives in the base namespace, which exists once anything was written
+    NVSDelegateHandle_t handle;
+    NVSDelegateError_t err = _nvsDelegate->open(_nvsNamespace, NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    int64_t generation = 0;
+    err = _nvsDelegate->get_i64(handle, DATABASE_GENERATION_KEY, &generation);
+    _nvsDelegate->close(handle);
+
+    // A namespace never replaced reads the base generation
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+        return NVS_DELEGATE_OK;
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    // A reset may have come before the previous generation was erased
+    _generation.store(generation == 1 ? 1 : 0);
+    _staleGeneration = true;
+
+    Log_Debug(_logger, "Namespace '%s' reads generation %d", _nvsNamespace, (int)_generation.load());
+    return NVS_DELEGATE_OK;
+}
+
+NVSDelegateError_t DatabaseAPI::clearGeneration(uint8_t const generation)
+{
+    NVSDelegateHandle_t handle;
+    NVSDelegateError_t err;
+
+    if (generation)
+    {
+        // The shadow namespace holds nothing but its generation
+        err = _nvsDelegate->open(_shadowNamespace, NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+        if (err != NVS_DELEGATE_OK)
+            return err;
+        err = _nvsDelegate->erase_all(handle);
+    }
+    else
+    {
+        // The base namespace keeps the generation pointer, so its keys are erased one by one,
+        // once listed: erasing while listing would invalidate the iterator
+        DatabaseKeyList list = {nullptr, 0, 0, false};
+        err = _nvsDelegate->list_keys(_nvsNamespace, collectKey, &list);
+        if (err == NVS_DELEGATE_OK && list.failed)
+            err = NVS_DELEGATE_NOT_ENOUGH_SPACE;
+        if (err == NVS_DELEGATE_OK)
+            err = _nvsDelegate->open(_nvsNamespace, NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+        if (err != NVS_DELEGATE_OK)
+        {
+            free(list.keys);
+            return err;
+        }
+
+        for (size_t i = 0; i < list.count && err == NVS_DELEGATE_OK; ++i)
+        {
+            if (strcmp(list.keys[i], DATABASE_GENERATION_KEY) == 0)
+                continue;
+            err = _nvsDelegate->erase_key(handle, list.keys[i]);
+            if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+                err = NVS_DELEGATE_OK;
+        }
+        free(list.keys);
+    }
+
+    if (err == NVS_DELEGATE_OK)
+        err = _nvsDelegate->commit(handle);
+    _nvsDelegate->close(handle);
+    return err;
+}
+
+NVSDelegateError_t DatabaseAPI::reserveEntries(size_t const needed)
+{
+    // Delegates reporting no statistics are not checked, the writes report the shortage
+    NVSDelegateStats_t stats;
+    if (_nvsDelegate->get_stats(&stats) != NVS_DELEGATE_OK)
+    {
+        Log_Verbose(_logger, "Storage not checked, the delegate reports no statistics");
+        return NVS_DELEGATE_OK;
+    }
+
+    size_t available = availableEntries(stats);
+    if (needed <= available)
+        return NVS_DELEGATE_OK;
+
+    // The generation left behind by replaceAll is the only space the library can give back
+    if (_staleGeneration)
+    {
+        NVSDelegateError_t const err = clearGeneration(_generation.load() ? 0 : 1);
+        if (err != NVS_DELEGATE_OK)
+            return err;
+        _staleGeneration = false;
+        Log_Verbose(_logger, "Stale generation of namespace '%s' erased to make room", _nvsNamespace);
+
+        if (_nvsDelegate->get_stats(&stats) == NVS_DELEGATE_OK)
+            available = availableEntries(stats);
+        if (needed <= available)
+            return NVS_DELEGATE_OK;
+    }
+
+    Log_Error(_logger, "%zu entries needed, %zu available", needed, available);
+    return NVS_DELEGATE_NOT_ENOUGH_SPACE;
+}
+
+bool DatabaseAPI::isUnchanged(NVSDelegateHandle_t const handle, char const *const key, char const *const value)
+{
+    if (!_writeElision)
+        return false;
+
+    // First write of the key since boot, take the fingerprint of the stored value once
+    if (_fingerprints.find(key) == nullptr)
+    {
+        uint32_t slot;
+        DatabaseSnapshot const *const snapshot = acquireSnapshot(&slot);
+        if (snapshot)
+        {
+            char const *const stored = snapshot->find(key, nullptr);
+            rememberValue(key, stored);
+            releaseSnapshot(slot);
+        }
+        else
+        {
+            char *stored = nullptr;
+            if (readValue(handle, key, &stored) == NVS_DELEGATE_OK)
+            {
+                rememberValue(key, stored);
+                free(stored);
+            }
+        }
+    }
+
+    DatabaseFingerprints::Fingerprint const *const fingerprint = _fingerprints.find(key);
+    return fingerprint && fingerprint->length == strlen(value) && fingerprint->hash == computeVersion(value);
+}
+
+void DatabaseAPI::rememberValue(char const *const key, char const *const value)
+{
+    if (!_writeElision)
+        return;
+
+    // Without a fingerprint the next write goes through, so a full table only costs elisions
+    if (value == nullptr || !_fingerprints.set(key, computeVersion(value), strlen(value)))
+        _fingerprints.remove(key);
+}
+
+NVSDelegateError_t DatabaseAPI::readValue(
+    NVSDelegateHandle_t const handle, char const *const key, char **out_value) const
+{
+    size_t length = 0;
+    NVSDelegateError_t err = _nvsDelegate->get_str(handle, key, nullptr, &length);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    // One extra byte keeps the buffer terminated whatever the delegate reports
+    char *const value = static_cast<char *>(malloc(length + 1));
+    if (value == nullptr)
+        return NVS_DELEGATE_NOT_ENOUGH_SPACE;
+
+    value[length] = '\0';
+    err = _nvsDelegate->get_str(handle, key, value, &length);
+    if (err != NVS_DELEGATE_OK)
+    {
+        free(value);
+        return err;
+    }
+
+    *out_value = value;
+    return NVS_DELEGATE_OK;
+}
+
+DatabaseError_t DatabaseAPI::runWithin(
+    DatabaseOperation_t const operation, char const *const key, char const *const value, uint32_t const budgetUs)
+{
+    // Waiting for another writer counts against the budget
+    int64_t const started = esp_timer_get_time();
+    if (!_writeMutex.tryLock(budgetUs / 1000))
+    {
+        Log_Verbose(_logger, "Key '%s' not written, database busy beyond %u us", key, static_cast<unsigned>(budgetUs));
+        return DATABASE_TIMEOUT;
+    }
+
+    DatabaseError_t err = DATABASE_TIMEOUT;
+    uint32_t const predicted = _latency.predict(operation);
+    if (esp_timer_get_time() - started + predicted <= budgetUs)
+        err = operation == DATABASE_OPERATION_SET ? set(key, value) : remove(key);
+    else
+        Log_Verbose(_logger, "Key '%s' not written, %u us predicted for a budget of %u us",
+                    key, static_cast<unsigned>(predicted), static_cast<unsigned>(budgetUs));
+
+    _writeMutex.unlock();
+    return err;
+}
+
+DatabaseError_t DatabaseAPI::commitValue(
+    NVSDelegateHandle_t const handle, char const *const key, char const *const value)
+{
+    _lastWriteMs.store(xTaskGetTickCount() * portTICK_PERIOD_MS);
+    _counters.remove(key);
+
+    // Set the value for the specified key, which no longer expires
+    int64_t const started = esp_timer_get_time();
+    NVSDelegateError_t err = writeExpiry(handle, key, 0);
+    if (err == NVS_DELEGATE_OK)
+        err = _nvsDelegate->set_str(handle, key, value);
+
+    // Commit on success, then close the NVS namespace
+    if (err == NVS_DELEGATE_OK)
+    {
+        err = _nvsDelegate->commit(handle);
+        _latency.record(DATABASE_OPERATION_SET, static_cast<uint32_t>(esp_timer_get_time() - started));
+    }
+    _nvsDelegate->close(handle);
+
+    // Handle specific errors and return appropriate DatabaseError_t value
+    if (err != NVS_DELEGATE_OK)
+    {
+        rememberValue(key, nullptr);
+        return mapErrorAndPrint(err);
+    }
+
+    updateSnapshot(key, value);
+    rememberValue(key, value);
+    overrideDefault(key, true);
+    _subscriptions.publish(key, DATABASE_CHANGE_SET);
+
+    Log_Verbose(_logger, "Key '%s' set successfully", key);
+    return DATABASE_OK;
+}
+
+DatabaseSnapshot const *DatabaseAPI::acquireSnapshot(uint32_t *out_slot) const
+{
+    // Announce the reader in the slot of the current epoch before loading the pointer, so a
+    // writer cannot free what is loaded; a publication in between may already have waited
+    // for that slot, the reader then moves to the new one
+    uint32_t epoch = _snapshotEpoch.load();
+    uint32_t slot = epoch & 1;
+    _snapshotReaders[slot].fetch_add(1);
+    while (_snapshotEpoch.load() != epoch)
+    {
+        _snapshotReaders[slot].fetch_sub(1);
+        epoch = _snapshotEpoch.load();
+        slot = epoch & 1;
+        _snapshotReaders[slot].fetch_add(1);
+    }
+    DatabaseSnapshot const *const snapshot = _snapshot.load();
+    if (snapshot == nullptr)
+        _snapshotReaders[slot].fetch_sub(1);
+    *out_slot = slot;
+    return snapshot;
+}
+
+void DatabaseAPI::releaseSnapshot(uint32_t const slot) const
+{
+    _snapshotReaders[slot].fetch_sub(1);
+}
+
+void DatabaseAPI::publishSnapshot(DatabaseSnapshot const *const snapshot)
+{
+    DatabaseSnapshot const *const previous = _snapshot.exchange(snapshot);
+    if (previous == nullptr)
+        return;
+
+    // Readers entering from now on count in the other slot and see the new snapshot, so only
+    // those already inside are waited for, however many readers keep coming
+    uint32_t const slot = _snapshotEpoch.fetch_add(1) & 1;
+    while (_snapshotReaders[slot].load() != 0)
+        vTaskDelay(1);
+
+    DatabaseSnapshot::destroy(previous);
+}
+
+void DatabaseAPI::updateSnapshot(char const *const key, char const *const value)
+{
+    DatabaseSnapshot const *const current = _snapshot.load();
+    if (current == nullptr)
+        return;
+
+    // Fall back to NVS reads if the new snapshot cannot be built
+    DatabaseSnapshot *const next = DatabaseSnapshot::withValue(current, key, value);
+    if (next == nullptr)
+        Log_Error(_logger, "Not enough memory for the snapshot, snapshot mode disabled");
+
+    publishSnapshot(next);
 }
@@ -0,0 +1,168 @@
+#include "DatabaseBatch.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Operation codes of the serialized batch
+#define DATABASE_BATCH_SET 'S'
+#define DATABASE_BATCH_REMOVE 'R'
+
+DatabaseBatch::DatabaseBatch() : _operations(nullptr), _count(0), _capacity(0)
+{
+}
+
+DatabaseBatch::~DatabaseBatch()
+{
+    clear();
+}
+
+DatabaseError_t DatabaseBatch::set(char const *const key, char const *const value)
+{
+    // Same rules as DatabaseAPI, keys starting with '~' are reserved
+    if (key == nullptr || strlen(key) == 0 || strlen(key) >= NVS_DELEGATE_MAX_KEY_LENGTH || key[0] == '~')
+        return DATABASE_KEY_INVALID;
+    if (value == nullptr || strlen(value) == 0 || strlen(value) >= NVS_DELEGATE_MAX_VALUE_LENGTH)
+        return DATABASE_VALUE_INVALID;
+
+    return stage(key, value) ? DATABASE_OK : DATABASE_NOT_ENOUGH_SPACE;
+}
+
+DatabaseError_t DatabaseBatch::remove(char const *const key)
+{
+    if (key == nullptr || strlen(key) == 0 || strlen(key) >= NVS_DELEGATE_MAX_KEY_LENGTH || key[0] == '~')
+        return DATABASE_KEY_INVALID;
+
+    return stage(key, nullptr) ? DATABASE_OK : DATABASE_NOT_ENOUGH_SPACE;
+}
+
+void DatabaseBatch::clear()
+{
+    for (size_t i = 0; i < _count; ++i)
+        free(_operations[i].value);
+    free(_operations);
+    _operations = nullptr;
+    _count = 0;
+    _capacity = 0;
+}
+
+size_t DatabaseBatch::count() const
+{
+    return _count;
+}
+
+DatabaseBatch::Operation const &DatabaseBatch::at(size_t const index) const
+{
+    return _operations[index];
+}
+
+size_t DatabaseBatch::serializedLength() const
+{
+    size_t length = 0;
+    for (size_t i = 0; i < _count; ++i)
+    {
+        length += 1 + strlen(_operations[i].key) + 1;
+        if (_operations[i].value)
+            length += strlen(_operations[i].value) + 1;
+    }
+    return length;
+}
+
+void DatabaseBatch::serialize(uint8_t *out) const
+{
+    for (size_t i = 0; i < _count; ++i)
+    {
+        Operation const &operation = _operations[i];
+        *out++ = operation.value ? DATABASE_BATCH_SET : DATABASE_BATCH_REMOVE;
+
+        size_t const keyLength = strlen(operation.key) + 1;
+        memcpy(out, operation.key, keyLength);
+        out += keyLength;
+
+        if (operation.value)
+        {
+            size_t const valueLength = strlen(operation.value) + 1;
+            memcpy(out, operation.value, valueLength);
+            out += valueLength;
+        }
+    }
+}
+
+bool DatabaseBatch::deserialize(uint8_t const *const data, size_t const length)
+{
+    clear();
+
+    size_t position = 0;
+    while (position < length)
+    {
+        uint8_t const code = data[position++];
+        if (code != DATABASE_BATCH_SET && code != DATABASE_BATCH_REMOVE)
+            break;
+
+        // Key and value must be terminated within the data
+        char const *const key = reinterpret_cast<char const *>(data + position);
+        size_t const keyLength = strnlen(key, length - position);
+        if (keyLength == length - position)
+            break;
+        position += keyLength + 1;
+
+        char const *value = nullptr;
+        if (code == DATABASE_BATCH_SET)
+        {
+            value = reinterpret_cast<char const *>(data + position);
+            size_t const valueLength = strnlen(value, length - position);
+            if (valueLength == length - position)
+                break;
+            position += valueLength + 1;
+        }
+
+        if ((value ? set(key, value) : remove(key)) != DATABASE_OK)
+            break;
+    }
+
+    if (position == length)
+        return true;
+
+    clear();
+    return false;
+}
+
+bool DatabaseBatch::stage(char const *const key, char const *const value)
+{
+    char *copy = nullptr;
+    if (value)
+    {
+        copy = static_cast<char *>(malloc(strlen(value) + 1));
+        if (copy == nullptr)
+            return false;
+        strcpy(copy, value);
+    }
+
+    // A key staged again keeps its position and takes the new operation
+    for (size_t i = 0; i < _count; ++i)
+        if (strcmp(_operations[i].key, key) == 0)
+        {
+            free(_operations[i].value);
+            _operations[i].value = copy;
+            return true;
+        }
+
+    // Grow by doubling, starting with room for four operations
+    if (_count == _capacity)
+    {
+        size_t const capacity = _capacity ? _capacity * 2 : 4;
+        Operation *const operations = static_cast<Operation *>(realloc(_operations, capacity * sizeof(Operation)));
+        if (operations == nullptr)
+        {
+            free(copy);
+            return false;
+        }
+
+        _operations = operations;
+        _capacity = capacity;
+    }
+
+    Operation &operation = _operations[_count++];
+    strcpy(operation.key, key);
+    operation.value = copy;
+    return true;
+}
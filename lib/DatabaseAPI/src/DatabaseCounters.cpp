@@ -0,0 +1,72 @@
+#include "DatabaseCounters.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+DatabaseCounters::DatabaseCounters() : _counters(nullptr), _count(0), _capacity(0)
+{
+}
+
+DatabaseCounters::~DatabaseCounters()
+{
+    clear();
+}
+
+DatabaseCounters::Counter *DatabaseCounters::find(char const *const key)
+{
+    for (size_t i = 0; i < _count; ++i)
+        if (strcmp(_counters[i].key, key) == 0)
+            return &_counters[i];
+    return nullptr;
+}
+
+DatabaseCounters::Counter *DatabaseCounters::add(char const *const key, int64_t const value)
+{
+    // Grow by doubling, starting with room for four counters
+    if (_count == _capacity)
+    {
+        size_t const capacity = _capacity ? _capacity * 2 : 4;
+        Counter *const counters = static_cast<Counter *>(realloc(_counters, capacity * sizeof(Counter)));
+        if (counters == nullptr)
+            return nullptr;
+
+        _counters = counters;
+        _capacity = capacity;
+    }
+
+    Counter &counter = _counters[_count++];
+    strncpy(counter.key, key, sizeof(counter.key) - 1);
+    counter.key[sizeof(counter.key) - 1] = '\0';
+    counter.value = value;
+    counter.pending = 0;
+    counter.dirtySinceMs = 0;
+    return &counter;
+}
+
+void DatabaseCounters::remove(char const *const key)
+{
+    Counter *const counter = find(key);
+    if (counter == nullptr)
+        return;
+
+    // Order does not matter, move the last counter into the freed slot
+    *counter = _counters[--_count];
+}
+
+void DatabaseCounters::clear()
+{
+    free(_counters);
+    _counters = nullptr;
+    _count = 0;
+    _capacity = 0;
+}
+
+size_t DatabaseCounters::count() const
+{
+    return _count;
+}
+
+DatabaseCounters::Counter &DatabaseCounters::at(size_t const index)
+{
+    return _counters[index];
+}
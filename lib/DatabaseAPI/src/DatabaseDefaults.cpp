@@ -0,0 +1,36 @@
+#include "DatabaseDefaults.hpp"
+
+#include <string.h>
+
+DatabaseDefaultsTable::DatabaseDefaultsTable()
+    : _entries(nullptr), _count(0), _seed(0), _buckets(nullptr), _slots(nullptr)
+{
+}
+
+bool DatabaseDefaultsTable::find(char const *const key, size_t *out_index) const
+{
+    if (_count == 0)
+        return false;
+
+    // The bucket of the key, then its slot within the bucket, holds the only candidate
+    DatabaseDefaultsBucket const &bucket = _buckets[DatabaseDefaultsHash::hash(key, _seed) % _count];
+    if (bucket.size == 0)
+        return false;
+
+    uint16_t const index = _slots[bucket.offset + DatabaseDefaultsHash::hash(key, bucket.seed) % bucket.size];
+    if (index == DATABASE_DEFAULTS_EMPTY_SLOT || strcmp(_entries[index].key, key) != 0)
+        return false;
+
+    *out_index = index;
+    return true;
+}
+
+DatabaseDefault const &DatabaseDefaultsTable::at(size_t const index) const
+{
+    return _entries[index];
+}
+
+size_t DatabaseDefaultsTable::count() const
+{
+    return _count;
+}
@@ -0,0 +1,131 @@
+#include "DatabaseExpiry.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+DatabaseExpiry::DatabaseExpiry() : _expiries(nullptr), _count(0), _capacity(0)
+{
+}
+
+DatabaseExpiry::~DatabaseExpiry()
+{
+    clear();
+}
+
+DatabaseExpiry::Expiry const *DatabaseExpiry::find(char const *const key) const
+{
+    for (size_t i = 0; i < _count; ++i)
+        if (strcmp(_expiries[i].key, key) == 0)
+            return &_expiries[i];
+    return nullptr;
+}
+
+bool DatabaseExpiry::set(char const *const key, uint32_t const expiresAt)
+{
+    Expiry *const found = const_cast<Expiry *>(find(key));
+    if (found)
+    {
+        found->expiresAt = expiresAt;
+        return true;
+    }
+
+    // Grow by doubling, starting with room for four keys
+    if (_count == _capacity)
+    {
+        size_t const capacity = _capacity ? _capacity * 2 : 4;
+        Expiry *const expiries = static_cast<Expiry *>(realloc(_expiries, capacity * sizeof(Expiry)));
+        if (expiries == nullptr)
+            return false;
+
+        _expiries = expiries;
+        _capacity = capacity;
+    }
+
+    Expiry &expiry = _expiries[_count++];
+    strncpy(expiry.key, key, sizeof(expiry.key) - 1);
+    expiry.key[sizeof(expiry.key) - 1] = '\0';
+    expiry.expiresAt = expiresAt;
+    return true;
+}
+
+void DatabaseExpiry::remove(char const *const key)
+{
+    Expiry const *const expiry = find(key);
+    if (expiry == nullptr)
+        return;
+
+    // Order does not matter, move the last key into the freed slot
+    _expiries[expiry - _expiries] = _expiries[--_count];
+}
+
+void DatabaseExpiry::clear()
+{
+    free(_expiries);
+    _expiries = nullptr;
+    _count = 0;
+    _capacity = 0;
+}
+
+size_t DatabaseExpiry::count() const
+{
+    return _count;
+}
+
+DatabaseExpiry::Expiry const &DatabaseExpiry::at(size_t const index) const
+{
+    return _expiries[index];
+}
+
+size_t DatabaseExpiry::serializedLength() const
+{
+    size_t length = 0;
+    for (size_t i = 0; i < _count; ++i)
+        length += 4 + strlen(_expiries[i].key) + 1;
+    return length;
+}
+
+void DatabaseExpiry::serialize(uint8_t *out) const
+{
+    for (size_t i = 0; i < _count; ++i)
+    {
+        uint32_t const expiresAt = _expiries[i].expiresAt;
+        for (size_t b = 0; b < 4; ++b)
+            *out++ = static_cast<uint8_t>(expiresAt >> (8 * b));
+
+        size_t const keyLength = strlen(_expiries[i].key) + 1;
+        memcpy(out, _expiries[i].key, keyLength);
+        out += keyLength;
+    }
+}
+
+bool DatabaseExpiry::deserialize(uint8_t const *const data, size_t const length)
+{
+    clear();
+
+    size_t position = 0;
+    while (position < length)
+    {
+        // A record is 4 bytes of time and a terminated key of at most NVS_DELEGATE_MAX_KEY_LENGTH bytes
+        if (length - position < 4 + 2)
+            break;
+        uint32_t expiresAt = 0;
+        for (size_t b = 0; b < 4; ++b)
+            expiresAt |= static_cast<uint32_t>(data[position + b]) << (8 * b);
+        position += 4;
+
+        char const *const key = reinterpret_cast<char const *>(data + position);
+        size_t const keyLength = strnlen(key, length - position);
+        if (keyLength == 0 || keyLength == length - position || keyLength >= NVS_DELEGATE_MAX_KEY_LENGTH)
+            break;
+        position += keyLength + 1;
+
+        if (!set(key, expiresAt))
+            break;
+    }
+
+    if (position == length)
+        return true;
+
+    clear();
+    return false;
+}
@@ -0,0 +1,71 @@
+#include "DatabaseFingerprints.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+DatabaseFingerprints::DatabaseFingerprints() : _fingerprints(nullptr), _count(0), _capacity(0)
+{
+}
+
+DatabaseFingerprints::~DatabaseFingerprints()
+{
+    clear();
+}
+
+DatabaseFingerprints::Fingerprint const *DatabaseFingerprints::find(char const *const key) const
+{
+    for (size_t i = 0; i < _count; ++i)
+        if (strcmp(_fingerprints[i].key, key) == 0)
+            return &_fingerprints[i];
+    return nullptr;
+}
+
+bool DatabaseFingerprints::set(char const *const key, uint32_t const hash, size_t const length)
+{
+    Fingerprint *fingerprint = const_cast<Fingerprint *>(find(key));
+    if (fingerprint == nullptr)
+    {
+        // Grow by doubling, starting with room for eight fingerprints
+        if (_count == _capacity)
+        {
+            size_t const capacity = _capacity ? _capacity * 2 : 8;
+            Fingerprint *const fingerprints = static_cast<Fingerprint *>(realloc(_fingerprints, capacity * sizeof(Fingerprint)));
+            if (fingerprints == nullptr)
+                return false;
+
+            _fingerprints = fingerprints;
+            _capacity = capacity;
+        }
+
+        fingerprint = &_fingerprints[_count++];
+        strncpy(fingerprint->key, key, sizeof(fingerprint->key) - 1);
+        fingerprint->key[sizeof(fingerprint->key) - 1] = '\0';
+    }
+
+    fingerprint->hash = hash;
+    fingerprint->length = static_cast<uint16_t>(length);
+    return true;
+}
+
+void DatabaseFingerprints::remove(char const *const key)
+{
+    Fingerprint *const fingerprint = const_cast<Fingerprint *>(find(key));
+    if (fingerprint == nullptr)
+        return;
+
+    // Order does not matter, move the last fingerprint into the freed slot
+    *fingerprint = _fingerprints[--_count];
+}
+
+void DatabaseFingerprints::clear()
+{
+    free(_fingerprints);
+    _fingerprints = nullptr;
+    _count = 0;
+    _capacity = 0;
+}
+
+size_t DatabaseFingerprints::count() const
+{
+    return _count;
+}
@@ -0,0 +1,21 @@
+#include "DatabaseHash.hpp"
+
+#define DATABASE_HASH_OFFSET_BASIS 2166136261u
+#define DATABASE_HASH_PRIME 16777619u
+
+uint32_t DatabaseHash::fnv1a(void const *const data, size_t const length)
+{
+    uint8_t const *const bytes = static_cast<uint8_t const *>(data);
+    uint32_t hash = DATABASE_HASH_OFFSET_BASIS;
+    for (size_t i = 0; i < length; ++i)
+        hash = (hash ^ bytes[i]) * DATABASE_HASH_PRIME;
+    return hash;
+}
+
+uint32_t DatabaseHash::fnv1a(char const *const string)
+{
+    uint32_t hash = DATABASE_HASH_OFFSET_BASIS;
+    for (char const *c = string; *c; ++c)
+        hash = (hash ^ static_cast<uint8_t>(*c)) * DATABASE_HASH_PRIME;
+    return hash;
+}
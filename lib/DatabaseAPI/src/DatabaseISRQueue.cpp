@@ -0,0 +1,167 @@
+#include "DatabaseISRQueue.hpp"
+
+#include <new>
+#include <string.h>
+
+// Constructor for DatabaseISRQueue
+DatabaseISRQueue::DatabaseISRQueue(
+    DatabaseAPIInterface *const database, size_t const capacity,
+    MultiPrinterLoggerInterface *const logger)
+    : _database(database), _slots(capacity ? new (std::nothrow) Slot[capacity] : nullptr),
+      _capacity(_slots ? capacity : 0), _head(0), _tail(0), _dropped(0),
+      _drainTask(nullptr), _drainPeriodMs(0), _stopRequested(false), _drainTaskStopped(nullptr),
+      _logger(logger)
+{
+    Log_Debug(_logger, "DatabaseISRQueue created with %zu slots", _capacity);
+}
+
+// Destructor for DatabaseISRQueue
+DatabaseISRQueue::~DatabaseISRQueue()
+{
+    stopDrainTask();
+    drain();
+    delete[] _slots;
+    Log_Debug(_logger, "DatabaseISRQueue destroyed");
+}
+
+// Queues a value from interrupt context
+DatabaseError_t IRAM_ATTR DatabaseISRQueue::enqueueFromISR(char const *const key, char const *const value)
+{
+    uint32_t const head = _head.load(std::memory_order_relaxed);
+    uint32_t const tail = _tail.load(std::memory_order_acquire);
+
+    // Drop the value if every slot is still waiting to be drained
+    if (head - tail >= _capacity)
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return DATABASE_NOT_ENOUGH_SPACE;
+    }
+
+    // Fill the slot before publishing it to the consumer
+    Slot &slot = _slots[head % _capacity];
+    if (!copyBounded(slot.key, key, sizeof(slot.key)))
+        return DATABASE_KEY_INVALID;
+    if (!copyBounded(slot.value, value, sizeof(slot.value)))
+        return DATABASE_VALUE_INVALID;
+
+    _head.store(head + 1, std::memory_order_release);
+    return DATABASE_OK;
+}
+
+// Writes every pending value to the database
+DatabaseError_t DatabaseISRQueue::drain(size_t *appliedCount)
+{
+    DatabaseLockGuard guard(_drainMutex);
+
+    size_t applied = 0;
+    DatabaseError_t result = DATABASE_OK;
+
+    uint32_t const tail = _tail.load(std::memory_order_relaxed);
+    uint32_t const head = _head.load(std::memory_order_acquire);
+
+    for (uint32_t i = tail; i != head; ++i)
+    {
+        Slot const &slot = _slots[i % _capacity];
+
+        // Skip the value if a newer one for the same key is pending
+        bool superseded = false;
+        for (uint32_t j = i + 1; j != head && !superseded; ++j)
+            superseded = strcmp(_slots[j % _capacity].key, slot.key) == 0;
+        if (superseded)
+            continue;
+
+        DatabaseError_t err = _database ? _database->set(slot.key, slot.value) : DATABASE_ERROR;
+        if (err != DATABASE_OK)
+        {
+            Log_Error(_logger, "Failed to write queued key '%s'", slot.key);
+            result = err;
+            continue;
+        }
+        ++applied;
+    }
+
+    // Release the drained slots to the producer
+    _tail.store(head, std::memory_order_release);
+
+    if (appliedCount)
+        *appliedCount = applied;
+
+    Log_Verbose(_logger, "Drained %u queued values, %zu written", (unsigned)(head - tail), applied);
+    return result;
+}
+
+// Starts the background drain task
+DatabaseError_t DatabaseISRQueue::startDrainTask(
+    uint32_t const periodMs, uint32_t const stackSize, UBaseType_t const priority)
+{
+    if (_drainTask)
+        return DATABASE_OK;
+
+    _drainTaskStopped = xSemaphoreCreateBinary();
+    if (!_drainTaskStopped)
+        return DATABASE_ERROR;
+
+    _drainPeriodMs = periodMs;
+    _stopRequested.store(false);
+    if (xTaskCreate(drainTaskEntry, "DatabaseISRQueue", stackSize, this, priority, &_drainTask) != pdPASS)
+    {
+        Log_Error(_logger, "Failed to create the drain task");
+        vSemaphoreDelete(_drainTaskStopped);
+        _drainTaskStopped = nullptr;
+        _drainTask = nullptr;
+        return DATABASE_ERROR;
+    }
+
+    Log_Debug(_logger, "Drain task started with a period of %u ms", (unsigned)periodMs);
+    return DATABASE_OK;
+}
+
+// Stops the background drain task
+void DatabaseISRQueue::stopDrainTask()
+{
+    if (!_drainTask)
+        return;
+
+    // Wait for the task to finish its final drain and exit
+    _stopRequested.store(true);
+    xSemaphoreTake(_drainTaskStopped, portMAX_DELAY);
+    vSemaphoreDelete(_drainTaskStopped);
+    _drainTaskStopped = nullptr;
+    _drainTask = nullptr;
+
+    Log_Debug(_logger, "Drain task stopped");
+}
+
+uint32_t DatabaseISRQueue::droppedCount() const
+{
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+void DatabaseISRQueue::drainTaskEntry(void *arg)
+{
+    DatabaseISRQueue *const queue = static_cast<DatabaseISRQueue *>(arg);
+
+    while (!queue->_stopRequested.load())
+    {
+        queue->drain();
+        vTaskDelay(pdMS_TO_TICKS(queue->_drainPeriodMs));
+    }
+    queue->drain();
+
+    xSemaphoreGive(queue->_drainTaskStopped);
+    vTaskDelete(nullptr);
+}
+
+bool IRAM_ATTR DatabaseISRQueue::copyBounded(char *destination, char const *const source, size_t const size)
+{
+    if (source == nullptr || source[0] == '\0')
+        return false;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        destination[i] = source[i];
+        if (source[i] == '\0')
+            return true;
+    }
+    return false;
+}
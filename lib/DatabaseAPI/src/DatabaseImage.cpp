@@ -0,0 +1,148 @@
+#include "DatabaseImage.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+DatabaseImage::DatabaseImage(DatabaseImageWriter_t const writer, void *const context)
+    : _writer(writer), _context(context), _crc(0), _count(0)
+{
+}
+
+bool DatabaseImage::begin()
+{
+    uint8_t const header[] = {DATABASE_IMAGE_MAGIC[0], DATABASE_IMAGE_MAGIC[1], DATABASE_IMAGE_MAGIC[2], DATABASE_IMAGE_VERSION};
+    return write(header, sizeof(header));
+}
+
+bool DatabaseImage::add(char const *const key, char const *const value)
+{
+    size_t const keyLength = strlen(key);
+    size_t const valueLength = strlen(value);
+    if (keyLength == 0 || keyLength >= NVS_DELEGATE_MAX_KEY_LENGTH || valueLength == 0 || valueLength >= NVS_DELEGATE_MAX_VALUE_LENGTH)
+        return false;
+
+    // The count field holds 2 bytes
+    if (_count == 0xFFFF)
+        return false;
+
+    uint8_t const keyField = static_cast<uint8_t>(keyLength);
+    uint8_t const valueField[] = {static_cast<uint8_t>(valueLength), static_cast<uint8_t>(valueLength >> 8)};
+    if (!write(&keyField, 1) || !write(reinterpret_cast<uint8_t const *>(key), keyLength) ||
+        !write(valueField, sizeof(valueField)) || !write(reinterpret_cast<uint8_t const *>(value), valueLength))
+        return false;
+
+    _count++;
+    return true;
+}
+
+bool DatabaseImage::end()
+{
+    uint8_t const trailer[] = {0, static_cast<uint8_t>(_count), static_cast<uint8_t>(_count >> 8)};
+    if (!write(trailer, sizeof(trailer)))
+        return false;
+
+    // The CRC covers every byte before it
+    uint8_t const crc[] = {static_cast<uint8_t>(_crc), static_cast<uint8_t>(_crc >> 8),
+                           static_cast<uint8_t>(_crc >> 16), static_cast<uint8_t>(_crc >> 24)};
+    return _writer(crc, sizeof(crc), _context);
+}
+
+size_t DatabaseImage::count() const
+{
+    return _count;
+}
+
+DatabaseError_t DatabaseImage::read(DatabaseImageReader_t const reader, void *const context, DatabaseBatch *const batch)
+{
+    batch->clear();
+
+    uint8_t header[4];
+    if (!reader(header, sizeof(header), context) || memcmp(header, DATABASE_IMAGE_MAGIC, 3) != 0 || header[3] != DATABASE_IMAGE_VERSION)
+        return DATABASE_VALUE_INVALID;
+    uint32_t crc = crc32(0, header, sizeof(header));
+
+    DatabaseError_t err = DATABASE_OK;
+    size_t count = 0;
+    uint8_t keyLength;
+    while (err == DATABASE_OK)
+    {
+        // A key length of 0 ends the values
+        if (!reader(&keyLength, 1, context))
+        {
+            err = DATABASE_VALUE_INVALID;
+            break;
+        }
+        crc = crc32(crc, &keyLength, 1);
+        if (keyLength == 0)
+            break;
+
+        char key[NVS_DELEGATE_MAX_KEY_LENGTH];
+        uint8_t valueField[2];
+        if (keyLength >= NVS_DELEGATE_MAX_KEY_LENGTH || !reader(reinterpret_cast<uint8_t *>(key), keyLength, context) ||
+            !reader(valueField, sizeof(valueField), context))
+        {
+            err = DATABASE_VALUE_INVALID;
+            break;
+        }
+        key[keyLength] = '\0';
+        crc = crc32(crc, reinterpret_cast<uint8_t *>(key), keyLength);
+        crc = crc32(crc, valueField, sizeof(valueField));
+
+        size_t const valueLength = valueField[0] | (valueField[1] << 8);
+        if (valueLength == 0 || valueLength >= NVS_DELEGATE_MAX_VALUE_LENGTH)
+        {
+            err = DATABASE_VALUE_INVALID;
+            break;
+        }
+
+        char *const value = static_cast<char *>(malloc(valueLength + 1));
+        if (value == nullptr)
+            err = DATABASE_NOT_ENOUGH_SPACE;
+        else if (!reader(reinterpret_cast<uint8_t *>(value), valueLength, context))
+            err = DATABASE_VALUE_INVALID;
+        else
+        {
+            value[valueLength] = '\0';
+            crc = crc32(crc, reinterpret_cast<uint8_t *>(value), valueLength);
+            err = batch->set(key, value);
+            count++;
+        }
+        free(value);
+    }
+
+    // The trailer holds the number of values and the CRC of everything before it
+    uint8_t trailer[6];
+    if (err == DATABASE_OK && !reader(trailer, sizeof(trailer), context))
+        err = DATABASE_VALUE_INVALID;
+    if (err == DATABASE_OK)
+    {
+        crc = crc32(crc, trailer, 2);
+        size_t const storedCount = trailer[0] | (trailer[1] << 8);
+        uint32_t const storedCrc = trailer[2] | (trailer[3] << 8) | (trailer[4] << 16) | (static_cast<uint32_t>(trailer[5]) << 24);
+        if (storedCount != count || storedCrc != crc)
+            err = DATABASE_VALUE_INVALID;
+    }
+
+    if (err != DATABASE_OK)
+        batch->clear();
+    return err;
+}
+
+uint32_t DatabaseImage::crc32(uint32_t const crc, uint8_t const *const data, size_t const length)
+{
+    // Bitwise, reflected polynomial 0xEDB88320: slower than a table, but no RAM or rodata cost
+    uint32_t value = ~crc;
+    for (size_t i = 0; i < length; ++i)
+    {
+        value ^= data[i];
+        for (int bit = 0; bit < 8; ++bit)
+            value = (value >> 1) ^ (0xEDB88320u & (0u - (value & 1u)));
+    }
+    return ~value;
+}
+
+bool DatabaseImage::write(uint8_t const *const data, size_t const length)
+{
+    _crc = crc32(_crc, data, length);
+    return _writer(data, length, _context);
+}
@@ -0,0 +1,79 @@
+#include "DatabaseJob.hpp"
+
+#include <esp_timer.h>
+
+#include "DatabaseAPI.hpp"
+
+DatabaseJob::DatabaseJob()
+    : _database(nullptr), _next(0), _eraseAll(false), _done(true), _result(DATABASE_OK)
+{
+}
+
+DatabaseError_t DatabaseJob::step(uint32_t const budgetUs)
+{
+    if (_done)
+        return DATABASE_OK;
+
+    int64_t const start = esp_timer_get_time();
+    do
+    {
+        // The batch is over, only the erase of what is left may remain
+        if (_next == _batch.count())
+        {
+            _result = _eraseAll ? _database->eraseAll() : DATABASE_OK;
+            _done = true;
+            _batch.clear();
+            return _result;
+        }
+
+        DatabaseBatch::Operation const &operation = _batch.at(_next);
+        DatabaseError_t err = operation.value ? _database->set(operation.key, operation.value)
+                                              : _database->remove(operation.key);
+
+        // A key removed in between is not an error
+        if (err == DATABASE_KEY_NOT_FOUND && operation.value == nullptr)
+            err = DATABASE_OK;
+        if (err != DATABASE_OK)
+        {
+            _result = err;
+            _done = true;
+            _batch.clear();
+            return err;
+        }
+        _next++;
+
+        // Without an erase to follow, the last key completes the job
+        if (_next == _batch.count() && !_eraseAll)
+        {
+            _done = true;
+            _batch.clear();
+            return DATABASE_OK;
+        }
+    } while (esp_timer_get_time() - start < budgetUs);
+
+    return DATABASE_OK;
+}
+
+bool DatabaseJob::isDone() const
+{
+    return _done;
+}
+
+DatabaseError_t DatabaseJob::result() const
+{
+    return _result;
+}
+
+size_t DatabaseJob::remaining() const
+{
+    return _done ? 0 : _batch.count() - _next;
+}
+
+void DatabaseJob::start(DatabaseAPI *const database, bool const eraseAll)
+{
+    _database = database;
+    _next = 0;
+    _eraseAll = eraseAll;
+    _done = false;
+    _result = DATABASE_OK;
+}
@@ -0,0 +1,433 @@
+#include "DatabaseKeyMap.hpp"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DatabaseHash.hpp"
+
+// Hash keys are the prefix, 8 hex digits and the digit of an extra slot
+#define DATABASE_KEY_MAP_HASH_DIGITS 8
+#define DATABASE_KEY_MAP_MAX_PREFIX_LENGTH (NVS_DELEGATE_MAX_KEY_LENGTH - DATABASE_KEY_MAP_HASH_DIGITS - 2)
+// Length of the key and ':' in front of a record, plus the terminator
+#define DATABASE_KEY_MAP_HEADER_TEXT_LENGTH 4
+// Slot digit, length of the key and ':' in front of each key of the collision table
+#define DATABASE_KEY_MAP_TABLE_ENTRY_LENGTH (4 + DATABASE_KEY_MAP_MAX_KEY_LENGTH)
+
+// Records of the map listed by forEach, filled by visitRecord
+struct DatabaseKeyMapScan
+{
+    DatabaseKeyMap const *map;
+    DatabaseKeyMapVisitor_t visitor;
+    void *context;
+    DatabaseError_t err;
+};
+
+DatabaseKeyMap::DatabaseKeyMap(
+    DatabaseAPI *const database, char const *const prefix, size_t const maxValueLength,
+    MultiPrinterLoggerInterface *const logger)
+    : DatabasePrefixedStore(database, prefix, DATABASE_KEY_MAP_MAX_PREFIX_LENGTH, "Key map", logger),
+      _maxValueLength(maxValueLength), _text(nullptr), _collisions(nullptr), _collisionCount(0)
+{
+    Log_Debug(_logger, "DatabaseKeyMap created for prefix '%s'", _prefix);
+}
+
+DatabaseKeyMap::~DatabaseKeyMap()
+{
+    free(_text);
+    free(_collisions);
+    Log_Debug(_logger, "DatabaseKeyMap destroyed");
+}
+
+DatabaseError_t DatabaseKeyMap::begin()
+{
+    // Validate the configuration
+    DatabaseError_t const configurationErr = validate(_maxValueLength > 0 && textLength() <= NVS_DELEGATE_MAX_VALUE_LENGTH);
+    if (configurationErr != DATABASE_OK)
+        return configurationErr;
+
+    DatabaseLockGuard guard(_mutex);
+
+    if (_text == nullptr)
+        _text = static_cast<char *>(malloc(textLength()));
+    if (_collisions == nullptr)
+        _collisions = static_cast<Collision *>(malloc(DATABASE_KEY_MAP_MAX_COLLISIONS * sizeof(Collision)));
+    if (_text == nullptr || _collisions == nullptr)
+    {
+        Log_Error(_logger, "Not enough memory for the key map '%s'", _prefix);
+        return DATABASE_NOT_ENOUGH_SPACE;
+    }
+
+    // A map without collision has no table
+    char tableKey[NVS_DELEGATE_MAX_KEY_LENGTH];
+    strcpy(tableKey, _prefix);
+    strcat(tableKey, DATABASE_KEY_MAP_TABLE_SUFFIX);
+    _collisionCount = 0;
+    DatabaseError_t const err = _database->get(tableKey, _text, textLength());
+    if (err != DATABASE_OK && err != DATABASE_KEY_NOT_FOUND)
+        return err;
+    if (err == DATABASE_OK && !decodeTable())
+    {
+        Log_Error(_logger, "Collision table of key map '%s' is corrupted", _prefix);
+        _collisionCount = 0;
+        return DATABASE_ERROR;
+    }
+    _begun = true;
+
+    Log_Debug(_logger, "Key map '%s' has %u keys in extra slots", _prefix, static_cast<unsigned>(_collisionCount));
+    return DATABASE_OK;
+}
+
+DatabaseError_t DatabaseKeyMap::get(char const *const key, char *value, size_t const maxValueLength) const
+{
+    // Validate input parameters
+    if (!isKeyValid(key))
+    {
+        Log_Error(_logger, "Invalid key");
+        return DATABASE_KEY_INVALID;
+    }
+    if (value == nullptr || maxValueLength == 0)
+    {
+        Log_Error(_logger, "Invalid value");
+        return DATABASE_VALUE_INVALID;
+    }
+
+    DatabaseLockGuard guard(_mutex);
+
+    if (!isStarted())
+        return DATABASE_ERROR;
+
+    char nvsKey[NVS_DELEGATE_MAX_KEY_LENGTH];
+    char const *stored = nullptr;
+    DatabaseError_t const err = locate(key, nvsKey, &stored);
+    if (err != DATABASE_OK)
+        return err;
+
+    if (strlen(stored) >= maxValueLength)
+    {
+        Log_Error(_logger, "Buffer too small for key '%s'", key);
+        return DATABASE_VALUE_INVALID;
+    }
+    strcpy(value, stored);
+    return DATABASE_OK;
+}
+
+DatabaseError_t DatabaseKeyMap::set(char const *const key, char const *const value)
+{
+    // Validate input parameters
+    if (!isKeyValid(key))
+    {
+        Log_Error(_logger, "Invalid key");
+        return DATABASE_KEY_INVALID;
+    }
+    if (value == nullptr || strlen(value) == 0 || strlen(value) > _maxValueLength)
+    {
+        Log_Error(_logger, "Invalid value");
+        return DATABASE_VALUE_INVALID;
+    }
+
+    DatabaseLockGuard guard(_mutex);
+
+    if (!isStarted())
+        return DATABASE_ERROR;
+
+    uint32_t const hash = DatabaseHash::fnv1a(key);
+    size_t const keyLength = strlen(key);
+    char nvsKey[NVS_DELEGATE_MAX_KEY_LENGTH];
+
+    // A key in the collision table, or whose hash slot is free or its own, is written in place
+    Collision const *const collision = findCollision(key, hash);
+    bool taken = false;
+    if (collision)
+        slotKey(hash, collision->slot, nvsKey);
+    else
+    {
+        slotKey(hash, 0, nvsKey);
+        char const *stored = nullptr;
+        size_t storedLength = 0;
+        DatabaseError_t const err = load(nvsKey, &stored, &storedLength);
+        if (err != DATABASE_OK && err != DATABASE_KEY_NOT_FOUND)
+            return err;
+        taken = err == DATABASE_OK && (storedLength != keyLength || memcmp(stored, key, keyLength) != 0);
+    }
+
+    if (!taken)
+    {
+        snprintf(_text, textLength(), "%u:%s%s", static_cast<unsigned>(keyLength), key, value);
+        return _database->set(nvsKey, _text);
+    }
+
+    // The hash slot holds another key, take the first extra slot no key of the same hash uses
+    uint8_t slot = 1;
+    for (; slot < DATABASE_KEY_MAP_MAX_SLOTS; ++slot)
+    {
+        bool used = false;
+        for (size_t i = 0; i < _collisionCount && !used; ++i)
+            used = _collisions[i].hash == hash && _collisions[i].slot == slot;
+        if (!used)
+            break;
+    }
+    if (slot >= DATABASE_KEY_MAP_MAX_SLOTS || _collisionCount >= DATABASE_KEY_MAP_MAX_COLLISIONS)
+    {
+        Log_Error(_logger, "No slot left for key '%s' in key map '%s'", key, _prefix);
+        return DATABASE_NOT_ENOUGH_SPACE;
+    }
+
+    Collision &added = _collisions[_collisionCount++];
+    added.hash = hash;
+    added.slot = slot;
+    strcpy(added.key, key);
+    Log_Verbose(_logger, "Key '%s' collides in key map '%s', stored in slot %u", key, _prefix, static_cast<unsigned>(slot));
+
+    // The record and the table entry pointing to it are written together
+    DatabaseBatch batch;
+    slotKey(hash, slot, nvsKey);
+    snprintf(_text, textLength(), "%u:%s%s", static_cast<unsigned>(keyLength), key, value);
+    DatabaseError_t err = batch.set(nvsKey, _text);
+    if (err == DATABASE_OK)
+        err = stageTable(batch);
+    if (err == DATABASE_OK)
+        err = _database->commit(batch);
+    if (err != DATABASE_OK)
+        _collisionCount--;
+    return err;
+}
+
+DatabaseError_t DatabaseKeyMap::remove(char const *const key)
+{
+    // Validate input parameters
+    if (!isKeyValid(key))
+    {
+        Log_Error(_logger, "Invalid key");
+        return DATABASE_KEY_INVALID;
+    }
+
+    DatabaseLockGuard guard(_mutex);
+
+    if (!isStarted())
+        return DATABASE_ERROR;
+
+    uint32_t const hash = DatabaseHash::fnv1a(key);
+    Collision const *const collision = findCollision(key, hash);
+    char nvsKey[NVS_DELEGATE_MAX_KEY_LENGTH];
+    if (collision == nullptr)
+    {
+        DatabaseError_t const err = locate(key, nvsKey, nullptr);
+        if (err != DATABASE_OK)
+            return err;
+        return _database->remove(nvsKey);
+    }
+
+    // The record and its table entry are removed together
+    slotKey(hash, collision->slot, nvsKey);
+    size_t const index = static_cast<size_t>(collision - _collisions);
+    Collision const removed = *collision;
+    _collisions[index] = _collisions[--_collisionCount];
+
+    DatabaseBatch batch;
+    DatabaseError_t err = batch.remove(nvsKey);
+    if (err == DATABASE_OK)
+        err = stageTable(batch);
+    if (err == DATABASE_OK)
+        err = _database->commit(batch);
+    if (err != DATABASE_OK)
+    {
+        _collisions[_collisionCount++] = _collisions[index];
+        _collisions[index] = removed;
+    }
+    return err;
+}
+
+DatabaseError_t DatabaseKeyMap::isExist(char const *const key) const
+{
+    // Validate input parameters
+    if (!isKeyValid(key))
+    {
+        Log_Error(_logger, "Invalid key");
+        return DATABASE_KEY_INVALID;
+    }
+
+    DatabaseLockGuard guard(_mutex);
+
+    if (!isStarted())
+        return DATABASE_ERROR;
+
+    char nvsKey[NVS_DELEGATE_MAX_KEY_LENGTH];
+    return locate(key, nvsKey, nullptr);
+}
+
+DatabaseError_t DatabaseKeyMap::forEach(DatabaseKeyMapVisitor_t const visitor, void *const context) const
+{
+    // Validate input parameters
+    if (visitor == nullptr)
+    {
+        Log_Error(_logger, "Invalid value");
+        return DATABASE_VALUE_INVALID;
+    }
+
+    DatabaseLockGuard guard(_mutex);
+
+    if (!isStarted())
+        return DATABASE_ERROR;
+
+    DatabaseKeyMapScan scan = {this, visitor, context, DATABASE_OK};
+    DatabaseError_t const err = _database->listKeys(visitRecord, &scan);
+    return err != DATABASE_OK ? err : scan.err;
+}
+
+size_t DatabaseKeyMap::collisions() const
+{
+    DatabaseLockGuard guard(_mutex);
+    return _collisionCount;
+}
+
+size_t DatabaseKeyMap::textLength() const
+{
+    size_t const recordLength = DATABASE_KEY_MAP_HEADER_TEXT_LENGTH + DATABASE_KEY_MAP_MAX_KEY_LENGTH + _maxValueLength;
+    size_t const tableLength = DATABASE_KEY_MAP_MAX_COLLISIONS * DATABASE_KEY_MAP_TABLE_ENTRY_LENGTH + 1;
+    return recordLength > tableLength ? recordLength : tableLength;
+}
+
+bool DatabaseKeyMap::isKeyValid(char const *const key)
+{
+    return key && strlen(key) > 0 && strlen(key) < DATABASE_KEY_MAP_MAX_KEY_LENGTH;
+}
+
+void DatabaseKeyMap::slotKey(uint32_t const hash, uint8_t const slot, char *out_key) const
+{
+    size_t const length = strlen(_prefix);
+    memcpy(out_key, _prefix, length);
+    if (slot == 0)
+        snprintf(out_key + length, NVS_DELEGATE_MAX_KEY_LENGTH - length, "%08x", static_cast<unsigned>(hash));
+    else
+        snprintf(out_key + length, NVS_DELEGATE_MAX_KEY_LENGTH - length, "%08x%u", static_cast<unsigned>(hash),
+                 static_cast<unsigned>(slot));
+}
+
+DatabaseKeyMap::Collision const *DatabaseKeyMap::findCollision(char const *const key, uint32_t const hash) const
+{
+    for (size_t i = 0; i < _collisionCount; ++i)
+        if (_collisions[i].hash == hash && strcmp(_collisions[i].key, key) == 0)
+            return &_collisions[i];
+    return nullptr;
+}
+
+DatabaseError_t DatabaseKeyMap::load(char const *const nvsKey, char const **out_key, size_t *out_keyLength) const
+{
+    DatabaseError_t const err = _database->get(nvsKey, _text, textLength());
+    if (err != DATABASE_OK)
+        return err;
+
+    // A record starts with the length of its key and ':'
+    char *end = nullptr;
+    unsigned long const keyLength = strtoul(_text, &end, 10);
+    if (end == _text || *end != ':' || keyLength == 0 || keyLength > strlen(end + 1))
+    {
+        Log_Error(_logger, "Record '%s' of key map '%s' is corrupted", nvsKey, _prefix);
+        return DATABASE_KEY_NOT_FOUND;
+    }
+
+    *out_key = end + 1;
+    *out_keyLength = keyLength;
+    return DATABASE_OK;
+}
+
+DatabaseError_t DatabaseKeyMap::locate(char const *const key, char *out_nvsKey, char const **out_value) const
+{
+    uint32_t const hash = DatabaseHash::fnv1a(key);
+    Collision const *const collision = findCollision(key, hash);
+    slotKey(hash, collision ? collision->slot : 0, out_nvsKey);
+
+    // The record names its key, so a hash slot holding another key is told apart in the same read
+    char const *stored = nullptr;
+    size_t storedLength = 0;
+    DatabaseError_t const err = load(out_nvsKey, &stored, &storedLength);
+    if (err != DATABASE_OK)
+        return err;
+    if (storedLength != strlen(key) || memcmp(stored, key, storedLength) != 0)
+        return DATABASE_KEY_NOT_FOUND;
+
+    if (out_value)
+        *out_value = stored + storedLength;
+    return DATABASE_OK;
+}
+
+void DatabaseKeyMap::encodeTable() const
+{
+    size_t length = 0;
+    _text[0] = '\0';
+    for (size_t i = 0; i < _collisionCount; ++i)
+        length += snprintf(_text + length, textLength() - length, "%u%u:%s", static_cast<unsigned>(_collisions[i].slot),
+                           static_cast<unsigned>(strlen(_collisions[i].key)), _collisions[i].key);
+}
+
+bool DatabaseKeyMap::decodeTable()
+{
+    // Entries are "<slot><length>:<key>", one after the other
+    char const *text = _text;
+    while (*text)
+    {
+        if (_collisionCount == DATABASE_KEY_MAP_MAX_COLLISIONS || *text < '1' || *text > '9')
+            return false;
+        uint8_t const slot = static_cast<uint8_t>(*text - '0');
+
+        char *end = nullptr;
+        unsigned long const keyLength = strtoul(text + 1, &end, 10);
+        if (end == text + 1 || *end != ':' || keyLength == 0 || keyLength >= DATABASE_KEY_MAP_MAX_KEY_LENGTH ||
+            keyLength > strlen(end + 1) || slot >= DATABASE_KEY_MAP_MAX_SLOTS)
+            return false;
+
+        Collision &collision = _collisions[_collisionCount++];
+        memcpy(collision.key, end + 1, keyLength);
+        collision.key[keyLength] = '\0';
+        collision.hash = DatabaseHash::fnv1a(collision.key);
+        collision.slot = slot;
+        text = end + 1 + keyLength;
+    }
+    return true;
+}
+
+DatabaseError_t DatabaseKeyMap::stageTable(DatabaseBatch &batch) const
+{
+    char tableKey[NVS_DELEGATE_MAX_KEY_LENGTH];
+    strcpy(tableKey, _prefix);
+    strcat(tableKey, DATABASE_KEY_MAP_TABLE_SUFFIX);
+    if (_collisionCount == 0)
+        return batch.remove(tableKey);
+
+    encodeTable();
+    return batch.set(tableKey, _text);
+}
+
+bool DatabaseKeyMap::visitRecord(char const *const nvsKey, void *context)
+{
+    DatabaseKeyMapScan *const scan = static_cast<DatabaseKeyMapScan *>(context);
+    DatabaseKeyMap const *const map = scan->map;
+
+    // Only hash keys of the map hold records, the prefix followed by 8 hex digits and an optional slot digit
+    size_t const prefixLength = strlen(map->_prefix);
+    size_t const length = strlen(nvsKey);
+    if (strncmp(nvsKey, map->_prefix, prefixLength) != 0 || length < prefixLength + DATABASE_KEY_MAP_HASH_DIGITS ||
+        length > prefixLength + DATABASE_KEY_MAP_HASH_DIGITS + 1)
+        return true;
+    for (size_t i = prefixLength; i < length; ++i)
+        if (!isxdigit(static_cast<unsigned char>(nvsKey[i])))
+            return true;
+
+    char const *stored = nullptr;
+    size_t storedLength = 0;
+    DatabaseError_t const err = map->load(nvsKey, &stored, &storedLength);
+    if (err == DATABASE_KEY_NOT_FOUND)
+        return true;
+    if (err != DATABASE_OK || storedLength >= DATABASE_KEY_MAP_MAX_KEY_LENGTH)
+    {
+        scan->err = err != DATABASE_OK ? err : DATABASE_ERROR;
+        return false;
+    }
+
+    char key[DATABASE_KEY_MAP_MAX_KEY_LENGTH];
+    memcpy(key, stored, storedLength);
+    key[storedLength] = '\0';
+    return scan->visitor(key, stored + storedLength, scan->context);
+}
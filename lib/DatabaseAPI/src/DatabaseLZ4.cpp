@@ -0,0 +1,180 @@
+#include "DatabaseLZ4.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Limits of the LZ4 block format
+#define DATABASE_LZ4_MIN_MATCH 4     // Shortest match encoded
+#define DATABASE_LZ4_LAST_LITERALS 5 // The last bytes are always literals
+#define DATABASE_LZ4_MATCH_LIMIT 12  // The last match starts at least this far from the end
+#define DATABASE_LZ4_MAX_OFFSET 65535
+
+static uint32_t read32(uint8_t const *const p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t hash32(uint32_t const sequence)
+{
+    return (sequence * 2654435761u) >> (32 - DATABASE_LZ4_HASH_BITS);
+}
+
+// Writes the extension bytes of a length of at least 15, returns false if they do not fit
+static bool writeLength(uint8_t *const destination, size_t const capacity, size_t *out, size_t length)
+{
+    for (length -= 15; length >= 255; length -= 255)
+    {
+        if (*out >= capacity)
+            return false;
+        destination[(*out)++] = 255;
+    }
+    if (*out >= capacity)
+        return false;
+    destination[(*out)++] = static_cast<uint8_t>(length);
+    return true;
+}
+
+// Reads the extension bytes of a length, returns false if they run past the input
+static bool readLength(uint8_t const *const source, size_t const sourceLength, size_t *in, size_t *length)
+{
+    uint8_t byte;
+    do
+    {
+        if (*in >= sourceLength)
+            return false;
+        byte = source[(*in)++];
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// Writes a sequence: token, literals, and the match unless matchLength is 0
+static bool writeSequence(
+    uint8_t *const destination, size_t const capacity, size_t *out,
+    uint8_t const *const literals, size_t const literalLength, size_t const offset, size_t const matchLength)
+{
+    if (*out >= capacity)
+        return false;
+
+    size_t const matchCode = matchLength ? matchLength - DATABASE_LZ4_MIN_MATCH : 0;
+    destination[(*out)++] = static_cast<uint8_t>(((literalLength < 15 ? literalLength : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+
+    if (literalLength >= 15 && !writeLength(destination, capacity, out, literalLength))
+        return false;
+    if (capacity - *out < literalLength)
+        return false;
+    memcpy(destination + *out, literals, literalLength);
+    *out += literalLength;
+
+    if (matchLength == 0)
+        return true;
+
+    if (capacity - *out < 2)
+        return false;
+    destination[(*out)++] = static_cast<uint8_t>(offset);
+    destination[(*out)++] = static_cast<uint8_t>(offset >> 8);
+    return matchCode < 15 || writeLength(destination, capacity, out, matchCode);
+}
+
+size_t DatabaseLZ4::compress(uint8_t const *const source, size_t const sourceLength, uint8_t *const destination, size_t const capacity)
+{
+    if (source == nullptr || destination == nullptr || sourceLength > DATABASE_LZ4_MAX_OFFSET)
+        return 0;
+
+    size_t out = 0;
+    size_t anchor = 0;
+
+    // Inputs too short for a match are a single run of literals
+    if (sourceLength > DATABASE_LZ4_MATCH_LIMIT)
+    {
+        // Position + 1 of the last sequence of each hash, 0 for none
+        uint16_t *const table = static_cast<uint16_t *>(calloc(1 << DATABASE_LZ4_HASH_BITS, sizeof(uint16_t)));
+        if (table == nullptr)
+            return 0;
+
+        size_t const lastMatchStart = sourceLength - DATABASE_LZ4_MATCH_LIMIT;
+        size_t const matchEnd = sourceLength - DATABASE_LZ4_LAST_LITERALS;
+        size_t position = 0;
+        while (position <= lastMatchStart)
+        {
+            uint32_t const sequence = read32(source + position);
+            uint32_t const hash = hash32(sequence);
+            size_t const candidate = table[hash];
+            table[hash] = static_cast<uint16_t>(position + 1);
+
+            if (candidate == 0 || read32(source + candidate - 1) != sequence)
+            {
+                position++;
+                continue;
+            }
+
+            size_t const reference = candidate - 1;
+            size_t matchLength = DATABASE_LZ4_MIN_MATCH;
+            while (position + matchLength < matchEnd && source[reference + matchLength] == source[position + matchLength])
+                matchLength++;
+
+            if (!writeSequence(destination, capacity, &out, source + anchor, position - anchor, position - reference, matchLength))
+            {
+                free(table);
+                return 0;
+            }
+
+            position += matchLength;
+            anchor = position;
+        }
+
+        free(table);
+    }
+
+    if (!writeSequence(destination, capacity, &out, source + anchor, sourceLength - anchor, 0, 0))
+        return 0;
+    return out;
+}
+
+bool DatabaseLZ4::decompress(uint8_t const *const source, size_t const sourceLength, uint8_t *const destination, size_t const length)
+{
+    if (source == nullptr || destination == nullptr)
+        return false;
+
+    size_t in = 0;
+    size_t out = 0;
+    while (in < sourceLength)
+    {
+        uint8_t const token = source[in++];
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(source, sourceLength, &in, &literalLength))
+            return false;
+        if (literalLength > sourceLength - in || literalLength > length - out)
+            return false;
+        memcpy(destination + out, source + in, literalLength);
+        in += literalLength;
+        out += literalLength;
+
+        // The last sequence has no match
+        if (in == sourceLength)
+            return out == length;
+
+        if (sourceLength - in < 2)
+            return false;
+        size_t const offset = source[in] | (source[in + 1] << 8);
+        in += 2;
+        if (offset == 0 || offset > out)
+            return false;
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(source, sourceLength, &in, &matchLength))
+            return false;
+        matchLength += DATABASE_LZ4_MIN_MATCH;
+        if (matchLength > length - out)
+            return false;
+
+        // Byte by byte, a match may overlap the bytes it produces
+        for (size_t i = 0; i < matchLength; i++, out++)
+            destination[out] = destination[out - offset];
+    }
+
+    return false;
+}
@@ -0,0 +1,54 @@
+#include "DatabaseLatency.hpp"
+
+#include <string.h>
+
+DatabaseLatency::DatabaseLatency()
+{
+    memset(_history, 0, sizeof(_history));
+}
+
+void DatabaseLatency::record(DatabaseOperation_t const operation, uint32_t const latencyUs)
+{
+    if (operation >= DATABASE_OPERATION_COUNT)
+        return;
+
+    // Kept scaled, as in RFC 6298: gains of 1/8 for the latency and 1/4 for the deviation
+    History &history = _history[operation];
+    if (history.samples == 0)
+    {
+        history.smoothed = latencyUs << 3;
+        history.deviation = latencyUs << 1;
+    }
+    else
+    {
+        int32_t error = static_cast<int32_t>(latencyUs) - static_cast<int32_t>(history.smoothed >> 3);
+        history.smoothed += error;
+        if (error < 0)
+            error = -error;
+        history.deviation += error - static_cast<int32_t>(history.deviation >> 2);
+    }
+
+    if (latencyUs > history.worst)
+        history.worst = latencyUs;
+    if (history.samples < UINT32_MAX)
+        history.samples++;
+}
+
+uint32_t DatabaseLatency::predict(DatabaseOperation_t const operation) const
+{
+    if (operation >= DATABASE_OPERATION_COUNT)
+        return 0;
+
+    History const &history = _history[operation];
+    return (history.smoothed >> 3) + history.deviation;
+}
+
+uint32_t DatabaseLatency::worst(DatabaseOperation_t const operation) const
+{
+    return operation < DATABASE_OPERATION_COUNT ? _history[operation].worst : 0;
+}
+
+uint32_t DatabaseLatency::samples(DatabaseOperation_t const operation) const
+{
+    return operation < DATABASE_OPERATION_COUNT ? _history[operation].samples : 0;
+}
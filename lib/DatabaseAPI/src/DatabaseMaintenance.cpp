@@ -0,0 +1,175 @@
+#include "DatabaseMaintenance.hpp"
+
+// Constructor for DatabaseMaintenance
+DatabaseMaintenance::DatabaseMaintenance(DatabaseAPI *const database, MultiPrinterLoggerInterface *const logger)
+    : _database(database), _minFreeEntries(DATABASE_MAINTENANCE_MIN_FREE_ENTRIES),
+      _idleMs(DATABASE_MAINTENANCE_IDLE_MS), _detector(nullptr), _detectorContext(nullptr),
+      _stage(STAGE_STALE_GENERATION), _reclaimCount(0), _task(nullptr), _periodMs(0),
+      _stopRequested(false), _taskStopped(nullptr), _logger(logger)
+{
+    Log_Debug(_logger, "DatabaseMaintenance created");
+}
+
+// Destructor for DatabaseMaintenance
+DatabaseMaintenance::~DatabaseMaintenance()
+{
+    stop();
+    Log_Debug(_logger, "DatabaseMaintenance destroyed");
+}
+
+void DatabaseMaintenance::setWatermark(size_t const minFreeEntries)
+{
+    _minFreeEntries.store(minFreeEntries);
+}
+
+void DatabaseMaintenance::setIdleTime(uint32_t const idleMs)
+{
+    _idleMs.store(idleMs);
+}
+
+void DatabaseMaintenance::setIdleDetector(DatabaseIdleDetector_t const detector, void *const context)
+{
+    DatabaseLockGuard guard(_stepMutex);
+    _detector = detector;
+    _detectorContext = context;
+}
+
+bool DatabaseMaintenance::isIdle() const
+{
+    if (_database == nullptr)
+        return false;
+
+    DatabaseLockGuard guard(_stepMutex);
+    if (_detector)
+        return _detector(_database, _detectorContext);
+    return _database->getIdleTime() >= _idleMs.load();
+}
+
+// Persists the pending counters, then runs one piece of reclamation if the database is short of free entries
+DatabaseError_t DatabaseMaintenance::step(bool *worked)
+{
+    if (worked)
+        *worked = false;
+
+    if (_database == nullptr)
+        return DATABASE_ERROR;
+
+    DatabaseLockGuard guard(_stepMutex);
+    if (!isIdle())
+        return DATABASE_OK;
+
+    // Counters left idle are written whatever the free entries, nothing is written if none is pending
+    DatabaseError_t err = _database->flushCounters();
+    if (err != DATABASE_OK)
+    {
+        Log_Error(_logger, "Persisting the counters failed");
+        return err;
+    }
+
+    NVSDelegateStats_t stats;
+    err = _database->getSpaceStats(&stats);
+    if (err != DATABASE_OK)
+        return err;
+
+    // Start over from the first stage the next time space runs short
+    if (stats.freeEntries >= _minFreeEntries.load())
+    {
+        _stage = STAGE_STALE_GENERATION;
+        return DATABASE_OK;
+    }
+
+    Log_Verbose(_logger, "%zu free entries of %zu, reclaiming", stats.freeEntries, stats.totalEntries);
+    err = runStage();
+    _reclaimCount++;
+    if (worked)
+        *worked = true;
+    return err;
+}
+
+DatabaseError_t DatabaseMaintenance::runStage()
+{
+    DatabaseError_t err = DATABASE_OK;
+    switch (_stage)
+    {
+    case STAGE_STALE_GENERATION:
+        err = _database->eraseStaleGeneration();
+        _stage = STAGE_EXPIRED_KEYS;
+        break;
+    default:
+    {
+        // A full sweep may have left more expired keys for the next step
+        size_t removed = 0;
+        err = _database->sweepExpired(DATABASE_MAINTENANCE_SWEEP_KEYS, &removed);
+        if (err != DATABASE_OK || removed < DATABASE_MAINTENANCE_SWEEP_KEYS)
+            _stage = STAGE_STALE_GENERATION;
+        break;
+    }
+    }
+
+    if (err != DATABASE_OK)
+        Log_Error(_logger, "Reclamation failed");
+    return err;
+}
+
+// Starts the background task
+DatabaseError_t DatabaseMaintenance::start(
+    uint32_t const periodMs, uint32_t const stackSize, UBaseType_t const priority)
+{
+    if (_task)
+        return DATABASE_OK;
+
+    _taskStopped = xSemaphoreCreateBinary();
+    if (!_taskStopped)
+        return DATABASE_ERROR;
+
+    _periodMs = periodMs;
+    _stopRequested.store(false);
+    if (xTaskCreate(taskEntry, "DatabaseMaintenance", stackSize, this, priority, &_task) != pdPASS)
+    {
+        Log_Error(_logger, "Failed to create the maintenance task");
+        vSemaphoreDelete(_taskStopped);
+        _taskStopped = nullptr;
+        _task = nullptr;
+        return DATABASE_ERROR;
+    }
+
+    Log_Debug(_logger, "Maintenance task started with a period of %u ms", (unsigned)periodMs);
+    return DATABASE_OK;
+}
+
+// Stops the background task
+void DatabaseMaintenance::stop()
+{
+    if (!_task)
+        return;
+
+    // Wake the task from its wait, then wait for it to finish its current step and exit
+    _stopRequested.store(true);
+    xTaskNotifyGive(_task);
+    xSemaphoreTake(_taskStopped, portMAX_DELAY);
+    vSemaphoreDelete(_taskStopped);
+    _taskStopped = nullptr;
+    _task = nullptr;
+
+    Log_Debug(_logger, "Maintenance task stopped");
+}
+
+uint32_t DatabaseMaintenance::reclaimCount() const
+{
+    return _reclaimCount.load();
+}
+
+void DatabaseMaintenance::taskEntry(void *arg)
+{
+    DatabaseMaintenance *const maintenance = static_cast<DatabaseMaintenance *>(arg);
+
+    // The period is waited for as a notification, so that stop does not wait for it to elapse
+    while (!maintenance->_stopRequested.load())
+    {
+        maintenance->step();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(maintenance->_periodMs));
+    }
+
+    xSemaphoreGive(maintenance->_taskStopped);
+    vTaskDelete(nullptr);
+}
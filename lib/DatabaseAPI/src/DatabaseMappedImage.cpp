@@ -0,0 +1,266 @@
+#include "DatabaseMappedImage.hpp"
+
+#include <string.h>
+
+#include "DatabaseImage.hpp"
+#include "NVSDelegateInterface.hpp"
+
+#ifdef ESP_PLATFORM
+#include <esp_partition.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Magic and version in front of the values
+#define DATABASE_MAPPED_IMAGE_HEADER_LENGTH 4
+// Terminating 0 byte, count on 2 bytes and CRC on 4 bytes after the values
+#define DATABASE_MAPPED_IMAGE_TRAILER_LENGTH 7
+
+DatabaseMappedView::DatabaseMappedView()
+    : _image(nullptr), _data(nullptr), _length(0)
+{
+}
+
+DatabaseMappedView::~DatabaseMappedView()
+{
+    release();
+}
+
+char const *DatabaseMappedView::data() const
+{
+    return _data;
+}
+
+size_t DatabaseMappedView::length() const
+{
+    return _length;
+}
+
+void DatabaseMappedView::release()
+{
+    if (_image == nullptr)
+        return;
+
+    _image->_views--;
+    _image = nullptr;
+    _data = nullptr;
+    _length = 0;
+}
+
+DatabaseMappedImage::DatabaseMappedImage(char const *const source, MultiPrinterLoggerInterface *const logger)
+    : _source(source), _region(nullptr), _regionLength(0), _imageLength(0), _count(0), _mapping(0), _views(0),
+      _logger(logger)
+{
+    Log_Debug(_logger, "DatabaseMappedImage created for '%s'", _source ? _source : "");
+}
+
+DatabaseMappedImage::DatabaseMappedImage(uint8_t const *const image, size_t const length, MultiPrinterLoggerInterface *const logger)
+    : _source(nullptr), _region(image), _regionLength(image ? length : 0), _imageLength(0), _count(0), _mapping(0),
+      _views(0), _logger(logger)
+{
+    Log_Debug(_logger, "DatabaseMappedImage created for %u bytes in memory", static_cast<unsigned>(_regionLength));
+}
+
+DatabaseMappedImage::~DatabaseMappedImage()
+{
+    if (_views > 0)
+        Log_Error(_logger, "DatabaseMappedImage destroyed while %u views hold values", static_cast<unsigned>(_views));
+    unmap();
+    Log_Debug(_logger, "DatabaseMappedImage destroyed");
+}
+
+DatabaseError_t DatabaseMappedImage::begin()
+{
+    DatabaseLockGuard guard(_mutex);
+
+    if (_imageLength > 0)
+        return DATABASE_OK;
+
+    DatabaseError_t const err = map();
+    if (err != DATABASE_OK)
+        return err;
+
+    if (!check())
+    {
+        Log_Error(_logger, "Invalid image");
+        unmap();
+        return DATABASE_VALUE_INVALID;
+    }
+
+    Log_Debug(_logger, "Image of %u values, %u bytes mapped", static_cast<unsigned>(_count), static_cast<unsigned>(_imageLength));
+    return DATABASE_OK;
+}
+
+DatabaseError_t DatabaseMappedImage::end()
+{
+    DatabaseLockGuard guard(_mutex);
+
+    if (_views > 0)
+    {
+        Log_Error(_logger, "%u views still hold values of the image", static_cast<unsigned>(_views));
+        return DATABASE_ERROR;
+    }
+
+    unmap();
+    return DATABASE_OK;
+}
+
+DatabaseError_t DatabaseMappedImage::get(char const *const key, DatabaseMappedView *const view) const
+{
+    // Validate input parameters
+    if (key == nullptr || strlen(key) == 0 || strlen(key) >= NVS_DELEGATE_MAX_KEY_LENGTH)
+    {
+        Log_Error(_logger, "Invalid key");
+        return DATABASE_KEY_INVALID;
+    }
+    if (view == nullptr)
+    {
+        Log_Error(_logger, "Invalid value");
+        return DATABASE_VALUE_INVALID;
+    }
+    view->release();
+
+    DatabaseLockGuard guard(_mutex);
+
+    if (_imageLength == 0)
+    {
+        Log_Error(_logger, "Image not mapped");
+        return DATABASE_ERROR;
+    }
+
+    // The image was checked by begin(), so the walk stays inside it
+    size_t const keyLength = strlen(key);
+    size_t position = DATABASE_MAPPED_IMAGE_HEADER_LENGTH;
+    while (_region[position] != 0)
+    {
+        size_t const entryKeyLength = _region[position];
+        uint8_t const *const entryKey = _region + position + 1;
+        uint8_t const *const valueField = entryKey + entryKeyLength;
+        size_t const valueLength = valueField[0] | (valueField[1] << 8);
+
+        if (entryKeyLength == keyLength && memcmp(entryKey, key, keyLength) == 0)
+        {
+            _views++;
+            view->_image = this;
+            view->_data = reinterpret_cast<char const *>(valueField + 2);
+            view->_length = valueLength;
+            return DATABASE_OK;
+        }
+        position += 1 + entryKeyLength + 2 + valueLength;
+    }
+
+    return DATABASE_KEY_NOT_FOUND;
+}
+
+size_t DatabaseMappedImage::count() const
+{
+    DatabaseLockGuard guard(_mutex);
+    return _count;
+}
+
+DatabaseError_t DatabaseMappedImage::map()
+{
+    // An image in memory is always mapped
+    if (_source == nullptr)
+        return _region ? DATABASE_OK : DATABASE_KEY_NOT_FOUND;
+
+#ifdef ESP_PLATFORM
+    esp_partition_t const *const partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, _source);
+    if (partition == nullptr)
+    {
+        Log_Error(_logger, "Partition '%s' not found", _source);
+        return DATABASE_KEY_NOT_FOUND;
+    }
+
+    void const *region = nullptr;
+    esp_partition_mmap_handle_t mapping = 0;
+    if (esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &region, &mapping) != ESP_OK)
+    {
+        Log_Error(_logger, "Partition '%s' could not be mapped", _source);
+        return DATABASE_ERROR;
+    }
+    _region = static_cast<uint8_t const *>(region);
+    _regionLength = partition->size;
+    _mapping = mapping;
+#else
+    int const file = open(_source, O_RDONLY);
+    if (file < 0)
+    {
+        Log_Error(_logger, "File '%s' not found", _source);
+        return DATABASE_KEY_NOT_FOUND;
+    }
+
+    struct stat status;
+    void *region = MAP_FAILED;
+    if (fstat(file, &status) == 0 && status.st_size > 0)
+        region = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (region == MAP_FAILED)
+    {
+        Log_Error(_logger, "File '%s' could not be mapped", _source);
+        return DATABASE_ERROR;
+    }
+    _region = static_cast<uint8_t const *>(region);
+    _regionLength = status.st_size;
+#endif
+
+    return DATABASE_OK;
+}
+
+void DatabaseMappedImage::unmap()
+{
+    _imageLength = 0;
+    _count = 0;
+    if (_source == nullptr || _region == nullptr)
+        return;
+
+#ifdef ESP_PLATFORM
+    esp_partition_munmap(_mapping);
+#else
+    munmap(const_cast<uint8_t *>(_region), _regionLength);
+#endif
+    _region = nullptr;
+    _regionLength = 0;
+    _mapping = 0;
+}
+
+bool DatabaseMappedImage::check()
+{
+    if (_regionLength < DATABASE_MAPPED_IMAGE_HEADER_LENGTH + DATABASE_MAPPED_IMAGE_TRAILER_LENGTH ||
+        memcmp(_region, DATABASE_IMAGE_MAGIC, 3) != 0 || _region[3] != DATABASE_IMAGE_VERSION)
+        return false;
+
+    // Walk the entries up to the terminating 0 byte, the region may be longer than the image
+    size_t position = DATABASE_MAPPED_IMAGE_HEADER_LENGTH;
+    size_t count = 0;
+    while (position < _regionLength && _region[position] != 0)
+    {
+        size_t const keyLength = _region[position];
+        if (keyLength >= NVS_DELEGATE_MAX_KEY_LENGTH || position + 1 + keyLength + 2 > _regionLength)
+            return false;
+
+        uint8_t const *const valueField = _region + position + 1 + keyLength;
+        size_t const valueLength = valueField[0] | (valueField[1] << 8);
+        if (valueLength == 0)
+            return false;
+
+        position += 1 + keyLength + 2 + valueLength;
+        count++;
+    }
+    if (position + DATABASE_MAPPED_IMAGE_TRAILER_LENGTH > _regionLength)
+        return false;
+
+    // The trailer holds the number of values and the CRC of everything before it
+    uint8_t const *const trailer = _region + position + 1;
+    size_t const storedCount = trailer[0] | (trailer[1] << 8);
+    uint32_t const storedCrc = trailer[2] | (trailer[3] << 8) | (trailer[4] << 16) | (static_cast<uint32_t>(trailer[5]) << 24);
+    if (storedCount != count || storedCrc != DatabaseImage::crc32(0, _region, position + 3))
+        return false;
+
+    _imageLength = position + DATABASE_MAPPED_IMAGE_TRAILER_LENGTH;
+    _count = count;
+    return true;
+}
@@ -0,0 +1,38 @@
+#include "DatabaseMutex.hpp"
+
+DatabaseMutex::DatabaseMutex() : _handle(xSemaphoreCreateRecursiveMutex())
+{
+}
+
+DatabaseMutex::~DatabaseMutex()
+{
+    if (_handle)
+        vSemaphoreDelete(_handle);
+}
+
+void DatabaseMutex::lock() const
+{
+    if (_handle)
+        xSemaphoreTakeRecursive(_handle, portMAX_DELAY);
+}
+
+bool DatabaseMutex::tryLock(uint32_t const timeoutMs) const
+{
+    return _handle && xSemaphoreTakeRecursive(_handle, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+}
+
+void DatabaseMutex::unlock() const
+{
+    if (_handle)
+        xSemaphoreGiveRecursive(_handle);
+}
+
+DatabaseLockGuard::DatabaseLockGuard(DatabaseMutex const &mutex) : _mutex(mutex)
+{
+    _mutex.lock();
+}
+
+DatabaseLockGuard::~DatabaseLockGuard()
+{
+    _mutex.unlock();
+}
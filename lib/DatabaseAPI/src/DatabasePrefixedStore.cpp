@@ -0,0 +1,43 @@
+#include "DatabasePrefixedStore.hpp"
+
+#include <string.h>
+
+DatabasePrefixedStore::DatabasePrefixedStore(
+    DatabaseAPI *const database, char const *const prefix, size_t const maxPrefixLength,
+    char const *const name, MultiPrinterLoggerInterface *const logger)
+    : _database(database), _name(name), _logger(logger), _begun(false)
+{
+    // An invalid prefix is kept empty and reported by begin()
+    if (prefix == nullptr || strlen(prefix) == 0 || strlen(prefix) > maxPrefixLength)
+        _prefix[0] = '\0';
+    else
+        strcpy(_prefix, prefix);
+}
+
+DatabaseError_t DatabasePrefixedStore::validate(bool const valueValid) const
+{
+    // Keys starting with '~' are reserved by DatabaseAPI
+    if (_prefix[0] == '\0' || _prefix[0] == '~')
+    {
+        Log_Error(_logger, "Invalid key");
+        return DATABASE_KEY_INVALID;
+    }
+    if (!valueValid)
+    {
+        Log_Error(_logger, "Invalid value");
+        return DATABASE_VALUE_INVALID;
+    }
+    if (_database == nullptr)
+    {
+        Log_Error(_logger, "Unknown error");
+        return DATABASE_ERROR;
+    }
+    return DATABASE_OK;
+}
+
+bool DatabasePrefixedStore::isStarted() const
+{
+    if (!_begun)
+        Log_Error(_logger, "%s '%s' not started", _name, _prefix);
+    return _begun;
+}
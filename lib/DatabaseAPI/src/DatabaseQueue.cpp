@@ -0,0 +1,325 @@
+#include "DatabaseQueue.hpp"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Sequence number and ':' in front of a message, plus the terminator
+#define DATABASE_QUEUE_HEADER_TEXT_LENGTH 12
+// Slot keys end with up to 3 digits
+#define DATABASE_QUEUE_MAX_PREFIX_LENGTH (NVS_DELEGATE_MAX_KEY_LENGTH - 4)
+
+DatabaseQueue::DatabaseQueue(
+    DatabaseAPI *const database, char const *const prefix, uint16_t const capacity, size_t const maxMessageLength,
+    MultiPrinterLoggerInterface *const logger)
+    : DatabasePrefixedStore(database, prefix, DATABASE_QUEUE_MAX_PREFIX_LENGTH, "Queue", logger),
+      _capacity(capacity), _maxMessageLength(maxMessageLength), _text(nullptr), _head(0), _tail(0)
+{
+    Log_Debug(_logger, "DatabaseQueue created for prefix '%s'", _prefix);
+}
+
+DatabaseQueue::~DatabaseQueue()
+{
+    free(_text);
+    Log_Debug(_logger, "DatabaseQueue destroyed");
+}
+
+DatabaseError_t DatabaseQueue::begin()
+{
+    // Validate the configuration
+    DatabaseError_t const configurationErr = validate(_capacity > 0 && _capacity <= DATABASE_QUEUE_MAX_CAPACITY &&
+                                                      _maxMessageLength > 0 && textLength() <= NVS_DELEGATE_MAX_VALUE_LENGTH);
+    if (configurationErr != DATABASE_OK)
+        return configurationErr;
+
+    DatabaseLockGuard guard(_mutex);
+
+    if (_text == nullptr)
+        _text = static_cast<char *>(malloc(textLength()));
+    if (_text == nullptr)
+    {
+        Log_Error(_logger, "Not enough memory for the queue '%s'", _prefix);
+        return DATABASE_NOT_ENOUGH_SPACE;
+    }
+
+    // Messages are enqueued and removed in order, so the stored ones are contiguous
+    bool found = false;
+    _head = 0;
+    _tail = 0;
+    for (uint16_t i = 0; i < _capacity; ++i)
+    {
+        char key[NVS_DELEGATE_MAX_KEY_LENGTH];
+        slotKey(i, key);
+
+        DatabaseError_t const err = _database->get(key, _text, textLength());
+        if (err == DATABASE_ERROR)
+            return err;
+
+        uint32_t sequence = 0;
+        if (err != DATABASE_OK || decode(_text, &sequence) == nullptr || sequence % _capacity != i)
+            continue;
+
+        if (!found || sequence < _head)
+            _head = sequence;
+        if (!found || sequence >= _tail)
+            _tail = sequence + 1;
+        found = true;
+    }
+    _begun = true;
+
+    Log_Debug(_logger, "Queue '%s' holds %u messages", _prefix, static_cast<unsigned>(_tail - _head));
+    return DATABASE_OK;
+}
+
+DatabaseError_t DatabaseQueue::enqueue(char const *const message)
+{
+    // Validate input parameters
+    if (message == nullptr || strlen(message) > _maxMessageLength)
+    {
+        Log_Error(_logger, "Invalid value");
+        return DATABASE_VALUE_INVALID;
+    }
+
+    DatabaseLockGuard guard(_mutex);
+
+    if (!isStarted())
+        return DATABASE_ERROR;
+    if (_tail - _head >= _capacity)
+    {
+        Log_Error(_logger, "Queue '%s' is full", _prefix);
+        return DATABASE_NOT_ENOUGH_SPACE;
+    }
+
+    char key[NVS_DELEGATE_MAX_KEY_LENGTH];
+    slotKey(_tail, key);
+    snprintf(_text, textLength(), "%" PRIu32 ":%s", _tail, message);
+
+    DatabaseError_t const err = _database->set(key, _text);
+    if (err != DATABASE_OK)
+        return err;
+
+    _tail++;
+    return DATABASE_OK;
+}
+
+DatabaseError_t DatabaseQueue::enqueue(char const *const *const messages, size_t const count)
+{
+    // Validate input parameters
+    if (messages == nullptr)
+    {
+        Log_Error(_logger, "Invalid value");
+        return DATABASE_VALUE_INVALID;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (messages[i] == nullptr || strlen(messages[i]) > _maxMessageLength)
+        {
+            Log_Error(_logger, "Invalid value");
+            return DATABASE_VALUE_INVALID;
+        }
+    }
+
+    DatabaseLockGuard guard(_mutex);
+
+    if (!isStarted())
+        return DATABASE_ERROR;
+    if (count > _capacity - (_tail - _head))
+    {
+        Log_Error(_logger, "Queue '%s' has no room for %u messages", _prefix, static_cast<unsigned>(count));
+        return DATABASE_NOT_ENOUGH_SPACE;
+    }
+
+    DatabaseBatch batch;
+    for (size_t i = 0; i < count; ++i)
+    {
+        char key[NVS_DELEGATE_MAX_KEY_LENGTH];
+        slotKey(_tail + i, key);
+        snprintf(_text, textLength(), "%" PRIu32 ":%s", static_cast<uint32_t>(_tail + i), messages[i]);
+
+        DatabaseError_t const err = batch.set(key, _text);
+        if (err != DATABASE_OK)
+            return err;
+    }
+
+    // Applied in order under one commit, a reset keeps a contiguous prefix of the messages
+    DatabaseError_t const err = _database->commit(batch, false);
+    if (err != DATABASE_OK)
+        return err;
+
+    _tail += count;
+    return DATABASE_OK;
+}
+
+DatabaseError_t DatabaseQueue::peek(size_t const index, char *message, size_t const maxLength) const
+{
+    // Validate input parameters
+    if (message == nullptr || maxLength == 0)
+    {
+        Log_Error(_logger, "Invalid value");
+        return DATABASE_VALUE_INVALID;
+    }
+
+    DatabaseLockGuard guard(_mutex);
+
+    if (!isStarted())
+        return DATABASE_ERROR;
+    if (index >= _tail - _head)
+        return DATABASE_KEY_NOT_FOUND;
+
+    char const *stored = nullptr;
+    DatabaseError_t const err = load(_head + index, &stored);
+    if (err != DATABASE_OK)
+        return err;
+
+    if (strlen(stored) >= maxLength)
+    {
+        Log_Error(_logger, "Buffer too small for message %u of queue '%s'", static_cast<unsigned>(index), _prefix);
+        return DATABASE_VALUE_INVALID;
+    }
+    strcpy(message, stored);
+    return DATABASE_OK;
+}
+
+DatabaseError_t DatabaseQueue::dequeue(
+    DatabaseQueueConsumer_t const consumer, void *const context, size_t const maxCount, size_t *out_count)
+{
+    // Validate input parameters
+    if (consumer == nullptr)
+    {
+        Log_Error(_logger, "Invalid value");
+        return DATABASE_VALUE_INVALID;
+    }
+    if (out_count)
+        *out_count = 0;
+
+    DatabaseLockGuard guard(_mutex);
+
+    if (!isStarted())
+        return DATABASE_ERROR;
+
+    // Hand messages over until the consumer stops, then acknowledge the handled ones together
+    size_t handled = 0;
+    DatabaseError_t loadErr = DATABASE_OK;
+    while (handled < maxCount && handled < _tail - _head)
+    {
+        char const *message = nullptr;
+        loadErr = load(_head + handled, &message);
+        if (loadErr == DATABASE_KEY_NOT_FOUND)
+        {
+            Log_Error(_logger, "Message %" PRIu32 " of queue '%s' is missing, skipped", static_cast<uint32_t>(_head + handled), _prefix);
+            loadErr = DATABASE_OK;
+            handled++;
+            continue;
+        }
+        if (loadErr != DATABASE_OK)
+        {
+            Log_Error(_logger, "Reading message %" PRIu32 " of queue '%s' failed", static_cast<uint32_t>(_head + handled), _prefix);
+            break;
+        }
+        if (!consumer(message, context))
+            break;
+        handled++;
+    }
+
+    // The messages handled before a failed read are acknowledged, the read error is still reported
+    DatabaseError_t const err = ack(handled);
+    if (err == DATABASE_OK && out_count)
+        *out_count = handled;
+    return err != DATABASE_OK ? err : loadErr;
+}
+
+DatabaseError_t DatabaseQueue::ack(size_t const count)
+{
+    DatabaseLockGuard guard(_mutex);
+
+    if (!isStarted())
+        return DATABASE_ERROR;
+    if (count > _tail - _head)
+    {
+        Log_Error(_logger, "Invalid value");
+        return DATABASE_VALUE_INVALID;
+    }
+    if (count == 0)
+        return DATABASE_OK;
+
+    // Removed oldest first under one commit, a reset keeps the queue contiguous
+    DatabaseBatch batch;
+    DatabaseError_t err = stageRemoval(batch, count);
+    if (err == DATABASE_OK)
+        err = _database->commit(batch, false);
+    if (err != DATABASE_OK)
+        return err;
+
+    _head += count;
+    if (_head == _tail)
+        _head = _tail = 0;
+    return DATABASE_OK;
+}
+
+size_t DatabaseQueue::size() const
+{
+    DatabaseLockGuard guard(_mutex);
+    return _tail - _head;
+}
+
+size_t DatabaseQueue::capacity() const
+{
+    return _capacity;
+}
+
+size_t DatabaseQueue::textLength() const
+{
+    return DATABASE_QUEUE_HEADER_TEXT_LENGTH + _maxMessageLength;
+}
+
+void DatabaseQueue::slotKey(uint32_t const sequence, char *key) const
+{
+    size_t const length = strlen(_prefix);
+    memcpy(key, _prefix, length);
+    snprintf(key + length, NVS_DELEGATE_MAX_KEY_LENGTH - length, "%u",
+             static_cast<unsigned>(sequence % _capacity) % DATABASE_QUEUE_MAX_CAPACITY);
+}
+
+DatabaseError_t DatabaseQueue::load(uint32_t const sequence, char const **out_message) const
+{
+    char key[NVS_DELEGATE_MAX_KEY_LENGTH];
+    slotKey(sequence, key);
+
+    DatabaseError_t const err = _database->get(key, _text, textLength());
+    if (err != DATABASE_OK)
+        return err;
+
+    uint32_t stored = 0;
+    char const *const message = decode(_text, &stored);
+    if (message == nullptr || stored != sequence)
+        return DATABASE_KEY_NOT_FOUND;
+
+    *out_message = message;
+    return DATABASE_OK;
+}
+
+char const *DatabaseQueue::decode(char const *const text, uint32_t *out_sequence)
+{
+    char *end = nullptr;
+    unsigned long const sequence = strtoul(text, &end, 10);
+    if (end == text || *end != ':' || sequence > UINT32_MAX)
+        return nullptr;
+
+    *out_sequence = static_cast<uint32_t>(sequence);
+    return end + 1;
+}
+
+DatabaseError_t DatabaseQueue::stageRemoval(DatabaseBatch &batch, size_t const count) const
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        char key[NVS_DELEGATE_MAX_KEY_LENGTH];
+        slotKey(_head + i, key);
+
+        DatabaseError_t const err = batch.remove(key);
+        if (err != DATABASE_OK)
+            return err;
+    }
+    return DATABASE_OK;
+}
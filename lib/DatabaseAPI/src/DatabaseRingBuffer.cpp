@@ -0,0 +1,298 @@
+#include "DatabaseRingBuffer.hpp"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Longest encoded record: an 11-character difference and its separator
+#define DATABASE_RING_BUFFER_RECORD_TEXT_LENGTH 12
+// Slot number, ':' and the delta marker, plus the terminator
+#define DATABASE_RING_BUFFER_HEADER_TEXT_LENGTH 13
+// Slot keys end with up to 3 digits
+#define DATABASE_RING_BUFFER_MAX_PREFIX_LENGTH (NVS_DELEGATE_MAX_KEY_LENGTH - 4)
+
+DatabaseRingBuffer::DatabaseRingBuffer(
+    DatabaseAPI *const database, char const *const prefix, uint8_t const slotCount, uint8_t const recordsPerSlot,
+    bool const deltaEncoding, MultiPrinterLoggerInterface *const logger)
+    : DatabasePrefixedStore(database, prefix, DATABASE_RING_BUFFER_MAX_PREFIX_LENGTH, "Ring buffer", logger),
+      _slotCount(slotCount), _recordsPerSlot(recordsPerSlot), _deltaEncoding(deltaEncoding), _head(nullptr),
+      _records(nullptr), _text(nullptr), _headSlot(0), _headCount(0), _headDirty(false)
+{
+    Log_Debug(_logger, "DatabaseRingBuffer created for prefix '%s'", _prefix);
+}
+
+DatabaseRingBuffer::~DatabaseRingBuffer()
+{
+    // Records still in RAM are written on a clean shutdown
+    flush();
+
+    free(_head);
+    free(_records);
+    free(_text);
+    Log_Debug(_logger, "DatabaseRingBuffer destroyed");
+}
+
+DatabaseError_t DatabaseRingBuffer::begin()
+{
+    // Validate the configuration
+    DatabaseError_t const configurationErr = validate(_slotCount >= 2 && _recordsPerSlot > 0 &&
+                                                      _recordsPerSlot <= DATABASE_RING_BUFFER_MAX_RECORDS_PER_SLOT);
+    if (configurationErr != DATABASE_OK)
+        return configurationErr;
+
+    DatabaseLockGuard guard(_mutex);
+
+    if (_head == nullptr)
+        _head = static_cast<int32_t *>(malloc(_recordsPerSlot * sizeof(int32_t)));
+    if (_records == nullptr)
+        _records = static_cast<int32_t *>(malloc(_recordsPerSlot * sizeof(int32_t)));
+    if (_text == nullptr)
+        _text = static_cast<char *>(malloc(textLength()));
+    if (_head == nullptr || _records == nullptr || _text == nullptr)
+    {
+        Log_Error(_logger, "Not enough memory for the ring buffer '%s'", _prefix);
+        return DATABASE_NOT_ENOUGH_SPACE;
+    }
+
+    // The slot holding the highest sequence number is the one being filled
+    bool found = false;
+    _headSlot = 0;
+    _headCount = 0;
+    for (uint8_t i = 0; i < _slotCount; ++i)
+    {
+        char key[NVS_DELEGATE_MAX_KEY_LENGTH];
+        slotKey(i, key);
+
+        DatabaseError_t const err = _database->get(key, _text, textLength());
+        if (err == DATABASE_ERROR)
+            return err;
+
+        // Missing, oversized or corrupt slots hold no records
+        uint32_t slot = 0;
+        uint8_t count = 0;
+        if (err != DATABASE_OK || !decode(_text, &slot, _records, &count) || slot % _slotCount != i)
+            continue;
+
+        if (!found || slot > _headSlot)
+        {
+            found = true;
+            _headSlot = slot;
+            _headCount = count;
+            memcpy(_head, _records, count * sizeof(int32_t));
+        }
+    }
+    _headDirty = false;
+    _begun = true;
+
+    Log_Debug(_logger, "Ring buffer '%s' continues at record %" PRIu32, _prefix, nextSequence());
+    return DATABASE_OK;
+}
+
+DatabaseError_t DatabaseRingBuffer::append(int32_t const value, uint32_t *sequence)
+{
+    DatabaseLockGuard guard(_mutex);
+
+    if (!isStarted())
+        return DATABASE_ERROR;
+
+    // Move on to the next slot, overwriting the oldest one, once the current slot is written
+    if (_headCount == _recordsPerSlot)
+    {
+        if (_headDirty)
+        {
+            DatabaseError_t const err = flush();
+            if (err != DATABASE_OK)
+                return err;
+        }
+        _headSlot++;
+        _headCount = 0;
+    }
+
+    _head[_headCount++] = value;
+    _headDirty = true;
+    if (sequence)
+        *sequence = _headSlot * _recordsPerSlot + _headCount - 1;
+
+    // A full slot is written once; a failed write is retried by the next append or flush
+    if (_headCount == _recordsPerSlot)
+        return flush();
+    return DATABASE_OK;
+}
+
+DatabaseError_t DatabaseRingBuffer::flush()
+{
+    DatabaseLockGuard guard(_mutex);
+
+    if (!_begun)
+        return DATABASE_ERROR;
+    if (!_headDirty)
+        return DATABASE_OK;
+
+    size_t length = snprintf(_text, textLength(), "%" PRIu32 ":%s", _headSlot, _deltaEncoding ? "d" : "");
+    for (uint8_t i = 0; i < _headCount; ++i)
+    {
+        int64_t const record = (_deltaEncoding && i > 0) ? static_cast<int64_t>(_head[i]) - _head[i - 1] : _head[i];
+        length += snprintf(_text + length, textLength() - length, "%s%" PRId64, i > 0 ? "," : "", record);
+    }
+
+    char key[NVS_DELEGATE_MAX_KEY_LENGTH];
+    slotKey(_headSlot, key);
+    DatabaseError_t const err = _database->set(key, _text);
+    if (err != DATABASE_OK)
+        return err;
+
+    _headDirty = false;
+    Log_Verbose(_logger, "Ring buffer slot '%s' written with %u records", key, _headCount);
+    return DATABASE_OK;
+}
+
+DatabaseError_t DatabaseRingBuffer::forEachNewest(DatabaseRingBufferVisitor_t const visitor, void *const context) const
+{
+    // Validate input parameters
+    if (visitor == nullptr)
+    {
+        Log_Error(_logger, "Invalid value");
+        return DATABASE_VALUE_INVALID;
+    }
+
+    DatabaseLockGuard guard(_mutex);
+
+    if (!_begun)
+        return DATABASE_ERROR;
+
+    // The slot being filled comes from RAM, older ones from NVS
+    for (uint32_t slot = _headSlot + 1; slot-- > oldestSlot();)
+    {
+        int32_t const *records = _head;
+        uint8_t count = _headCount;
+        if (slot != _headSlot)
+        {
+            if (!loadSlot(slot, &count))
+                continue;
+            records = _records;
+        }
+
+        for (uint8_t i = count; i-- > 0;)
+            if (!visitor(slot * _recordsPerSlot + i, records[i], context))
+                return DATABASE_OK;
+    }
+
+    return DATABASE_OK;
+}
+
+DatabaseError_t DatabaseRingBuffer::read(
+    uint32_t const first, int32_t *out_values, size_t const maxCount, size_t *out_count) const
+{
+    // Validate input parameters
+    if (out_values == nullptr || out_count == nullptr)
+    {
+        Log_Error(_logger, "Invalid value");
+        return DATABASE_VALUE_INVALID;
+    }
+
+    DatabaseLockGuard guard(_mutex);
+
+    *out_count = 0;
+    if (!_begun)
+        return DATABASE_ERROR;
+
+    // Slots before the one holding the first record are not read
+    uint32_t slot = first / _recordsPerSlot;
+    if (slot < oldestSlot())
+        slot = oldestSlot();
+
+    for (; slot <= _headSlot && *out_count < maxCount; ++slot)
+    {
+        int32_t const *records = _head;
+        uint8_t count = _headCount;
+        if (slot != _headSlot)
+        {
+            if (!loadSlot(slot, &count))
+                continue;
+            records = _records;
+        }
+
+        for (uint8_t i = 0; i < count && *out_count < maxCount; ++i)
+            if (slot * _recordsPerSlot + i >= first)
+                out_values[(*out_count)++] = records[i];
+    }
+
+    return DATABASE_OK;
+}
+
+uint32_t DatabaseRingBuffer::nextSequence() const
+{
+    DatabaseLockGuard guard(_mutex);
+    return _headSlot * _recordsPerSlot + _headCount;
+}
+
+size_t DatabaseRingBuffer::capacity() const
+{
+    return static_cast<size_t>(_slotCount) * _recordsPerSlot;
+}
+
+size_t DatabaseRingBuffer::textLength() const
+{
+    return DATABASE_RING_BUFFER_HEADER_TEXT_LENGTH + _recordsPerSlot * DATABASE_RING_BUFFER_RECORD_TEXT_LENGTH;
+}
+
+void DatabaseRingBuffer::slotKey(uint32_t const slot, char *key) const
+{
+    size_t const length = strlen(_prefix);
+    memcpy(key, _prefix, length);
+    snprintf(key + length, NVS_DELEGATE_MAX_KEY_LENGTH - length, "%u", static_cast<uint8_t>(slot % _slotCount));
+}
+
+bool DatabaseRingBuffer::loadSlot(uint32_t const slot, uint8_t *out_count) const
+{
+    char key[NVS_DELEGATE_MAX_KEY_LENGTH];
+    slotKey(slot, key);
+
+    // A slot still holding an older lap is not part of the log
+    uint32_t stored = 0;
+    return _database->get(key, _text, textLength()) == DATABASE_OK &&
+           decode(_text, &stored, _records, out_count) && stored == slot;
+}
+
+bool DatabaseRingBuffer::decode(char const *text, uint32_t *out_slot, int32_t *out_values, uint8_t *out_count) const
+{
+    char *end = nullptr;
+    unsigned long const slot = strtoul(text, &end, 10);
+    if (end == text || *end != ':' || slot > UINT32_MAX)
+        return false;
+    text = end + 1;
+
+    bool const delta = *text == 'd';
+    if (delta)
+        text++;
+
+    uint8_t count = 0;
+    int64_t previous = 0;
+    while (*text != '\0')
+    {
+        if (count == _recordsPerSlot || (count > 0 && *text++ != ','))
+            return false;
+
+        int64_t record = strtoll(text, &end, 10);
+        if (end == text)
+            return false;
+        text = end;
+
+        if (delta && count > 0)
+            record += previous;
+        if (record < INT32_MIN || record > INT32_MAX)
+            return false;
+        out_values[count++] = static_cast<int32_t>(record);
+        previous = record;
+    }
+
+    *out_slot = static_cast<uint32_t>(slot);
+    *out_count = count;
+    return true;
+}
+
+uint32_t DatabaseRingBuffer::oldestSlot() const
+{
+    return _headSlot >= _slotCount - 1u ? _headSlot - (_slotCount - 1u) : 0;
+}
@@ -0,0 +1,89 @@
+#include "DatabaseSequence.hpp"
+
+#include <string.h>
+
+DatabaseSequence::DatabaseSequence(
+    DatabaseAPI *const database, char const *const key, uint32_t const blockSize,
+    MultiPrinterLoggerInterface *const logger)
+    : _database(database), _blockSize(blockSize), _logger(logger), _next(0), _limit(0)
+{
+    // An invalid key is kept empty and reported by next()
+    if (key == nullptr || strlen(key) == 0 || strlen(key) >= NVS_DELEGATE_MAX_KEY_LENGTH)
+        _key[0] = '\0';
+    else
+        strcpy(_key, key);
+
+    Log_Debug(_logger, "DatabaseSequence created for key '%s'", _key);
+}
+
+DatabaseSequence::~DatabaseSequence()
+{
+    Log_Debug(_logger, "DatabaseSequence destroyed");
+}
+
+DatabaseError_t DatabaseSequence::next(uint32_t *id)
+{
+    // Validate input parameters
+    if (id == nullptr || _blockSize == 0)
+    {
+        Log_Error(_logger, "Invalid value");
+        return DATABASE_VALUE_INVALID;
+    }
+
+    while (true)
+    {
+        // Load the limit before the next ID; a new block moves the next ID before publishing its limit
+        uint32_t const limit = _limit.load();
+        uint32_t current = _next.load();
+        if (current < limit)
+        {
+            // Lock-free path, served from RAM
+            if (_next.compare_exchange_weak(current, current + 1))
+            {
+                *id = current;
+                return DATABASE_OK;
+            }
+            continue;
+        }
+
+        DatabaseError_t const err = reserveBlock();
+        if (err != DATABASE_OK)
+            return err;
+    }
+}
+
+DatabaseError_t DatabaseSequence::reserveBlock()
+{
+    DatabaseLockGuard guard(_reserveMutex);
+
+    // Another task may have reserved a block while we waited
+    if (_next.load() < _limit.load())
+        return DATABASE_OK;
+
+    if (_database == nullptr)
+    {
+        Log_Error(_logger, "Unknown error");
+        return DATABASE_ERROR;
+    }
+
+    // Persist the end of the new block before handing out any of its IDs
+    int64_t limit = 0;
+    DatabaseError_t err = _database->increment(_key, _blockSize, &limit);
+    if (err == DATABASE_OK)
+        err = _database->flushCounters();
+    if (err != DATABASE_OK)
+        return err;
+
+    if (limit < static_cast<int64_t>(_blockSize) || limit > static_cast<int64_t>(UINT32_MAX))
+    {
+        Log_Error(_logger, "Sequence '%s' exhausted the 32-bit ID range", _key);
+        return DATABASE_ERROR;
+    }
+
+    // The block starts where the persisted one ended, skipping IDs lost in a reboot
+    _next.store(static_cast<uint32_t>(limit - _blockSize));
+    _limit.store(static_cast<uint32_t>(limit));
+
+    Log_Debug(_logger, "Sequence '%s' reserved IDs up to %u", _key, static_cast<uint32_t>(limit));
+    return DATABASE_OK;
+}
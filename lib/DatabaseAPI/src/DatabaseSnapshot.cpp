@@ -0,0 +1,260 @@
+#include "DatabaseSnapshot.hpp"
+
+#include <algorithm>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief State shared by the two listing passes of DatabaseSnapshot::load.
+ */
+struct DatabaseSnapshot::LoadContext
+{
+    NVSDelegateInterface const *nvsDelegate; /**< Delegate used to read the values. */
+    NVSDelegateHandle_t handle;              /**< Handle of the namespace being loaded. */
+    NVSDelegateError_t err;                  /**< First error met while listing. */
+    size_t count;                            /**< Number of string entries seen. */
+    size_t poolSize;                         /**< Bytes used by the keys and values seen. */
+    DatabaseSnapshot *snapshot;              /**< Snapshot to fill on the second pass, nullptr on the first. */
+    size_t countCapacity;                    /**< Number of entries allocated after the first pass. */
+    size_t poolCapacity;                     /**< Size of the pool allocated after the first pass. */
+};
+
+bool DatabaseSnapshot::loadKey(char const *const key, void *context)
+{
+    LoadContext *const load = static_cast<LoadContext *>(context);
+
+    // Only string values belong to the snapshot, other types are not found by get_str
+    size_t valueLength = 0;
+    NVSDelegateError_t err = load->nvsDelegate->get_str(load->handle, key, nullptr, &valueLength);
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+        return true;
+    if (err != NVS_DELEGATE_OK)
+    {
+        load->err = err;
+        return false;
+    }
+
+    size_t const keyLength = strlen(key) + 1;
+
+    // First pass only measures the namespace
+    if (load->snapshot == nullptr)
+    {
+        load->count++;
+        load->poolSize += keyLength + valueLength;
+        return true;
+    }
+
+    // The namespace grew between the two passes
+    if (load->count >= load->countCapacity || load->poolSize + keyLength + valueLength > load->poolCapacity)
+    {
+        load->err = NVS_DELEGATE_UNKOWN_ERROR;
+        return false;
+    }
+
+    Entry &entry = load->snapshot->_entries[load->count];
+    entry.keyOffset = load->poolSize;
+    entry.valueOffset = entry.keyOffset + keyLength;
+    memcpy(load->snapshot->_pool + entry.keyOffset, key, keyLength);
+
+    err = load->nvsDelegate->get_str(load->handle, key, load->snapshot->_pool + entry.valueOffset, &valueLength);
+    if (err != NVS_DELEGATE_OK)
+    {
+        load->err = err;
+        return false;
+    }
+    entry.valueLength = valueLength;
+
+    load->count++;
+    load->poolSize += keyLength + valueLength;
+    return true;
+}
+
+DatabaseSnapshot::DatabaseSnapshot(size_t const count, Entry *const entries, char *const pool)
+    : _count(count), _entries(entries), _pool(pool)
+{
+}
+
+DatabaseSnapshot *DatabaseSnapshot::allocate(size_t const count, size_t const poolSize)
+{
+    // Header, entries and pool share one block
+    size_t const entriesOffset = (sizeof(DatabaseSnapshot) + alignof(Entry) - 1) / alignof(Entry) * alignof(Entry);
+    size_t const poolOffset = entriesOffset + count * sizeof(Entry);
+
+    char *const block = static_cast<char *>(malloc(poolOffset + poolSize));
+    if (block == nullptr)
+        return nullptr;
+
+    return new (block) DatabaseSnapshot(
+        count, reinterpret_cast<Entry *>(block + entriesOffset), block + poolOffset);
+}
+
+DatabaseSnapshot *DatabaseSnapshot::load(
+    NVSDelegateInterface const *const nvsDelegate, char const *const nvsNamespace,
+    NVSDelegateError_t *err)
+{
+    NVSDelegateHandle_t handle;
+    *err = nvsDelegate->open(nvsNamespace, NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+
+    // A namespace that was never written is an empty snapshot
+    if (*err == NVS_DELEGATE_KEY_NOT_FOUND)
+    {
+        *err = NVS_DELEGATE_OK;
+        return allocate(0, 0);
+    }
+    if (*err != NVS_DELEGATE_OK)
+        return nullptr;
+
+    // First pass measures the namespace
+    LoadContext context = {};
+    context.nvsDelegate = nvsDelegate;
+    context.handle = handle;
+    context.err = NVS_DELEGATE_OK;
+    *err = nvsDelegate->list_keys(nvsNamespace, loadKey, &context);
+    if (*err == NVS_DELEGATE_OK)
+        *err = context.err;
+    if (*err != NVS_DELEGATE_OK)
+    {
+        nvsDelegate->close(handle);
+        return nullptr;
+    }
+
+    DatabaseSnapshot *const snapshot = allocate(context.count, context.poolSize);
+    if (snapshot == nullptr)
+    {
+        nvsDelegate->close(handle);
+        *err = NVS_DELEGATE_NOT_ENOUGH_SPACE;
+        return nullptr;
+    }
+
+    // Second pass copies the keys and values into the pool
+    context.countCapacity = context.count;
+    context.poolCapacity = context.poolSize;
+    context.count = 0;
+    context.poolSize = 0;
+    context.snapshot = snapshot;
+    *err = nvsDelegate->list_keys(nvsNamespace, loadKey, &context);
+    nvsDelegate->close(handle);
+
+    if (*err == NVS_DELEGATE_OK)
+        *err = context.err;
+    if (*err == NVS_DELEGATE_OK && context.count != context.countCapacity)
+        *err = NVS_DELEGATE_UNKOWN_ERROR;
+    if (*err != NVS_DELEGATE_OK)
+    {
+        destroy(snapshot);
+        return nullptr;
+    }
+
+    snapshot->sort();
+    return snapshot;
+}
+
+DatabaseSnapshot *DatabaseSnapshot::withValue(
+    DatabaseSnapshot const *const base, char const *const key, char const *const value)
+{
+    size_t const baseCount = base ? base->_count : 0;
+
+    // Measure the new snapshot, leaving out the previous value of the key
+    size_t count = value ? 1 : 0;
+    size_t poolSize = value ? strlen(key) + 1 + strlen(value) + 1 : 0;
+    for (size_t i = 0; i < baseCount; ++i)
+    {
+        if (strcmp(base->keyAt(i), key) == 0)
+            continue;
+        count++;
+        poolSize += strlen(base->keyAt(i)) + 1 + base->_entries[i].valueLength;
+    }
+
+    DatabaseSnapshot *const snapshot = allocate(count, poolSize);
+    if (snapshot == nullptr)
+        return nullptr;
+
+    // Copy the entries in key order, inserting the new value at its sorted position
+    size_t index = 0;
+    uint32_t offset = 0;
+    bool inserted = value == nullptr;
+    for (size_t i = 0; i <= baseCount; ++i)
+    {
+        char const *const baseKey = i < baseCount ? base->keyAt(i) : nullptr;
+        int const order = baseKey ? strcmp(baseKey, key) : 1;
+
+        if (!inserted && order >= 0)
+        {
+            Entry &entry = snapshot->_entries[index++];
+            size_t const keyLength = strlen(key) + 1;
+            entry.keyOffset = offset;
+            memcpy(snapshot->_pool + offset, key, keyLength);
+            offset += keyLength;
+            entry.valueOffset = offset;
+            entry.valueLength = strlen(value) + 1;
+            memcpy(snapshot->_pool + offset, value, entry.valueLength);
+            offset += entry.valueLength;
+            inserted = true;
+        }
+
+        if (baseKey == nullptr || order == 0)
+            continue;
+
+        Entry &entry = snapshot->_entries[index++];
+        size_t const keyLength = strlen(baseKey) + 1;
+        entry.keyOffset = offset;
+        memcpy(snapshot->_pool + offset, baseKey, keyLength);
+        offset += keyLength;
+        entry.valueOffset = offset;
+        entry.valueLength = base->_entries[i].valueLength;
+        memcpy(snapshot->_pool + offset, base->_pool + base->_entries[i].valueOffset, entry.valueLength);
+        offset += entry.valueLength;
+    }
+
+    return snapshot;
+}
+
+void DatabaseSnapshot::destroy(DatabaseSnapshot const *const snapshot)
+{
+    if (snapshot == nullptr)
+        return;
+
+    snapshot->~DatabaseSnapshot();
+    free(const_cast<DatabaseSnapshot *>(snapshot));
+}
+
+char const *DatabaseSnapshot::find(char const *const key, size_t *length) const
+{
+    // Binary search over the sorted entries
+    size_t low = 0;
+    size_t high = _count;
+    while (low < high)
+    {
+        size_t const middle = low + (high - low) / 2;
+        int const order = strcmp(keyAt(middle), key);
+        if (order == 0)
+        {
+            if (length)
+                *length = _entries[middle].valueLength;
+            return _pool + _entries[middle].valueOffset;
+        }
+        if (order < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return nullptr;
+}
+
+size_t DatabaseSnapshot::count() const
+{
+    return _count;
+}
+
+char const *DatabaseSnapshot::keyAt(size_t const index) const
+{
+    return _pool + _entries[index].keyOffset;
+}
+
+void DatabaseSnapshot::sort()
+{
+    char const *const pool = _pool;
+    std::sort(_entries, _entries + _count, [pool](Entry const &a, Entry const &b)
+              { return strcmp(pool + a.keyOffset, pool + b.keyOffset) < 0; });
+}
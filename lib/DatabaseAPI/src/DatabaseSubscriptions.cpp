@@ -0,0 +1,193 @@
+#include "DatabaseSubscriptions.hpp"
+
+#include <string.h>
+
+#define DATABASE_SUBSCRIPTIONS_STOP 0xFF
+
+// Constructor for DatabaseSubscriptions
+DatabaseSubscriptions::DatabaseSubscriptions(MultiPrinterLoggerInterface *const logger)
+    : _count(0), _nextId(1), _queue(nullptr), _task(nullptr), _taskStopped(nullptr),
+      _overflowed(false), _dropped(0), _logger(logger)
+{
+    memset(_subscriptions, 0, sizeof(_subscriptions));
+}
+
+// Destructor for DatabaseSubscriptions
+DatabaseSubscriptions::~DatabaseSubscriptions()
+{
+    stop();
+    if (_taskStopped)
+        vSemaphoreDelete(_taskStopped);
+    if (_queue)
+        vQueueDelete(_queue);
+}
+
+// Subscribes a callback to a key or a prefix
+DatabaseError_t DatabaseSubscriptions::subscribe(
+    char const *const pattern, DatabaseChangeCallback_t const callback, void *const context, uint32_t *out_id)
+{
+    // Validate input parameters
+    if (pattern == nullptr || strlen(pattern) == 0 || strlen(pattern) >= NVS_DELEGATE_MAX_KEY_LENGTH)
+        return DATABASE_KEY_INVALID;
+    if (callback == nullptr)
+        return DATABASE_VALUE_INVALID;
+
+    DatabaseLockGuard guard(_mutex);
+
+    Subscription *free = nullptr;
+    for (size_t i = 0; i < DATABASE_MAX_SUBSCRIPTIONS && free == nullptr; ++i)
+        if (_subscriptions[i].callback == nullptr)
+            free = &_subscriptions[i];
+    if (free == nullptr || !start())
+        return DATABASE_NOT_ENOUGH_SPACE;
+
+    strcpy(free->pattern, pattern);
+    free->callback = callback;
+    free->context = context;
+    free->id = _nextId++;
+    _count.fetch_add(1);
+    if (out_id)
+        *out_id = free->id;
+
+    Log_Debug(_logger, "Subscription %u to '%s' added", (unsigned)free->id, pattern);
+    return DATABASE_OK;
+}
+
+// Removes a subscription
+DatabaseError_t DatabaseSubscriptions::unsubscribe(uint32_t const id)
+{
+    // Waits for a delivery in progress, so the callback is not running once this returns
+    DatabaseLockGuard guard(_mutex);
+
+    for (size_t i = 0; i < DATABASE_MAX_SUBSCRIPTIONS; ++i)
+    {
+        if (_subscriptions[i].callback == nullptr || _subscriptions[i].id != id)
+            continue;
+
+        _subscriptions[i].callback = nullptr;
+        _count.fetch_sub(1);
+        Log_Debug(_logger, "Subscription %u removed", (unsigned)id);
+        return DATABASE_OK;
+    }
+
+    return DATABASE_KEY_NOT_FOUND;
+}
+
+// Queues a change without blocking
+void DatabaseSubscriptions::publish(char const *const key, DatabaseChange_t const change)
+{
+    // No queue to fill and no copy unless someone listens
+    if (_count.load() == 0)
+        return;
+
+    Event event;
+    strncpy(event.key, key ? key : "", sizeof(event.key) - 1);
+    event.key[sizeof(event.key) - 1] = '\0';
+    event.change = change;
+
+    // A full queue drops the change, subscribers are told to read their keys again
+    if (xQueueSend(_queue, &event, 0) != pdPASS)
+    {
+        _dropped.fetch_add(1);
+        _overflowed.store(true);
+    }
+}
+
+uint32_t DatabaseSubscriptions::droppedCount() const
+{
+    return _dropped.load();
+}
+
+// Stops the delivery task after the queued changes
+void DatabaseSubscriptions::stop()
+{
+    {
+        DatabaseLockGuard guard(_mutex);
+        if (_task == nullptr)
+            return;
+        memset(_subscriptions, 0, sizeof(_subscriptions));
+        _count.store(0);
+        _task = nullptr;
+    }
+
+    // Writers see no subscription any more, so the stop event is the last one queued
+    Event stop;
+    stop.key[0] = '\0';
+    stop.change = DATABASE_SUBSCRIPTIONS_STOP;
+    xQueueSend(_queue, &stop, portMAX_DELAY);
+    xSemaphoreTake(_taskStopped, portMAX_DELAY);
+    Log_Debug(_logger, "Subscription delivery task stopped");
+}
+
+bool DatabaseSubscriptions::start()
+{
+    if (_task)
+        return true;
+
+    if (_queue == nullptr)
+        _queue = xQueueCreate(DATABASE_SUBSCRIPTION_QUEUE_LENGTH, sizeof(Event));
+    if (_taskStopped == nullptr)
+        _taskStopped = xSemaphoreCreateBinary();
+    if (_queue == nullptr || _taskStopped == nullptr)
+    {
+        Log_Error(_logger, "Not enough memory for the subscription queue");
+        return false;
+    }
+
+    if (xTaskCreate(taskEntry, "DatabaseSubscriptions", DATABASE_SUBSCRIPTION_STACK_SIZE, this,
+                    DATABASE_SUBSCRIPTION_PRIORITY, &_task) != pdPASS)
+    {
+        Log_Error(_logger, "Failed to create the subscription delivery task");
+        _task = nullptr;
+        return false;
+    }
+
+    Log_Debug(_logger, "Subscription delivery task started");
+    return true;
+}
+
+void DatabaseSubscriptions::deliver(Event const &event)
+{
+    DatabaseLockGuard guard(_mutex);
+
+    // Changes of every key reach every subscription
+    bool const everyKey = event.change == DATABASE_CHANGE_ERASED || event.change == DATABASE_CHANGE_OVERFLOW;
+    for (size_t i = 0; i < DATABASE_MAX_SUBSCRIPTIONS; ++i)
+    {
+        Subscription const &subscription = _subscriptions[i];
+        if (subscription.callback && (everyKey || matches(subscription.pattern, event.key)))
+            subscription.callback(event.key, static_cast<DatabaseChange_t>(event.change), subscription.context);
+    }
+}
+
+void DatabaseSubscriptions::taskEntry(void *arg)
+{
+    DatabaseSubscriptions *const subscriptions = static_cast<DatabaseSubscriptions *>(arg);
+
+    Event event;
+    while (xQueueReceive(subscriptions->_queue, &event, portMAX_DELAY) == pdPASS &&
+           event.change != DATABASE_SUBSCRIPTIONS_STOP)
+    {
+        subscriptions->deliver(event);
+
+        // Dropped changes are reported once the queue has room again
+        if (subscriptions->_overflowed.exchange(false))
+        {
+            Event overflow;
+            overflow.key[0] = '\0';
+            overflow.change = DATABASE_CHANGE_OVERFLOW;
+            subscriptions->deliver(overflow);
+        }
+    }
+
+    xSemaphoreGive(subscriptions->_taskStopped);
+    vTaskDelete(nullptr);
+}
+
+bool DatabaseSubscriptions::matches(char const *const pattern, char const *const key)
+{
+    size_t const length = strlen(pattern);
+    if (pattern[length - 1] == '*')
+        return strncmp(pattern, key, length - 1) == 0;
+    return strcmp(pattern, key) == 0;
+}
@@ -0,0 +1,628 @@
+#include "MemoryNVSDelegate.hpp"
+
+#include <new>
+#include <stdlib.h>
+
+#include "DatabaseHash.hpp"
+#include "NVSDelegateUtils.hpp"
+
+// Handles are ((namespace index + 1) << 1) | readonly, so 0 is never valid
+#define MEMORY_NVS_DELEGATE_READONLY_BIT 1u
+
+// Number of keys copied out of a shard per lock while listing
+#define MEMORY_NVS_DELEGATE_LIST_CHUNK 8
+
+// NVS entries used by a string or a blob of the given length, see get_stats
+#define MEMORY_NVS_DELEGATE_STRING_ENTRIES(length) (1 + ((length) + 31) / 32)
+#define MEMORY_NVS_DELEGATE_BLOB_ENTRIES(length) (2 + ((length) + 31) / 32)
+
+MemoryNVSDelegate::MemoryNVSDelegate(MultiPrinterLoggerInterface *const logger)
+    : m_logger(logger), m_namespaceCount(0)
+{
+    for (size_t i = 0; i < MEMORY_NVS_DELEGATE_MAX_NAMESPACES; ++i)
+        m_namespaces[i] = nullptr;
+
+    Log_Debug(m_logger, "MemoryNVSDelegate created");
+}
+
+MemoryNVSDelegate::~MemoryNVSDelegate()
+{
+    size_t const count = m_namespaceCount.load();
+    for (size_t i = 0; i < count; ++i)
+    {
+        clearNamespace(m_namespaces[i]);
+        delete m_namespaces[i];
+    }
+
+    Log_Debug(m_logger, "MemoryNVSDelegate destroyed");
+}
+
+NVSDelegateError_t MemoryNVSDelegate::open(
+    char const *const name, NVSDelegateOpenMode_t const open_mode,
+    NVSDelegateHandle_t *out_handle) const
+{
+    // Check if the namespace name and the handle pointer are valid
+    if (!isNamespaceValid(name))
+        return printAndReturnError(NVS_DELEGATE_NAMESPACE_INVALID);
+
+    if (out_handle == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    bool const readonly = open_mode == NVSDelegateOpenMode_t::NVSDelegate_READONLY;
+
+    // Published namespaces are found without taking any lock
+    Namespace *ns = findNamespace(name);
+    if (ns == nullptr && !readonly)
+    {
+        DatabaseLockGuard lock(m_namespaceMutex);
+
+        // Another task may have created it while we waited
+        ns = findNamespace(name);
+        if (ns == nullptr)
+        {
+            size_t const count = m_namespaceCount.load();
+            if (count >= MEMORY_NVS_DELEGATE_MAX_NAMESPACES)
+                return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+
+            ns = new (std::nothrow) Namespace();
+            if (ns == nullptr)
+                return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+
+            strcpy(ns->name, name);
+            ns->exists.store(false);
+            for (size_t i = 0; i < MEMORY_NVS_DELEGATE_SHARD_COUNT; ++i)
+                ns->shards[i].entries = nullptr;
+
+            // Fill the slot before publishing the new count
+            m_namespaces[count] = ns;
+            m_namespaceCount.store(count + 1);
+        }
+    }
+
+    if (ns == nullptr || (readonly && !ns->exists.load()))
+        return printAndReturnError(NVS_DELEGATE_KEY_NOT_FOUND);
+
+    if (!readonly)
+        ns->exists.store(true);
+
+    size_t index = 0;
+    while (m_namespaces[index] != ns)
+        index++;
+
+    *out_handle = ((index + 1) << 1) | (readonly ? MEMORY_NVS_DELEGATE_READONLY_BIT : 0);
+    return printAndReturnError(NVS_DELEGATE_OK);
+}
+
+void MemoryNVSDelegate::close(NVSDelegateHandle_t handle) const
+{
+    Log_Verbose(m_logger, "MemoryNVSDelegate closing namespace");
+}
+
+NVSDelegateError_t MemoryNVSDelegate::set_str(
+    NVSDelegateHandle_t handle, char const *const key,
+    char const *const value) const
+{
+    // Check if the key and value are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (!isValueValid(value))
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Namespace *ns;
+    NVSDelegateError_t err = resolve(handle, true, &ns);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    Log_Verbose(m_logger, "MemoryNVSDelegate setting key '%s' to value '%s'", key, value);
+
+    // Copy the value before taking the lock
+    size_t const length = strlen(value) + 1;
+    char *copy = static_cast<char *>(malloc(length));
+    if (copy == nullptr)
+        return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+    memcpy(copy, value, length);
+
+    Shard &shard = shardOf(ns, key);
+    {
+        DatabaseLockGuard lock(shard.mutex);
+
+        Entry *const entry = findEntry(shard, key, true);
+        if (entry == nullptr)
+        {
+            free(copy);
+            return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+        }
+
+        // Swap the value in, the previous one is freed after the lock is released
+        char *const previous = entry->value;
+        entry->value = copy;
+        entry->length = length;
+        entry->blob = false;
+        copy = previous;
+    }
+    free(copy);
+
+    return printAndReturnError(NVS_DELEGATE_OK);
+}
+
+NVSDelegateError_t MemoryNVSDelegate::get_str(
+    NVSDelegateHandle_t handle, char const *const key,
+    char *out_value, size_t *length) const
+{
+    // Check if the key and the length pointer are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (length == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Namespace *ns;
+    NVSDelegateError_t err = resolve(handle, false, &ns);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    Log_Verbose(m_logger, "MemoryNVSDelegate getting value for key '%s'", key);
+
+    Shard &shard = shardOf(ns, key);
+    DatabaseLockGuard lock(shard.mutex);
+
+    // An entry holding an integer or bytes is not a string, as with nvs_get_str
+    Entry const *const entry = findEntry(shard, key, false);
+    if (entry == nullptr || entry->value == nullptr || entry->blob)
+        return printAndReturnError(NVS_DELEGATE_KEY_NOT_FOUND);
+
+    return printAndReturnError(NVSDelegateUtils::copyString(entry->value, entry->length - 1, out_value, length));
+}
+
+NVSDelegateError_t MemoryNVSDelegate::set_i64(
+    NVSDelegateHandle_t handle, char const *const key, int64_t const value) const
+{
+    // Check if the key is valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    Namespace *ns;
+    NVSDelegateError_t err = resolve(handle, true, &ns);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    Log_Verbose(m_logger, "MemoryNVSDelegate setting key '%s' to integer %lld", key, (long long)value);
+
+    Shard &shard = shardOf(ns, key);
+    char *previous;
+    {
+        DatabaseLockGuard lock(shard.mutex);
+
+        Entry *const entry = findEntry(shard, key, true);
+        if (entry == nullptr)
+            return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+
+        // A string value of the key is replaced by the integer
+        previous = entry->value;
+        entry->value = nullptr;
+        entry->length = 0;
+        entry->blob = false;
+        entry->integer = value;
+    }
+    free(previous);
+
+    return printAndReturnError(NVS_DELEGATE_OK);
+}
+
+NVSDelegateError_t MemoryNVSDelegate::get_i64(
+    NVSDelegateHandle_t handle, char const *const key, int64_t *out_value) const
+{
+    // Check if the key and the value pointer are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (out_value == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Namespace *ns;
+    NVSDelegateError_t err = resolve(handle, false, &ns);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    Log_Verbose(m_logger, "MemoryNVSDelegate getting integer for key '%s'", key);
+
+    Shard &shard = shardOf(ns, key);
+    DatabaseLockGuard lock(shard.mutex);
+
+    Entry const *const entry = findEntry(shard, key, false);
+    if (entry == nullptr || entry->value != nullptr)
+        return printAndReturnError(NVS_DELEGATE_KEY_NOT_FOUND);
+
+    *out_value = entry->integer;
+    return printAndReturnError(NVS_DELEGATE_OK);
+}
+
+NVSDelegateError_t MemoryNVSDelegate::set_blob(
+    NVSDelegateHandle_t handle, char const *const key,
+    void const *const value, size_t const length) const
+{
+    // Check if the key and value are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (value == nullptr || length == 0)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Namespace *ns;
+    NVSDelegateError_t err = resolve(handle, true, &ns);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    Log_Verbose(m_logger, "MemoryNVSDelegate setting key '%s' to %zu bytes", key, length);
+
+    // Copy the bytes before taking the lock
+    char *copy = static_cast<char *>(malloc(length));
+    if (copy == nullptr)
+        return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+    memcpy(copy, value, length);
+
+    Shard &shard = shardOf(ns, key);
+    {
+        DatabaseLockGuard lock(shard.mutex);
+
+        Entry *const entry = findEntry(shard, key, true);
+        if (entry == nullptr)
+        {
+            free(copy);
+            return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+        }
+
+        // Swap the bytes in, the previous value is freed after the lock is released
+        char *const previous = entry->value;
+        entry->value = copy;
+        entry->length = length;
+        entry->blob = true;
+        copy = previous;
+    }
+    free(copy);
+
+    return printAndReturnError(NVS_DELEGATE_OK);
+}
+
+NVSDelegateError_t MemoryNVSDelegate::get_blob(
+    NVSDelegateHandle_t handle, char const *const key,
+    void *out_value, size_t *length) const
+{
+    // Check if the key and the length pointer are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (length == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Namespace *ns;
+    NVSDelegateError_t err = resolve(handle, false, &ns);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    Log_Verbose(m_logger, "MemoryNVSDelegate getting bytes for key '%s'", key);
+
+    Shard &shard = shardOf(ns, key);
+    DatabaseLockGuard lock(shard.mutex);
+
+    Entry const *const entry = findEntry(shard, key, false);
+    if (entry == nullptr || !entry->blob)
+        return printAndReturnError(NVS_DELEGATE_KEY_NOT_FOUND);
+
+    // Same convention as nvs_get_blob, a null buffer only queries the length
+    if (out_value != nullptr)
+    {
+        if (*length < entry->length)
+            return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+        memcpy(out_value, entry->value, entry->length);
+    }
+    *length = entry->length;
+
+    return printAndReturnError(NVS_DELEGATE_OK);
+}
+
+NVSDelegateError_t MemoryNVSDelegate::erase_key(
+    NVSDelegateHandle_t handle, char const *const key) const
+{
+    // Check if the key is valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    Namespace *ns;
+    NVSDelegateError_t err = resolve(handle, true, &ns);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    Log_Verbose(m_logger, "MemoryNVSDelegate erasing key '%s'", key);
+
+    Shard &shard = shardOf(ns, key);
+    Entry *entry;
+    {
+        DatabaseLockGuard lock(shard.mutex);
+
+        Entry **link = &shard.entries;
+        while (*link != nullptr && strcmp((*link)->key, key) != 0)
+            link = &(*link)->next;
+
+        entry = *link;
+        if (entry != nullptr)
+            *link = entry->next;
+    }
+
+    if (entry == nullptr)
+        return printAndReturnError(NVS_DELEGATE_KEY_NOT_FOUND);
+
+    free(entry->value);
+    free(entry);
+
+    return printAndReturnError(NVS_DELEGATE_OK);
+}
+
+NVSDelegateError_t MemoryNVSDelegate::erase_all(NVSDelegateHandle_t handle) const
+{
+    Namespace *ns;
+    NVSDelegateError_t err = resolve(handle, true, &ns);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    Log_Verbose(m_logger, "MemoryNVSDelegate erasing all keys of namespace '%s'", ns->name);
+    clearNamespace(ns);
+
+    return printAndReturnError(NVS_DELEGATE_OK);
+}
+
+NVSDelegateError_t MemoryNVSDelegate::erase_flash_all() const
+{
+    Log_Verbose(m_logger, "MemoryNVSDelegate erasing all keys and values from all namespaces");
+
+    // Namespaces keep their slot, so handles stay resolvable, but READONLY opens fail again
+    size_t const count = m_namespaceCount.load();
+    for (size_t i = 0; i < count; ++i)
+    {
+        m_namespaces[i]->exists.store(false);
+        clearNamespace(m_namespaces[i]);
+    }
+
+    return printAndReturnError(NVS_DELEGATE_OK);
+}
+
+NVSDelegateError_t MemoryNVSDelegate::commit(NVSDelegateHandle_t handle) const
+{
+    Namespace *ns;
+    return resolve(handle, true, &ns);
+}
+
+NVSDelegateError_t MemoryNVSDelegate::list_keys(
+    char const *const name, NVSDelegateKeyCallback_t callback, void *context) const
+{
+    // Check if the namespace name and the callback are valid
+    if (!isNamespaceValid(name))
+        return printAndReturnError(NVS_DELEGATE_NAMESPACE_INVALID);
+
+    if (callback == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Log_Verbose(m_logger, "MemoryNVSDelegate listing keys of namespace '%s'", name);
+
+    Namespace *const ns = findNamespace(name);
+    if (ns == nullptr)
+        return printAndReturnError(NVS_DELEGATE_OK);
+
+    // Keys are copied out in small chunks so the callback runs without holding a
+    // shard lock and may call back into the delegate
+    char keys[MEMORY_NVS_DELEGATE_LIST_CHUNK][NVS_DELEGATE_MAX_KEY_LENGTH];
+    for (size_t i = 0; i < MEMORY_NVS_DELEGATE_SHARD_COUNT; ++i)
+    {
+        Shard &shard = ns->shards[i];
+        size_t position = 0;
+        size_t copied;
+        do
+        {
+            copied = 0;
+            {
+                DatabaseLockGuard lock(shard.mutex);
+
+                Entry const *entry = shard.entries;
+                for (size_t skipped = 0; entry != nullptr && skipped < position; ++skipped)
+                    entry = entry->next;
+
+                for (; entry != nullptr && copied < MEMORY_NVS_DELEGATE_LIST_CHUNK; entry = entry->next)
+                    strcpy(keys[copied++], entry->key);
+            }
+
+            for (size_t k = 0; k < copied; ++k)
+                if (!callback(keys[k], context))
+                    return printAndReturnError(NVS_DELEGATE_OK);
+
+            position += copied;
+        } while (copied == MEMORY_NVS_DELEGATE_LIST_CHUNK);
+    }
+
+    return printAndReturnError(NVS_DELEGATE_OK);
+}
+
+NVSDelegateError_t MemoryNVSDelegate::get_stats(NVSDelegateStats_t *out_stats) const
+{
+    if (out_stats == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Log_Verbose(m_logger, "MemoryNVSDelegate counting the entries of every namespace");
+
+    size_t used = 0;
+    size_t namespaces = 0;
+    size_t const count = m_namespaceCount.load();
+    for (size_t i = 0; i < count; ++i)
+    {
+        Namespace *const ns = m_namespaces[i];
+        if (!ns->exists.load())
+            continue;
+        namespaces++;
+        used += 1 + countEntries(ns);
+    }
+
+    out_stats->usedEntries = used;
+    out_stats->totalEntries = MEMORY_NVS_DELEGATE_TOTAL_ENTRIES;
+    out_stats->freeEntries = used < MEMORY_NVS_DELEGATE_TOTAL_ENTRIES ? MEMORY_NVS_DELEGATE_TOTAL_ENTRIES - used : 0;
+    out_stats->namespaceCount = namespaces;
+    return printAndReturnError(NVS_DELEGATE_OK);
+}
+
+NVSDelegateError_t MemoryNVSDelegate::get_used_entries(NVSDelegateHandle_t handle, size_t *out_entries) const
+{
+    if (out_entries == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Namespace *ns;
+    NVSDelegateError_t const err = resolve(handle, false, &ns);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    *out_entries = countEntries(ns);
+    return printAndReturnError(NVS_DELEGATE_OK);
+}
+
+NVSDelegateError_t MemoryNVSDelegate::resolve(
+    NVSDelegateHandle_t const handle, bool const writable, Namespace **out_namespace) const
+{
+    size_t const index = (handle >> 1);
+    if (index == 0 || index > m_namespaceCount.load())
+        return printAndReturnError(NVS_DELEGATE_HANDLE_INVALID);
+
+    if (writable && (handle & MEMORY_NVS_DELEGATE_READONLY_BIT))
+        return printAndReturnError(NVS_DELEGATE_READONLY);
+
+    *out_namespace = m_namespaces[index - 1];
+    return NVS_DELEGATE_OK;
+}
+
+MemoryNVSDelegate::Namespace *MemoryNVSDelegate::findNamespace(char const *const name) const
+{
+    size_t const count = m_namespaceCount.load();
+    for (size_t i = 0; i < count; ++i)
+        if (strcmp(m_namespaces[i]->name, name) == 0)
+            return m_namespaces[i];
+    return nullptr;
+}
+
+MemoryNVSDelegate::Shard &MemoryNVSDelegate::shardOf(Namespace *const ns, char const *const key) const
+{
+    return ns->shards[DatabaseHash::fnv1a(key) % MEMORY_NVS_DELEGATE_SHARD_COUNT];
+}
+
+MemoryNVSDelegate::Entry *MemoryNVSDelegate::findEntry(
+    Shard &shard, char const *const key, bool const create) const
+{
+    Entry *entry = shard.entries;
+    while (entry != nullptr && strcmp(entry->key, key) != 0)
+        entry = entry->next;
+
+    if (entry != nullptr || !create)
+        return entry;
+
+    entry = static_cast<Entry *>(malloc(sizeof(Entry)));
+    if (entry == nullptr)
+        return nullptr;
+
+    strcpy(entry->key, key);
+    entry->value = nullptr;
+    entry->length = 0;
+    entry->blob = false;
+    entry->integer = 0;
+    entry->next = shard.entries;
+    shard.entries = entry;
+    return entry;
+}
+
+void MemoryNVSDelegate::clearNamespace(Namespace *const ns) const
+{
+    for (size_t i = 0; i < MEMORY_NVS_DELEGATE_SHARD_COUNT; ++i)
+    {
+        Shard &shard = ns->shards[i];
+
+        // Detach the chain under the lock, free it outside
+        Entry *entry;
+        {
+            DatabaseLockGuard lock(shard.mutex);
+            entry = shard.entries;
+            shard.entries = nullptr;
+        }
+
+        while (entry != nullptr)
+        {
+            Entry *const next = entry->next;
+            free(entry->value);
+            free(entry);
+            entry = next;
+        }
+    }
+}
+
+NVSDelegateError_t MemoryNVSDelegate::printAndReturnError(NVSDelegateError_t const error) const
+{
+    switch (error)
+    {
+    case NVS_DELEGATE_OK:
+        break;
+    case NVS_DELEGATE_KEY_INVALID:
+        Log_Error(m_logger, "Invalid key");
+        break;
+    case NVS_DELEGATE_VALUE_INVALID:
+        Log_Error(m_logger, "Invalid value");
+        break;
+    case NVS_DELEGATE_NAMESPACE_INVALID:
+        Log_Error(m_logger, "Invalid namespace name");
+        break;
+    case NVS_DELEGATE_KEY_NOT_FOUND:
+        Log_Error(m_logger, "Key not found");
+        break;
+    case NVS_DELEGATE_NOT_ENOUGH_SPACE:
+        Log_Error(m_logger, "Not enough space");
+        break;
+    case NVS_DELEGATE_HANDLE_INVALID:
+        Log_Error(m_logger, "Invalid namespace handle");
+        break;
+    case NVS_DELEGATE_READONLY:
+        Log_Error(m_logger, "Attempt to write in READONLY mode");
+        break;
+    default:
+        Log_Error(m_logger, "Unknown error");
+        break;
+    }
+
+    return error;
+}
+
+bool MemoryNVSDelegate::isNamespaceValid(const char *const name) const
+{
+    return name && strlen(name) > 0 && strlen(name) < NVS_DELEGATE_MAX_NAMESPACE_LENGTH;
+}
+
+bool MemoryNVSDelegate::isKeyValid(const char *const key) const
+{
+    return key && strlen(key) > 0 && strlen(key) < NVS_DELEGATE_MAX_KEY_LENGTH;
+}
+
+bool MemoryNVSDelegate::isValueValid(const char *const value) const
+{
+    return value && strlen(value) > 0 && strlen(value) < NVS_DELEGATE_MAX_VALUE_LENGTH;
+}
+
+size_t MemoryNVSDelegate::countEntries(Namespace *const ns) const
+{
+    size_t entries = 0;
+    for (size_t i = 0; i < MEMORY_NVS_DELEGATE_SHARD_COUNT; ++i)
+    {
+        DatabaseLockGuard lock(ns->shards[i].mutex);
+        for (Entry const *entry = ns->shards[i].entries; entry != nullptr; entry = entry->next)
+        {
+            if (entry->value == nullptr)
+                entries += 1;
+            else if (entry->blob)
+                entries += MEMORY_NVS_DELEGATE_BLOB_ENTRIES(entry->length);
+            else
+                entries += MEMORY_NVS_DELEGATE_STRING_ENTRIES(entry->length);
+        }
+    }
+    return entries;
+}
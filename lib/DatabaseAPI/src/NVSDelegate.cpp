@@ -71,6 +71,78 @@ NVSDelegateError_t NVSDelegate::get_str(
     return mapErrorAndPrint(err);
 }
 
+NVSDelegateError_t NVSDelegate::set_i64(
+    NVSDelegateHandle_t handle, char const *const key, int64_t const value) const
+{
+    // Check if the key is valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    Log_Verbose(m_logger, "NVSDelegate setting key '%s' to integer %lld", key, (long long)value);
+    // Attempt to set the integer value for the specified key
+    esp_err_t err = nvs_set_i64(handle, key, value);
+
+    // Map ESP-IDF errors to NVSDelegateError_t
+    return mapErrorAndPrint(err);
+}
+
+NVSDelegateError_t NVSDelegate::get_i64(
+    NVSDelegateHandle_t handle, char const *const key, int64_t *out_value) const
+{
+    // Check if the key and the value pointer are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (out_value == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Log_Verbose(m_logger, "NVSDelegate getting integer for key '%s'", key);
+    // Attempt to get the integer value for the specified key
+    esp_err_t err = nvs_get_i64(handle, key, out_value);
+
+    // Map ESP-IDF errors to NVSDelegateError_t
+    return mapErrorAndPrint(err);
+}
+
+NVSDelegateError_t NVSDelegate::set_blob(
+    NVSDelegateHandle_t handle, char const *const key,
+    void const *const value, size_t const length) const
+{
+    // Check if the key and value are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (value == nullptr || length == 0)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Log_Verbose(m_logger, "NVSDelegate setting key '%s' to %zu bytes", key, length);
+    // Attempt to set the binary value for the specified key
+    esp_err_t err = nvs_set_blob(handle, key, value, length);
+
+    // Map ESP-IDF errors to NVSDelegateError_t
+    return mapErrorAndPrint(err);
+}
+
+NVSDelegateError_t NVSDelegate::get_blob(
+    NVSDelegateHandle_t handle, char const *const key,
+    void *out_value, size_t *length) const
+{
+    // Check if the key is valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    // Check if the length pointer is valid
+    if (length == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Log_Verbose(m_logger, "NVSDelegate getting bytes for key '%s'", key);
+    // Attempt to get the binary value for the specified key
+    esp_err_t err = nvs_get_blob(handle, key, out_value, length);
+
+    // Map ESP-IDF errors to NVSDelegateError_t
+    return mapErrorAndPrint(err);
+}
+
 NVSDelegateError_t NVSDelegate::erase_key(
     NVSDelegateHandle_t handle, char const *const key) const
 {
@@ -119,6 +191,86 @@ NVSDelegateError_t NVSDelegate::commit(NVSDelegateHandle_t handle) const
     return mapErrorAndPrint(err);
 }
 
+NVSDelegateError_t NVSDelegate::list_keys(
+    char const *const name, NVSDelegateKeyCallback_t callback, void *context) const
+{
+    // Check if the namespace name and the callback are valid
+    if (!isNamespaceValid(name))
+        return printAndReturnError(NVS_DELEGATE_NAMESPACE_INVALID);
+
+    if (callback == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Log_Verbose(m_logger, "NVSDelegate listing keys of namespace '%s'", name);
+    nvs_entry_info_t info;
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    // Walk the entries of the namespace, the iterator is released when the end is reached
+    nvs_iterator_t iterator = nullptr;
+    esp_err_t err = nvs_entry_find(NVS_DEFAULT_PART_NAME, name, NVS_TYPE_ANY, &iterator);
+    while (err == ESP_OK)
+    {
+        nvs_entry_info(iterator, &info);
+        if (!callback(info.key, context))
+            break;
+        err = nvs_entry_next(&iterator);
+    }
+    nvs_release_iterator(iterator);
+
+    // Reaching the end of the namespace is not an error
+    if (err == ESP_ERR_NVS_NOT_FOUND)
+        err = ESP_OK;
+#else
+    // Walk the entries of the namespace, the iterator is released when the end is reached
+    nvs_iterator_t iterator = nvs_entry_find(NVS_DEFAULT_PART_NAME, name, NVS_TYPE_ANY);
+    while (iterator != nullptr)
+    {
+        nvs_entry_info(iterator, &info);
+        if (!callback(info.key, context))
+            break;
+        iterator = nvs_entry_next(iterator);
+    }
+    nvs_release_iterator(iterator);
+    esp_err_t err = ESP_OK;
+#endif
+
+    // Map ESP-IDF errors to NVSDelegateError_t
+    return mapErrorAndPrint(err);
+}
+
+NVSDelegateError_t NVSDelegate::get_stats(NVSDelegateStats_t *out_stats) const
+{
+    if (out_stats == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Log_Verbose(m_logger, "NVSDelegate reading the statistics of the partition");
+    nvs_stats_t stats;
+    esp_err_t err = nvs_get_stats(NVS_DEFAULT_PART_NAME, &stats);
+    if (err == ESP_OK)
+    {
+        out_stats->usedEntries = stats.used_entries;
+        out_stats->freeEntries = stats.free_entries;
+        out_stats->totalEntries = stats.total_entries;
+        out_stats->namespaceCount = stats.namespace_count;
+    }
+
+    // Map ESP-IDF errors to NVSDelegateError_t
+    return mapErrorAndPrint(err);
+}
+
+NVSDelegateError_t NVSDelegate::get_used_entries(NVSDelegateHandle_t handle, size_t *out_entries) const
+{
+    if (out_entries == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Log_Verbose(m_logger, "NVSDelegate counting the entries of namespace");
+    // Attempt to count the entries of the specified namespace
+    esp_err_t err = nvs_get_used_entry_count(handle, out_entries);
+
+    // Map ESP-IDF errors to NVSDelegateError_t
+    return mapErrorAndPrint(err);
+}
+
 nvs_open_mode_t const NVSDelegate::mapOpenMode(NVSDelegateOpenMode_t const open_mode) const
 {
     return (open_mode == NVSDelegateOpenMode_t::NVSDelegate_READONLY)
@@ -133,6 +285,7 @@ NVSDelegateError_t NVSDelegate::mapErrorAndPrint(esp_err_t const err) const
     case ESP_OK:
         return printAndReturnError(NVS_DELEGATE_OK);
     case ESP_ERR_NVS_NOT_FOUND:
+    case ESP_ERR_NVS_TYPE_MISMATCH: // Stored with another type, not found as this one
         return printAndReturnError(NVS_DELEGATE_KEY_NOT_FOUND);
     case ESP_ERR_NVS_NOT_ENOUGH_SPACE:
         return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
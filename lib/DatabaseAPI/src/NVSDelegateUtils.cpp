@@ -0,0 +1,60 @@
+#include "NVSDelegateUtils.hpp"
+
+#include <string.h>
+
+// Queries the length of the entry of a key with the given type
+static NVSDelegateError_t findEntry(
+    NVSDelegateInterface const *const nvsDelegate, NVSDelegateHandle_t const handle, char const *const key, bool const blob)
+{
+    size_t length = 0;
+    return blob ? nvsDelegate->get_blob(handle, key, nullptr, &length)
+                : nvsDelegate->get_str(handle, key, nullptr, &length);
+}
+
+NVSDelegateError_t NVSDelegateUtils::eraseOtherType(
+    NVSDelegateInterface const *const nvsDelegate, NVSDelegateHandle_t const handle, char const *const key,
+    bool const blob, void const *const value, size_t const length)
+{
+    bool erased = false;
+    NVSDelegateError_t err = NVS_DELEGATE_OK;
+    for (int i = 0; i < NVS_DELEGATE_UTILS_MAX_ERASES && err == NVS_DELEGATE_OK; ++i)
+    {
+        err = findEntry(nvsDelegate, handle, key, !blob);
+        if (err == NVS_DELEGATE_OK)
+        {
+            err = nvsDelegate->erase_key(handle, key);
+            erased = true;
+        }
+    }
+    if (err == NVS_DELEGATE_OK)
+        return NVS_DELEGATE_UNKOWN_ERROR;
+    if (err != NVS_DELEGATE_KEY_NOT_FOUND)
+        return err;
+    if (!erased)
+        return NVS_DELEGATE_OK;
+
+    err = findEntry(nvsDelegate, handle, key, blob);
+    if (err != NVS_DELEGATE_KEY_NOT_FOUND)
+        return err;
+    return blob ? nvsDelegate->set_blob(handle, key, value, length)
+                : nvsDelegate->set_str(handle, key, static_cast<char const *>(value));
+}
+
+bool NVSDelegateUtils::fitsString(char const *const out_value, size_t const length, size_t const valueLength)
+{
+    return out_value == nullptr || length > valueLength;
+}
+
+NVSDelegateError_t NVSDelegateUtils::copyString(
+    char const *const value, size_t const valueLength, char *out_value, size_t *length)
+{
+    if (!fitsString(out_value, *length, valueLength))
+        return NVS_DELEGATE_VALUE_INVALID;
+    if (out_value != nullptr)
+    {
+        memcpy(out_value, value, valueLength);
+        out_value[valueLength] = '\0';
+    }
+    *length = valueLength + 1;
+    return NVS_DELEGATE_OK;
+}
@@ -0,0 +1,443 @@
+#include "NVSImageDelegate.hpp"
+
+#include "DatabaseImage.hpp"
+#include "NVSDelegateUtils.hpp"
+
+// Layout of the pages and items of ESP-IDF NVS
+#define NVS_IMAGE_ENTRY_SIZE 32
+#define NVS_IMAGE_ENTRY_COUNT 126
+#define NVS_IMAGE_BITMAP_OFFSET 32
+#define NVS_IMAGE_FIRST_ENTRY_OFFSET 64
+#define NVS_IMAGE_PAGE_EMPTY 0xFFFFFFFFu
+#define NVS_IMAGE_PAGE_CORRUPT 0x00000000u
+#define NVS_IMAGE_ENTRY_EMPTY 0x3
+#define NVS_IMAGE_ENTRY_WRITTEN 0x2
+#define NVS_IMAGE_TYPE_U8 0x01
+#define NVS_IMAGE_TYPE_I64 0x18
+#define NVS_IMAGE_TYPE_STRING 0x21
+#define NVS_IMAGE_TYPE_BLOB 0x41
+#define NVS_IMAGE_TYPE_BLOB_DATA 0x42
+#define NVS_IMAGE_TYPE_BLOB_INDEX 0x48
+#define NVS_IMAGE_CHUNK_ANY 0xFF
+#define NVS_IMAGE_MAX_NAMESPACES 254
+
+// Item fields
+#define NVS_IMAGE_ITEM_NAMESPACE(item) ((item)[0])
+#define NVS_IMAGE_ITEM_TYPE(item) ((item)[1])
+#define NVS_IMAGE_ITEM_SPAN(item) ((item)[2])
+#define NVS_IMAGE_ITEM_CHUNK(item) ((item)[3])
+#define NVS_IMAGE_ITEM_KEY(item) (reinterpret_cast<char const *>((item) + 8))
+#define NVS_IMAGE_ITEM_DATA(item) ((item) + 24)
+
+// Reads a little-endian 32-bit integer
+static uint32_t readU32(uint8_t const *const data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+// CRC-32 of NVS, seeded with 0xFFFFFFFF as esp_rom_crc32_le is by NVS
+static uint32_t nvsCrc32(uint32_t const crc, uint8_t const *const data, size_t const length)
+{
+    return DatabaseImage::crc32(crc, data, length);
+}
+
+NVSImageDelegate::NVSImageDelegate(
+    uint8_t const *const image, size_t const length, MultiPrinterLoggerInterface *const logger)
+    : m_image(image), m_pageCount(image ? length / NVS_IMAGE_DELEGATE_PAGE_SIZE : 0), m_logger(logger)
+{
+    Log_Debug(m_logger, "NVSImageDelegate created over %zu pages", m_pageCount);
+}
+
+NVSDelegateError_t NVSImageDelegate::open(
+    char const *const name, NVSDelegateOpenMode_t const open_mode, NVSDelegateHandle_t *out_handle) const
+{
+    // Check if the namespace name and the handle pointer are valid
+    if (!isNamespaceValid(name))
+        return printAndReturnError(NVS_DELEGATE_NAMESPACE_INVALID);
+
+    if (out_handle == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    if (open_mode != NVSDelegateOpenMode_t::NVSDelegate_READONLY)
+        return printAndReturnError(NVS_DELEGATE_READONLY);
+
+    Log_Verbose(m_logger, "NVSImageDelegate opening namespace '%s'", name);
+
+    // The handle is the index of the namespace in the image
+    uint8_t const index = findNamespace(name);
+    if (index == 0)
+        return printAndReturnError(NVS_DELEGATE_KEY_NOT_FOUND);
+
+    *out_handle = index;
+    return NVS_DELEGATE_OK;
+}
+
+void NVSImageDelegate::close(NVSDelegateHandle_t handle) const
+{
+    Log_Verbose(m_logger, "NVSImageDelegate closing handle %u", (unsigned)handle);
+}
+
+NVSDelegateError_t NVSImageDelegate::set_str(
+    NVSDelegateHandle_t handle, char const *const key, char const *const value) const
+{
+    return printAndReturnError(NVS_DELEGATE_READONLY);
+}
+
+NVSDelegateError_t NVSImageDelegate::get_str(
+    NVSDelegateHandle_t handle, char const *const key, char *out_value, size_t *length) const
+{
+    // Check if the key, the length pointer and the handle are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (length == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    if (!isHandleValid(handle))
+        return printAndReturnError(NVS_DELEGATE_HANDLE_INVALID);
+
+    Log_Verbose(m_logger, "NVSImageDelegate getting value for key '%s'", key);
+
+    size_t dataLength = 0;
+    uint8_t const *const item = findItem(handle, NVS_IMAGE_TYPE_STRING, key, NVS_IMAGE_CHUNK_ANY);
+    uint8_t const *const data = item ? variableData(item, &dataLength) : nullptr;
+    if (data == nullptr || dataLength == 0)
+        return printAndReturnError(NVS_DELEGATE_KEY_NOT_FOUND);
+
+    // The stored length counts the terminator, which is written again in case the image lacks it
+    return printAndReturnError(
+        NVSDelegateUtils::copyString(reinterpret_cast<char const *>(data), dataLength - 1, out_value, length));
+}
+
+NVSDelegateError_t NVSImageDelegate::set_i64(
+    NVSDelegateHandle_t handle, char const *const key, int64_t const value) const
+{
+    return printAndReturnError(NVS_DELEGATE_READONLY);
+}
+
+NVSDelegateError_t NVSImageDelegate::get_i64(
+    NVSDelegateHandle_t handle, char const *const key, int64_t *out_value) const
+{
+    // Check if the key, the value pointer and the handle are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (out_value == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    if (!isHandleValid(handle))
+        return printAndReturnError(NVS_DELEGATE_HANDLE_INVALID);
+
+    Log_Verbose(m_logger, "NVSImageDelegate getting integer for key '%s'", key);
+
+    uint8_t const *const item = findItem(handle, NVS_IMAGE_TYPE_I64, key, NVS_IMAGE_CHUNK_ANY);
+    if (item == nullptr)
+        return printAndReturnError(NVS_DELEGATE_KEY_NOT_FOUND);
+
+    uint8_t const *const data = NVS_IMAGE_ITEM_DATA(item);
+    *out_value = static_cast<int64_t>(readU32(data) | (static_cast<uint64_t>(readU32(data + 4)) << 32));
+    return NVS_DELEGATE_OK;
+}
+
+NVSDelegateError_t NVSImageDelegate::set_blob(
+    NVSDelegateHandle_t handle, char const *const key, void const *const value, size_t const length) const
+{
+    return printAndReturnError(NVS_DELEGATE_READONLY);
+}
+
+NVSDelegateError_t NVSImageDelegate::get_blob(
+    NVSDelegateHandle_t handle, char const *const key, void *out_value, size_t *length) const
+{
+    // Check if the key, the length pointer and the handle are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (length == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    if (!isHandleValid(handle))
+        return printAndReturnError(NVS_DELEGATE_HANDLE_INVALID);
+
+    Log_Verbose(m_logger, "NVSImageDelegate getting bytes for key '%s'", key);
+
+    // A blob is an index item and its chunks, or a single item in the first version of the format
+    uint8_t chunkCount = 1;
+    uint8_t chunkStart = NVS_IMAGE_CHUNK_ANY;
+    uint8_t type = NVS_IMAGE_TYPE_BLOB;
+    size_t blobLength = 0;
+    uint8_t const *const index = findItem(handle, NVS_IMAGE_TYPE_BLOB_INDEX, key, NVS_IMAGE_CHUNK_ANY);
+    if (index)
+    {
+        blobLength = readU32(NVS_IMAGE_ITEM_DATA(index));
+        chunkCount = NVS_IMAGE_ITEM_DATA(index)[4];
+        chunkStart = NVS_IMAGE_ITEM_DATA(index)[5];
+        type = NVS_IMAGE_TYPE_BLOB_DATA;
+    }
+
+    // Walk the chunks once to check them, and copy them if a buffer is given
+    size_t copied = 0;
+    for (uint8_t i = 0; i < chunkCount; ++i)
+    {
+        uint8_t const chunk = index ? static_cast<uint8_t>(chunkStart + i) : NVS_IMAGE_CHUNK_ANY;
+        size_t dataLength = 0;
+        uint8_t const *const item = findItem(handle, type, key, chunk);
+        uint8_t const *const data = item ? variableData(item, &dataLength) : nullptr;
+        if (data == nullptr)
+            return printAndReturnError(NVS_DELEGATE_KEY_NOT_FOUND);
+
+        if (out_value != nullptr && copied + dataLength <= *length)
+            memcpy(static_cast<uint8_t *>(out_value) + copied, data, dataLength);
+        copied += dataLength;
+    }
+
+    if (index && copied != blobLength)
+        return printAndReturnError(NVS_DELEGATE_KEY_NOT_FOUND);
+
+    // Same convention as nvs_get_blob, a null buffer only queries the length
+    if (out_value != nullptr && *length < copied)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+    *length = copied;
+
+    return NVS_DELEGATE_OK;
+}
+
+NVSDelegateError_t NVSImageDelegate::erase_key(NVSDelegateHandle_t handle, char const *const key) const
+{
+    return printAndReturnError(NVS_DELEGATE_READONLY);
+}
+
+NVSDelegateError_t NVSImageDelegate::erase_all(NVSDelegateHandle_t handle) const
+{
+    return printAndReturnError(NVS_DELEGATE_READONLY);
+}
+
+NVSDelegateError_t NVSImageDelegate::erase_flash_all() const
+{
+    return printAndReturnError(NVS_DELEGATE_READONLY);
+}
+
+NVSDelegateError_t NVSImageDelegate::commit(NVSDelegateHandle_t handle) const
+{
+    return printAndReturnError(NVS_DELEGATE_READONLY);
+}
+
+NVSDelegateError_t NVSImageDelegate::list_keys(
+    char const *const name, NVSDelegateKeyCallback_t callback, void *context) const
+{
+    // Check if the namespace name and the callback are valid
+    if (!isNamespaceValid(name))
+        return printAndReturnError(NVS_DELEGATE_NAMESPACE_INVALID);
+
+    if (callback == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Log_Verbose(m_logger, "NVSImageDelegate listing keys of namespace '%s'", name);
+
+    uint8_t const index = findNamespace(name);
+    if (index == 0)
+        return NVS_DELEGATE_OK;
+
+    // The chunks of a blob are listed once, through its index item
+    char key[NVS_DELEGATE_MAX_KEY_LENGTH];
+    size_t position = 0;
+    uint8_t const *item;
+    while ((item = nextItem(&position)) != nullptr)
+    {
+        if (NVS_IMAGE_ITEM_NAMESPACE(item) != index || NVS_IMAGE_ITEM_TYPE(item) == NVS_IMAGE_TYPE_BLOB_DATA)
+            continue;
+        memcpy(key, NVS_IMAGE_ITEM_KEY(item), NVS_DELEGATE_MAX_KEY_LENGTH - 1);
+        key[NVS_DELEGATE_MAX_KEY_LENGTH - 1] = '\0';
+        if (!callback(key, context))
+            break;
+    }
+
+    return NVS_DELEGATE_OK;
+}
+
+NVSDelegateError_t NVSImageDelegate::get_stats(NVSDelegateStats_t *out_stats) const
+{
+    if (out_stats == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Log_Verbose(m_logger, "NVSImageDelegate reading the entry states of %zu pages", m_pageCount);
+
+    out_stats->usedEntries = 0;
+    out_stats->freeEntries = 0;
+    out_stats->totalEntries = m_pageCount * NVS_IMAGE_ENTRY_COUNT;
+    out_stats->namespaceCount = 0;
+    for (size_t pageIndex = 0; pageIndex < m_pageCount; ++pageIndex)
+    {
+        // Every entry of a page never initialized is free
+        uint8_t const *const page = m_image + pageIndex * NVS_IMAGE_DELEGATE_PAGE_SIZE;
+        if (readU32(page) == NVS_IMAGE_PAGE_EMPTY)
+        {
+            out_stats->freeEntries += NVS_IMAGE_ENTRY_COUNT;
+            continue;
+        }
+
+        for (size_t entry = 0; entry < NVS_IMAGE_ENTRY_COUNT; ++entry)
+        {
+            uint8_t const entryState = (page[NVS_IMAGE_BITMAP_OFFSET + entry / 4] >> ((entry % 4) * 2)) & 0x3;
+            if (entryState == NVS_IMAGE_ENTRY_WRITTEN)
+                out_stats->usedEntries++;
+            else if (entryState == NVS_IMAGE_ENTRY_EMPTY)
+                out_stats->freeEntries++;
+        }
+    }
+
+    // Namespaces are defined by U8 items of namespace 0
+    size_t position = 0;
+    uint8_t const *item;
+    while ((item = nextItem(&position)) != nullptr)
+        if (NVS_IMAGE_ITEM_NAMESPACE(item) == 0 && NVS_IMAGE_ITEM_TYPE(item) == NVS_IMAGE_TYPE_U8)
+            out_stats->namespaceCount++;
+
+    return NVS_DELEGATE_OK;
+}
+
+NVSDelegateError_t NVSImageDelegate::get_used_entries(NVSDelegateHandle_t handle, size_t *out_entries) const
+{
+    if (out_entries == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    if (!isHandleValid(handle))
+        return printAndReturnError(NVS_DELEGATE_HANDLE_INVALID);
+
+    *out_entries = 0;
+    size_t position = 0;
+    uint8_t const *item;
+    while ((item = nextItem(&position)) != nullptr)
+        if (NVS_IMAGE_ITEM_NAMESPACE(item) == handle)
+            *out_entries += NVS_IMAGE_ITEM_SPAN(item);
+
+    return NVS_DELEGATE_OK;
+}
+
+uint8_t const *NVSImageDelegate::nextItem(size_t *position) const
+{
+    while (*position < m_pageCount * NVS_IMAGE_ENTRY_COUNT)
+    {
+        size_t const pageIndex = *position / NVS_IMAGE_ENTRY_COUNT;
+        size_t const entry = *position % NVS_IMAGE_ENTRY_COUNT;
+        uint8_t const *const page = m_image + pageIndex * NVS_IMAGE_DELEGATE_PAGE_SIZE;
+
+        // Empty and corrupt pages hold no item, nor do pages whose header is damaged
+        uint32_t const state = readU32(page);
+        if (state == NVS_IMAGE_PAGE_EMPTY || state == NVS_IMAGE_PAGE_CORRUPT || readU32(page + 28) != nvsCrc32(0xFFFFFFFFu, page + 4, 24))
+        {
+            *position = (pageIndex + 1) * NVS_IMAGE_ENTRY_COUNT;
+            continue;
+        }
+
+        // Two bits of state per entry
+        uint8_t const entryState = (page[NVS_IMAGE_BITMAP_OFFSET + entry / 4] >> ((entry % 4) * 2)) & 0x3;
+        uint8_t const *const item = page + NVS_IMAGE_FIRST_ENTRY_OFFSET + entry * NVS_IMAGE_ENTRY_SIZE;
+        if (entryState != NVS_IMAGE_ENTRY_WRITTEN)
+        {
+            (*position)++;
+            continue;
+        }
+
+        // The CRC covers the item but its own field; a damaged item is skipped alone
+        uint32_t crc = nvsCrc32(0xFFFFFFFFu, item, 4);
+        crc = nvsCrc32(crc, item + 8, NVS_IMAGE_ENTRY_SIZE - 8);
+        uint8_t const span = NVS_IMAGE_ITEM_SPAN(item);
+        if (crc != readU32(item + 4) || span == 0 || entry + span > NVS_IMAGE_ENTRY_COUNT)
+        {
+            (*position)++;
+            continue;
+        }
+
+        *position += span;
+        return item;
+    }
+
+    return nullptr;
+}
+
+uint8_t const *NVSImageDelegate::findItem(
+    uint8_t const namespaceIndex, uint8_t const type, char const *const key, uint8_t const chunkIndex) const
+{
+    size_t position = 0;
+    uint8_t const *item;
+    while ((item = nextItem(&position)) != nullptr)
+    {
+        if (NVS_IMAGE_ITEM_NAMESPACE(item) == namespaceIndex && NVS_IMAGE_ITEM_TYPE(item) == type &&
+            NVS_IMAGE_ITEM_CHUNK(item) == chunkIndex && strncmp(NVS_IMAGE_ITEM_KEY(item), key, NVS_DELEGATE_MAX_KEY_LENGTH) == 0)
+            return item;
+    }
+
+    return nullptr;
+}
+
+uint8_t const *NVSImageDelegate::variableData(uint8_t const *const item, size_t *out_length) const
+{
+    // Size on 2 bytes, 2 reserved bytes, then the CRC of the data, which follows the item
+    uint8_t const *const field = NVS_IMAGE_ITEM_DATA(item);
+    size_t const length = field[0] | (field[1] << 8);
+    uint8_t const *const data = item + NVS_IMAGE_ENTRY_SIZE;
+    if (length == 0 || length > (NVS_IMAGE_ITEM_SPAN(item) - 1u) * NVS_IMAGE_ENTRY_SIZE ||
+        nvsCrc32(0xFFFFFFFFu, data, length) != readU32(field + 4))
+        return nullptr;
+
+    *out_length = length;
+    return data;
+}
+
+uint8_t NVSImageDelegate::findNamespace(char const *const name) const
+{
+    // Namespaces are defined by U8 items of namespace 0, keyed by name, holding the index
+    uint8_t const *const item = findItem(0, NVS_IMAGE_TYPE_U8, name, NVS_IMAGE_CHUNK_ANY);
+    if (item == nullptr)
+        return 0;
+
+    uint8_t const index = NVS_IMAGE_ITEM_DATA(item)[0];
+    return index <= NVS_IMAGE_MAX_NAMESPACES ? index : 0;
+}
+
+NVSDelegateError_t NVSImageDelegate::printAndReturnError(NVSDelegateError_t const error) const
+{
+    switch (error)
+    {
+    case NVS_DELEGATE_OK:
+        break;
+    case NVS_DELEGATE_KEY_INVALID:
+        Log_Error(m_logger, "Invalid key");
+        break;
+    case NVS_DELEGATE_VALUE_INVALID:
+        Log_Error(m_logger, "Invalid value");
+        break;
+    case NVS_DELEGATE_NAMESPACE_INVALID:
+        Log_Error(m_logger, "Invalid namespace name");
+        break;
+    case NVS_DELEGATE_KEY_NOT_FOUND:
+        Log_Error(m_logger, "Key not found");
+        break;
+    case NVS_DELEGATE_HANDLE_INVALID:
+        Log_Error(m_logger, "Invalid namespace handle");
+        break;
+    case NVS_DELEGATE_READONLY:
+        Log_Error(m_logger, "Attempt to write a read-only image");
+        break;
+    default:
+        Log_Error(m_logger, "Unknown error");
+        break;
+    }
+
+    return error;
+}
+
+bool NVSImageDelegate::isNamespaceValid(const char *const name) const
+{
+    return name && strlen(name) > 0 && strlen(name) < NVS_DELEGATE_MAX_NAMESPACE_LENGTH;
+}
+
+bool NVSImageDelegate::isKeyValid(const char *const key) const
+{
+    return key && strlen(key) > 0 && strlen(key) < NVS_DELEGATE_MAX_KEY_LENGTH;
+}
+
+bool NVSImageDelegate::isHandleValid(NVSDelegateHandle_t const handle) const
+{
+    return handle > 0 && handle <= NVS_IMAGE_MAX_NAMESPACES;
+}
@@ -0,0 +1,713 @@
+#include "PackedNVSDelegate.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "DatabaseHash.hpp"
+#include "NVSDelegateUtils.hpp"
+
+// A bucket is a record count followed by [key length][key][value length][value] records
+#define PACKED_NVS_DELEGATE_HEADER_LENGTH 1
+
+// NVS entries used by a string or a blob of the given length, see getSpaceReport
+#define PACKED_NVS_DELEGATE_STRING_ENTRIES(length) (1 + ((length) + 31) / 32)
+#define PACKED_NVS_DELEGATE_BLOB_ENTRIES(length) (2 + ((length) + 31) / 32)
+
+/**
+ * @brief State of a listing that hides the bucket keys.
+ */
+struct PackedListContext
+{
+    PackedNVSDelegate const *delegate;  /**< Delegate listing the keys. */
+    NVSDelegateKeyCallback_t callback;  /**< Callback of the caller. */
+    void *context;                      /**< Context of the caller. */
+    bool stopped;                       /**< true once the callback returned false. */
+};
+
+/**
+ * @brief State of a space report.
+ */
+struct PackedReportContext
+{
+    NVSDelegateInterface const *nvsDelegate; /**< Wrapped delegate. */
+    NVSDelegateHandle_t handle;              /**< Handle of the namespace reported. */
+    PackedNVSDelegateReport_t *report;       /**< Report being filled. */
+};
+
+PackedNVSDelegate::PackedNVSDelegate(
+    NVSDelegateInterface *const nvsDelegate, size_t const bucketCount, MultiPrinterLoggerInterface *const logger)
+    : m_nvsDelegate(nvsDelegate),
+      m_bucketCount(bucketCount >= 1 && bucketCount <= PACKED_NVS_DELEGATE_MAX_BUCKET_COUNT ? bucketCount : PACKED_NVS_DELEGATE_BUCKET_COUNT),
+      m_logger(logger)
+{
+    memset(m_handles, 0, sizeof(m_handles));
+    memset(m_filters, 0, sizeof(m_filters));
+
+    if (m_bucketCount != bucketCount)
+        Log_Error(m_logger, "Invalid bucket count %u, using %u", (unsigned)bucketCount, (unsigned)m_bucketCount);
+
+    Log_Debug(m_logger, "PackedNVSDelegate created with %u buckets", (unsigned)m_bucketCount);
+}
+
+PackedNVSDelegate::~PackedNVSDelegate()
+{
+    for (size_t i = 0; i < PACKED_NVS_DELEGATE_MAX_NAMESPACES; ++i)
+        free(m_filters[i].buckets);
+
+    Log_Debug(m_logger, "PackedNVSDelegate destroyed");
+}
+
+NVSDelegateError_t PackedNVSDelegate::open(
+    char const *const name, NVSDelegateOpenMode_t const open_mode,
+    NVSDelegateHandle_t *out_handle) const
+{
+    NVSDelegateError_t const err = m_nvsDelegate->open(name, open_mode, out_handle);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    // Only the filters need the namespace; with a full table the buckets are read every time
+    DatabaseLockGuard guard(m_handleMutex);
+    for (size_t i = 0; i < PACKED_NVS_DELEGATE_MAX_OPEN_HANDLES; ++i)
+    {
+        if (m_handles[i].name[0] == '\0')
+        {
+            m_handles[i].handle = *out_handle;
+            strcpy(m_handles[i].name, name);
+            break;
+        }
+    }
+    return err;
+}
+
+void PackedNVSDelegate::close(NVSDelegateHandle_t handle) const
+{
+    {
+        DatabaseLockGuard guard(m_handleMutex);
+        for (size_t i = 0; i < PACKED_NVS_DELEGATE_MAX_OPEN_HANDLES; ++i)
+        {
+            if (m_handles[i].name[0] != '\0' && m_handles[i].handle == handle)
+            {
+                m_handles[i].name[0] = '\0';
+                break;
+            }
+        }
+    }
+    m_nvsDelegate->close(handle);
+}
+
+NVSDelegateError_t PackedNVSDelegate::set_str(
+    NVSDelegateHandle_t handle, char const *const key,
+    char const *const value) const
+{
+    // Check if the key and value are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (value == nullptr || strlen(value) == 0 || strlen(value) >= NVS_DELEGATE_MAX_VALUE_LENGTH)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Log_Verbose(m_logger, "PackedNVSDelegate setting key '%s' to value '%s'", key, value);
+
+    size_t const keyLength = strlen(key);
+    size_t const valueLength = strlen(value);
+    uint32_t const hash = DatabaseHash::fnv1a(key, keyLength);
+    size_t const bucketIndex = bucketOf(hash);
+    BucketFilter *const filter = filterOf(handle, bucketIndex);
+
+    char bucketKey[NVS_DELEGATE_MAX_KEY_LENGTH];
+    bucketKeyOf(bucketIndex, bucketKey);
+
+    DatabaseLockGuard lock(bucketMutexOf(bucketIndex));
+
+    // A long value whose key is not in the bucket leaves the bucket as is
+    if (valueLength >= PACKED_NVS_DELEGATE_MAX_VALUE_LENGTH && filter && filter->known && !(filter->keys & filterBitOf(hash)))
+        return m_nvsDelegate->set_str(handle, key, value);
+
+    uint8_t *const bucket = static_cast<uint8_t *>(malloc(PACKED_NVS_DELEGATE_MAX_BUCKET_LENGTH));
+    if (bucket == nullptr)
+        return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+
+    size_t length;
+    NVSDelegateError_t err = loadBucket(handle, bucketKey, bucket, &length);
+    if (err != NVS_DELEGATE_OK)
+    {
+        free(bucket);
+        return err;
+    }
+    if (filter)
+        refreshFilter(filter, bucket, length);
+
+    // Take the previous record out of the bucket, it is rewritten only if something changed
+    size_t recordLength = 0;
+    size_t const offset = findRecord(bucket, length, key, &recordLength);
+    if (offset)
+    {
+        memmove(bucket + offset, bucket + offset + recordLength, length - offset - recordLength);
+        length -= recordLength;
+        bucket[0]--;
+    }
+
+    bool const packed = valueLength < PACKED_NVS_DELEGATE_MAX_VALUE_LENGTH && bucket[0] < UINT8_MAX &&
+                        length + 2 + keyLength + valueLength <= PACKED_NVS_DELEGATE_MAX_BUCKET_LENGTH;
+    if (!packed)
+    {
+        // Long value or full bucket: store it on its own, then drop the packed copy
+        err = m_nvsDelegate->set_str(handle, key, value);
+        if (err == NVS_DELEGATE_OK && offset)
+        {
+            err = storeBucket(handle, bucketKey, bucket, length);
+            if (err == NVS_DELEGATE_OK && filter)
+                refreshFilter(filter, bucket, length);
+        }
+        free(bucket);
+        return err;
+    }
+
+    // Append the record, then drop a copy stored on its own
+    uint8_t *record = bucket + length;
+    *record++ = static_cast<uint8_t>(keyLength);
+    memcpy(record, key, keyLength);
+    record += keyLength;
+    *record++ = static_cast<uint8_t>(valueLength);
+    memcpy(record, value, valueLength);
+    length += 2 + keyLength + valueLength;
+    bucket[0]++;
+
+    // The key joins the filter before the bucket is written, so a failed write cannot hide it
+    if (filter)
+        filter->keys |= filterBitOf(hash);
+
+    err = storeBucket(handle, bucketKey, bucket, length);
+    free(bucket);
+    if (err == NVS_DELEGATE_OK && !offset)
+    {
+        err = m_nvsDelegate->erase_key(handle, key);
+        if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+            err = NVS_DELEGATE_OK;
+    }
+    return err;
+}
+
+NVSDelegateError_t PackedNVSDelegate::get_str(
+    NVSDelegateHandle_t handle, char const *const key,
+    char *out_value, size_t *length) const
+{
+    // Check if the key and the length pointer are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (length == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Log_Verbose(m_logger, "PackedNVSDelegate getting value for key '%s'", key);
+
+    uint32_t const hash = DatabaseHash::fnv1a(key);
+    size_t const bucketIndex = bucketOf(hash);
+    BucketFilter *const filter = filterOf(handle, bucketIndex);
+
+    char bucketKey[NVS_DELEGATE_MAX_KEY_LENGTH];
+    bucketKeyOf(bucketIndex, bucketKey);
+
+    {
+        DatabaseLockGuard lock(bucketMutexOf(bucketIndex));
+
+        // A key the filter rules out is read from the wrapped delegate without reading the bucket
+        if (filter && filter->known && !(filter->keys & filterBitOf(hash)))
+            return m_nvsDelegate->get_str(handle, key, out_value, length);
+
+        uint8_t *const bucket = static_cast<uint8_t *>(malloc(PACKED_NVS_DELEGATE_MAX_BUCKET_LENGTH));
+        if (bucket == nullptr)
+            return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+
+        size_t bucketLength;
+        NVSDelegateError_t err = loadBucket(handle, bucketKey, bucket, &bucketLength);
+        if (err != NVS_DELEGATE_OK)
+        {
+            free(bucket);
+            return err;
+        }
+        if (filter)
+            refreshFilter(filter, bucket, bucketLength);
+
+        size_t recordLength = 0;
+        size_t const offset = findRecord(bucket, bucketLength, key, &recordLength);
+        if (offset)
+        {
+            uint8_t const *const value = bucket + offset + 1 + bucket[offset] + 1;
+            err = printAndReturnError(
+                NVSDelegateUtils::copyString(reinterpret_cast<char const *>(value), value[-1], out_value, length));
+            free(bucket);
+            return err;
+        }
+        free(bucket);
+    }
+
+    return m_nvsDelegate->get_str(handle, key, out_value, length);
+}
+
+NVSDelegateError_t PackedNVSDelegate::set_i64(
+    NVSDelegateHandle_t handle, char const *const key, int64_t const value) const
+{
+    return m_nvsDelegate->set_i64(handle, key, value);
+}
+
+NVSDelegateError_t PackedNVSDelegate::get_i64(
+    NVSDelegateHandle_t handle, char const *const key, int64_t *out_value) const
+{
+    return m_nvsDelegate->get_i64(handle, key, out_value);
+}
+
+NVSDelegateError_t PackedNVSDelegate::set_blob(
+    NVSDelegateHandle_t handle, char const *const key,
+    void const *const value, size_t const length) const
+{
+    return m_nvsDelegate->set_blob(handle, key, value, length);
+}
+
+NVSDelegateError_t PackedNVSDelegate::get_blob(
+    NVSDelegateHandle_t handle, char const *const key,
+    void *out_value, size_t *length) const
+{
+    return m_nvsDelegate->get_blob(handle, key, out_value, length);
+}
+
+NVSDelegateError_t PackedNVSDelegate::erase_key(
+    NVSDelegateHandle_t handle, char const *const key) const
+{
+    // Check if the key is valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    Log_Verbose(m_logger, "PackedNVSDelegate erasing key '%s'", key);
+
+    uint32_t const hash = DatabaseHash::fnv1a(key);
+    size_t const bucketIndex = bucketOf(hash);
+    BucketFilter *const filter = filterOf(handle, bucketIndex);
+
+    char bucketKey[NVS_DELEGATE_MAX_KEY_LENGTH];
+    bucketKeyOf(bucketIndex, bucketKey);
+
+    {
+        DatabaseLockGuard lock(bucketMutexOf(bucketIndex));
+
+        if (filter && filter->known && !(filter->keys & filterBitOf(hash)))
+            return m_nvsDelegate->erase_key(handle, key);
+
+        uint8_t *const bucket = static_cast<uint8_t *>(malloc(PACKED_NVS_DELEGATE_MAX_BUCKET_LENGTH));
+        if (bucket == nullptr)
+            return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+
+        size_t length;
+        NVSDelegateError_t err = loadBucket(handle, bucketKey, bucket, &length);
+        if (err != NVS_DELEGATE_OK)
+        {
+            free(bucket);
+            return err;
+        }
+        if (filter)
+            refreshFilter(filter, bucket, length);
+
+        size_t recordLength = 0;
+        size_t const offset = findRecord(bucket, length, key, &recordLength);
+        if (offset)
+        {
+            memmove(bucket + offset, bucket + offset + recordLength, length - offset - recordLength);
+            bucket[0]--;
+            err = storeBucket(handle, bucketKey, bucket, length - recordLength);
+            if (err == NVS_DELEGATE_OK && filter)
+                refreshFilter(filter, bucket, length - recordLength);
+            free(bucket);
+            return err;
+        }
+        free(bucket);
+    }
+
+    return m_nvsDelegate->erase_key(handle, key);
+}
+
+NVSDelegateError_t PackedNVSDelegate::erase_all(NVSDelegateHandle_t handle) const
+{
+    NVSDelegateError_t const err = m_nvsDelegate->erase_all(handle);
+
+    // Forgotten after the erase, so no filter is rebuilt from the erased buckets
+    char name[NVS_DELEGATE_MAX_NAMESPACE_LENGTH] = {0};
+    {
+        DatabaseLockGuard guard(m_handleMutex);
+        for (size_t i = 0; i < PACKED_NVS_DELEGATE_MAX_OPEN_HANDLES; ++i)
+        {
+            if (m_handles[i].name[0] != '\0' && m_handles[i].handle == handle)
+            {
+                strcpy(name, m_handles[i].name);
+                break;
+            }
+        }
+    }
+    forgetFilters(name[0] != '\0' ? name : nullptr);
+    return err;
+}
+
+NVSDelegateError_t PackedNVSDelegate::erase_flash_all() const
+{
+    NVSDelegateError_t const err = m_nvsDelegate->erase_flash_all();
+    forgetFilters(nullptr);
+    return err;
+}
+
+NVSDelegateError_t PackedNVSDelegate::commit(NVSDelegateHandle_t handle) const
+{
+    return m_nvsDelegate->commit(handle);
+}
+
+NVSDelegateError_t PackedNVSDelegate::list_keys(
+    char const *const name, NVSDelegateKeyCallback_t callback, void *context) const
+{
+    if (callback == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    Log_Verbose(m_logger, "PackedNVSDelegate listing keys of namespace '%s'", name);
+
+    // Keys stored on their own, without the bucket keys
+    PackedListContext list = {this, callback, context, false};
+    NVSDelegateError_t err = m_nvsDelegate->list_keys(
+        name,
+        [](char const *const key, void *context) -> bool
+        {
+            PackedListContext *const list = static_cast<PackedListContext *>(context);
+            if (list->delegate->isBucketKey(key))
+                return true;
+            list->stopped = !list->callback(key, list->context);
+            return !list->stopped;
+        },
+        &list);
+    if (err != NVS_DELEGATE_OK || list.stopped)
+        return err;
+
+    NVSDelegateHandle_t handle;
+    err = m_nvsDelegate->open(name, NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+        return NVS_DELEGATE_OK;
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    // Packed keys, from a copy of each bucket so the callback may call back into the delegate
+    uint8_t *const bucket = static_cast<uint8_t *>(malloc(PACKED_NVS_DELEGATE_MAX_BUCKET_LENGTH));
+    if (bucket == nullptr)
+    {
+        m_nvsDelegate->close(handle);
+        return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+    }
+
+    char bucketKey[NVS_DELEGATE_MAX_KEY_LENGTH];
+    char key[NVS_DELEGATE_MAX_KEY_LENGTH];
+    for (size_t i = 0; i < m_bucketCount && err == NVS_DELEGATE_OK && !list.stopped; ++i)
+    {
+        bucketKeyOf(i, bucketKey);
+
+        size_t length;
+        {
+            DatabaseLockGuard lock(bucketMutexOf(i));
+            err = loadBucket(handle, bucketKey, bucket, &length);
+        }
+
+        for (size_t offset = PACKED_NVS_DELEGATE_HEADER_LENGTH; err == NVS_DELEGATE_OK && offset < length && !list.stopped;)
+        {
+            size_t const keyLength = bucket[offset];
+            memcpy(key, bucket + offset + 1, keyLength);
+            key[keyLength] = '\0';
+            offset += 1 + keyLength + 1 + bucket[offset + 1 + keyLength];
+
+            list.stopped = !callback(key, context);
+        }
+    }
+
+    free(bucket);
+    m_nvsDelegate->close(handle);
+    return err;
+}
+
+NVSDelegateError_t PackedNVSDelegate::get_stats(NVSDelegateStats_t *out_stats) const
+{
+    return m_nvsDelegate->get_stats(out_stats);
+}
+
+NVSDelegateError_t PackedNVSDelegate::get_used_entries(NVSDelegateHandle_t handle, size_t *out_entries) const
+{
+    return m_nvsDelegate->get_used_entries(handle, out_entries);
+}
+
+NVSDelegateError_t PackedNVSDelegate::getSpaceReport(char const *const name, PackedNVSDelegateReport_t *out_report) const
+{
+    if (out_report == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    memset(out_report, 0, sizeof(*out_report));
+
+    PackedReportContext report = {m_nvsDelegate, 0, out_report};
+    NVSDelegateError_t err = m_nvsDelegate->open(name, NVSDelegateOpenMode_t::NVSDelegate_READONLY, &report.handle);
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+        return NVS_DELEGATE_OK;
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    // Classify every key stored in the wrapped delegate by its type
+    err = m_nvsDelegate->list_keys(
+        name,
+        [](char const *const key, void *context) -> bool
+        {
+            PackedReportContext *const report = static_cast<PackedReportContext *>(context);
+            PackedNVSDelegateReport_t *const out = report->report;
+
+            size_t length = 0;
+            int64_t integer;
+            if (report->nvsDelegate->get_str(report->handle, key, nullptr, &length) == NVS_DELEGATE_OK)
+            {
+                out->logicalKeys++;
+                out->entries += PACKED_NVS_DELEGATE_STRING_ENTRIES(length);
+                out->unpackedEntries += PACKED_NVS_DELEGATE_STRING_ENTRIES(length);
+            }
+            else if (report->nvsDelegate->get_i64(report->handle, key, &integer) == NVS_DELEGATE_OK)
+            {
+                out->logicalKeys++;
+                out->entries += 1;
+                out->unpackedEntries += 1;
+            }
+            else if (report->nvsDelegate->get_blob(report->handle, key, nullptr, &length) == NVS_DELEGATE_OK)
+            {
+                out->entries += PACKED_NVS_DELEGATE_BLOB_ENTRIES(length);
+                if (strncmp(key, PACKED_NVS_DELEGATE_BUCKET_PREFIX, strlen(PACKED_NVS_DELEGATE_BUCKET_PREFIX)) == 0)
+                {
+                    out->buckets++;
+                    return true;
+                }
+
+                out->logicalKeys++;
+                out->unpackedEntries += PACKED_NVS_DELEGATE_BLOB_ENTRIES(length);
+            }
+            return true;
+        },
+        &report);
+
+    uint8_t *const bucket = err == NVS_DELEGATE_OK ? static_cast<uint8_t *>(malloc(PACKED_NVS_DELEGATE_MAX_BUCKET_LENGTH)) : nullptr;
+    if (err == NVS_DELEGATE_OK && bucket == nullptr)
+        err = printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+
+    // Count the packed keys, as if each were a string of its own
+    char bucketKey[NVS_DELEGATE_MAX_KEY_LENGTH];
+    for (size_t i = 0; i < m_bucketCount && err == NVS_DELEGATE_OK; ++i)
+    {
+        bucketKeyOf(i, bucketKey);
+
+        size_t length;
+        {
+            DatabaseLockGuard lock(bucketMutexOf(i));
+            err = loadBucket(report.handle, bucketKey, bucket, &length);
+        }
+        for (size_t offset = PACKED_NVS_DELEGATE_HEADER_LENGTH; err == NVS_DELEGATE_OK && offset < length;)
+        {
+            size_t const valueLength = bucket[offset + 1 + bucket[offset]];
+            offset += 1 + bucket[offset] + 1 + valueLength;
+
+            out_report->logicalKeys++;
+            out_report->packedKeys++;
+            out_report->unpackedEntries += PACKED_NVS_DELEGATE_STRING_ENTRIES(valueLength + 1);
+        }
+    }
+
+    free(bucket);
+    m_nvsDelegate->close(report.handle);
+    return err;
+}
+
+size_t PackedNVSDelegate::bucketOf(uint32_t const hash) const
+{
+    return hash % m_bucketCount;
+}
+
+uint64_t PackedNVSDelegate::filterBitOf(uint32_t const hash) const
+{
+    // The bits of the hash left once the bucket is chosen
+    return 1ULL << ((hash / m_bucketCount) % 64);
+}
+
+void PackedNVSDelegate::bucketKeyOf(size_t const bucket, char *out_bucketKey) const
+{
+    snprintf(out_bucketKey, NVS_DELEGATE_MAX_KEY_LENGTH, PACKED_NVS_DELEGATE_BUCKET_PREFIX "%02u", (unsigned)bucket);
+}
+
+DatabaseMutex const &PackedNVSDelegate::bucketMutexOf(size_t const bucket) const
+{
+    return m_bucketMutexes[bucket % PACKED_NVS_DELEGATE_LOCK_COUNT];
+}
+
+PackedNVSDelegate::BucketFilter *PackedNVSDelegate::filterOf(NVSDelegateHandle_t const handle, size_t const bucket) const
+{
+    DatabaseLockGuard guard(m_handleMutex);
+
+    char const *name = nullptr;
+    for (size_t i = 0; i < PACKED_NVS_DELEGATE_MAX_OPEN_HANDLES && name == nullptr; ++i)
+    {
+        if (m_handles[i].name[0] != '\0' && m_handles[i].handle == handle)
+            name = m_handles[i].name;
+    }
+    if (name == nullptr)
+        return nullptr;
+
+    // Slots are never released, so a filter stays valid once handed out
+    NamespaceFilters *freeSlot = nullptr;
+    for (size_t i = 0; i < PACKED_NVS_DELEGATE_MAX_NAMESPACES; ++i)
+    {
+        if (m_filters[i].name[0] == '\0')
+        {
+            if (freeSlot == nullptr)
+                freeSlot = &m_filters[i];
+        }
+        else if (strcmp(m_filters[i].name, name) == 0)
+            return &m_filters[i].buckets[bucket];
+    }
+    if (freeSlot == nullptr)
+        return nullptr;
+
+    freeSlot->buckets = static_cast<BucketFilter *>(calloc(m_bucketCount, sizeof(BucketFilter)));
+    if (freeSlot->buckets == nullptr)
+        return nullptr;
+    strcpy(freeSlot->name, name);
+    return &freeSlot->buckets[bucket];
+}
+
+void PackedNVSDelegate::refreshFilter(BucketFilter *const filter, uint8_t const *const bucket, size_t const length) const
+{
+    filter->keys = 0;
+    for (size_t offset = PACKED_NVS_DELEGATE_HEADER_LENGTH; offset < length;)
+    {
+        size_t const keyLength = bucket[offset];
+        filter->keys |= filterBitOf(DatabaseHash::fnv1a(reinterpret_cast<char const *>(bucket + offset + 1), keyLength));
+        offset += 1 + keyLength + 1 + bucket[offset + 1 + keyLength];
+    }
+    filter->known = true;
+}
+
+void PackedNVSDelegate::forgetFilters(char const *const name) const
+{
+    DatabaseLockGuard guard(m_handleMutex);
+    for (size_t i = 0; i < PACKED_NVS_DELEGATE_MAX_NAMESPACES; ++i)
+    {
+        if (m_filters[i].name[0] == '\0' || (name != nullptr && strcmp(m_filters[i].name, name) != 0))
+            continue;
+
+        for (size_t j = 0; j < m_bucketCount; ++j)
+        {
+            DatabaseLockGuard lock(bucketMutexOf(j));
+            m_filters[i].buckets[j].known = false;
+        }
+    }
+}
+
+NVSDelegateError_t PackedNVSDelegate::loadBucket(
+    NVSDelegateHandle_t const handle, char const *const bucketKey, uint8_t *bucket, size_t *out_length) const
+{
+    size_t length = PACKED_NVS_DELEGATE_MAX_BUCKET_LENGTH;
+    NVSDelegateError_t err = m_nvsDelegate->get_blob(handle, bucketKey, bucket, &length);
+
+    // A missing bucket holds no record
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+    {
+        bucket[0] = 0;
+        *out_length = PACKED_NVS_DELEGATE_HEADER_LENGTH;
+        return NVS_DELEGATE_OK;
+    }
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    if (!isBucketValid(bucket, length))
+    {
+        Log_Error(m_logger, "Bucket '%s' is malformed", bucketKey);
+        return printAndReturnError(NVS_DELEGATE_UNKOWN_ERROR);
+    }
+
+    *out_length = length;
+    return NVS_DELEGATE_OK;
+}
+
+NVSDelegateError_t PackedNVSDelegate::storeBucket(
+    NVSDelegateHandle_t const handle, char const *const bucketKey, uint8_t const *const bucket, size_t const length) const
+{
+    // An empty bucket is erased rather than stored
+    if (bucket[0] == 0)
+    {
+        NVSDelegateError_t const err = m_nvsDelegate->erase_key(handle, bucketKey);
+        return err == NVS_DELEGATE_KEY_NOT_FOUND ? NVS_DELEGATE_OK : err;
+    }
+
+    return m_nvsDelegate->set_blob(handle, bucketKey, bucket, length);
+}
+
+size_t PackedNVSDelegate::findRecord(
+    uint8_t const *const bucket, size_t const length, char const *const key, size_t *out_recordLength) const
+{
+    size_t const keyLength = strlen(key);
+    for (size_t offset = PACKED_NVS_DELEGATE_HEADER_LENGTH; offset < length;)
+    {
+        size_t const recordKeyLength = bucket[offset];
+        size_t const recordLength = 1 + recordKeyLength + 1 + bucket[offset + 1 + recordKeyLength];
+        if (recordKeyLength == keyLength && memcmp(bucket + offset + 1, key, keyLength) == 0)
+        {
+            *out_recordLength = recordLength;
+            return offset;
+        }
+        offset += recordLength;
+    }
+    return 0;
+}
+
+bool PackedNVSDelegate::isBucketValid(uint8_t const *const bucket, size_t const length) const
+{
+    if (length < PACKED_NVS_DELEGATE_HEADER_LENGTH)
+        return false;
+
+    size_t count = 0;
+    size_t offset = PACKED_NVS_DELEGATE_HEADER_LENGTH;
+    while (offset < length)
+    {
+        // Key length, key and value length, then the value must all lie within the bucket
+        size_t const keyLength = bucket[offset];
+        if (keyLength == 0 || keyLength >= NVS_DELEGATE_MAX_KEY_LENGTH || offset + 1 + keyLength >= length)
+            return false;
+        offset += 1 + keyLength + 1 + bucket[offset + 1 + keyLength];
+        count++;
+    }
+
+    return offset == length && count == bucket[0];
+}
+
+bool PackedNVSDelegate::isBucketKey(char const *const key) const
+{
+    return strncmp(key, PACKED_NVS_DELEGATE_BUCKET_PREFIX, strlen(PACKED_NVS_DELEGATE_BUCKET_PREFIX)) == 0;
+}
+
+NVSDelegateError_t PackedNVSDelegate::printAndReturnError(NVSDelegateError_t const error) const
+{
+    switch (error)
+    {
+    case NVS_DELEGATE_OK:
+        break;
+    case NVS_DELEGATE_KEY_INVALID:
+        Log_Error(m_logger, "Invalid key");
+        break;
+    case NVS_DELEGATE_VALUE_INVALID:
+        Log_Error(m_logger, "Invalid value");
+        break;
+    case NVS_DELEGATE_NOT_ENOUGH_SPACE:
+        Log_Error(m_logger, "Not enough space");
+        break;
+    default:
+        Log_Error(m_logger, "Unknown error");
+        break;
+    }
+
+    return error;
+}
+
+bool PackedNVSDelegate::isKeyValid(const char *const key) const
+{
+    return key && strlen(key) > 0 && strlen(key) < NVS_DELEGATE_MAX_KEY_LENGTH;
+}
@@ -0,0 +1,541 @@
+#include "TieredNVSDelegate.hpp"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "DatabaseImage.hpp"
+#include "NVSDelegateUtils.hpp"
+
+#define TIERED_NVS_DELEGATE_FILE_MAGIC "NVST"
+#define TIERED_NVS_DELEGATE_FILE_MAGIC_LENGTH 4
+// Magic, then the namespace and the key, each null-padded to their maximum length
+#define TIERED_NVS_DELEGATE_FILE_HEADER_LENGTH \
+    (TIERED_NVS_DELEGATE_FILE_MAGIC_LENGTH + NVS_DELEGATE_MAX_NAMESPACE_LENGTH + NVS_DELEGATE_MAX_KEY_LENGTH)
+// Files are named by their id as 8 hexadecimal digits
+#define TIERED_NVS_DELEGATE_FILE_NAME_LENGTH 8
+#define TIERED_NVS_DELEGATE_MAX_PATH_LENGTH (TIERED_NVS_DELEGATE_MAX_DIRECTORY_LENGTH + TIERED_NVS_DELEGATE_FILE_NAME_LENGTH + 1)
+// Orphans found per pass over the directory, removed once the directory is closed
+#define TIERED_NVS_DELEGATE_ORPHAN_BATCH 16
+
+static uint32_t readU32(uint8_t const *const data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+static void writeU32(uint8_t *const data, uint32_t const value)
+{
+    data[0] = static_cast<uint8_t>(value);
+    data[1] = static_cast<uint8_t>(value >> 8);
+    data[2] = static_cast<uint8_t>(value >> 16);
+    data[3] = static_cast<uint8_t>(value >> 24);
+}
+
+// Parses the id of a file name, false for names the delegate did not write
+static bool parseFileName(char const *const name, uint32_t *out_id)
+{
+    if (strlen(name) != TIERED_NVS_DELEGATE_FILE_NAME_LENGTH)
+        return false;
+
+    char *end = nullptr;
+    unsigned long const id = strtoul(name, &end, 16);
+    if (*end != '\0')
+        return false;
+
+    *out_id = static_cast<uint32_t>(id);
+    return true;
+}
+
+TieredNVSDelegate::TieredNVSDelegate(
+    NVSDelegateInterface *const nvsDelegate, char const *const directory, size_t const threshold,
+    MultiPrinterLoggerInterface *const logger)
+    : m_nvsDelegate(nvsDelegate), m_threshold(threshold), m_logger(logger), m_lastId(0), m_lastIdLoaded(false)
+{
+    memset(m_handles, 0, sizeof(m_handles));
+
+    // An invalid directory is kept empty, and every value stays in the wrapped delegate
+    if (directory == nullptr || strlen(directory) == 0 || strlen(directory) >= TIERED_NVS_DELEGATE_MAX_DIRECTORY_LENGTH)
+    {
+        Log_Error(m_logger, "Invalid directory, values are not tiered");
+        m_directory[0] = '\0';
+    }
+    else
+    {
+        strcpy(m_directory, directory);
+        mkdir(m_directory, 0755);
+    }
+
+    Log_Debug(m_logger, "TieredNVSDelegate created for directory '%s'", m_directory);
+}
+
+TieredNVSDelegate::~TieredNVSDelegate()
+{
+    Log_Debug(m_logger, "TieredNVSDelegate destroyed");
+}
+
+NVSDelegateError_t TieredNVSDelegate::open(
+    char const *const name, NVSDelegateOpenMode_t const open_mode,
+    NVSDelegateHandle_t *out_handle) const
+{
+    NVSDelegateError_t const err = m_nvsDelegate->open(name, open_mode, out_handle);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    // Only writes to files need the namespace; a full table is reported by them
+    DatabaseLockGuard guard(m_handleMutex);
+    for (size_t i = 0; i < TIERED_NVS_DELEGATE_MAX_OPEN_HANDLES; ++i)
+    {
+        if (m_handles[i].name[0] == '\0')
+        {
+            m_handles[i].handle = *out_handle;
+            strcpy(m_handles[i].name, name);
+            break;
+        }
+    }
+    return err;
+}
+
+void TieredNVSDelegate::close(NVSDelegateHandle_t handle) const
+{
+    {
+        DatabaseLockGuard guard(m_handleMutex);
+        for (size_t i = 0; i < TIERED_NVS_DELEGATE_MAX_OPEN_HANDLES; ++i)
+        {
+            if (m_handles[i].name[0] != '\0' && m_handles[i].handle == handle)
+            {
+                m_handles[i].name[0] = '\0';
+                break;
+            }
+        }
+    }
+    m_nvsDelegate->close(handle);
+}
+
+NVSDelegateError_t TieredNVSDelegate::set_str(
+    NVSDelegateHandle_t handle, char const *const key,
+    char const *const value) const
+{
+    // Check if the key and value are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (value == nullptr || strlen(value) == 0 || strlen(value) >= NVS_DELEGATE_MAX_VALUE_LENGTH)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    DatabaseLockGuard guard(m_fileMutex);
+
+    Pointer previous;
+    NVSDelegateError_t err = readPointer(handle, key, &previous);
+    if (err != NVS_DELEGATE_OK && err != NVS_DELEGATE_KEY_NOT_FOUND)
+        return err;
+    bool const hadFile = err == NVS_DELEGATE_OK;
+
+    // The inline value or the pointer record is written before the entry of the other type is erased
+    size_t const valueLength = strlen(value);
+    if (valueLength < m_threshold || m_directory[0] == '\0')
+    {
+        Log_Verbose(m_logger, "TieredNVSDelegate setting key '%s' in NVS", key);
+        err = m_nvsDelegate->set_str(handle, key, value);
+        if (err == NVS_DELEGATE_OK && hadFile)
+            err = NVSDelegateUtils::eraseOtherType(m_nvsDelegate, handle, key, false, value, 0);
+        if (err == NVS_DELEGATE_OK && hadFile)
+            removeFile(previous.id);
+        return err;
+    }
+
+    char name[NVS_DELEGATE_MAX_NAMESPACE_LENGTH];
+    if (!namespaceOf(handle, name))
+        return printAndReturnError(NVS_DELEGATE_HANDLE_INVALID);
+
+    // The new file is complete before the pointer record moves to it
+    Pointer pointer;
+    pointer.length = static_cast<uint32_t>(valueLength);
+    pointer.crc = DatabaseImage::crc32(0, reinterpret_cast<uint8_t const *>(value), valueLength);
+    err = writeFile(name, key, value, valueLength, &pointer.id);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    uint8_t record[TIERED_NVS_DELEGATE_POINTER_LENGTH];
+    record[0] = TIERED_NVS_DELEGATE_FORMAT_FILE;
+    writeU32(record + 1, pointer.id);
+    writeU32(record + 5, pointer.length);
+    writeU32(record + 9, pointer.crc);
+
+    err = m_nvsDelegate->set_blob(handle, key, record, sizeof(record));
+    if (err != NVS_DELEGATE_OK)
+    {
+        removeFile(pointer.id);
+        return err;
+    }
+
+    if (!hadFile)
+        err = NVSDelegateUtils::eraseOtherType(m_nvsDelegate, handle, key, true, record, sizeof(record));
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    if (hadFile)
+        removeFile(previous.id);
+
+    Log_Verbose(m_logger, "TieredNVSDelegate setting key '%s', %zu bytes in file %08x", key, valueLength, (unsigned)pointer.id);
+    return NVS_DELEGATE_OK;
+}
+
+NVSDelegateError_t TieredNVSDelegate::get_str(
+    NVSDelegateHandle_t handle, char const *const key,
+    char *out_value, size_t *length) const
+{
+    // Check if the key and the length pointer are valid
+    if (!isKeyValid(key))
+        return printAndReturnError(NVS_DELEGATE_KEY_INVALID);
+
+    if (length == nullptr)
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+
+    // Values kept in NVS are the common case
+    NVSDelegateError_t err = m_nvsDelegate->get_str(handle, key, out_value, length);
+    if (err != NVS_DELEGATE_KEY_NOT_FOUND)
+        return err;
+
+    Pointer pointer;
+    err = readPointer(handle, key, &pointer);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    if (!NVSDelegateUtils::fitsString(out_value, *length, pointer.length))
+        return printAndReturnError(NVS_DELEGATE_VALUE_INVALID);
+    if (out_value == nullptr)
+    {
+        *length = pointer.length + 1;
+        return NVS_DELEGATE_OK;
+    }
+
+    Log_Verbose(m_logger, "TieredNVSDelegate getting key '%s' from file %08x", key, (unsigned)pointer.id);
+
+    char path[TIERED_NVS_DELEGATE_MAX_PATH_LENGTH];
+    filePath(pointer.id, path);
+    FILE *const file = fopen(path, "rb");
+    if (file == nullptr)
+        return printAndReturnError(NVS_DELEGATE_UNKOWN_ERROR);
+
+    // Read past the header straight into the caller's buffer, then check it
+    bool const read = fseek(file, TIERED_NVS_DELEGATE_FILE_HEADER_LENGTH, SEEK_SET) == 0 &&
+                      fread(out_value, 1, pointer.length, file) == pointer.length;
+    fclose(file);
+    if (!read || DatabaseImage::crc32(0, reinterpret_cast<uint8_t const *>(out_value), pointer.length) != pointer.crc)
+    {
+        out_value[0] = '\0';
+        return printAndReturnError(NVS_DELEGATE_UNKOWN_ERROR);
+    }
+
+    out_value[pointer.length] = '\0';
+    *length = pointer.length + 1;
+    return NVS_DELEGATE_OK;
+}
+
+NVSDelegateError_t TieredNVSDelegate::set_i64(
+    NVSDelegateHandle_t handle, char const *const key, int64_t const value) const
+{
+    return m_nvsDelegate->set_i64(handle, key, value);
+}
+
+NVSDelegateError_t TieredNVSDelegate::get_i64(
+    NVSDelegateHandle_t handle, char const *const key, int64_t *out_value) const
+{
+    return m_nvsDelegate->get_i64(handle, key, out_value);
+}
+
+NVSDelegateError_t TieredNVSDelegate::set_blob(
+    NVSDelegateHandle_t handle, char const *const key,
+    void const *const value, size_t const length) const
+{
+    return m_nvsDelegate->set_blob(handle, key, value, length);
+}
+
+NVSDelegateError_t TieredNVSDelegate::get_blob(
+    NVSDelegateHandle_t handle, char const *const key,
+    void *out_value, size_t *length) const
+{
+    return m_nvsDelegate->get_blob(handle, key, out_value, length);
+}
+
+NVSDelegateError_t TieredNVSDelegate::erase_key(
+    NVSDelegateHandle_t handle, char const *const key) const
+{
+    DatabaseLockGuard guard(m_fileMutex);
+
+    Pointer pointer;
+    bool const hadFile = readPointer(handle, key, &pointer) == NVS_DELEGATE_OK;
+
+    NVSDelegateError_t const err = m_nvsDelegate->erase_key(handle, key);
+    if (err == NVS_DELEGATE_OK && hadFile)
+        removeFile(pointer.id);
+    return err;
+}
+
+NVSDelegateError_t TieredNVSDelegate::erase_all(NVSDelegateHandle_t handle) const
+{
+    NVSDelegateError_t const err = m_nvsDelegate->erase_all(handle);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+
+    // The files of the namespace have no pointer record any more
+    removeOrphans();
+    return err;
+}
+
+NVSDelegateError_t TieredNVSDelegate::erase_flash_all() const
+{
+    NVSDelegateError_t const err = m_nvsDelegate->erase_flash_all();
+    if (err != NVS_DELEGATE_OK || m_directory[0] == '\0')
+        return err;
+
+    DatabaseLockGuard guard(m_fileMutex);
+
+    // Every file of the directory is removed, whatever namespace it belongs to
+    DIR *const directory = opendir(m_directory);
+    if (directory == nullptr)
+        return err;
+    uint32_t ids[TIERED_NVS_DELEGATE_ORPHAN_BATCH];
+    size_t count;
+    do
+    {
+        count = 0;
+        rewinddir(directory);
+        struct dirent *entry;
+        while (count < TIERED_NVS_DELEGATE_ORPHAN_BATCH && (entry = readdir(directory)) != nullptr)
+            if (parseFileName(entry->d_name, &ids[count]))
+                count++;
+        for (size_t i = 0; i < count; ++i)
+            removeFile(ids[i]);
+    } while (count == TIERED_NVS_DELEGATE_ORPHAN_BATCH);
+    closedir(directory);
+
+    m_lastId = 0;
+    m_lastIdLoaded = true;
+    return err;
+}
+
+NVSDelegateError_t TieredNVSDelegate::commit(NVSDelegateHandle_t handle) const
+{
+    return m_nvsDelegate->commit(handle);
+}
+
+NVSDelegateError_t TieredNVSDelegate::list_keys(
+    char const *const name, NVSDelegateKeyCallback_t callback, void *context) const
+{
+    return m_nvsDelegate->list_keys(name, callback, context);
+}
+
+NVSDelegateError_t TieredNVSDelegate::get_stats(NVSDelegateStats_t *out_stats) const
+{
+    return m_nvsDelegate->get_stats(out_stats);
+}
+
+NVSDelegateError_t TieredNVSDelegate::get_used_entries(NVSDelegateHandle_t handle, size_t *out_entries) const
+{
+    return m_nvsDelegate->get_used_entries(handle, out_entries);
+}
+
+NVSDelegateError_t TieredNVSDelegate::removeOrphans(size_t *out_removed) const
+{
+    if (out_removed)
+        *out_removed = 0;
+    if (m_directory[0] == '\0')
+        return NVS_DELEGATE_OK;
+
+    DatabaseLockGuard guard(m_fileMutex);
+
+    DIR *const directory = opendir(m_directory);
+    if (directory == nullptr)
+        return printAndReturnError(NVS_DELEGATE_UNKOWN_ERROR);
+
+    // Orphans are collected per batch, so no file is removed while the directory is read
+    uint32_t orphans[TIERED_NVS_DELEGATE_ORPHAN_BATCH];
+    size_t count;
+    do
+    {
+        count = 0;
+        rewinddir(directory);
+        struct dirent *entry;
+        while (count < TIERED_NVS_DELEGATE_ORPHAN_BATCH && (entry = readdir(directory)) != nullptr)
+        {
+            uint32_t id = 0;
+            if (parseFileName(entry->d_name, &id) && !isReferenced(id))
+                orphans[count++] = id;
+        }
+        for (size_t i = 0; i < count; ++i)
+            removeFile(orphans[i]);
+        if (out_removed)
+            *out_removed += count;
+    } while (count == TIERED_NVS_DELEGATE_ORPHAN_BATCH);
+    closedir(directory);
+
+    return NVS_DELEGATE_OK;
+}
+
+NVSDelegateError_t TieredNVSDelegate::readPointer(
+    NVSDelegateHandle_t const handle, char const *const key, Pointer *out_pointer) const
+{
+    uint8_t record[TIERED_NVS_DELEGATE_POINTER_LENGTH];
+    size_t length = sizeof(record);
+
+    // Any other blob under the key is not a pointer record
+    size_t stored = 0;
+    NVSDelegateError_t err = m_nvsDelegate->get_blob(handle, key, nullptr, &stored);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+    if (stored != sizeof(record))
+        return NVS_DELEGATE_KEY_NOT_FOUND;
+
+    err = m_nvsDelegate->get_blob(handle, key, record, &length);
+    if (err != NVS_DELEGATE_OK)
+        return err;
+    if (length != sizeof(record) || record[0] != TIERED_NVS_DELEGATE_FORMAT_FILE)
+        return NVS_DELEGATE_KEY_NOT_FOUND;
+
+    out_pointer->id = readU32(record + 1);
+    out_pointer->length = readU32(record + 5);
+    out_pointer->crc = readU32(record + 9);
+    return NVS_DELEGATE_OK;
+}
+
+bool TieredNVSDelegate::namespaceOf(NVSDelegateHandle_t const handle, char *name) const
+{
+    DatabaseLockGuard guard(m_handleMutex);
+    for (size_t i = 0; i < TIERED_NVS_DELEGATE_MAX_OPEN_HANDLES; ++i)
+    {
+        if (m_handles[i].name[0] != '\0' && m_handles[i].handle == handle)
+        {
+            strcpy(name, m_handles[i].name);
+            return true;
+        }
+    }
+    return false;
+}
+
+NVSDelegateError_t TieredNVSDelegate::writeFile(
+    char const *const name, char const *const key, char const *const value, size_t const length,
+    uint32_t *out_id) const
+{
+    // Ids continue after the highest one in the directory, read once
+    if (!m_lastIdLoaded)
+    {
+        DIR *const directory = opendir(m_directory);
+        if (directory == nullptr)
+            return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+        struct dirent *entry;
+        while ((entry = readdir(directory)) != nullptr)
+        {
+            uint32_t id = 0;
+            if (parseFileName(entry->d_name, &id) && id > m_lastId)
+                m_lastId = id;
+        }
+        closedir(directory);
+        m_lastIdLoaded = true;
+    }
+    uint32_t const id = ++m_lastId;
+
+    uint8_t header[TIERED_NVS_DELEGATE_FILE_HEADER_LENGTH] = {0};
+    memcpy(header, TIERED_NVS_DELEGATE_FILE_MAGIC, TIERED_NVS_DELEGATE_FILE_MAGIC_LENGTH);
+    strcpy(reinterpret_cast<char *>(header) + TIERED_NVS_DELEGATE_FILE_MAGIC_LENGTH, name);
+    strcpy(reinterpret_cast<char *>(header) + TIERED_NVS_DELEGATE_FILE_MAGIC_LENGTH + NVS_DELEGATE_MAX_NAMESPACE_LENGTH, key);
+
+    char path[TIERED_NVS_DELEGATE_MAX_PATH_LENGTH];
+    filePath(id, path);
+    FILE *const file = fopen(path, "wb");
+    if (file == nullptr)
+        return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+
+    bool const written = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+                         fwrite(value, 1, length, file) == length;
+    if (fclose(file) != 0 || !written)
+    {
+        remove(path);
+        return printAndReturnError(NVS_DELEGATE_NOT_ENOUGH_SPACE);
+    }
+
+    *out_id = id;
+    return NVS_DELEGATE_OK;
+}
+
+bool TieredNVSDelegate::isReferenced(uint32_t const id) const
+{
+    char path[TIERED_NVS_DELEGATE_MAX_PATH_LENGTH];
+    filePath(id, path);
+    FILE *const file = fopen(path, "rb");
+    if (file == nullptr)
+        return true;
+
+    uint8_t header[TIERED_NVS_DELEGATE_FILE_HEADER_LENGTH + 1] = {0};
+    bool const read = fread(header, 1, TIERED_NVS_DELEGATE_FILE_HEADER_LENGTH, file) == TIERED_NVS_DELEGATE_FILE_HEADER_LENGTH;
+    fclose(file);
+
+    // A file cut short before its header was complete is left by an interrupted write
+    if (!read || memcmp(header, TIERED_NVS_DELEGATE_FILE_MAGIC, TIERED_NVS_DELEGATE_FILE_MAGIC_LENGTH) != 0)
+        return false;
+
+    char name[NVS_DELEGATE_MAX_NAMESPACE_LENGTH] = {0};
+    char key[NVS_DELEGATE_MAX_KEY_LENGTH] = {0};
+    memcpy(name, header + TIERED_NVS_DELEGATE_FILE_MAGIC_LENGTH, sizeof(name) - 1);
+    memcpy(key, header + TIERED_NVS_DELEGATE_FILE_MAGIC_LENGTH + NVS_DELEGATE_MAX_NAMESPACE_LENGTH, sizeof(key) - 1);
+
+    NVSDelegateHandle_t handle = 0;
+    NVSDelegateError_t err = m_nvsDelegate->open(name, NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+        return false;
+    if (err != NVS_DELEGATE_OK)
+        return true;
+
+    Pointer pointer;
+    err = readPointer(handle, key, &pointer);
+    m_nvsDelegate->close(handle);
+
+    if (err == NVS_DELEGATE_KEY_NOT_FOUND)
+        return false;
+    return err != NVS_DELEGATE_OK || pointer.id == id;
+}
+
+void TieredNVSDelegate::filePath(uint32_t const id, char *path) const
+{
+    snprintf(path, TIERED_NVS_DELEGATE_MAX_PATH_LENGTH, "%s/%08x", m_directory, static_cast<unsigned>(id));
+}
+
+void TieredNVSDelegate::removeFile(uint32_t const id) const
+{
+    char path[TIERED_NVS_DELEGATE_MAX_PATH_LENGTH];
+    filePath(id, path);
+    if (remove(path) != 0)
+        Log_Error(m_logger, "TieredNVSDelegate could not remove file '%s'", path);
+}
+
+NVSDelegateError_t TieredNVSDelegate::printAndReturnError(NVSDelegateError_t const error) const
+{
+    switch (error)
+    {
+    case NVS_DELEGATE_OK:
+        break;
+    case NVS_DELEGATE_KEY_INVALID:
+        Log_Error(m_logger, "Invalid key");
+        break;
+    case NVS_DELEGATE_VALUE_INVALID:
+        Log_Error(m_logger, "Invalid value");
+        break;
+    case NVS_DELEGATE_HANDLE_INVALID:
+        Log_Error(m_logger, "Namespace of the handle unknown");
+        break;
+    case NVS_DELEGATE_NOT_ENOUGH_SPACE:
+        Log_Error(m_logger, "Not enough space");
+        break;
+    default:
+        Log_Error(m_logger, "Unknown error");
+        break;
+    }
+
+    return error;
+}
+
+bool TieredNVSDelegate::isKeyValid(const char *const key) const
+{
+    return key && strlen(key) > 0 && strlen(key) < NVS_DELEGATE_MAX_KEY_LENGTH;
+}
@@ -0,0 +1,125 @@
+#ifndef BENCHMARK_IMPORT_BENCHMARK_HPP
+#define BENCHMARK_IMPORT_BENCHMARK_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "../test_Unit/FaultInjectingNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseImage.hpp"
+
+#ifndef BENCHMARK_IMPORT_KEYS
+#define BENCHMARK_IMPORT_KEYS 200
+#endif
+
+// Image held in a heap buffer, sized for BENCHMARK_IMPORT_KEYS values
+struct BenchmarkImage
+{
+    uint8_t *data;
+    size_t capacity;
+    size_t length;
+    size_t position;
+};
+
+// setup benchmark suite
+class ImportBenchmark : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        faultInjectingNVSDelegate = new FaultInjectingNVSDelegate();
+        faultInjectingNVSDelegate->failStats = true; // benchmarks measure commits, not capacity
+        image.capacity = 64 * BENCHMARK_IMPORT_KEYS;
+        image.data = static_cast<uint8_t *>(malloc(image.capacity));
+        image.length = 0;
+        image.position = 0;
+    }
+
+    void TearDown() override
+    {
+        free(image.data);
+        delete faultInjectingNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    static bool writeImage(uint8_t const *const data, size_t const length, void *context)
+    {
+        BenchmarkImage *const target = static_cast<BenchmarkImage *>(context);
+        if (target->length + length > target->capacity)
+            return false;
+        memcpy(target->data + target->length, data, length);
+        target->length += length;
+        return true;
+    }
+
+    static bool readImage(uint8_t *data, size_t const length, void *context)
+    {
+        BenchmarkImage *const source = static_cast<BenchmarkImage *>(context);
+        if (source->position + length > source->length)
+            return false;
+        memcpy(data, source->data + source->position, length);
+        source->position += length;
+        return true;
+    }
+
+    FaultInjectingNVSDelegate *faultInjectingNVSDelegate;
+    BenchmarkImage image;
+};
+
+/** Benchmarking importNamespace Method of DatabaseAPI class
+ * @brief Provisioning BENCHMARK_IMPORT_KEYS values with one set per key, then from an image.
+ */
+
+TEST_F(ImportBenchmark, provisioning)
+{
+    // arrange
+    char key[16];
+    char value[32];
+    int failures = 0;
+    DatabaseAPI source(faultInjectingNVSDelegate, "source");
+    DatabaseAPI target(faultInjectingNVSDelegate, "target");
+
+    // act
+    faultInjectingNVSDelegate->commits = 0;
+    unsigned long start = micros();
+    for (int i = 0; i < BENCHMARK_IMPORT_KEYS; i++)
+    {
+        snprintf(key, sizeof(key), "cfg%d", i);
+        snprintf(value, sizeof(value), "factory value %d", i);
+        if (source.set(key, value) != DATABASE_OK)
+            failures++;
+    }
+    unsigned long const setElapsed = micros() - start;
+    unsigned long const setCommits = faultInjectingNVSDelegate->commits;
+
+    ASSERT_EQ(source.exportNamespace(writeImage, &image), DatabaseError_t::DATABASE_OK);
+
+    faultInjectingNVSDelegate->commits = 0;
+    start = micros();
+    DatabaseError_t const err = target.importNamespace(readImage, &image);
+    unsigned long const importElapsed = micros() - start;
+    unsigned long const importCommits = faultInjectingNVSDelegate->commits;
+
+    Serial.printf("%d keys, set per key: %4lu commits, %7lu us\n", BENCHMARK_IMPORT_KEYS, setCommits, setElapsed);
+    Serial.printf("%d keys, import     : %4lu commits, %7lu us, image of %u bytes\n",
+                  BENCHMARK_IMPORT_KEYS, importCommits, importElapsed, (unsigned)image.length);
+
+    // assert
+    EXPECT_EQ(failures, 0);
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(setCommits, (unsigned long)BENCHMARK_IMPORT_KEYS);
+    EXPECT_EQ(importCommits, 1UL);
+    EXPECT_EQ(target.isExist("cfg199"), DatabaseError_t::DATABASE_OK);
+}
+
+#endif // BENCHMARK_IMPORT_BENCHMARK_HPP
@@ -0,0 +1,126 @@
+#ifndef BENCHMARK_JOB_BENCHMARK_HPP
+#define BENCHMARK_JOB_BENCHMARK_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "NVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseJob.hpp"
+
+#ifndef BENCHMARK_JOB_KEY_COUNT
+#define BENCHMARK_JOB_KEY_COUNT 100
+#endif
+
+#ifndef BENCHMARK_JOB_BUDGET_US
+#define BENCHMARK_JOB_BUDGET_US 2000
+#endif
+
+// setup benchmark suite
+class JobBenchmark : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        nvsDelegate = new NVSDelegate();
+        databaseAPI = new DatabaseAPI(nvsDelegate, "bench_job");
+    }
+
+    void TearDown() override
+    {
+        databaseAPI->eraseAll();
+        delete databaseAPI;
+        delete nvsDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Stages BENCHMARK_JOB_KEY_COUNT values of 32 characters
+    void stage(DatabaseBatch &batch, char const *const prefix)
+    {
+        char key[16];
+        char value[33];
+        for (int i = 0; i < BENCHMARK_JOB_KEY_COUNT; i++)
+        {
+            snprintf(key, sizeof(key), "%s%d", prefix, i);
+            snprintf(value, sizeof(value), "%s-%027d", prefix, i);
+            batch.set(key, value);
+        }
+    }
+
+    // Steps a job to completion, returns the number of steps and the longest one in microseconds
+    void run(DatabaseJob &job, size_t *steps, unsigned long *longest, int *failures)
+    {
+        *steps = 0;
+        *longest = 0;
+        while (!job.isDone())
+        {
+            unsigned long const start = micros();
+            if (job.step(BENCHMARK_JOB_BUDGET_US) != DATABASE_OK)
+                (*failures)++;
+            unsigned long const elapsed = micros() - start;
+            if (elapsed > *longest)
+                *longest = elapsed;
+            (*steps)++;
+        }
+    }
+
+    DatabaseAPI *databaseAPI;
+    NVSDelegate *nvsDelegate;
+};
+
+/** Benchmarking DatabaseJob class
+ * @brief Latency of a bulk write and a namespace erase in one call, and of the longest step of the same job.
+ */
+
+TEST_F(JobBenchmark, stepLatency)
+{
+    // arrange
+    DatabaseBatch batch;
+    DatabaseJob job;
+    int failures = 0;
+    size_t commitSteps, eraseSteps;
+    unsigned long commitLongest, eraseLongest;
+
+    // act
+    stage(batch, "a");
+    unsigned long start = micros();
+    if (databaseAPI->commit(batch, false) != DATABASE_OK)
+        failures++;
+    unsigned long const commitElapsed = micros() - start;
+
+    start = micros();
+    if (databaseAPI->eraseAll() != DATABASE_OK)
+        failures++;
+    unsigned long const eraseElapsed = micros() - start;
+
+    batch.clear();
+    stage(batch, "b");
+    if (databaseAPI->startCommit(batch, &job) != DATABASE_OK)
+        failures++;
+    run(job, &commitSteps, &commitLongest, &failures);
+
+    if (databaseAPI->startEraseAll(&job) != DATABASE_OK)
+        failures++;
+    run(job, &eraseSteps, &eraseLongest, &failures);
+
+    Serial.printf("%d keys, commit  : one call %7lu us | %3u steps of %u us, longest %6lu us\n",
+                  BENCHMARK_JOB_KEY_COUNT, commitElapsed, (unsigned)commitSteps, BENCHMARK_JOB_BUDGET_US, commitLongest);
+    Serial.printf("%d keys, eraseAll: one call %7lu us | %3u steps of %u us, longest %6lu us\n",
+                  BENCHMARK_JOB_KEY_COUNT, eraseElapsed, (unsigned)eraseSteps, BENCHMARK_JOB_BUDGET_US, eraseLongest);
+
+    // assert
+    EXPECT_EQ(failures, 0);
+    EXPECT_EQ(databaseAPI->isExist("b0"), DATABASE_KEY_NOT_FOUND);
+}
+
+#endif // BENCHMARK_JOB_BENCHMARK_HPP
@@ -0,0 +1,117 @@
+#ifndef BENCHMARK_PACKING_BENCHMARK_HPP
+#define BENCHMARK_PACKING_BENCHMARK_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "MemoryNVSDelegate.hpp"
+#include "PackedNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+
+#ifndef BENCHMARK_PACKED_KEY_COUNT
+#define BENCHMARK_PACKED_KEY_COUNT 256
+#endif
+
+// setup benchmark suite, the same small values stored with and without packing
+class PackingBenchmark : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        plainNVSDelegate = new MemoryNVSDelegate();
+        packedMemoryNVSDelegate = new MemoryNVSDelegate();
+        packedNVSDelegate = new PackedNVSDelegate(packedMemoryNVSDelegate);
+        plainDatabaseAPI = new DatabaseAPI(plainNVSDelegate, "bench");
+        packedDatabaseAPI = new DatabaseAPI(packedNVSDelegate, "bench");
+    }
+
+    void TearDown() override
+    {
+        delete packedDatabaseAPI;
+        delete plainDatabaseAPI;
+        delete packedNVSDelegate;
+        delete packedMemoryNVSDelegate;
+        delete plainNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Sets then reads BENCHMARK_PACKED_KEY_COUNT flags of 2 to 8 characters,
+    // returns the elapsed times in microseconds
+    void run(DatabaseAPI *databaseAPI, unsigned long *setTime, unsigned long *getTime, int *failures)
+    {
+        char key[16];
+        char value[16];
+
+        unsigned long start = micros();
+        for (int i = 0; i < BENCHMARK_PACKED_KEY_COUNT; i++)
+        {
+            snprintf(key, sizeof(key), "flag%d", i);
+            snprintf(value, sizeof(value), "%.*s", 2 + i % 7, "12345678");
+            if (databaseAPI->set(key, value) != DATABASE_OK)
+                (*failures)++;
+        }
+        *setTime = micros() - start;
+
+        start = micros();
+        for (int i = 0; i < BENCHMARK_PACKED_KEY_COUNT; i++)
+        {
+            snprintf(key, sizeof(key), "flag%d", i);
+            if (databaseAPI->get(key, value, sizeof(value)) != DATABASE_OK || strlen(value) != (size_t)(2 + i % 7))
+                (*failures)++;
+        }
+        *getTime = micros() - start;
+    }
+
+    DatabaseAPI *plainDatabaseAPI;
+    DatabaseAPI *packedDatabaseAPI;
+    PackedNVSDelegate *packedNVSDelegate;
+    MemoryNVSDelegate *packedMemoryNVSDelegate;
+    MemoryNVSDelegate *plainNVSDelegate;
+};
+
+/** Benchmarking PackedNVSDelegate class
+ * @brief NVS entries used per logical key, and set/get time, with and without packing.
+ */
+
+TEST_F(PackingBenchmark, smallValues)
+{
+    // arrange
+    unsigned long plainSet, plainGet, packedSet, packedGet;
+    int failures = 0;
+    PackedNVSDelegateReport_t plainReport;
+    PackedNVSDelegateReport_t packedReport;
+    PackedNVSDelegate plainReporter(plainNVSDelegate); // only used to count the entries of the plain namespace
+
+    // act
+    run(plainDatabaseAPI, &plainSet, &plainGet, &failures);
+    run(packedDatabaseAPI, &packedSet, &packedGet, &failures);
+    ASSERT_EQ(plainReporter.getSpaceReport("bench", &plainReport), NVSDelegateError_t::NVS_DELEGATE_OK);
+    ASSERT_EQ(packedNVSDelegate->getSpaceReport("bench", &packedReport), NVSDelegateError_t::NVS_DELEGATE_OK);
+
+    Serial.printf("plain : %3u keys, %4u entries, %.2f entries/key, set %6lu us, get %6lu us\n",
+                  (unsigned)plainReport.logicalKeys, (unsigned)plainReport.entries,
+                  (double)plainReport.entries / plainReport.logicalKeys, plainSet, plainGet);
+    Serial.printf("packed: %3u keys, %4u entries, %.2f entries/key, set %6lu us, get %6lu us (%u keys in %u buckets)\n",
+                  (unsigned)packedReport.logicalKeys, (unsigned)packedReport.entries,
+                  (double)packedReport.entries / packedReport.logicalKeys, packedSet, packedGet,
+                  (unsigned)packedReport.packedKeys, (unsigned)packedReport.buckets);
+
+    // assert
+    EXPECT_EQ(failures, 0);
+    EXPECT_EQ(plainReport.logicalKeys, (size_t)BENCHMARK_PACKED_KEY_COUNT);
+    EXPECT_EQ(packedReport.logicalKeys, (size_t)BENCHMARK_PACKED_KEY_COUNT);
+    EXPECT_EQ(packedReport.unpackedEntries, plainReport.entries);
+    EXPECT_LT(packedReport.entries, plainReport.entries);
+}
+
+#endif // BENCHMARK_PACKING_BENCHMARK_HPP
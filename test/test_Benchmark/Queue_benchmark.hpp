@@ -0,0 +1,117 @@
+#ifndef BENCHMARK_QUEUE_BENCHMARK_HPP
+#define BENCHMARK_QUEUE_BENCHMARK_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "../test_Unit/FaultInjectingNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseQueue.hpp"
+
+#ifndef BENCHMARK_QUEUE_MESSAGES
+#define BENCHMARK_QUEUE_MESSAGES 200
+#endif
+
+#ifndef BENCHMARK_QUEUE_BATCH
+#define BENCHMARK_QUEUE_BATCH 20
+#endif
+
+// setup benchmark suite
+class QueueBenchmark : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        faultInjectingNVSDelegate = new FaultInjectingNVSDelegate();
+        faultInjectingNVSDelegate->failStats = true; // benchmarks measure commits, not capacity
+        databaseAPI = new DatabaseAPI(faultInjectingNVSDelegate, "TEST_NVS");
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete faultInjectingNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    static bool publish(char const *const message, void *context)
+    {
+        (*static_cast<int *>(context))++;
+        return message[0] != '\0';
+    }
+
+    FaultInjectingNVSDelegate *faultInjectingNVSDelegate;
+    DatabaseAPI *databaseAPI;
+};
+
+/** Benchmarking DatabaseQueue class
+ * @brief Buffering BENCHMARK_QUEUE_MESSAGES messages one by one, then in batches, and draining them in batches.
+ */
+
+TEST_F(QueueBenchmark, storeAndForward)
+{
+    // arrange
+    char texts[BENCHMARK_QUEUE_BATCH][64];
+    char const *messages[BENCHMARK_QUEUE_BATCH];
+    for (int i = 0; i < BENCHMARK_QUEUE_BATCH; i++)
+    {
+        snprintf(texts[i], sizeof(texts[i]), "{\"topic\":\"sensors/%d\",\"value\":%d}", i, 1000 + i);
+        messages[i] = texts[i];
+    }
+    int failures = 0;
+    int published = 0;
+    DatabaseQueue queue(databaseAPI, "mq", BENCHMARK_QUEUE_MESSAGES, 64);
+    ASSERT_EQ(queue.begin(), DatabaseError_t::DATABASE_OK);
+
+    // act
+    faultInjectingNVSDelegate->commits = 0;
+    unsigned long start = micros();
+    for (int i = 0; i < BENCHMARK_QUEUE_MESSAGES; i++)
+        if (queue.enqueue(messages[i % BENCHMARK_QUEUE_BATCH]) != DATABASE_OK)
+            failures++;
+    unsigned long const singleElapsed = micros() - start;
+    unsigned long const singleCommits = faultInjectingNVSDelegate->commits;
+
+    faultInjectingNVSDelegate->commits = 0;
+    start = micros();
+    while (queue.size() > 0)
+        if (queue.dequeue(publish, &published, BENCHMARK_QUEUE_BATCH) != DATABASE_OK)
+            failures++;
+    unsigned long const dequeueElapsed = micros() - start;
+    unsigned long const dequeueCommits = faultInjectingNVSDelegate->commits;
+
+    faultInjectingNVSDelegate->commits = 0;
+    start = micros();
+    for (int i = 0; i < BENCHMARK_QUEUE_MESSAGES / BENCHMARK_QUEUE_BATCH; i++)
+        if (queue.enqueue(messages, BENCHMARK_QUEUE_BATCH) != DATABASE_OK)
+            failures++;
+    unsigned long const batchElapsed = micros() - start;
+    unsigned long const batchCommits = faultInjectingNVSDelegate->commits;
+
+    Serial.printf("%d messages, enqueue one by one    : %4lu commits, %7lu us\n",
+                  BENCHMARK_QUEUE_MESSAGES, singleCommits, singleElapsed);
+    Serial.printf("%d messages, enqueue in batches %2d: %4lu commits, %7lu us\n",
+                  BENCHMARK_QUEUE_MESSAGES, BENCHMARK_QUEUE_BATCH, batchCommits, batchElapsed);
+    Serial.printf("%d messages, dequeue in batches %2d: %4lu commits, %7lu us\n",
+                  BENCHMARK_QUEUE_MESSAGES, BENCHMARK_QUEUE_BATCH, dequeueCommits, dequeueElapsed);
+
+    // assert
+    EXPECT_EQ(failures, 0);
+    EXPECT_EQ(published, BENCHMARK_QUEUE_MESSAGES);
+    EXPECT_EQ(singleCommits, (unsigned long)BENCHMARK_QUEUE_MESSAGES);
+    EXPECT_EQ(batchCommits, (unsigned long)(BENCHMARK_QUEUE_MESSAGES / BENCHMARK_QUEUE_BATCH));
+    EXPECT_EQ(dequeueCommits, (unsigned long)(BENCHMARK_QUEUE_MESSAGES / BENCHMARK_QUEUE_BATCH));
+    EXPECT_EQ(queue.size(), (size_t)BENCHMARK_QUEUE_MESSAGES);
+}
+
+#endif // BENCHMARK_QUEUE_BENCHMARK_HPP
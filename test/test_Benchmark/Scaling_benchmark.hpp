@@ -0,0 +1,128 @@
+#ifndef BENCHMARK_SCALING_BENCHMARK_HPP
+#define BENCHMARK_SCALING_BENCHMARK_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "MemoryNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+
+#ifndef BENCHMARK_MAX_THREADS
+#define BENCHMARK_MAX_THREADS 4
+#endif
+
+#ifndef BENCHMARK_OPERATIONS_PER_THREAD
+#define BENCHMARK_OPERATIONS_PER_THREAD 2000
+#endif
+
+#define BENCHMARK_KEY_COUNT 64
+
+// setup benchmark suite, the parameter is the percentage of reads
+class ScalingBenchmark : public ::testing::TestWithParam<int>
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        // the in-memory delegate keeps the backend out of the measurement
+        memoryNVSDelegate = new MemoryNVSDelegate();
+        databaseAPI = new DatabaseAPI(memoryNVSDelegate, "bench");
+
+        char key[16];
+        for (int i = 0; i < BENCHMARK_KEY_COUNT; i++)
+        {
+            snprintf(key, sizeof(key), "key%d", i);
+            databaseAPI->set(key, "initial");
+        }
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete memoryNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Runs BENCHMARK_OPERATIONS_PER_THREAD random operations on each of the given number of threads,
+    // returns the elapsed time in microseconds
+    unsigned long run(int threads, int readPercent, std::atomic<int> &failures)
+    {
+        std::vector<std::thread> workers;
+        unsigned long const start = micros();
+
+        for (int t = 0; t < threads; t++)
+        {
+            workers.push_back(std::thread(
+                [this, t, readPercent, &failures]()
+                {
+                    uint32_t random = 2463534242u + t; // xorshift32 state, one per thread
+                    char key[16];
+                    char value[16];
+                    for (int i = 0; i < BENCHMARK_OPERATIONS_PER_THREAD; i++)
+                    {
+                        random ^= random << 13;
+                        random ^= random >> 17;
+                        random ^= random << 5;
+                        snprintf(key, sizeof(key), "key%u", (unsigned)(random % BENCHMARK_KEY_COUNT));
+
+                        DatabaseError_t err;
+                        if ((int)((random >> 8) % 100) < readPercent)
+                            err = databaseAPI->get(key, value, sizeof(value));
+                        else
+                        {
+                            snprintf(value, sizeof(value), "%d", i);
+                            err = databaseAPI->set(key, value);
+                        }
+                        if (err != DATABASE_OK)
+                            failures++;
+                    }
+                }));
+        }
+        for (size_t i = 0; i < workers.size(); i++)
+            workers[i].join();
+
+        return micros() - start;
+    }
+
+    DatabaseAPI *databaseAPI;
+    MemoryNVSDelegate *memoryNVSDelegate;
+};
+
+/** Benchmarking DatabaseAPI class
+ * @brief Throughput of one shared DatabaseAPI from 1 to BENCHMARK_MAX_THREADS threads.
+ */
+
+TEST_P(ScalingBenchmark, mixedReadWrite)
+{
+    int const readPercent = GetParam();
+
+    for (int threads = 1; threads <= BENCHMARK_MAX_THREADS; threads++)
+    {
+        // act
+        std::atomic<int> failures(0);
+        unsigned long const elapsed = run(threads, readPercent, failures);
+        unsigned long const operations = (unsigned long)threads * BENCHMARK_OPERATIONS_PER_THREAD;
+
+        Serial.printf("reads %3d%% threads %d: %7lu ops/s (%lu us)\n",
+                      readPercent, threads, elapsed ? (unsigned long)(operations * 1000000ULL / elapsed) : 0UL, elapsed);
+
+        // assert
+        EXPECT_EQ(failures.load(), 0);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(ReadPercent, ScalingBenchmark, ::testing::Values(100, 90, 50, 0));
+
+#endif // BENCHMARK_SCALING_BENCHMARK_HPP
@@ -0,0 +1,127 @@
+#ifndef BENCHMARK_TIERED_BENCHMARK_HPP
+#define BENCHMARK_TIERED_BENCHMARK_HPP
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <gtest/gtest.h>
+
+#include "NVSDelegate.hpp"
+#include "TieredNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+
+#ifndef BENCHMARK_TIERED_DIRECTORY
+#define BENCHMARK_TIERED_DIRECTORY "/littlefs/bench"
+#endif
+
+#ifndef BENCHMARK_TIERED_ITERATIONS
+#define BENCHMARK_TIERED_ITERATIONS 20
+#endif
+
+#define BENCHMARK_TIERED_MAX_LENGTH 4000
+
+// setup benchmark suite, the same values stored in NVS only and with large ones tiered to files
+class TieredBenchmark : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+
+    // Mounted once, before any heap is measured
+    static void SetUpTestSuite()
+    {
+        LittleFS.begin(true);
+    }
+
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        nvsDelegate = new NVSDelegate();
+        tieredNVSDelegate = new TieredNVSDelegate(nvsDelegate, BENCHMARK_TIERED_DIRECTORY);
+        plainDatabaseAPI = new DatabaseAPI(nvsDelegate, "bench_plain");
+        tieredDatabaseAPI = new DatabaseAPI(tieredNVSDelegate, "bench_tier");
+        value = static_cast<char *>(malloc(BENCHMARK_TIERED_MAX_LENGTH + 1));
+        readBack = static_cast<char *>(malloc(BENCHMARK_TIERED_MAX_LENGTH + 1));
+    }
+
+    void TearDown() override
+    {
+        plainDatabaseAPI->eraseAll();
+        tieredDatabaseAPI->eraseAll();
+        free(readBack);
+        free(value);
+        delete tieredDatabaseAPI;
+        delete plainDatabaseAPI;
+        delete tieredNVSDelegate;
+        delete nvsDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Sets then reads a value of the given length BENCHMARK_TIERED_ITERATIONS times,
+    // returns the average times in microseconds
+    void run(DatabaseAPI *databaseAPI, size_t length, unsigned long *setTime, unsigned long *getTime, int *failures)
+    {
+        for (size_t i = 0; i < length; i++)
+            value[i] = 'a' + i % 26;
+        value[length] = '\0';
+
+        unsigned long start = micros();
+        for (int i = 0; i < BENCHMARK_TIERED_ITERATIONS; i++)
+        {
+            value[0] = 'A' + i % 26; // a changed value, so no write is skipped
+            if (databaseAPI->set("value", value) != DATABASE_OK)
+                (*failures)++;
+        }
+        *setTime = (micros() - start) / BENCHMARK_TIERED_ITERATIONS;
+
+        start = micros();
+        for (int i = 0; i < BENCHMARK_TIERED_ITERATIONS; i++)
+        {
+            if (databaseAPI->get("value", readBack, BENCHMARK_TIERED_MAX_LENGTH + 1) != DATABASE_OK ||
+                strcmp(readBack, value) != 0)
+                (*failures)++;
+        }
+        *getTime = (micros() - start) / BENCHMARK_TIERED_ITERATIONS;
+    }
+
+    DatabaseAPI *plainDatabaseAPI;
+    DatabaseAPI *tieredDatabaseAPI;
+    TieredNVSDelegate *tieredNVSDelegate;
+    NVSDelegate *nvsDelegate;
+    char *value;
+    char *readBack;
+};
+
+/** Benchmarking TieredNVSDelegate class
+ * @brief Set/get latency per value length, in NVS only and with values from TIERED_NVS_DELEGATE_DEFAULT_THRESHOLD in files.
+ */
+
+TEST_F(TieredBenchmark, latencyPerTier)
+{
+    // arrange
+    size_t const lengths[] = {64, 512, TIERED_NVS_DELEGATE_DEFAULT_THRESHOLD - 1, TIERED_NVS_DELEGATE_DEFAULT_THRESHOLD, 2048, BENCHMARK_TIERED_MAX_LENGTH};
+    int failures = 0;
+
+    // act & assert
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+    {
+        unsigned long plainSet, plainGet, tieredSet, tieredGet;
+        run(plainDatabaseAPI, lengths[i], &plainSet, &plainGet, &failures);
+        run(tieredDatabaseAPI, lengths[i], &tieredSet, &tieredGet, &failures);
+
+        Serial.printf("%4u bytes: nvs set %6lu us, get %5lu us | tiered (%s) set %6lu us, get %5lu us\n",
+                      (unsigned)lengths[i], plainSet, plainGet,
+                      lengths[i] < TIERED_NVS_DELEGATE_DEFAULT_THRESHOLD ? "nvs " : "file",
+                      tieredSet, tieredGet);
+    }
+
+    EXPECT_EQ(failures, 0);
+}
+
+#endif // BENCHMARK_TIERED_BENCHMARK_HPP
@@ -0,0 +1,106 @@
+#ifndef BENCHMARK_TRANSACTION_BENCHMARK_HPP
+#define BENCHMARK_TRANSACTION_BENCHMARK_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "../test_Unit/FaultInjectingNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseBatch.hpp"
+
+#ifndef BENCHMARK_TRANSACTION_ROUNDS
+#define BENCHMARK_TRANSACTION_ROUNDS 100
+#endif
+
+// setup benchmark suite, the parameter is the number of keys updated together
+class TransactionBenchmark : public ::testing::TestWithParam<int>
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        faultInjectingNVSDelegate = new FaultInjectingNVSDelegate();
+        databaseAPI = new DatabaseAPI(faultInjectingNVSDelegate, "bench");
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete faultInjectingNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Updates the given number of keys BENCHMARK_TRANSACTION_ROUNDS times, one set per key
+    // (mode 0), as a plain batch (mode 1) or as an atomic batch (mode 2), and prints the cost
+    void run(int keys, int mode, unsigned long *commits, unsigned long *bytes)
+    {
+        char const *const names[] = {"set per key", "plain batch", "atomic batch"};
+        char key[16];
+        char value[32];
+        int failures = 0;
+
+        faultInjectingNVSDelegate->writes = 0;
+        faultInjectingNVSDelegate->bytes = 0;
+        faultInjectingNVSDelegate->commits = 0;
+        unsigned long const start = micros();
+        for (int round = 0; round < BENCHMARK_TRANSACTION_ROUNDS; round++)
+        {
+            DatabaseBatch batch;
+            for (int i = 0; i < keys; i++)
+            {
+                snprintf(key, sizeof(key), "net%d", i);
+                snprintf(value, sizeof(value), "value %d of round %d", i, round);
+                if ((mode == 0 ? databaseAPI->set(key, value) : batch.set(key, value)) != DATABASE_OK)
+                    failures++;
+            }
+            if (mode != 0 && databaseAPI->commit(batch, mode == 2) != DATABASE_OK)
+                failures++;
+        }
+        unsigned long const elapsed = micros() - start;
+
+        Serial.printf("%2d keys, %-12s: %5lu writes, %6lu bytes, %4lu commits per %d rounds, %7lu us\n",
+                      keys, names[mode], faultInjectingNVSDelegate->writes, faultInjectingNVSDelegate->bytes,
+                      faultInjectingNVSDelegate->commits, BENCHMARK_TRANSACTION_ROUNDS, elapsed);
+
+        EXPECT_EQ(failures, 0);
+        *commits = faultInjectingNVSDelegate->commits;
+        *bytes = faultInjectingNVSDelegate->bytes;
+    }
+
+    DatabaseAPI *databaseAPI;
+    FaultInjectingNVSDelegate *faultInjectingNVSDelegate;
+};
+
+/** Benchmarking commit Method of DatabaseAPI class
+ * @brief Cost of the journal of an atomic batch, against plain batched writes and one set per key.
+ */
+
+TEST_P(TransactionBenchmark, journalOverhead)
+{
+    int const keys = GetParam();
+    unsigned long setCommits, setBytes, plainCommits, plainBytes, atomicCommits, atomicBytes;
+
+    // act
+    run(keys, 0, &setCommits, &setBytes);
+    run(keys, 1, &plainCommits, &plainBytes);
+    run(keys, 2, &atomicCommits, &atomicBytes);
+
+    // assert
+    EXPECT_EQ(plainCommits, (unsigned long)BENCHMARK_TRANSACTION_ROUNDS);
+    EXPECT_EQ(atomicCommits, 3UL * BENCHMARK_TRANSACTION_ROUNDS);
+    EXPECT_EQ(plainBytes, setBytes);
+    EXPECT_LT(atomicBytes, 2 * plainBytes + (unsigned long)keys * 8 * BENCHMARK_TRANSACTION_ROUNDS); // values twice, plus keys
+}
+
+INSTANTIATE_TEST_SUITE_P(Keys, TransactionBenchmark, ::testing::Values(3, 16));
+
+#endif // BENCHMARK_TRANSACTION_BENCHMARK_HPP
@@ -0,0 +1,7 @@
+#include "Scaling_benchmark.hpp"
+#include "Packing_benchmark.hpp"
+#include "Transaction_benchmark.hpp"
+#include "Import_benchmark.hpp"
+#include "Queue_benchmark.hpp"
+#include "Tiered_benchmark.hpp"
+#include "Job_benchmark.hpp"
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifndef INTEGRATED_COUNTER_TEST_HPP
+#define INTEGRATED_COUNTER_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include "DatabaseAPI.hpp"
+#include "NVSDelegate.hpp"
+
+// Integrated test suite for the counters of DatabaseAPI
+class IntegratedCounterTest : public ::testing::Test
+{
+protected:
+    int startFreeHeap = 0;
+    int memoryLeak = 0;
+
+    void SetUp() override
+    {
+        // Get the free heap before each test
+        delay(10);
+        startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+
+        // Initialize the database API with the actual NVS implementation
+        nvsDelegate = new NVSDelegate();
+        databaseAPI = new DatabaseAPI(nvsDelegate, "testNamespace");
+    }
+
+    void TearDown() override
+    {
+        // Delete the database API
+        delete databaseAPI;
+
+        NVSDelegateHandle_t handle;
+        nvsDelegate->open("testNamespace", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+        nvsDelegate->erase_all(handle);
+        nvsDelegate->close(handle);
+
+        delete nvsDelegate;
+
+        // Calculate the memory leak
+        delay(10);
+        memoryLeak = ESP.getFreeHeap() - startFreeHeap;
+        delay(10);
+
+        if (memoryLeak != 0)
+            FAIL() << "Memory leak of " << memoryLeak << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    DatabaseAPI *databaseAPI;
+    NVSDelegate *nvsDelegate;
+};
+
+/** Integrated Testing of the counters of DatabaseAPI class
+ * @brief Counters are stored as native 64-bit integers in NVS.
+ */
+
+TEST_F(IntegratedCounterTest, increment_StoredAsInteger)
+{
+    // Arrange
+    int64_t value = 0;
+    int64_t stored = 0;
+    NVSDelegateHandle_t handle;
+
+    // Act
+    DatabaseError_t err1 = databaseAPI->increment("counter", 5);
+    DatabaseError_t err2 = databaseAPI->decrement("counter", 2, &value);
+
+    // Assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(value, 3);
+    ASSERT_EQ(nvsDelegate->open("testNamespace", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle), NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(nvsDelegate->get_i64(handle, "counter", &stored), NVSDelegateError_t::NVS_DELEGATE_OK);
+    nvsDelegate->close(handle);
+    EXPECT_EQ(stored, 3);
+}
+
+TEST_F(IntegratedCounterTest, flushCounters_SurvivesRestart)
+{
+    // Arrange
+    databaseAPI->setCounterPersistPolicy(100, 0);
+    for (int i = 0; i < 10; i++)
+        ASSERT_EQ(databaseAPI->increment("counter"), DatabaseError_t::DATABASE_OK);
+    int64_t stored = 0;
+    NVSDelegateHandle_t handle;
+
+    // Act
+    DatabaseError_t err = databaseAPI->flushCounters();
+
+    // Assert, on what a restart reads from flash
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_OK);
+    ASSERT_EQ(nvsDelegate->open("testNamespace", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle), NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(nvsDelegate->get_i64(handle, "counter", &stored), NVSDelegateError_t::NVS_DELEGATE_OK);
+    nvsDelegate->close(handle);
+    EXPECT_EQ(stored, 10);
+}
+
+#endif // INTEGRATED_COUNTER_TEST_HPP
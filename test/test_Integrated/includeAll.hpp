@@ -4,4 +4,5 @@
 #include "IsExist_test.hpp"
 #include "GetValueLength_test.hpp"
 #include "EraseAll_test.hpp"
-#include "Heap_test.hpp"
\ No newline at end of file
+#include "Heap_test.hpp"
+#include "Counter_test.hpp"
\ No newline at end of file
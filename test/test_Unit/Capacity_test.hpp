@@ -0,0 +1,184 @@
+#ifndef UNIT_CAPACITY_TEST_HPP
+#define UNIT_CAPACITY_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "MemoryNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseBatch.hpp"
+#include "DatabaseJob.hpp"
+
+// setup test suite
+class CapacityTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        memoryNVSDelegate = new MemoryNVSDelegate();
+        databaseAPI = new DatabaseAPI(memoryNVSDelegate, "TEST_NVS");
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete memoryNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Stages count values of length characters, under keys made of the prefix and an index
+    void stage(DatabaseBatch &batch, char const *const prefix, int const count, size_t const length)
+    {
+        char key[16];
+        char *const value = static_cast<char *>(malloc(length + 1));
+        memset(value, 'v', length);
+        value[length] = '\0';
+        for (int i = 0; i < count; i++)
+        {
+            snprintf(key, sizeof(key), "%s%d", prefix, i);
+            ASSERT_EQ(batch.set(key, value), DATABASE_OK);
+        }
+        free(value);
+    }
+
+    DatabaseAPI *databaseAPI;
+    MemoryNVSDelegate *memoryNVSDelegate;
+};
+
+/** Testing estimateEntries Method of DatabaseAPI class
+ * @brief A value takes a header and one entry per 32 bytes with its terminator, the journal a blob.
+ */
+TEST_F(CapacityTest, estimateEntries)
+{
+    // arrange
+    DatabaseBatch batch;
+    stage(batch, "a", 1, 31); // 32 bytes with the terminator
+    stage(batch, "b", 1, 32);
+    ASSERT_EQ(batch.remove("c"), DATABASE_OK);
+    size_t plain = 0;
+    size_t atomic = 0;
+    size_t empty = 1;
+    DatabaseBatch emptyBatch;
+
+    // act
+    DatabaseError_t const err = databaseAPI->estimateEntries(batch, false, &plain);
+    DatabaseError_t const atomicErr = databaseAPI->estimateEntries(batch, true, &atomic);
+    DatabaseError_t const emptyErr = databaseAPI->estimateEntries(emptyBatch, true, &empty);
+
+    // assert
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_EQ(plain, 2u + 3u);
+    EXPECT_EQ(atomicErr, DATABASE_OK);
+    EXPECT_EQ(atomic, plain + 2u + (batch.serializedLength() + 31) / 32);
+    EXPECT_EQ(emptyErr, DATABASE_OK);
+    EXPECT_EQ(empty, 0u);
+    EXPECT_EQ(databaseAPI->estimateEntries(batch, false, nullptr), DATABASE_VALUE_INVALID);
+}
+
+/** Testing commit Method of DatabaseAPI class
+ * @brief A batch larger than the available entries is rejected before any key is written, in every form.
+ */
+TEST_F(CapacityTest, batchRejectedBeforeAnyWrite)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->set("existing", "old"), DATABASE_OK);
+    DatabaseBatch batch;
+    ASSERT_EQ(batch.set("existing", "new"), DATABASE_OK);
+    stage(batch, "big", 4, 4000);
+    size_t needed = 0;
+    size_t available = 0;
+    ASSERT_EQ(databaseAPI->estimateEntries(batch, false, &needed), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->getAvailableEntries(&available), DATABASE_OK);
+    DatabaseJob job;
+
+    // act
+    DatabaseError_t const atomicErr = databaseAPI->commit(batch);
+    DatabaseError_t const plainErr = databaseAPI->commit(batch, false);
+    DatabaseError_t const jobErr = databaseAPI->startCommit(batch, &job);
+    DatabaseError_t const replaceErr = databaseAPI->replaceAll(batch);
+
+    // assert
+    EXPECT_GT(needed, available);
+    EXPECT_EQ(atomicErr, DATABASE_NOT_ENOUGH_SPACE);
+    EXPECT_EQ(plainErr, DATABASE_NOT_ENOUGH_SPACE);
+    EXPECT_EQ(jobErr, DATABASE_NOT_ENOUGH_SPACE);
+    EXPECT_TRUE(job.isDone());
+    EXPECT_EQ(replaceErr, DATABASE_NOT_ENOUGH_SPACE);
+    char value[8] = {0};
+    EXPECT_EQ(databaseAPI->get("existing", value, sizeof(value)), DATABASE_OK);
+    EXPECT_STREQ(value, "old");
+    EXPECT_EQ(databaseAPI->isExist("big0"), DATABASE_KEY_NOT_FOUND);
+}
+
+/** Testing commit Method of DatabaseAPI class
+ * @brief A batch that only fits without the generation left behind by replaceAll erases it first.
+ */
+TEST_F(CapacityTest, staleGenerationErasedToMakeRoom)
+{
+    // arrange
+    DatabaseBatch generation;
+    stage(generation, "gen", 2, 2000);
+    ASSERT_EQ(databaseAPI->replaceAll(generation), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->replaceAll(generation), DATABASE_OK);
+    DatabaseNamespaceUsage_t before;
+    ASSERT_EQ(databaseAPI->getNamespaceUsage(&before), DATABASE_OK);
+    DatabaseBatch batch;
+    stage(batch, "big", 3, 3000);
+    size_t needed = 0;
+    size_t available = 0;
+    ASSERT_EQ(databaseAPI->estimateEntries(batch, false, &needed), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->getAvailableEntries(&available), DATABASE_OK);
+
+    // act
+    DatabaseError_t const err = databaseAPI->commit(batch, false);
+    DatabaseNamespaceUsage_t after;
+    ASSERT_EQ(databaseAPI->getNamespaceUsage(&after), DATABASE_OK);
+
+    // assert
+    EXPECT_GT(needed, available);
+    EXPECT_LE(needed, available + before.staleEntries);
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_GT(before.staleEntries, 0u);
+    EXPECT_EQ(after.staleEntries, 0u);
+    EXPECT_EQ(databaseAPI->isExist("big2"), DATABASE_OK);
+    EXPECT_EQ(databaseAPI->isExist("gen0"), DATABASE_OK);
+}
+
+/** Testing getNamespaceUsage Method of DatabaseAPI class
+ * @brief Reserved keys take entries but are not counted as keys; a namespace never written uses nothing.
+ */
+TEST_F(CapacityTest, getNamespaceUsage)
+{
+    // arrange
+    DatabaseNamespaceUsage_t empty;
+    DatabaseNamespaceUsage_t usage;
+
+    // act
+    DatabaseError_t const emptyErr = databaseAPI->getNamespaceUsage(&empty);
+    ASSERT_EQ(databaseAPI->enableExpiry(), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("ssid", "office"), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("token", "abc", 60), DATABASE_OK);
+    DatabaseError_t const err = databaseAPI->getNamespaceUsage(&usage);
+
+    // assert
+    EXPECT_EQ(emptyErr, DATABASE_OK);
+    EXPECT_EQ(empty.keys, 0u);
+    EXPECT_EQ(empty.entries, 0u);
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_EQ(usage.keys, 2u);
+    EXPECT_GT(usage.entries, 2u * 2u); // the expiry table too
+    EXPECT_EQ(usage.staleEntries, 0u);
+    EXPECT_EQ(databaseAPI->getNamespaceUsage(nullptr), DATABASE_VALUE_INVALID);
+}
+
+#endif // UNIT_CAPACITY_TEST_HPP
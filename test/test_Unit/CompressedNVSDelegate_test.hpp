@@ -0,0 +1,290 @@
+#ifndef UNIT_COMPRESSED_NVS_DELEGATE_TEST_HPP
+#define UNIT_COMPRESSED_NVS_DELEGATE_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "MemoryNVSDelegate.hpp"
+#include "FaultInjectingNVSDelegate.hpp"
+#include "CompressedNVSDelegate.hpp"
+#include "DatabaseLZ4.hpp"
+#include "DatabaseAPI.hpp"
+
+// setup test suite
+class CompressedNVSDelegateTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        memoryNVSDelegate = new MemoryNVSDelegate();
+        compressedNVSDelegate = new CompressedNVSDelegate(memoryNVSDelegate);
+        databaseAPI = new DatabaseAPI(compressedNVSDelegate, "TEST_NVS");
+
+        // A configuration document of the kind that compresses well
+        size_t length = snprintf(json, sizeof(json), "{");
+        for (int i = 0; i < 12; i++)
+            length += snprintf(json + length, sizeof(json) - length, "\"sensor%d\":{\"enabled\":true,\"offset\":0.0,\"gain\":1.0},", i);
+        snprintf(json + length, sizeof(json) - length, "\"version\":3}");
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete compressedNVSDelegate;
+        delete memoryNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Length of a key as stored by the wrapped delegate, 0 if it is not stored with that type
+    size_t storedLength(char const *const key, bool blob)
+    {
+        NVSDelegateHandle_t handle;
+        size_t length = 0;
+        if (memoryNVSDelegate->open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle) != NVSDelegateError_t::NVS_DELEGATE_OK)
+            return 0;
+        NVSDelegateError_t err = blob ? memoryNVSDelegate->get_blob(handle, key, nullptr, &length)
+                                      : memoryNVSDelegate->get_str(handle, key, nullptr, &length);
+        return err == NVSDelegateError_t::NVS_DELEGATE_OK ? length : 0;
+    }
+
+    DatabaseAPI *databaseAPI;
+    CompressedNVSDelegate *compressedNVSDelegate;
+    MemoryNVSDelegate *memoryNVSDelegate;
+    char json[1024];
+};
+
+/** Testing CompressedNVSDelegate class
+ * @brief Large values are stored compressed and read back unchanged, others are stored verbatim.
+ */
+
+TEST_F(CompressedNVSDelegateTest, set_LargeValue_StoredCompressed)
+{
+    // arrange
+    char value[1024];
+    size_t length = 0;
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("config", json);
+    DatabaseError_t err2 = databaseAPI->getValueLength("config", &length);
+    DatabaseError_t err3 = databaseAPI->get("config", value, sizeof(value));
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(length, strlen(json) + 1);
+    EXPECT_STREQ(value, json);
+    EXPECT_EQ(storedLength("config", false), 0u);
+    EXPECT_GT(storedLength("config", true), 0u);
+    EXPECT_LT(storedLength("config", true), strlen(json) / 3);
+}
+
+TEST_F(CompressedNVSDelegateTest, set_ShortOrIncompressible_StoredVerbatim)
+{
+    // arrange
+    char noise[201];
+    uint32_t random = 2463534242u;
+    for (size_t i = 0; i < sizeof(noise) - 1; i++)
+    {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        noise[i] = static_cast<char>('!' + random % 90);
+    }
+    noise[sizeof(noise) - 1] = '\0';
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("flag", "on");
+    DatabaseError_t err2 = databaseAPI->set("noise", noise);
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(storedLength("flag", false), 3u);
+    EXPECT_EQ(storedLength("noise", false), sizeof(noise));
+    EXPECT_EQ(storedLength("noise", true), 0u);
+}
+
+TEST_F(CompressedNVSDelegateTest, set_ChangingValue_SwitchesStorage)
+{
+    // arrange
+    char value[1024];
+    ASSERT_EQ(databaseAPI->set("config", json), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("config", "{}");
+    DatabaseError_t err2 = databaseAPI->get("config", value, sizeof(value));
+    bool const verbatim = storedLength("config", false) > 0 && storedLength("config", true) == 0;
+    DatabaseError_t err3 = databaseAPI->set("config", json);
+    DatabaseError_t err4 = databaseAPI->remove("config");
+    DatabaseError_t err5 = databaseAPI->isExist("config");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "{}");
+    EXPECT_TRUE(verbatim);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err5, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+}
+
+TEST_F(CompressedNVSDelegateTest, set_CompressedWriteFails_PreviousValueKept)
+{
+    // arrange
+    FaultInjectingNVSDelegate faultInjectingNVSDelegate;
+    CompressedNVSDelegate compressed(&faultInjectingNVSDelegate);
+    DatabaseAPI database(&compressed, "TEST_NVS");
+    ASSERT_EQ(database.set("config", "{}"), DatabaseError_t::DATABASE_OK);
+    faultInjectingNVSDelegate.failBlobs = true;
+    char value[1024];
+
+    // act
+    DatabaseError_t err1 = database.set("config", json);
+    DatabaseError_t err2 = database.get("config", value, sizeof(value));
+
+    // assert
+    EXPECT_NE(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "{}");
+}
+
+TEST_F(CompressedNVSDelegateTest, set_SwitchingType_NoStaleEntry)
+{
+    for (int blobFirst = 0; blobFirst < 2; blobFirst++)
+    {
+        // arrange
+        FaultInjectingNVSDelegate faultInjectingNVSDelegate;
+        faultInjectingNVSDelegate.separateTypes = true;
+        faultInjectingNVSDelegate.eraseBlobFirst = blobFirst == 1;
+        CompressedNVSDelegate compressed(&faultInjectingNVSDelegate);
+        NVSDelegateHandle_t handle;
+        ASSERT_EQ(compressed.open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle), NVSDelegateError_t::NVS_DELEGATE_OK);
+        char value[1024];
+        size_t length = sizeof(value);
+        size_t stringLength = 0;
+        size_t blobLength = 0;
+
+        // act
+        NVSDelegateError_t err1 = compressed.set_str(handle, "config", "{}");
+        NVSDelegateError_t err2 = compressed.set_str(handle, "config", json);
+        NVSDelegateError_t err3 = faultInjectingNVSDelegate.get_str(handle, "config", nullptr, &stringLength);
+        NVSDelegateError_t err4 = compressed.get_str(handle, "config", value, &length);
+        NVSDelegateError_t err5 = compressed.set_str(handle, "config", "{}");
+        NVSDelegateError_t err6 = faultInjectingNVSDelegate.get_blob(handle, "config", nullptr, &blobLength);
+        compressed.close(handle);
+
+        // assert
+        EXPECT_EQ(err1, NVSDelegateError_t::NVS_DELEGATE_OK);
+        EXPECT_EQ(err2, NVSDelegateError_t::NVS_DELEGATE_OK);
+        EXPECT_EQ(err3, NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND);
+        EXPECT_EQ(err4, NVSDelegateError_t::NVS_DELEGATE_OK);
+        EXPECT_STREQ(value, json);
+        EXPECT_EQ(err5, NVSDelegateError_t::NVS_DELEGATE_OK);
+        EXPECT_EQ(err6, NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND);
+    }
+}
+
+TEST_F(CompressedNVSDelegateTest, set_SwitchingType_NewEntryWrittenOnce)
+{
+    // arrange
+    FaultInjectingNVSDelegate faultInjectingNVSDelegate;
+    faultInjectingNVSDelegate.separateTypes = true;
+    CompressedNVSDelegate compressed(&faultInjectingNVSDelegate);
+    NVSDelegateHandle_t handle;
+    ASSERT_EQ(compressed.open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle), NVSDelegateError_t::NVS_DELEGATE_OK);
+    ASSERT_EQ(compressed.set_str(handle, "config", "{}"), NVSDelegateError_t::NVS_DELEGATE_OK);
+    faultInjectingNVSDelegate.writes = 0;
+
+    // act
+    NVSDelegateError_t err = compressed.set_str(handle, "config", json);
+    compressed.close(handle);
+
+    // assert
+    EXPECT_EQ(err, NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(faultInjectingNVSDelegate.writes, 2u); // the blob, then the erase of the string
+}
+
+TEST_F(CompressedNVSDelegateTest, get_BufferTooSmall_ValueInvalid)
+{
+    // arrange
+    char value[64];
+    ASSERT_EQ(databaseAPI->set("config", json), DatabaseError_t::DATABASE_OK);
+    NVSDelegateHandle_t handle;
+    ASSERT_EQ(compressedNVSDelegate->open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle), NVSDelegateError_t::NVS_DELEGATE_OK);
+    size_t length = sizeof(value);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->get("config", value, sizeof(value));
+    NVSDelegateError_t err2 = compressedNVSDelegate->get_str(handle, "config", value, &length);
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_VALUE_INVALID);
+    EXPECT_EQ(err2, NVSDelegateError_t::NVS_DELEGATE_VALUE_INVALID);
+}
+
+TEST_F(CompressedNVSDelegateTest, compareAndSetAndSnapshot_CompressedValue)
+{
+    // arrange
+    char value[1024];
+    char updated[1024];
+    strcpy(updated, json);
+    strcat(updated, " ");
+    ASSERT_EQ(databaseAPI->set("config", json), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->compareAndSet("config", json, updated);
+    DatabaseError_t err2 = databaseAPI->enableSnapshot();
+    DatabaseError_t err3 = databaseAPI->get("config", value, sizeof(value));
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, updated);
+}
+
+TEST_F(CompressedNVSDelegateTest, DatabaseLZ4_RoundTripAndCorruption)
+{
+    // arrange
+    uint8_t source[600];
+    uint8_t compressed[700];
+    uint8_t decompressed[600];
+    uint32_t random = 88172645u;
+    for (size_t i = 0; i < sizeof(source); i++)
+    {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        // runs, repeats at varying distances and noise
+        source[i] = i < 200 ? 'a' : (i < 400 ? source[i - 1 - random % 40] : static_cast<uint8_t>(random));
+    }
+
+    // act & assert
+    for (size_t length = 0; length <= sizeof(source); length += 7)
+    {
+        size_t const compressedLength = DatabaseLZ4::compress(source, length, compressed, sizeof(compressed));
+        ASSERT_GT(compressedLength, 0u) << "length " << length;
+        ASSERT_TRUE(DatabaseLZ4::decompress(compressed, compressedLength, decompressed, length)) << "length " << length;
+        ASSERT_EQ(memcmp(source, decompressed, length), 0) << "length " << length;
+    }
+
+    size_t const compressedLength = DatabaseLZ4::compress(source, sizeof(source), compressed, sizeof(compressed));
+    EXPECT_EQ(DatabaseLZ4::compress(source, sizeof(source), compressed, 10), 0u);
+    EXPECT_FALSE(DatabaseLZ4::decompress(compressed, compressedLength - 1, decompressed, sizeof(decompressed)));
+    EXPECT_FALSE(DatabaseLZ4::decompress(compressed, compressedLength, decompressed, sizeof(decompressed) - 1));
+    compressed[0] = 0x0F; // no literals, then a match before the start of the output
+    EXPECT_FALSE(DatabaseLZ4::decompress(compressed, compressedLength, decompressed, sizeof(decompressed)));
+}
+
+#endif // UNIT_COMPRESSED_NVS_DELEGATE_TEST_HPP
@@ -0,0 +1,235 @@
+#ifndef UNIT_CONDITIONAL_WRITE_TEST_HPP
+#define UNIT_CONDITIONAL_WRITE_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <thread>
+#include <vector>
+
+#include "MockingClass.hpp"
+#include "MemoryNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "NVSDelegateInterface.hpp"
+
+// setup test suite
+class ConditionalWriteTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        // setup mock
+        mockNVSDelegate = new MockNVSDelegate();
+        databaseAPI = new DatabaseAPI(mockNVSDelegate, "TEST_NVS");
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete mockNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Expects the single READWRITE handle every conditional write uses
+    void expectOpenClose()
+    {
+        EXPECT_CALL(*mockNVSDelegate, open(testing::StrEq("TEST_NVS"), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, ::testing::_))
+            .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+        EXPECT_CALL(*mockNVSDelegate, close(::testing::_)).Times(1);
+    }
+
+    // Expects the write and its single commit
+    void expectCommit(char const *const key, char const *const value)
+    {
+        EXPECT_CALL(*mockNVSDelegate, set_str(::testing::_, testing::StrEq(key), testing::StrEq(value)))
+            .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+        EXPECT_CALL(*mockNVSDelegate, commit(::testing::_))
+            .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    }
+
+    DatabaseAPI *databaseAPI;
+    MockNVSDelegate *mockNVSDelegate;
+};
+
+/** Testing conditional writes of DatabaseAPI class
+ * @brief setIfAbsent, compareAndSet and setIfVersion look up and write under one handle and one commit.
+ */
+
+TEST_F(ConditionalWriteTest, setIfAbsent_KeyMissing_Written)
+{
+    // arrange
+    expectOpenClose();
+    EXPECT_CALL(*mockNVSDelegate, get_str(::testing::_, testing::StrEq("key"), nullptr, ::testing::NotNull()))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND));
+    expectCommit("key", "value");
+
+    // act
+    DatabaseError_t err = databaseAPI->setIfAbsent("key", "value");
+
+    // assert
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_OK);
+}
+
+TEST_F(ConditionalWriteTest, setIfAbsent_KeyExists_AlreadyExists)
+{
+    // arrange
+    expectOpenClose();
+    EXPECT_CALL(*mockNVSDelegate, get_str(::testing::_, testing::StrEq("key"), nullptr, ::testing::NotNull()))
+        .WillOnce(::testing::DoAll(::testing::SetArgPointee<3>(strlen("old") + 1), ::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK)));
+    EXPECT_CALL(*mockNVSDelegate, set_str(::testing::_, ::testing::_, ::testing::_)).Times(0);
+    EXPECT_CALL(*mockNVSDelegate, commit(::testing::_)).Times(0);
+
+    // act
+    DatabaseError_t err = databaseAPI->setIfAbsent("key", "value");
+
+    // assert
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_KEY_ALREADY_EXISTS);
+}
+
+TEST_F(ConditionalWriteTest, compareAndSet_Matches_Written)
+{
+    // arrange
+    expectOpenClose();
+    EXPECT_CALL(*mockNVSDelegate, get_str(::testing::_, testing::StrEq("key"), ::testing::NotNull(), ::testing::Pointee(strlen("old") + 1)))
+        .WillOnce(::testing::DoAll(::testing::SetArrayArgument<2>("old", "old" + strlen("old") + 1), ::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK)));
+    expectCommit("key", "new");
+
+    // act
+    DatabaseError_t err = databaseAPI->compareAndSet("key", "old", "new");
+
+    // assert
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_OK);
+}
+
+TEST_F(ConditionalWriteTest, compareAndSet_Differs_Conflict)
+{
+    // arrange
+    expectOpenClose();
+    EXPECT_CALL(*mockNVSDelegate, get_str(::testing::_, testing::StrEq("key"), ::testing::NotNull(), ::testing::NotNull()))
+        .WillOnce(::testing::DoAll(::testing::SetArrayArgument<2>("abc", "abc" + strlen("abc") + 1), ::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK)));
+    EXPECT_CALL(*mockNVSDelegate, set_str(::testing::_, ::testing::_, ::testing::_)).Times(0);
+
+    // act
+    DatabaseError_t err = databaseAPI->compareAndSet("key", "old", "new");
+
+    // assert
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_CONFLICT);
+}
+
+TEST_F(ConditionalWriteTest, compareAndSet_LongerValue_Conflict)
+{
+    // arrange
+    expectOpenClose();
+    EXPECT_CALL(*mockNVSDelegate, get_str(::testing::_, testing::StrEq("key"), ::testing::NotNull(), ::testing::NotNull()))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_UNKOWN_ERROR));
+    EXPECT_CALL(*mockNVSDelegate, get_str(::testing::_, testing::StrEq("key"), nullptr, ::testing::NotNull()))
+        .WillOnce(::testing::DoAll(::testing::SetArgPointee<3>(strlen("much longer") + 1), ::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK)));
+    EXPECT_CALL(*mockNVSDelegate, set_str(::testing::_, ::testing::_, ::testing::_)).Times(0);
+
+    // act
+    DatabaseError_t err = databaseAPI->compareAndSet("key", "old", "new");
+
+    // assert
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_CONFLICT);
+}
+
+TEST_F(ConditionalWriteTest, compareAndSet_KeyMissing_KeyNotFound)
+{
+    // arrange
+    expectOpenClose();
+    EXPECT_CALL(*mockNVSDelegate, get_str(::testing::_, testing::StrEq("key"), ::testing::NotNull(), ::testing::NotNull()))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND));
+    EXPECT_CALL(*mockNVSDelegate, set_str(::testing::_, ::testing::_, ::testing::_)).Times(0);
+
+    // act
+    DatabaseError_t err = databaseAPI->compareAndSet("key", "old", "new");
+
+    // assert
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+}
+
+TEST_F(ConditionalWriteTest, invalidInput_Rejected)
+{
+    // act & assert, no delegate call is expected
+    EXPECT_EQ(databaseAPI->setIfAbsent("", "value"), DatabaseError_t::DATABASE_KEY_INVALID);
+    EXPECT_EQ(databaseAPI->setIfAbsent("key", ""), DatabaseError_t::DATABASE_VALUE_INVALID);
+    EXPECT_EQ(databaseAPI->compareAndSet("key", nullptr, "new"), DatabaseError_t::DATABASE_VALUE_INVALID);
+    EXPECT_EQ(databaseAPI->setIfVersion("key", 1, nullptr), DatabaseError_t::DATABASE_VALUE_INVALID);
+    EXPECT_EQ(databaseAPI->getVersion("key", nullptr), DatabaseError_t::DATABASE_VALUE_INVALID);
+}
+
+TEST_F(ConditionalWriteTest, setIfVersion_StaleVersion_Conflict)
+{
+    // arrange
+    MemoryNVSDelegate memoryNVSDelegate;
+    DatabaseAPI database(&memoryNVSDelegate, "TEST_NVS");
+    uint32_t absent;
+    uint32_t first;
+    uint32_t second;
+
+    // act & assert
+    ASSERT_EQ(database.getVersion("key", &absent), DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(absent, DATABASE_VERSION_ABSENT);
+    EXPECT_EQ(database.setIfVersion("key", absent, "one"), DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(database.setIfVersion("key", absent, "two"), DatabaseError_t::DATABASE_CONFLICT);
+
+    ASSERT_EQ(database.getVersion("key", &first), DatabaseError_t::DATABASE_OK);
+    EXPECT_NE(first, DATABASE_VERSION_ABSENT);
+    EXPECT_EQ(database.setIfVersion("key", first, "two"), DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(database.setIfVersion("key", first, "three"), DatabaseError_t::DATABASE_CONFLICT);
+
+    ASSERT_EQ(database.getVersion("key", &second), DatabaseError_t::DATABASE_OK);
+    EXPECT_NE(second, first);
+}
+
+/**
+ * @brief Tasks incrementing one value with get, then setIfVersion, never lose an update.
+ */
+TEST_F(ConditionalWriteTest, setIfVersion_ConcurrentIncrements)
+{
+    // arrange
+    MemoryNVSDelegate memoryNVSDelegate;
+    DatabaseAPI database(&memoryNVSDelegate, "TEST_NVS");
+    ASSERT_EQ(database.set("count", "0"), DatabaseError_t::DATABASE_OK);
+    std::vector<std::thread> tasks;
+
+    // act
+    for (int t = 0; t < 4; t++)
+    {
+        tasks.push_back(std::thread(
+            [&database]()
+            {
+                char value[16];
+                for (int i = 0; i < 50; i++)
+                {
+                    DatabaseError_t err;
+                    do
+                    {
+                        uint32_t version;
+                        database.get("count", value, sizeof(value), &version);
+                        snprintf(value, sizeof(value), "%d", atoi(value) + 1);
+                        err = database.setIfVersion("count", version, value);
+                    } while (err == DATABASE_CONFLICT);
+                }
+            }));
+    }
+    for (size_t i = 0; i < tasks.size(); i++)
+        tasks[i].join();
+    char value[16];
+
+    // assert
+    ASSERT_EQ(database.get("count", value, sizeof(value)), DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "200");
+}
+
+#endif // UNIT_CONDITIONAL_WRITE_TEST_HPP
@@ -0,0 +1,232 @@
+#ifndef UNIT_COUNTER_TEST_HPP
+#define UNIT_COUNTER_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "MockingClass.hpp"
+#include "MemoryNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "NVSDelegateInterface.hpp"
+
+// setup test suite
+class CounterTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        // setup mock
+        mockNVSDelegate = new MockNVSDelegate();
+        databaseAPI = new DatabaseAPI(mockNVSDelegate, "TEST_NVS");
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete mockNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Expects the first use of a counter that was never persisted
+    void expectLoadMissing(char const *const key)
+    {
+        EXPECT_CALL(*mockNVSDelegate, open(testing::StrEq("TEST_NVS"), NVSDelegateOpenMode_t::NVSDelegate_READONLY, ::testing::_))
+            .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK))
+            .RetiresOnSaturation();
+        EXPECT_CALL(*mockNVSDelegate, get_i64(::testing::_, testing::StrEq(key), ::testing::NotNull()))
+            .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND));
+    }
+
+    DatabaseAPI *databaseAPI;
+    MockNVSDelegate *mockNVSDelegate;
+};
+
+/** Testing counters of DatabaseAPI class
+ * @brief Counters are native integers served from RAM and persisted by policy.
+ */
+
+TEST_F(CounterTest, increment_DefaultPolicy_PersistsEveryChange)
+{
+    // arrange
+    expectLoadMissing("boot");
+    EXPECT_CALL(*mockNVSDelegate, open(testing::StrEq("TEST_NVS"), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, ::testing::_))
+        .Times(2)
+        .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, set_i64(::testing::_, testing::StrEq("boot"), 1))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, set_i64(::testing::_, testing::StrEq("boot"), 2))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, commit(::testing::_))
+        .Times(2)
+        .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, close(::testing::_)).Times(3);
+    int64_t value = 0;
+
+    // act
+    DatabaseError_t err1 = databaseAPI->increment("boot");
+    DatabaseError_t err2 = databaseAPI->increment("boot", 1, &value);
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(value, 2);
+}
+
+TEST_F(CounterTest, increment_EveryFiveChanges_Coalesced)
+{
+    // arrange
+    databaseAPI->setCounterPersistPolicy(5, 0);
+    expectLoadMissing("events");
+    EXPECT_CALL(*mockNVSDelegate, open(testing::StrEq("TEST_NVS"), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, ::testing::_))
+        .Times(3)
+        .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, set_i64(::testing::_, testing::StrEq("events"), 5))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, set_i64(::testing::_, testing::StrEq("events"), 10))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    // The destructor writes the two changes still pending
+    EXPECT_CALL(*mockNVSDelegate, set_i64(::testing::_, testing::StrEq("events"), 12))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, commit(::testing::_))
+        .Times(3)
+        .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, close(::testing::_)).Times(4);
+
+    // act
+    for (int i = 0; i < 12; i++)
+        ASSERT_EQ(databaseAPI->increment("events"), DatabaseError_t::DATABASE_OK);
+    int64_t value = 0;
+    DatabaseError_t err = databaseAPI->getCounter("events", &value);
+
+    // assert
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(value, 12);
+}
+
+TEST_F(CounterTest, flushCounters_OneCommitForAll)
+{
+    // arrange
+    databaseAPI->setCounterPersistPolicy(0, 0);
+    expectLoadMissing("first");
+    expectLoadMissing("second");
+    EXPECT_CALL(*mockNVSDelegate, close(::testing::_)).Times(2);
+    ASSERT_EQ(databaseAPI->increment("first", 3), DatabaseError_t::DATABASE_OK);
+    ASSERT_EQ(databaseAPI->decrement("second", 2), DatabaseError_t::DATABASE_OK);
+    ::testing::Mock::VerifyAndClearExpectations(mockNVSDelegate);
+
+    EXPECT_CALL(*mockNVSDelegate, open(testing::StrEq("TEST_NVS"), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, ::testing::_))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, set_i64(::testing::_, testing::StrEq("first"), 3))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, set_i64(::testing::_, testing::StrEq("second"), -2))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, commit(::testing::_))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, close(::testing::_)).Times(1);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->flushCounters();
+    DatabaseError_t err2 = databaseAPI->flushCounters(); // nothing pending, no delegate call
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+}
+
+TEST_F(CounterTest, getCounter_AfterRestart_Loaded)
+{
+    // arrange
+    MemoryNVSDelegate memoryNVSDelegate;
+    DatabaseAPI *before = new DatabaseAPI(&memoryNVSDelegate, "TEST_NVS");
+    before->setCounterPersistPolicy(0, 0);
+    ASSERT_EQ(before->increment("boot", 41), DatabaseError_t::DATABASE_OK);
+    delete before; // persists on a clean shutdown
+    DatabaseAPI after(&memoryNVSDelegate, "TEST_NVS");
+    int64_t value = 0;
+    int64_t missing = 0;
+
+    // act
+    DatabaseError_t err1 = after.increment("boot", 1, &value);
+    DatabaseError_t err2 = after.getCounter("missing", &missing);
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(value, 42);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+}
+
+TEST_F(CounterTest, increment_OldChange_PersistedByAge)
+{
+    // arrange
+    MemoryNVSDelegate memoryNVSDelegate;
+    DatabaseAPI database(&memoryNVSDelegate, "TEST_NVS");
+    database.setCounterPersistPolicy(0, 50);
+    NVSDelegateHandle_t handle;
+    int64_t stored = 0;
+
+    // act
+    ASSERT_EQ(database.increment("meter"), DatabaseError_t::DATABASE_OK);
+    ASSERT_EQ(memoryNVSDelegate.open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle), NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND);
+    delay(60);
+    ASSERT_EQ(database.increment("meter"), DatabaseError_t::DATABASE_OK);
+
+    // assert
+    ASSERT_EQ(memoryNVSDelegate.open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle), NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(memoryNVSDelegate.get_i64(handle, "meter", &stored), NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(stored, 2);
+}
+
+TEST_F(CounterTest, remove_PendingCounter_Removed)
+{
+    // arrange
+    MemoryNVSDelegate memoryNVSDelegate;
+    DatabaseAPI database(&memoryNVSDelegate, "TEST_NVS");
+    database.setCounterPersistPolicy(0, 0);
+    ASSERT_EQ(database.increment("meter"), DatabaseError_t::DATABASE_OK);
+    int64_t value = 0;
+
+    // act
+    DatabaseError_t err1 = database.remove("meter");
+    DatabaseError_t err2 = database.getCounter("meter", &value);
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+}
+
+TEST_F(CounterTest, set_PendingCounter_Dropped)
+{
+    // arrange
+    MemoryNVSDelegate memoryNVSDelegate;
+    DatabaseAPI database(&memoryNVSDelegate, "TEST_NVS");
+    database.setCounterPersistPolicy(0, 0);
+    ASSERT_EQ(database.increment("meter", 5), DatabaseError_t::DATABASE_OK);
+    int64_t counter = 0;
+    char value[8] = {0};
+
+    // act
+    DatabaseError_t err1 = database.set("meter", "hello");
+    DatabaseError_t err2 = database.getCounter("meter", &counter);
+    DatabaseError_t err3 = database.flushCounters();
+    DatabaseError_t err4 = database.get("meter", value, sizeof(value));
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_NE(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "hello");
+}
+
+#endif // UNIT_COUNTER_TEST_HPP
@@ -0,0 +1,132 @@
+#ifndef UNIT_DEADLINE_TEST_HPP
+#define UNIT_DEADLINE_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "FaultInjectingNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseLatency.hpp"
+
+// setup test suite
+class DeadlineTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        faultInjectingNVSDelegate = new FaultInjectingNVSDelegate();
+        databaseAPI = new DatabaseAPI(faultInjectingNVSDelegate, "TEST_NVS");
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete faultInjectingNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    DatabaseAPI *databaseAPI;
+    FaultInjectingNVSDelegate *faultInjectingNVSDelegate;
+};
+
+/** Testing DatabaseLatency
+ * @brief The prediction starts at three times the first latency, and follows the smoothed latency and deviation.
+ */
+TEST_F(DeadlineTest, latencyPrediction)
+{
+    // arrange
+    DatabaseLatency latency;
+
+    // act
+    uint32_t const empty = latency.predict(DATABASE_OPERATION_SET);
+    latency.record(DATABASE_OPERATION_SET, 1000);
+    uint32_t const first = latency.predict(DATABASE_OPERATION_SET);
+    for (int i = 0; i < 50; i++)
+        latency.record(DATABASE_OPERATION_SET, 1000);
+    uint32_t const steady = latency.predict(DATABASE_OPERATION_SET);
+    latency.record(DATABASE_OPERATION_SET, 30000);
+    uint32_t const spike = latency.predict(DATABASE_OPERATION_SET);
+
+    // assert
+    EXPECT_EQ(empty, 0u);
+    EXPECT_EQ(first, 3000u);
+    EXPECT_LT(steady, 1100u);
+    EXPECT_GT(spike, 30000u);
+    EXPECT_EQ(latency.worst(DATABASE_OPERATION_SET), 30000u);
+    EXPECT_EQ(latency.samples(DATABASE_OPERATION_SET), 52u);
+    EXPECT_EQ(latency.samples(DATABASE_OPERATION_REMOVE), 0u);
+}
+
+/** Testing DatabaseAPI::setWithin
+ * @brief After a stalled write, a write with a shorter budget is refused and nothing is written.
+ */
+TEST_F(DeadlineTest, DATABASE_TIMEOUT)
+{
+    // arrange
+    faultInjectingNVSDelegate->commitStallMs = 20;
+    ASSERT_EQ(databaseAPI->setWithin("first", "value", 1000), DATABASE_OK); // no history yet
+    faultInjectingNVSDelegate->commitStallMs = 0;
+
+    // act
+    DatabaseError_t const shortBudget = databaseAPI->setWithin("key", "value", 5000);
+    DatabaseError_t const shortRemove = databaseAPI->removeWithin("first", 5000);
+    DatabaseError_t const longBudget = databaseAPI->setWithin("key", "value", 500000);
+
+    // assert
+    EXPECT_GE(databaseAPI->getPredictedLatency(DATABASE_OPERATION_SET), 20000u);
+    EXPECT_EQ(shortBudget, DATABASE_TIMEOUT);
+    EXPECT_EQ(shortRemove, DATABASE_OK); // no remove history yet
+    EXPECT_EQ(longBudget, DATABASE_OK);
+    EXPECT_EQ(databaseAPI->isExist("key"), DATABASE_OK);
+    EXPECT_EQ(databaseAPI->isExist("first"), DATABASE_KEY_NOT_FOUND);
+}
+
+/** Testing DatabaseAPI::setWithin
+ * @brief The prediction decays as fast writes follow a stall, until writes fit the budget again.
+ */
+TEST_F(DeadlineTest, predictionRecovers)
+{
+    // arrange
+    faultInjectingNVSDelegate->commitStallMs = 20;
+    ASSERT_EQ(databaseAPI->set("key", "stalled"), DATABASE_OK);
+    faultInjectingNVSDelegate->commitStallMs = 0;
+    char value[16];
+
+    // act
+    int writes = 0;
+    while (databaseAPI->getPredictedLatency(DATABASE_OPERATION_SET) > 5000 && writes < 100)
+    {
+        snprintf(value, sizeof(value), "v%d", writes++);
+        ASSERT_EQ(databaseAPI->set("key", value), DATABASE_OK);
+    }
+    DatabaseError_t const err = databaseAPI->setWithin("key", "on time", 5000);
+
+    // assert
+    EXPECT_GT(writes, 1);
+    EXPECT_LT(writes, 100);
+    EXPECT_EQ(err, DATABASE_OK);
+}
+
+/** Testing DatabaseAPI::setWithin
+ * @brief Invalid arguments are reported as by set and remove.
+ */
+TEST_F(DeadlineTest, invalidArguments)
+{
+    // act & assert
+    EXPECT_EQ(databaseAPI->setWithin(nullptr, "value", 1000), DATABASE_KEY_INVALID);
+    EXPECT_EQ(databaseAPI->setWithin("key", "", 1000), DATABASE_VALUE_INVALID);
+    EXPECT_EQ(databaseAPI->removeWithin("", 1000), DATABASE_KEY_INVALID);
+    EXPECT_EQ(databaseAPI->removeWithin("missing", 1000), DATABASE_KEY_NOT_FOUND);
+}
+
+#endif // UNIT_DEADLINE_TEST_HPP
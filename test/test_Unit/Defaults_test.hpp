@@ -0,0 +1,258 @@
+#ifndef UNIT_DEFAULTS_TEST_HPP
+#define UNIT_DEFAULTS_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "FaultInjectingNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseDefaults.hpp"
+
+static constexpr DatabaseDefault TEST_DEFAULTS[] = {
+    {"ssid", "office"},
+    {"mode", "auto"},
+    {"interval", "60"},
+    {"server", "mqtt.local"},
+    {"port", "1883"},
+};
+static constexpr DatabaseDefaults<5> testDefaults = makeDatabaseDefaults(TEST_DEFAULTS);
+
+static constexpr DatabaseDefault MANY_DEFAULTS[] = {
+    {"k0", "0"}, {"k1", "1"}, {"k2", "2"}, {"k3", "3"}, {"k4", "4"}, {"k5", "5"}, {"k6", "6"}, {"k7", "7"},
+    {"k8", "8"}, {"k9", "9"}, {"k10", "10"}, {"k11", "11"}, {"k12", "12"}, {"k13", "13"}, {"k14", "14"},
+    {"k15", "15"}, {"k16", "16"}, {"k17", "17"}, {"k18", "18"}, {"k19", "19"}, {"k20", "20"}, {"k21", "21"},
+    {"k22", "22"}, {"k23", "23"}, {"k24", "24"}, {"k25", "25"}, {"k26", "26"}, {"k27", "27"}, {"k28", "28"},
+    {"k29", "29"}, {"k30", "30"}, {"k31", "31"}, {"k32", "32"}, {"k33", "33"}, {"k34", "34"}, {"k35", "35"},
+    {"k36", "36"}, {"k37", "37"}, {"k38", "38"}, {"k39", "39"},
+};
+static constexpr DatabaseDefaults<40> manyDefaults = makeDatabaseDefaults(MANY_DEFAULTS);
+
+// setup test suite
+class DefaultsTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        faultInjectingNVSDelegate = new FaultInjectingNVSDelegate();
+        databaseAPI = new DatabaseAPI(faultInjectingNVSDelegate, "TEST_NVS");
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete faultInjectingNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    DatabaseAPI *databaseAPI;
+    FaultInjectingNVSDelegate *faultInjectingNVSDelegate;
+};
+
+/** Testing the layout of DatabaseDefaults
+ * @brief Every key of the list is found at its index, other keys are not.
+ */
+
+TEST_F(DefaultsTest, tableFindsEveryKey)
+{
+    // arrange
+    DatabaseDefaultsTable const table(manyDefaults);
+    size_t index = 0;
+    int misplaced = 0;
+
+    // act
+    for (size_t i = 0; i < table.count(); i++)
+        if (!table.find(MANY_DEFAULTS[i].key, &index) || index != i)
+            misplaced++;
+    bool const foundMissing = table.find("k40", &index) || table.find("ssid", &index);
+
+    // assert
+    EXPECT_EQ(table.count(), 40u);
+    EXPECT_EQ(misplaced, 0);
+    EXPECT_FALSE(foundMissing);
+    EXPECT_STREQ(table.at(7).value, "7");
+}
+
+/** Testing get Method of DatabaseAPI class with defaults
+ * @brief A key never set reads as its default, without opening the namespace.
+ */
+
+TEST_F(DefaultsTest, defaultServedWithoutFlashAccess)
+{
+    // arrange
+    char value[16];
+    size_t length = 0;
+    ASSERT_EQ(databaseAPI->setDefaults(testDefaults), DatabaseError_t::DATABASE_OK);
+    faultInjectingNVSDelegate->opens = 0;
+
+    // act
+    DatabaseError_t const getErr = databaseAPI->get("server", value, sizeof(value));
+    DatabaseError_t const existErr = databaseAPI->isExist("mode");
+    DatabaseError_t const lengthErr = databaseAPI->getValueLength("port", &length);
+    unsigned long const opens = faultInjectingNVSDelegate->opens;
+    DatabaseError_t const missingErr = databaseAPI->isExist("missing");
+
+    // assert
+    EXPECT_EQ(getErr, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "mqtt.local");
+    EXPECT_EQ(existErr, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(lengthErr, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(length, 5u);
+    EXPECT_EQ(opens, 0UL);
+    EXPECT_EQ(missingErr, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+}
+
+/** Testing set and remove Methods of DatabaseAPI class with defaults
+ * @brief A set overrides the default, a remove restores it.
+ */
+
+TEST_F(DefaultsTest, setOverridesAndRemoveRestores)
+{
+    // arrange
+    char value[16];
+    char restored[16];
+    ASSERT_EQ(databaseAPI->setDefaults(testDefaults), DatabaseError_t::DATABASE_OK);
+
+    // act
+    ASSERT_EQ(databaseAPI->set("ssid", "home"), DatabaseError_t::DATABASE_OK);
+    DatabaseError_t const getErr = databaseAPI->get("ssid", value, sizeof(value));
+    ASSERT_EQ(databaseAPI->remove("ssid"), DatabaseError_t::DATABASE_OK);
+    DatabaseError_t const restoredErr = databaseAPI->get("ssid", restored, sizeof(restored));
+
+    // assert
+    EXPECT_EQ(getErr, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "home");
+    EXPECT_EQ(restoredErr, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(restored, "office");
+}
+
+/** Testing setDefaults Method of DatabaseAPI class
+ * @brief Values stored before the defaults are set keep overriding them.
+ */
+
+TEST_F(DefaultsTest, storedValuesFoundWhenSet)
+{
+    // arrange
+    char value[16];
+    ASSERT_EQ(databaseAPI->set("interval", "5"), DatabaseError_t::DATABASE_OK);
+
+    // act
+    ASSERT_EQ(databaseAPI->setDefaults(testDefaults), DatabaseError_t::DATABASE_OK);
+    DatabaseError_t const err = databaseAPI->get("interval", value, sizeof(value));
+
+    // assert
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "5");
+}
+
+/** Testing commit and eraseAll Methods of DatabaseAPI class with defaults
+ * @brief A batch overrides and restores defaults, eraseAll restores every default.
+ */
+
+TEST_F(DefaultsTest, batchAndEraseAll)
+{
+    // arrange
+    char mode[16];
+    char port[16];
+    char erased[16];
+    DatabaseBatch batch;
+    ASSERT_EQ(databaseAPI->set("port", "8883"), DatabaseError_t::DATABASE_OK);
+    ASSERT_EQ(databaseAPI->setDefaults(testDefaults), DatabaseError_t::DATABASE_OK);
+    ASSERT_EQ(batch.set("mode", "manual"), DatabaseError_t::DATABASE_OK);
+    ASSERT_EQ(batch.remove("port"), DatabaseError_t::DATABASE_OK);
+
+    // act
+    ASSERT_EQ(databaseAPI->commit(batch), DatabaseError_t::DATABASE_OK);
+    DatabaseError_t const modeErr = databaseAPI->get("mode", mode, sizeof(mode));
+    DatabaseError_t const portErr = databaseAPI->get("port", port, sizeof(port));
+    ASSERT_EQ(databaseAPI->eraseAll(), DatabaseError_t::DATABASE_OK);
+    DatabaseError_t const erasedErr = databaseAPI->get("mode", erased, sizeof(erased));
+
+    // assert
+    EXPECT_EQ(modeErr, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(mode, "manual");
+    EXPECT_EQ(portErr, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(port, "1883");
+    EXPECT_EQ(erasedErr, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(erased, "auto");
+}
+
+/** Testing getVersion and setIfVersion Methods of DatabaseAPI class
+ * @brief A key left at its default has the version of the default, which setIfVersion accepts.
+ */
+TEST_F(DefaultsTest, versionOfDefault)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->setDefaults(testDefaults), DatabaseError_t::DATABASE_OK);
+    char value[16] = {0};
+    uint32_t readVersion = DATABASE_VERSION_ABSENT;
+    uint32_t version = DATABASE_VERSION_ABSENT;
+
+    // act
+    DatabaseError_t const getErr = databaseAPI->get("mode", value, sizeof(value), &readVersion);
+    DatabaseError_t const versionErr = databaseAPI->getVersion("mode", &version);
+    DatabaseError_t const absentErr = databaseAPI->setIfVersion("mode", DATABASE_VERSION_ABSENT, "manual");
+    DatabaseError_t const err = databaseAPI->setIfVersion("mode", readVersion, "manual");
+
+    // assert
+    EXPECT_EQ(getErr, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(versionErr, DatabaseError_t::DATABASE_OK);
+    EXPECT_NE(version, DATABASE_VERSION_ABSENT);
+    EXPECT_EQ(version, readVersion);
+    EXPECT_EQ(absentErr, DatabaseError_t::DATABASE_CONFLICT);
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(databaseAPI->get("mode", value, sizeof(value)), DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "manual");
+}
+
+/** Testing compareAndSet Method of DatabaseAPI class
+ * @brief A key left at its default is compared with the default.
+ */
+TEST_F(DefaultsTest, compareAndSetDefault)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->setDefaults(testDefaults), DatabaseError_t::DATABASE_OK);
+    char value[16] = {0};
+
+    // act
+    DatabaseError_t const conflictErr = databaseAPI->compareAndSet("mode", "manual", "off");
+    DatabaseError_t const err = databaseAPI->compareAndSet("mode", "auto", "manual");
+
+    // assert
+    EXPECT_EQ(conflictErr, DatabaseError_t::DATABASE_CONFLICT);
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(databaseAPI->get("mode", value, sizeof(value)), DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "manual");
+}
+
+/** Testing setIfAbsent Method of DatabaseAPI class
+ * @brief A key left at its default exists and is not written, a key without default is.
+ */
+TEST_F(DefaultsTest, setIfAbsentDefault)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->setDefaults(testDefaults), DatabaseError_t::DATABASE_OK);
+    char value[16] = {0};
+
+    // act
+    DatabaseError_t const existsErr = databaseAPI->setIfAbsent("mode", "manual");
+    DatabaseError_t const err = databaseAPI->setIfAbsent("owner", "nodeA");
+
+    // assert
+    EXPECT_EQ(databaseAPI->isExist("mode"), DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(existsErr, DatabaseError_t::DATABASE_KEY_ALREADY_EXISTS);
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(databaseAPI->get("mode", value, sizeof(value)), DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "auto");
+}
+
+#endif // UNIT_DEFAULTS_TEST_HPP
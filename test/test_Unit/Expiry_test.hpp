@@ -0,0 +1,249 @@
+#ifndef UNIT_EXPIRY_TEST_HPP
+#define UNIT_EXPIRY_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "MemoryNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseExpiry.hpp"
+
+// Clock the tests move forward by hand
+static uint32_t expiryTestNow = 1000;
+static uint32_t expiryTestClock()
+{
+    return expiryTestNow;
+}
+
+// setup test suite
+class ExpiryTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        expiryTestNow = 1000;
+        memoryNVSDelegate = new MemoryNVSDelegate();
+        databaseAPI = new DatabaseAPI(memoryNVSDelegate, "TEST_NVS");
+        databaseAPI->setClock(expiryTestClock);
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete memoryNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Checks if a key is still stored by the delegate, expired or not
+    bool isStored(char const *const key, bool blob = false)
+    {
+        NVSDelegateHandle_t handle;
+        size_t length = 0;
+        if (memoryNVSDelegate->open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle) != NVSDelegateError_t::NVS_DELEGATE_OK)
+            return false;
+        if (blob)
+            return memoryNVSDelegate->get_blob(handle, key, nullptr, &length) == NVSDelegateError_t::NVS_DELEGATE_OK;
+        return memoryNVSDelegate->get_str(handle, key, nullptr, &length) == NVSDelegateError_t::NVS_DELEGATE_OK;
+    }
+
+    DatabaseAPI *databaseAPI;
+    MemoryNVSDelegate *memoryNVSDelegate;
+};
+
+/** Testing key expiry of DatabaseAPI class
+ * @brief Keys set with a TTL are filtered from reads once expired, and removed by sweepExpired.
+ */
+
+TEST_F(ExpiryTest, set_WithTTL_ExpiresLazily)
+{
+    // arrange
+    char value[16];
+    size_t length = 0;
+    ASSERT_EQ(databaseAPI->set("token", "abc", 60), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->get("token", value, sizeof(value));
+    expiryTestNow += 60;
+    DatabaseError_t err2 = databaseAPI->get("token", value, sizeof(value));
+    DatabaseError_t err3 = databaseAPI->isExist("token");
+    DatabaseError_t err4 = databaseAPI->getValueLength("token", &length);
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+    EXPECT_TRUE(isStored("token")); // still on flash until swept
+}
+
+TEST_F(ExpiryTest, enableExpiry_AfterRestart_Filtered)
+{
+    // arrange
+    char value[16];
+    ASSERT_EQ(databaseAPI->set("token", "abc", 60), DatabaseError_t::DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("name", "device"), DatabaseError_t::DATABASE_OK);
+    delete databaseAPI;
+    databaseAPI = new DatabaseAPI(memoryNVSDelegate, "TEST_NVS");
+    databaseAPI->setClock(expiryTestClock);
+    expiryTestNow += 61;
+
+    // act
+    DatabaseError_t err1 = databaseAPI->enableExpiry();
+    DatabaseError_t err2 = databaseAPI->get("token", value, sizeof(value));
+    DatabaseError_t err3 = databaseAPI->get("name", value, sizeof(value));
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+}
+
+/** Testing key expiry of DatabaseAPI class
+ * @brief After a restart, expired keys are filtered without enableExpiry, and a plain set clears the
+ *        persisted expiry so a later TTL write or sweep cannot remove the new value.
+ */
+TEST_F(ExpiryTest, afterRestart_PlainSetClearsPersistedExpiry)
+{
+    // arrange
+    char value[16];
+    ASSERT_EQ(databaseAPI->set("a", "x", 10), DatabaseError_t::DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("expired", "x", 10), DatabaseError_t::DATABASE_OK);
+    delete databaseAPI;
+    databaseAPI = new DatabaseAPI(memoryNVSDelegate, "TEST_NVS");
+    databaseAPI->setClock(expiryTestClock);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("a", "y");
+    DatabaseError_t err2 = databaseAPI->set("b", "z", 10);
+    expiryTestNow += 20;
+    DatabaseError_t err3 = databaseAPI->get("expired", value, sizeof(value));
+    size_t removed = 0;
+    DatabaseError_t err4 = databaseAPI->sweepExpired(10, &removed);
+    DatabaseError_t err5 = databaseAPI->get("a", value, sizeof(value));
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(removed, 2u); // "expired" and "b"
+    EXPECT_EQ(err5, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "y");
+}
+
+TEST_F(ExpiryTest, set_WithoutTTL_ClearsExpiry)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->set("token", "abc", 60), DatabaseError_t::DATABASE_OK);
+    ASSERT_TRUE(isStored(DATABASE_EXPIRY_KEY, true));
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("token", "def");
+    expiryTestNow += 120;
+    DatabaseError_t err2 = databaseAPI->isExist("token");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_FALSE(isStored(DATABASE_EXPIRY_KEY, true)); // empty table is erased
+}
+
+TEST_F(ExpiryTest, sweepExpired_Bounded)
+{
+    // arrange
+    char key[8];
+    for (int i = 0; i < 5; i++)
+    {
+        snprintf(key, sizeof(key), "old%d", i);
+        ASSERT_EQ(databaseAPI->set(key, "x", 10), DatabaseError_t::DATABASE_OK);
+    }
+    ASSERT_EQ(databaseAPI->set("fresh", "x", 100), DatabaseError_t::DATABASE_OK);
+    expiryTestNow += 10;
+    size_t removed1 = 0;
+    size_t removed2 = 0;
+    size_t removed3 = 0;
+
+    // act
+    DatabaseError_t err1 = databaseAPI->sweepExpired(2, &removed1);
+    DatabaseError_t err2 = databaseAPI->sweepExpired(10, &removed2);
+    DatabaseError_t err3 = databaseAPI->sweepExpired(10, &removed3);
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(removed1, 2u);
+    EXPECT_EQ(removed2, 3u);
+    EXPECT_EQ(removed3, 0u);
+    EXPECT_FALSE(isStored("old0"));
+    EXPECT_FALSE(isStored("old4"));
+    EXPECT_TRUE(isStored("fresh"));
+    EXPECT_TRUE(isStored(DATABASE_EXPIRY_KEY, true));
+}
+
+TEST_F(ExpiryTest, setIfAbsent_ExpiredKey_Written)
+{
+    // arrange
+    char value[16];
+    ASSERT_EQ(databaseAPI->set("lock", "nodeA", 5), DatabaseError_t::DATABASE_OK);
+    DatabaseError_t err1 = databaseAPI->setIfAbsent("lock", "nodeB");
+    expiryTestNow += 5;
+
+    // act
+    DatabaseError_t err2 = databaseAPI->setIfAbsent("lock", "nodeB");
+    expiryTestNow += 5;
+    DatabaseError_t err3 = databaseAPI->get("lock", value, sizeof(value));
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_KEY_ALREADY_EXISTS);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK); // no longer expires
+    EXPECT_STREQ(value, "nodeB");
+}
+
+TEST_F(ExpiryTest, set_ReservedKey_Invalid)
+{
+    // act
+    DatabaseError_t err = databaseAPI->set(DATABASE_EXPIRY_KEY, "x");
+
+    // assert
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_KEY_INVALID);
+}
+
+TEST_F(ExpiryTest, DatabaseExpiry_SerializeRoundTrip)
+{
+    // arrange
+    DatabaseExpiry expiry;
+    DatabaseExpiry loaded;
+    ASSERT_TRUE(expiry.set("a", 1));
+    ASSERT_TRUE(expiry.set("fifteen_chars__", 0x01020304));
+    uint8_t data[64];
+    size_t const length = expiry.serializedLength();
+    ASSERT_LE(length, sizeof(data));
+    expiry.serialize(data);
+
+    // act
+    bool ok = loaded.deserialize(data, length);
+    bool truncated = loaded.deserialize(data, length - 1);
+
+    // assert
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(length, 4u + 2u + 4u + 16u);
+    EXPECT_FALSE(truncated);
+    EXPECT_EQ(loaded.count(), 0u);
+    ASSERT_TRUE(loaded.deserialize(data, length));
+    ASSERT_NE(loaded.find("fifteen_chars__"), nullptr);
+    EXPECT_EQ(loaded.find("fifteen_chars__")->expiresAt, 0x01020304u);
+}
+
+#endif // UNIT_EXPIRY_TEST_HPP
@@ -0,0 +1,186 @@
+#ifndef FAULT_INJECTING_NVS_DELEGATE_HPP
+#define FAULT_INJECTING_NVS_DELEGATE_HPP
+
+#include <Arduino.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+
+#include "MemoryNVSDelegate.hpp"
+
+// MemoryNVSDelegate counting the calls that would reach the flash, and failing those a test
+// selects. Every fault is off by default, so it behaves as MemoryNVSDelegate until a test sets one.
+class FaultInjectingNVSDelegate : public MemoryNVSDelegate
+{
+public:
+    // Counters, reset by the tests as they need
+    mutable unsigned long opens = 0;
+    mutable unsigned long reads = 0;   // get_str and get_blob filling a buffer, of keys starting with readPrefix if set
+    mutable unsigned long writes = 0;  // set_str, set_blob and erase_key
+    mutable unsigned long bytes = 0;   // bytes given to set_str, terminator included, and to set_blob
+    mutable unsigned long commits = 0;
+    char const *readPrefix = nullptr;
+
+    // Faults
+    mutable int writesLeft = -1;          // writes that succeed before a power loss, -1 for none
+    char const *failingKey = nullptr;     // key whose writes fail without a power loss
+    mutable int keyFailures = -1;         // writes of failingKey that fail, -1 for all
+    char const *failingReadKey = nullptr; // key whose reads fail
+    bool failStrings = false;             // set_str reports a full storage
+    bool failBlobs = false;               // set_blob reports a full storage
+    bool failStats = false;               // get_stats fails, so writes skip their space check
+    uint32_t commitStallMs = 0;           // delay of every commit
+
+    // Storage
+    bool separateTypes = false;  // blobs kept apart from strings, so a key can hold one of each as on NVS, unseen by erase_all and list_keys
+    bool eraseBlobFirst = false; // erase_key drops the blob of such a key before its string
+
+    NVSDelegateError_t open(
+        char const *const name, NVSDelegateOpenMode_t const open_mode, NVSDelegateHandle_t *out_handle) const override
+    {
+        opens++;
+        return MemoryNVSDelegate::open(name, open_mode, out_handle);
+    }
+
+    NVSDelegateError_t set_str(NVSDelegateHandle_t handle, char const *const key, char const *const value) const override
+    {
+        NVSDelegateError_t const err = injectWriteFault(key);
+        if (err != NVS_DELEGATE_OK)
+            return err;
+        if (failStrings)
+            return NVS_DELEGATE_NOT_ENOUGH_SPACE;
+        writes++;
+        bytes += strlen(value) + 1;
+        return MemoryNVSDelegate::set_str(handle, key, value);
+    }
+
+    NVSDelegateError_t get_str(
+        NVSDelegateHandle_t handle, char const *const key, char *out_value, size_t *length) const override
+    {
+        if (failingReadKey && strcmp(key, failingReadKey) == 0)
+            return NVS_DELEGATE_UNKOWN_ERROR;
+        if (out_value)
+            countRead(key);
+        return MemoryNVSDelegate::get_str(handle, key, out_value, length);
+    }
+
+    NVSDelegateError_t set_i64(NVSDelegateHandle_t handle, char const *const key, int64_t const value) const override
+    {
+        if (isFailingKey(key))
+            return NVS_DELEGATE_UNKOWN_ERROR;
+        return MemoryNVSDelegate::set_i64(handle, key, value);
+    }
+
+    NVSDelegateError_t set_blob(
+        NVSDelegateHandle_t handle, char const *const key, void const *const value, size_t const length) const override
+    {
+        NVSDelegateError_t const err = injectWriteFault(key);
+        if (err != NVS_DELEGATE_OK)
+            return err;
+        if (failBlobs)
+            return NVS_DELEGATE_NOT_ENOUGH_SPACE;
+        writes++;
+        bytes += length;
+        if (!separateTypes)
+            return MemoryNVSDelegate::set_blob(handle, key, value, length);
+        if (handle & 1u)
+            return NVS_DELEGATE_READONLY;
+        m_blobs[blobKey(handle, key)].assign(static_cast<char const *>(value), length);
+        return NVS_DELEGATE_OK;
+    }
+
+    NVSDelegateError_t get_blob(
+        NVSDelegateHandle_t handle, char const *const key, void *out_value, size_t *length) const override
+    {
+        if (failingReadKey && strcmp(key, failingReadKey) == 0)
+            return NVS_DELEGATE_UNKOWN_ERROR;
+        if (out_value)
+            countRead(key);
+        if (!separateTypes)
+            return MemoryNVSDelegate::get_blob(handle, key, out_value, length);
+        auto const blob = m_blobs.find(blobKey(handle, key));
+        if (blob == m_blobs.end())
+            return NVS_DELEGATE_KEY_NOT_FOUND;
+        if (out_value != nullptr)
+        {
+            if (*length < blob->second.size())
+                return NVS_DELEGATE_VALUE_INVALID;
+            memcpy(out_value, blob->second.data(), blob->second.size());
+        }
+        *length = blob->second.size();
+        return NVS_DELEGATE_OK;
+    }
+
+    NVSDelegateError_t erase_key(NVSDelegateHandle_t handle, char const *const key) const override
+    {
+        if (writesLeft == 0)
+            return NVS_DELEGATE_UNKOWN_ERROR;
+        writes++;
+        auto const blob = separateTypes ? m_blobs.find(blobKey(handle, key)) : m_blobs.end();
+        if (blob == m_blobs.end())
+            return MemoryNVSDelegate::erase_key(handle, key);
+        size_t length = 0;
+        if (!eraseBlobFirst && MemoryNVSDelegate::get_str(handle, key, nullptr, &length) == NVS_DELEGATE_OK)
+            return MemoryNVSDelegate::erase_key(handle, key);
+        m_blobs.erase(blob);
+        return NVS_DELEGATE_OK;
+    }
+
+    NVSDelegateError_t erase_flash_all() const override
+    {
+        m_blobs.clear();
+        return MemoryNVSDelegate::erase_flash_all();
+    }
+
+    NVSDelegateError_t commit(NVSDelegateHandle_t handle) const override
+    {
+        if (commitStallMs > 0)
+            delay(commitStallMs);
+        commits++;
+        return MemoryNVSDelegate::commit(handle);
+    }
+
+    NVSDelegateError_t get_stats(NVSDelegateStats_t *out_stats) const override
+    {
+        if (failStats)
+            return NVS_DELEGATE_UNKOWN_ERROR;
+        return MemoryNVSDelegate::get_stats(out_stats);
+    }
+
+private:
+    mutable std::map<std::string, std::string> m_blobs; // blobs of the namespaces, when separateTypes
+
+    // Namespace of the handle, the bit telling a READONLY open apart dropped, and key
+    static std::string blobKey(NVSDelegateHandle_t const handle, char const *const key)
+    {
+        return std::to_string(handle >> 1) + '/' + key;
+    }
+
+    bool isFailingKey(char const *const key) const
+    {
+        if (failingKey == nullptr || strcmp(key, failingKey) != 0 || keyFailures == 0)
+            return false;
+        if (keyFailures > 0)
+            keyFailures--;
+        return true;
+    }
+
+    // Power loss first, then the failures of failingKey; a write that goes through uses up one of writesLeft
+    NVSDelegateError_t injectWriteFault(char const *const key) const
+    {
+        if (writesLeft == 0 || isFailingKey(key))
+            return NVS_DELEGATE_UNKOWN_ERROR;
+        if (writesLeft > 0)
+            writesLeft--;
+        return NVS_DELEGATE_OK;
+    }
+
+    void countRead(char const *const key) const
+    {
+        if (readPrefix == nullptr || strncmp(key, readPrefix, strlen(readPrefix)) == 0)
+            reads++;
+    }
+};
+
+#endif // FAULT_INJECTING_NVS_DELEGATE_HPP
@@ -0,0 +1,175 @@
+#ifndef UNIT_ISR_QUEUE_TEST_HPP
+#define UNIT_ISR_QUEUE_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+#include "MockingClass.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseISRQueue.hpp"
+#include "NVSDelegateInterface.hpp"
+
+// setup test suite
+class ISRQueueTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        // setup mock
+        mockNVSDelegate = new MockNVSDelegate();
+        databaseAPI = new DatabaseAPI(mockNVSDelegate, "TEST_NVS");
+
+        EXPECT_CALL(*mockNVSDelegate, open(testing::StrEq("TEST_NVS"), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, ::testing::_))
+            .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+
+        EXPECT_CALL(*mockNVSDelegate, commit(::testing::_))
+            .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+
+        EXPECT_CALL(*mockNVSDelegate, close(::testing::_))
+            .WillRepeatedly(::testing::Return());
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete mockNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    DatabaseAPI *databaseAPI;
+    MockNVSDelegate *mockNVSDelegate;
+};
+
+/** Testing DatabaseISRQueue
+ * @brief Values queued from interrupt context are written by drain(), newest value per key only.
+ *
+ * @return DatabaseError_t - Error code indicating the result of the operation. Possible values:
+ * - DATABASE_OK if the value was queued.
+ * - DATABASE_KEY_INVALID if the key is invalid.
+ * - DATABASE_VALUE_INVALID if the value is invalid.
+ * - DATABASE_NOT_ENOUGH_SPACE if every slot is pending.
+ */
+
+TEST_F(ISRQueueTest, drain_CoalescesByKey)
+{
+    // arrange
+    DatabaseISRQueue queue(databaseAPI, 8);
+
+    EXPECT_CALL(*mockNVSDelegate, set_str(::testing::_, testing::StrEq("edges"), testing::StrEq("2")))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, set_str(::testing::_, testing::StrEq("edges"), testing::StrEq("1")))
+        .Times(0);
+    EXPECT_CALL(*mockNVSDelegate, set_str(::testing::_, testing::StrEq("state"), testing::StrEq("high")))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+
+    // act
+    EXPECT_EQ(queue.enqueueFromISR("edges", "1"), DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(queue.enqueueFromISR("state", "high"), DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(queue.enqueueFromISR("edges", "2"), DatabaseError_t::DATABASE_OK);
+    size_t applied = 0;
+    DatabaseError_t err = queue.drain(&applied);
+
+    // assert
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(applied, 2u);
+}
+
+TEST_F(ISRQueueTest, DATABASE_NOT_ENOUGH_SPACE)
+{
+    // arrange
+    DatabaseISRQueue queue(databaseAPI, 2);
+
+    EXPECT_CALL(*mockNVSDelegate, set_str(::testing::_, ::testing::_, ::testing::_))
+        .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+
+    // act
+    DatabaseError_t err1 = queue.enqueueFromISR("a", "1");
+    DatabaseError_t err2 = queue.enqueueFromISR("b", "1");
+    DatabaseError_t err3 = queue.enqueueFromISR("c", "1");
+    queue.drain();
+    DatabaseError_t err4 = queue.enqueueFromISR("c", "1");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_NOT_ENOUGH_SPACE);
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(queue.droppedCount(), 1u);
+}
+
+TEST_F(ISRQueueTest, DATABASE_KEY_INVALID_VALUE_INVALID)
+{
+    // arrange
+    DatabaseISRQueue queue(databaseAPI, 2);
+
+    // act
+    DatabaseError_t err1 = queue.enqueueFromISR(nullptr, "1");
+    DatabaseError_t err2 = queue.enqueueFromISR("ToLongKeyInvalid", "1");
+    DatabaseError_t err3 = queue.enqueueFromISR("key", "");
+    DatabaseError_t err4 = queue.enqueueFromISR("key", "a value that is longer than one slot");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_KEY_INVALID);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_KEY_INVALID);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_VALUE_INVALID);
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_VALUE_INVALID);
+}
+
+/**
+ * @brief A producer thread stands in for the interrupt while the drain task consumes.
+ */
+TEST_F(ISRQueueTest, drainTask_ConcurrentProducer)
+{
+    // arrange
+    int const eventCount = 500;
+    int lastWritten = -1;
+    bool ordered = true;
+
+    EXPECT_CALL(*mockNVSDelegate, set_str(::testing::_, testing::StrEq("edges"), ::testing::NotNull()))
+        .WillRepeatedly(::testing::Invoke(
+            [&](NVSDelegateHandle_t, char const *const, char const *const value)
+            {
+                int written = atoi(value);
+                ordered = ordered && written > lastWritten;
+                lastWritten = written;
+                return NVSDelegateError_t::NVS_DELEGATE_OK;
+            }));
+
+    DatabaseISRQueue queue(databaseAPI, 4);
+    ASSERT_EQ(queue.startDrainTask(1), DatabaseError_t::DATABASE_OK);
+
+    // act
+    std::thread producer(
+        [&queue, eventCount]()
+        {
+            char value[12];
+            for (int i = 0; i < eventCount; ++i)
+            {
+                snprintf(value, sizeof(value), "%d", i);
+                while (queue.enqueueFromISR("edges", value) == DATABASE_NOT_ENOUGH_SPACE)
+                    delay(1);
+            }
+        });
+    producer.join();
+    queue.stopDrainTask();
+
+    // assert
+    EXPECT_TRUE(ordered);
+    EXPECT_EQ(lastWritten, eventCount - 1);
+}
+
+#endif // UNIT_ISR_QUEUE_TEST_HPP
@@ -0,0 +1,209 @@
+#ifndef UNIT_JOB_TEST_HPP
+#define UNIT_JOB_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "MemoryNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseJob.hpp"
+#include "MockingClass.hpp"
+#include "NamespaceImage_test.hpp" // ImageBuffer
+
+// setup test suite
+class JobTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        memoryNVSDelegate = new MemoryNVSDelegate();
+        databaseAPI = new DatabaseAPI(memoryNVSDelegate, "TEST_NVS");
+        buffer.length = 0;
+        buffer.position = 0;
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete memoryNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    static bool writeBuffer(uint8_t const *const data, size_t const length, void *context)
+    {
+        ImageBuffer *const image = static_cast<ImageBuffer *>(context);
+        if (image->length + length > sizeof(image->data))
+            return false;
+        memcpy(image->data + image->length, data, length);
+        image->length += length;
+        return true;
+    }
+
+    static bool readBuffer(uint8_t *data, size_t const length, void *context)
+    {
+        ImageBuffer *const image = static_cast<ImageBuffer *>(context);
+        if (image->position + length > image->length)
+            return false;
+        memcpy(data, image->data + image->position, length);
+        image->position += length;
+        return true;
+    }
+
+    // Steps a job with a zero budget until it is done, returns the number of steps
+    size_t runToCompletion(DatabaseJob &job)
+    {
+        size_t steps = 0;
+        while (!job.isDone() && steps < 100)
+        {
+            job.step(0);
+            steps++;
+        }
+        return steps;
+    }
+
+    DatabaseAPI *databaseAPI;
+    MemoryNVSDelegate *memoryNVSDelegate;
+    ImageBuffer buffer;
+};
+
+/** Testing DatabaseAPI::startEraseAll
+ * @brief Each step removes one key with a zero budget, the last one erases what is left.
+ */
+TEST_F(JobTest, eraseAllStepByStep)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->enableExpiry(), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("k1", "v1"), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("k2", "v2"), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("k3", "v3", 60), DATABASE_OK);
+    DatabaseJob job;
+
+    // act
+    DatabaseError_t const err = databaseAPI->startEraseAll(&job);
+    size_t const remaining = job.remaining();
+    ASSERT_EQ(job.step(0), DATABASE_OK);
+    size_t const remainingAfterStep = job.remaining();
+    size_t const steps = runToCompletion(job);
+
+    // assert
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_EQ(remaining, 3u);
+    EXPECT_EQ(remainingAfterStep, 2u);
+    EXPECT_EQ(steps, 3u);
+    EXPECT_TRUE(job.isDone());
+    EXPECT_EQ(job.result(), DATABASE_OK);
+    EXPECT_EQ(databaseAPI->isExist("k1"), DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(databaseAPI->isExist("k3"), DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(databaseAPI->set("k3", "again"), DATABASE_OK); // the expiry table went with the namespace
+    char value[16] = {0};
+    EXPECT_EQ(databaseAPI->get("k3", value, sizeof(value)), DATABASE_OK);
+}
+
+/** Testing DatabaseAPI::startCommit
+ * @brief A zero budget writes one key per step, a large budget finishes the job in one step.
+ */
+TEST_F(JobTest, commitStepByStep)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->set("old", "value"), DATABASE_OK);
+    DatabaseBatch batch;
+    ASSERT_EQ(batch.set("a", "1"), DATABASE_OK);
+    ASSERT_EQ(batch.set("b", "2"), DATABASE_OK);
+    ASSERT_EQ(batch.remove("old"), DATABASE_OK);
+    ASSERT_EQ(batch.set("c", "3"), DATABASE_OK);
+    DatabaseJob job;
+
+    // act
+    DatabaseError_t const err = databaseAPI->startCommit(batch, &job);
+    batch.clear(); // the job holds its own copy
+    ASSERT_EQ(job.step(0), DATABASE_OK);
+    DatabaseError_t const firstWritten = databaseAPI->isExist("a");
+    DatabaseError_t const secondWritten = databaseAPI->isExist("b");
+    ASSERT_EQ(job.step(1000000), DATABASE_OK);
+
+    // assert
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_EQ(firstWritten, DATABASE_OK);
+    EXPECT_EQ(secondWritten, DATABASE_KEY_NOT_FOUND);
+    EXPECT_TRUE(job.isDone());
+    EXPECT_EQ(job.remaining(), 0u);
+    EXPECT_EQ(databaseAPI->isExist("c"), DATABASE_OK);
+    EXPECT_EQ(databaseAPI->isExist("old"), DATABASE_KEY_NOT_FOUND);
+}
+
+/** Testing DatabaseAPI::startImport
+ * @brief An exported image is written back step by step; a corrupted one is rejected before any write.
+ */
+TEST_F(JobTest, importStepByStep)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->set("ssid", "office"), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("password", "secret"), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->exportNamespace(writeBuffer, &buffer), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->eraseAll(), DATABASE_OK);
+    DatabaseJob job;
+
+    // act
+    buffer.data[buffer.length - 1] ^= 0x01;
+    DatabaseError_t const corruptedErr = databaseAPI->startImport(readBuffer, &buffer, &job);
+    bool const corruptedDone = job.isDone();
+    buffer.data[buffer.length - 1] ^= 0x01;
+    buffer.position = 0;
+    DatabaseError_t const err = databaseAPI->startImport(readBuffer, &buffer, &job);
+    size_t const steps = runToCompletion(job);
+
+    // assert
+    EXPECT_EQ(corruptedErr, DATABASE_VALUE_INVALID);
+    EXPECT_TRUE(corruptedDone);
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_EQ(steps, 2u);
+    EXPECT_EQ(job.result(), DATABASE_OK);
+    char value[16] = {0};
+    ASSERT_EQ(databaseAPI->get("password", value, sizeof(value)), DATABASE_OK);
+    EXPECT_STREQ(value, "secret");
+}
+
+/** Testing DatabaseJob
+ * @brief A job never started is done, a failed write stops the job with its error.
+ */
+TEST_F(JobTest, resultAndInvalidArguments)
+{
+    // arrange
+    DatabaseJob job;
+    DatabaseBatch batch;
+    ASSERT_EQ(batch.set("key", "value"), DATABASE_OK);
+    MockNVSDelegate *mockNVSDelegate = new MockNVSDelegate();
+    DatabaseAPI *failingDatabaseAPI = new DatabaseAPI(mockNVSDelegate, "TEST_NVS");
+    EXPECT_CALL(*mockNVSDelegate, open(::testing::_, NVSDelegateOpenMode_t::NVSDelegate_READWRITE, ::testing::_))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_UNKOWN_ERROR));
+
+    // act
+    DatabaseError_t const idleStep = job.step(0);
+    bool const idleDone = job.isDone();
+    ASSERT_EQ(failingDatabaseAPI->startCommit(batch, &job), DATABASE_OK);
+    DatabaseError_t const failedStep = job.step(0);
+    delete failingDatabaseAPI;
+    delete mockNVSDelegate;
+
+    // assert
+    EXPECT_EQ(idleStep, DATABASE_OK);
+    EXPECT_TRUE(idleDone);
+    EXPECT_EQ(failedStep, DATABASE_ERROR);
+    EXPECT_TRUE(job.isDone());
+    EXPECT_EQ(job.result(), DATABASE_ERROR);
+    EXPECT_EQ(databaseAPI->startEraseAll(nullptr), DATABASE_VALUE_INVALID);
+    EXPECT_EQ(databaseAPI->startCommit(batch, nullptr), DATABASE_VALUE_INVALID);
+    EXPECT_EQ(databaseAPI->startImport(nullptr, &buffer, &job), DATABASE_VALUE_INVALID);
+}
+
+#endif // UNIT_JOB_TEST_HPP
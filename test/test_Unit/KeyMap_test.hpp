@@ -0,0 +1,175 @@
+#ifndef UNIT_KEY_MAP_TEST_HPP
+#define UNIT_KEY_MAP_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+
+#include "FaultInjectingNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseKeyMap.hpp"
+
+// Two keys with the same FNV-1a hash, 0x476e4614
+#define KEY_MAP_TEST_KEY "sensor/1149599/name"
+#define KEY_MAP_TEST_COLLIDING_KEY "sensor/1312382/name"
+
+// setup test suite
+class KeyMapTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        faultInjectingNVSDelegate = new FaultInjectingNVSDelegate();
+        databaseAPI = new DatabaseAPI(faultInjectingNVSDelegate, "TEST_NVS");
+        keyMap = new DatabaseKeyMap(databaseAPI);
+    }
+
+    void TearDown() override
+    {
+        delete keyMap;
+        delete databaseAPI;
+        delete faultInjectingNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Visitor collecting "key=value" into a std::set
+    static bool collect(char const *const key, char const *const value, void *context)
+    {
+        static_cast<std::set<std::string> *>(context)->insert(std::string(key) + "=" + value);
+        return true;
+    }
+
+    DatabaseAPI *databaseAPI;
+    FaultInjectingNVSDelegate *faultInjectingNVSDelegate;
+    DatabaseKeyMap *keyMap;
+};
+
+/** Testing set and get Methods of DatabaseKeyMap class
+ * @brief A key longer than NVS allows is stored under its hash key and read back.
+ */
+TEST_F(KeyMapTest, longKey)
+{
+    // arrange
+    char longest[DATABASE_KEY_MAP_MAX_KEY_LENGTH + 1];
+    memset(longest, 'k', sizeof(longest) - 1);
+    longest[sizeof(longest) - 1] = '\0';
+    char value[32] = {0};
+    ASSERT_EQ(keyMap->get("wifi/backup/2/password", value, sizeof(value)), DATABASE_ERROR); // not started
+    ASSERT_EQ(keyMap->begin(), DATABASE_OK);
+
+    // act
+    DatabaseError_t const err = keyMap->set("wifi/backup/2/password", "secret");
+    DatabaseError_t const getErr = keyMap->get("wifi/backup/2/password", value, sizeof(value));
+
+    // assert
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_EQ(getErr, DATABASE_OK);
+    EXPECT_STREQ(value, "secret");
+    EXPECT_EQ(keyMap->isExist("wifi/backup/2/password"), DATABASE_OK);
+    EXPECT_EQ(keyMap->isExist("wifi/backup/3/password"), DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(keyMap->collisions(), 0u);
+    EXPECT_EQ(keyMap->set(longest, "value"), DATABASE_KEY_INVALID);
+    EXPECT_EQ(keyMap->set("wifi/backup/2/password", ""), DATABASE_VALUE_INVALID);
+    EXPECT_EQ(keyMap->remove("wifi/backup/2/password"), DATABASE_OK);
+    EXPECT_EQ(keyMap->remove("wifi/backup/2/password"), DATABASE_KEY_NOT_FOUND);
+}
+
+/** Testing set Method of DatabaseKeyMap class
+ * @brief Keys sharing a hash are both kept, through the collision table, also after a restart.
+ */
+TEST_F(KeyMapTest, collision)
+{
+    // arrange
+    ASSERT_EQ(keyMap->begin(), DATABASE_OK);
+    char value[32] = {0};
+    char collidingValue[32] = {0};
+
+    // act
+    ASSERT_EQ(keyMap->set(KEY_MAP_TEST_KEY, "first"), DATABASE_OK);
+    ASSERT_EQ(keyMap->set(KEY_MAP_TEST_COLLIDING_KEY, "second"), DATABASE_OK);
+    ASSERT_EQ(keyMap->set(KEY_MAP_TEST_COLLIDING_KEY, "updated"), DATABASE_OK);
+    DatabaseKeyMap *const reopened = new DatabaseKeyMap(databaseAPI);
+    ASSERT_EQ(reopened->begin(), DATABASE_OK);
+    DatabaseError_t const err = reopened->get(KEY_MAP_TEST_KEY, value, sizeof(value));
+    DatabaseError_t const collidingErr = reopened->get(KEY_MAP_TEST_COLLIDING_KEY, collidingValue, sizeof(collidingValue));
+    size_t const collisions = reopened->collisions();
+    delete reopened;
+
+    // assert
+    EXPECT_EQ(keyMap->collisions(), 1u);
+    EXPECT_EQ(collisions, 1u);
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_STREQ(value, "first");
+    EXPECT_EQ(collidingErr, DATABASE_OK);
+    EXPECT_STREQ(collidingValue, "updated");
+    EXPECT_EQ(keyMap->remove(KEY_MAP_TEST_KEY), DATABASE_OK);
+    EXPECT_EQ(keyMap->isExist(KEY_MAP_TEST_COLLIDING_KEY), DATABASE_OK);
+    EXPECT_EQ(keyMap->remove(KEY_MAP_TEST_COLLIDING_KEY), DATABASE_OK);
+    EXPECT_EQ(keyMap->collisions(), 0u);
+    EXPECT_EQ(databaseAPI->isExist("#" DATABASE_KEY_MAP_TABLE_SUFFIX), DATABASE_KEY_NOT_FOUND); // empty table removed
+}
+
+/** Testing get Method of DatabaseKeyMap class
+ * @brief A lookup reads one value from the flash, as a DatabaseAPI get, with or without collision.
+ */
+TEST_F(KeyMapTest, lookupReadsOnce)
+{
+    // arrange
+    ASSERT_EQ(keyMap->begin(), DATABASE_OK);
+    ASSERT_EQ(keyMap->set(KEY_MAP_TEST_KEY, "first"), DATABASE_OK);
+    ASSERT_EQ(keyMap->set(KEY_MAP_TEST_COLLIDING_KEY, "second"), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("plain", "value"), DATABASE_OK);
+    char value[32];
+
+    // act
+    unsigned long const start = faultInjectingNVSDelegate->reads;
+    ASSERT_EQ(databaseAPI->get("plain", value, sizeof(value)), DATABASE_OK);
+    unsigned long const plainReads = faultInjectingNVSDelegate->reads - start;
+    ASSERT_EQ(keyMap->get(KEY_MAP_TEST_KEY, value, sizeof(value)), DATABASE_OK);
+    unsigned long const mappedReads = faultInjectingNVSDelegate->reads - start - plainReads;
+    ASSERT_EQ(keyMap->get(KEY_MAP_TEST_COLLIDING_KEY, value, sizeof(value)), DATABASE_OK);
+    unsigned long const collidingReads = faultInjectingNVSDelegate->reads - start - plainReads - mappedReads;
+
+    // assert
+    EXPECT_EQ(plainReads, 1u);
+    EXPECT_EQ(mappedReads, plainReads);
+    EXPECT_EQ(collidingReads, plainReads);
+}
+
+/** Testing forEach Method of DatabaseKeyMap class
+ * @brief Every key of the map is listed by its original name, keys of the database outside the map are not.
+ */
+TEST_F(KeyMapTest, forEach)
+{
+    // arrange
+    ASSERT_EQ(keyMap->begin(), DATABASE_OK);
+    ASSERT_EQ(keyMap->set("wifi/backup/2/password", "secret"), DATABASE_OK);
+    ASSERT_EQ(keyMap->set(KEY_MAP_TEST_KEY, "first"), DATABASE_OK);
+    ASSERT_EQ(keyMap->set(KEY_MAP_TEST_COLLIDING_KEY, "second"), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("plain", "value"), DATABASE_OK);
+    std::set<std::string> listed;
+
+    // act
+    DatabaseError_t const err = keyMap->forEach(collect, &listed);
+
+    // assert
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_EQ(listed, (std::set<std::string>{
+                          "wifi/backup/2/password=secret",
+                          KEY_MAP_TEST_KEY "=first",
+                          KEY_MAP_TEST_COLLIDING_KEY "=second"}));
+    EXPECT_EQ(keyMap->forEach(nullptr, nullptr), DATABASE_VALUE_INVALID);
+}
+
+#endif // UNIT_KEY_MAP_TEST_HPP
@@ -0,0 +1,235 @@
+#ifndef UNIT_MAINTENANCE_TEST_HPP
+#define UNIT_MAINTENANCE_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "MemoryNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseMaintenance.hpp"
+
+// Clock the tests move forward by hand
+static uint32_t maintenanceTestNow = 1000;
+static uint32_t maintenanceTestClock()
+{
+    return maintenanceTestNow;
+}
+
+// setup test suite
+class MaintenanceTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        maintenanceTestNow = 1000;
+        memoryNVSDelegate = new MemoryNVSDelegate();
+        databaseAPI = new DatabaseAPI(memoryNVSDelegate, "TEST_NVS");
+        databaseAPI->setClock(maintenanceTestClock);
+        maintenance = new DatabaseMaintenance(databaseAPI);
+    }
+
+    void TearDown() override
+    {
+        delete maintenance;
+        delete databaseAPI;
+        delete memoryNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Idle detector reporting the value of a bool
+    static bool flagDetector(DatabaseAPI *const database, void *context)
+    {
+        return *static_cast<bool *>(context);
+    }
+
+    // Value of a counter as persisted in a namespace, what a restart reads
+    int64_t storedCounter(char const *const nvsNamespace, char const *const key)
+    {
+        NVSDelegateHandle_t handle;
+        int64_t value = 0;
+        if (memoryNVSDelegate->open(nvsNamespace, NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle) != NVSDelegateError_t::NVS_DELEGATE_OK)
+            return 0;
+        memoryNVSDelegate->get_i64(handle, key, &value);
+        memoryNVSDelegate->close(handle);
+        return value;
+    }
+
+    DatabaseAPI *databaseAPI;
+    MemoryNVSDelegate *memoryNVSDelegate;
+    DatabaseMaintenance *maintenance;
+};
+
+/** Testing getSpaceStats Method of DatabaseAPI class
+ * @brief A string takes a header and one entry per 32 bytes, the namespace one entry.
+ */
+TEST_F(MaintenanceTest, getSpaceStats)
+{
+    // arrange
+    char value[101];
+    memset(value, 'a', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+    NVSDelegateStats_t empty;
+    NVSDelegateStats_t stats;
+
+    // act
+    DatabaseError_t const emptyErr = databaseAPI->getSpaceStats(&empty);
+    ASSERT_EQ(databaseAPI->set("key", value), DATABASE_OK);
+    DatabaseError_t const err = databaseAPI->getSpaceStats(&stats);
+
+    // assert
+    EXPECT_EQ(emptyErr, DATABASE_OK);
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_EQ(stats.usedEntries - empty.usedEntries, 1u + 1u + 4u);
+    EXPECT_EQ(stats.usedEntries + stats.freeEntries, stats.totalEntries);
+    EXPECT_EQ(stats.totalEntries, (size_t)MEMORY_NVS_DELEGATE_TOTAL_ENTRIES);
+    EXPECT_EQ(stats.namespaceCount, empty.namespaceCount + 1);
+    EXPECT_EQ(databaseAPI->getSpaceStats(nullptr), DATABASE_VALUE_INVALID);
+}
+
+/** Testing step Method of DatabaseMaintenance class
+ * @brief Nothing runs until the database has been idle long enough and free entries are below the watermark.
+ */
+TEST_F(MaintenanceTest, stepWaitsForIdleAndWatermark)
+{
+    // arrange
+    maintenance->setIdleTime(50);
+    bool aboveWatermark = true;
+    bool busy = true;
+    bool idle = false;
+
+    // act
+    ASSERT_EQ(databaseAPI->set("key", "value"), DATABASE_OK);
+    ASSERT_EQ(maintenance->step(&busy), DATABASE_OK);
+    delay(60);
+    maintenance->setWatermark(0);
+    ASSERT_EQ(maintenance->step(&aboveWatermark), DATABASE_OK);
+    maintenance->setWatermark(MEMORY_NVS_DELEGATE_TOTAL_ENTRIES + 1);
+    ASSERT_EQ(maintenance->step(&idle), DATABASE_OK);
+
+    // assert
+    EXPECT_FALSE(busy);
+    EXPECT_FALSE(aboveWatermark);
+    EXPECT_TRUE(idle);
+    EXPECT_GE(databaseAPI->getIdleTime(), 60u);
+    EXPECT_EQ(maintenance->reclaimCount(), 1u);
+}
+
+/** Testing step Method of DatabaseMaintenance class
+ * @brief Steps persist pending counters, erase the stale generation, then sweep expired keys a few at a time.
+ */
+TEST_F(MaintenanceTest, stepReclaimsInTurn)
+{
+    // arrange
+    DatabaseBatch batch;
+    ASSERT_EQ(batch.set("kept", "value"), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->replaceAll(batch), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->enableExpiry(), DATABASE_OK);
+    char key[16];
+    for (int i = 0; i < DATABASE_MAINTENANCE_SWEEP_KEYS + 1; i++)
+    {
+        snprintf(key, sizeof(key), "ttl%d", i);
+        ASSERT_EQ(databaseAPI->set(key, "value", 10), DATABASE_OK);
+    }
+    databaseAPI->setCounterPersistPolicy(100, 0);
+    ASSERT_EQ(databaseAPI->increment("boots", 3), DATABASE_OK);
+    maintenanceTestNow += 20;
+    bool idle = true;
+    maintenance->setIdleDetector(flagDetector, &idle);
+    maintenance->setWatermark(MEMORY_NVS_DELEGATE_TOTAL_ENTRIES + 1);
+    NVSDelegateStats_t before;
+    NVSDelegateStats_t after;
+    ASSERT_EQ(databaseAPI->getSpaceStats(&before), DATABASE_OK);
+
+    // act
+    ASSERT_EQ(maintenance->step(), DATABASE_OK); // counters and stale generation
+    ASSERT_EQ(maintenance->step(), DATABASE_OK); // four expired keys
+    ASSERT_EQ(maintenance->step(), DATABASE_OK); // the last expired key
+    ASSERT_EQ(databaseAPI->getSpaceStats(&after), DATABASE_OK);
+    idle = false;
+    bool worked = true;
+    ASSERT_EQ(maintenance->step(&worked), DATABASE_OK);
+
+    // assert
+    EXPECT_LT(after.usedEntries, before.usedEntries);
+    EXPECT_EQ(maintenance->reclaimCount(), 3u);
+    EXPECT_FALSE(worked);
+    EXPECT_EQ(databaseAPI->isExist("kept"), DATABASE_OK);
+    EXPECT_EQ(databaseAPI->isExist("ttl0"), DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(storedCounter("TEST_NVS~1", "boots"), 3); // replaceAll moved the namespace to its shadow
+}
+
+/** Testing step Method of DatabaseMaintenance class
+ * @brief Pending counters are persisted on an idle step even with free entries above the watermark.
+ */
+TEST_F(MaintenanceTest, stepPersistsCountersAboveWatermark)
+{
+    // arrange
+    databaseAPI->setCounterPersistPolicy(100, 0);
+    ASSERT_EQ(databaseAPI->increment("boots", 3), DATABASE_OK);
+    bool idle = true;
+    maintenance->setIdleDetector(flagDetector, &idle);
+    maintenance->setWatermark(0);
+    bool worked = true;
+
+    // act
+    DatabaseError_t const err = maintenance->step(&worked);
+
+    // assert
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_FALSE(worked);
+    EXPECT_EQ(maintenance->reclaimCount(), 0u);
+    EXPECT_EQ(storedCounter("TEST_NVS", "boots"), 3);
+}
+
+/** Testing start Method of DatabaseMaintenance class
+ * @brief The background task steps while the detector reports idle, and no longer once stopped.
+ */
+TEST_F(MaintenanceTest, backgroundTask)
+{
+    // arrange
+    bool idle = true;
+    maintenance->setIdleDetector(flagDetector, &idle);
+    maintenance->setWatermark(MEMORY_NVS_DELEGATE_TOTAL_ENTRIES + 1);
+
+    // act
+    DatabaseError_t const err = maintenance->start(5);
+    delay(50);
+    maintenance->stop();
+    uint32_t const stepped = maintenance->reclaimCount();
+    delay(20);
+
+    // assert
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_GT(stepped, 1u);
+    EXPECT_EQ(maintenance->reclaimCount(), stepped);
+}
+
+/** Testing stop Method of DatabaseMaintenance class
+ * @brief Stopping wakes the background task instead of waiting for its period to elapse.
+ */
+TEST_F(MaintenanceTest, stopDoesNotWaitForPeriod)
+{
+    // arrange
+    ASSERT_EQ(maintenance->start(10000), DATABASE_OK);
+    delay(20);
+
+    // act
+    unsigned long const start = millis();
+    maintenance->stop();
+    unsigned long const elapsed = millis() - start;
+
+    // assert
+    EXPECT_LT(elapsed, 1000u);
+}
+
+#endif // UNIT_MAINTENANCE_TEST_HPP
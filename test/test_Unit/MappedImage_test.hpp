@@ -0,0 +1,147 @@
+#ifndef UNIT_MAPPED_IMAGE_TEST_HPP
+#define UNIT_MAPPED_IMAGE_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "DatabaseImage.hpp"
+#include "DatabaseMappedImage.hpp"
+#include "NamespaceImage_test.hpp" // ImageBuffer
+
+// setup test suite
+class MappedImageTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+
+        // An image followed by erased flash, as in a partition
+        memset(certificate, 'C', sizeof(certificate) - 1);
+        certificate[sizeof(certificate) - 1] = '\0';
+        memset(buffer.data, 0xFF, sizeof(buffer.data));
+        buffer.length = 0;
+        DatabaseImage image(writeBuffer, &buffer);
+        ASSERT_TRUE(image.begin());
+        ASSERT_TRUE(image.add("ca", certificate));
+        ASSERT_TRUE(image.add("table", "0,1,4,9,16"));
+        ASSERT_TRUE(image.end());
+    }
+
+    void TearDown() override
+    {
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    static bool writeBuffer(uint8_t const *const data, size_t const length, void *context)
+    {
+        ImageBuffer *const image = static_cast<ImageBuffer *>(context);
+        if (image->length + length > sizeof(image->data))
+            return false;
+        memcpy(image->data + image->length, data, length);
+        image->length += length;
+        return true;
+    }
+
+    ImageBuffer buffer;
+    char certificate[300];
+};
+
+/** Testing DatabaseMappedImage::get
+ * @brief A view points straight into the image, without copying the value.
+ */
+TEST_F(MappedImageTest, viewPointsIntoImage)
+{
+    // arrange
+    DatabaseMappedImage image(buffer.data, sizeof(buffer.data));
+    ASSERT_EQ(image.begin(), DATABASE_OK);
+    DatabaseMappedView ca;
+    DatabaseMappedView table;
+
+    // act
+    DatabaseError_t err1 = image.get("ca", &ca);
+    DatabaseError_t err2 = image.get("table", &table);
+
+    // assert
+    EXPECT_EQ(err1, DATABASE_OK);
+    EXPECT_EQ(err2, DATABASE_OK);
+    EXPECT_EQ(image.count(), 2u);
+    ASSERT_EQ(ca.length(), strlen(certificate));
+    EXPECT_EQ(memcmp(ca.data(), certificate, ca.length()), 0);
+    EXPECT_GE(reinterpret_cast<uint8_t const *>(ca.data()), buffer.data);
+    EXPECT_LT(reinterpret_cast<uint8_t const *>(ca.data()), buffer.data + buffer.length);
+    ASSERT_EQ(table.length(), 10u);
+    EXPECT_EQ(memcmp(table.data(), "0,1,4,9,16", 10), 0);
+}
+
+/** Testing DatabaseMappedImage::end
+ * @brief The image is not unmapped while a view holds one of its values.
+ */
+TEST_F(MappedImageTest, viewKeepsImageMapped)
+{
+    // arrange
+    DatabaseMappedImage image(buffer.data, sizeof(buffer.data));
+    ASSERT_EQ(image.begin(), DATABASE_OK);
+    DatabaseMappedView view;
+    ASSERT_EQ(image.get("ca", &view), DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = image.end();
+    ASSERT_EQ(image.get("table", &view), DATABASE_OK); // replaces the value held
+    view.release();
+    DatabaseError_t err2 = image.end();
+
+    // assert
+    EXPECT_EQ(err1, DATABASE_ERROR);
+    EXPECT_EQ(err2, DATABASE_OK);
+    EXPECT_EQ(view.data(), nullptr);
+    EXPECT_EQ(view.length(), 0u);
+    EXPECT_EQ(image.get("ca", &view), DATABASE_ERROR);
+}
+
+/** Testing DatabaseMappedImage::get
+ * @brief Missing and invalid keys are reported, leaving the view empty.
+ */
+TEST_F(MappedImageTest, DATABASE_KEY_NOT_FOUND)
+{
+    // arrange
+    DatabaseMappedImage image(buffer.data, sizeof(buffer.data));
+    ASSERT_EQ(image.begin(), DATABASE_OK);
+    DatabaseMappedView view;
+
+    // act & assert
+    EXPECT_EQ(image.get("c", &view), DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(image.get("tables", &view), DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(image.get("", &view), DATABASE_KEY_INVALID);
+    EXPECT_EQ(image.get("a_very_long_key_name", &view), DATABASE_KEY_INVALID);
+    EXPECT_EQ(image.get("ca", nullptr), DATABASE_VALUE_INVALID);
+    EXPECT_EQ(view.data(), nullptr);
+}
+
+/** Testing DatabaseMappedImage::begin
+ * @brief A corrupted or truncated image is rejected, and a missing partition or file is reported.
+ */
+TEST_F(MappedImageTest, DATABASE_VALUE_INVALID)
+{
+    // arrange
+    DatabaseMappedImage truncated(buffer.data, buffer.length - 1);
+    DatabaseMappedImage missing("no_such_image");
+    buffer.data[10] ^= 0x01;
+    DatabaseMappedImage corrupted(buffer.data, sizeof(buffer.data));
+
+    // act & assert
+    EXPECT_EQ(truncated.begin(), DATABASE_VALUE_INVALID);
+    EXPECT_EQ(corrupted.begin(), DATABASE_VALUE_INVALID);
+    EXPECT_EQ(missing.begin(), DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(corrupted.count(), 0u);
+}
+
+#endif // UNIT_MAPPED_IMAGE_TEST_HPP
@@ -0,0 +1,175 @@
+#ifndef UNIT_MEMORY_NVS_DELEGATE_TEST_HPP
+#define UNIT_MEMORY_NVS_DELEGATE_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "MemoryNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "NVSDelegateInterface.hpp"
+
+// setup test suite
+class MemoryNVSDelegateTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        memoryNVSDelegate = new MemoryNVSDelegate();
+    }
+
+    void TearDown() override
+    {
+        delete memoryNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Counts the keys passed to a list_keys callback
+    static bool countKey(char const *const key, void *context)
+    {
+        (*static_cast<size_t *>(context))++;
+        return true;
+    }
+
+    MemoryNVSDelegate *memoryNVSDelegate;
+};
+
+/** Testing MemoryNVSDelegate class
+ * @brief Behaves like NVSDelegate, from many tasks at once.
+ */
+
+TEST_F(MemoryNVSDelegateTest, open_ReadonlyBeforeWrite_NotFound)
+{
+    // arrange
+    NVSDelegateHandle_t handle;
+
+    // act
+    NVSDelegateError_t err1 = memoryNVSDelegate->open("ns", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+    NVSDelegateError_t err2 = memoryNVSDelegate->open("ns", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+    NVSDelegateError_t err3 = memoryNVSDelegate->open("ns", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+    NVSDelegateError_t err4 = memoryNVSDelegate->open("namespace_too_long", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+
+    // assert
+    EXPECT_EQ(err1, NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND);
+    EXPECT_EQ(err2, NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(err3, NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(err4, NVSDelegateError_t::NVS_DELEGATE_NAMESPACE_INVALID);
+}
+
+TEST_F(MemoryNVSDelegateTest, setGetErase_Value)
+{
+    // arrange
+    NVSDelegateHandle_t writer;
+    NVSDelegateHandle_t reader;
+    ASSERT_EQ(memoryNVSDelegate->open("ns", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &writer), NVSDelegateError_t::NVS_DELEGATE_OK);
+    ASSERT_EQ(memoryNVSDelegate->open("ns", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &reader), NVSDelegateError_t::NVS_DELEGATE_OK);
+    char value[16];
+    size_t length = 0;
+
+    // act & assert
+    EXPECT_EQ(memoryNVSDelegate->set_str(writer, "key", "value"), NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(memoryNVSDelegate->set_str(writer, "key", "newValue"), NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(memoryNVSDelegate->set_str(reader, "key", "value"), NVSDelegateError_t::NVS_DELEGATE_READONLY);
+    EXPECT_EQ(memoryNVSDelegate->commit(writer), NVSDelegateError_t::NVS_DELEGATE_OK);
+
+    EXPECT_EQ(memoryNVSDelegate->get_str(reader, "key", nullptr, &length), NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(length, strlen("newValue") + 1);
+    length = 4;
+    EXPECT_EQ(memoryNVSDelegate->get_str(reader, "key", value, &length), NVSDelegateError_t::NVS_DELEGATE_VALUE_INVALID);
+    length = sizeof(value);
+    EXPECT_EQ(memoryNVSDelegate->get_str(reader, "key", value, &length), NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_STREQ(value, "newValue");
+
+    EXPECT_EQ(memoryNVSDelegate->erase_key(reader, "key"), NVSDelegateError_t::NVS_DELEGATE_READONLY);
+    EXPECT_EQ(memoryNVSDelegate->erase_key(writer, "key"), NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(memoryNVSDelegate->erase_key(writer, "key"), NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND);
+    EXPECT_EQ(memoryNVSDelegate->get_str(reader, "key", nullptr, &length), NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND);
+    EXPECT_EQ(memoryNVSDelegate->get_str(0, "key", nullptr, &length), NVSDelegateError_t::NVS_DELEGATE_HANDLE_INVALID);
+}
+
+TEST_F(MemoryNVSDelegateTest, eraseAll_listKeys_PerNamespace)
+{
+    // arrange
+    NVSDelegateHandle_t first;
+    NVSDelegateHandle_t second;
+    ASSERT_EQ(memoryNVSDelegate->open("first", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &first), NVSDelegateError_t::NVS_DELEGATE_OK);
+    ASSERT_EQ(memoryNVSDelegate->open("second", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &second), NVSDelegateError_t::NVS_DELEGATE_OK);
+    char key[16];
+    for (int i = 0; i < 40; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        ASSERT_EQ(memoryNVSDelegate->set_str(first, key, "value"), NVSDelegateError_t::NVS_DELEGATE_OK);
+    }
+    ASSERT_EQ(memoryNVSDelegate->set_str(second, "key", "value"), NVSDelegateError_t::NVS_DELEGATE_OK);
+    size_t firstCount = 0;
+    size_t secondCount = 0;
+    size_t flashCount = 0;
+
+    // act
+    EXPECT_EQ(memoryNVSDelegate->list_keys("first", countKey, &firstCount), NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(memoryNVSDelegate->erase_all(first), NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(memoryNVSDelegate->list_keys("first", countKey, &firstCount), NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(memoryNVSDelegate->list_keys("second", countKey, &secondCount), NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(memoryNVSDelegate->erase_flash_all(), NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(memoryNVSDelegate->list_keys("second", countKey, &flashCount), NVSDelegateError_t::NVS_DELEGATE_OK);
+
+    // assert
+    EXPECT_EQ(firstCount, 40);
+    EXPECT_EQ(secondCount, 1);
+    EXPECT_EQ(flashCount, 0);
+    EXPECT_EQ(memoryNVSDelegate->open("second", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &second), NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND);
+}
+
+/**
+ * @brief Several tasks, each with its own DatabaseAPI and handles, write and read their own keys at once.
+ */
+TEST_F(MemoryNVSDelegateTest, databaseAPI_ConcurrentTasks)
+{
+    // arrange
+    std::atomic<int> failures(0);
+    std::vector<std::thread> tasks;
+
+    // act
+    for (int t = 0; t < 4; t++)
+    {
+        tasks.push_back(std::thread(
+            [this, t, &failures]()
+            {
+                DatabaseAPI databaseAPI(memoryNVSDelegate, "shared");
+                char key[16];
+                char value[16];
+                char actual[16];
+                for (int i = 0; i < 100; i++)
+                {
+                    snprintf(key, sizeof(key), "t%d_%d", t, i % 10);
+                    snprintf(value, sizeof(value), "%d", i);
+                    if (databaseAPI.set(key, value) != DATABASE_OK)
+                        failures++;
+                    if (databaseAPI.get(key, actual, sizeof(actual)) != DATABASE_OK || strcmp(actual, value) != 0)
+                        failures++;
+                }
+            }));
+    }
+    for (size_t i = 0; i < tasks.size(); i++)
+        tasks[i].join();
+    size_t count = 0;
+    memoryNVSDelegate->list_keys("shared", countKey, &count);
+
+    // assert
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(count, 40);
+}
+
+#endif // UNIT_MEMORY_NVS_DELEGATE_TEST_HPP
@@ -11,14 +11,34 @@
 class MockNVSDelegate : public NVSDelegateInterface
 {
 public:
+    // DatabaseAPI looks for the journal of an interrupted commit when constructed over the mock,
+    // in a namespace that does not exist yet
+    MockNVSDelegate()
+    {
+        EXPECT_CALL(*this, open(::testing::_, NVSDelegateOpenMode_t::NVSDelegate_READONLY, ::testing::_))
+            .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND))
+            .RetiresOnSaturation();
+
+        // Without statistics, commits skip their space check
+        ON_CALL(*this, get_stats(::testing::_))
+            .WillByDefault(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_UNKOWN_ERROR));
+    }
+
     MOCK_METHOD(NVSDelegateError_t, open, (char const *const name, NVSDelegateOpenMode_t const open_mode, NVSDelegateHandle_t *out_handle), (const override));
     MOCK_METHOD(void, close, (NVSDelegateHandle_t handle), (const override));
     MOCK_METHOD(NVSDelegateError_t, set_str, (NVSDelegateHandle_t handle, char const *const key, char const *const value), (const override));
     MOCK_METHOD(NVSDelegateError_t, get_str, (NVSDelegateHandle_t handle, char const *const key, char *out_value, size_t *length), (const override));
+    MOCK_METHOD(NVSDelegateError_t, set_i64, (NVSDelegateHandle_t handle, char const *const key, int64_t const value), (const override));
+    MOCK_METHOD(NVSDelegateError_t, get_i64, (NVSDelegateHandle_t handle, char const *const key, int64_t *out_value), (const override));
+    MOCK_METHOD(NVSDelegateError_t, set_blob, (NVSDelegateHandle_t handle, char const *const key, void const *const value, size_t const length), (const override));
+    MOCK_METHOD(NVSDelegateError_t, get_blob, (NVSDelegateHandle_t handle, char const *const key, void *out_value, size_t *length), (const override));
     MOCK_METHOD(NVSDelegateError_t, erase_key, (NVSDelegateHandle_t handle, char const *const key), (const override));
     MOCK_METHOD(NVSDelegateError_t, erase_all, (NVSDelegateHandle_t handle), (const override));
     MOCK_METHOD(NVSDelegateError_t, erase_flash_all, (), (const override));
     MOCK_METHOD(NVSDelegateError_t, commit, (NVSDelegateHandle_t handle), (const override));
+    MOCK_METHOD(NVSDelegateError_t, list_keys, (char const *const name, NVSDelegateKeyCallback_t callback, void *context), (const override));
+    MOCK_METHOD(NVSDelegateError_t, get_stats, (NVSDelegateStats_t * out_stats), (const override));
+    MOCK_METHOD(NVSDelegateError_t, get_used_entries, (NVSDelegateHandle_t handle, size_t *out_entries), (const override));
 };
 
 #endif // MOCKING_CLASS_HPP
\ No newline at end of file
@@ -0,0 +1,233 @@
+#ifndef UNIT_NVS_IMAGE_DELEGATE_TEST_HPP
+#define UNIT_NVS_IMAGE_DELEGATE_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "NVSImageDelegate.hpp"
+#include "DatabaseAPI.hpp"
+
+#define NVS_IMAGE_TEST_PAGES 3
+
+// Used bytes of the first page of an image built by tools/nvs_partition.py from:
+//   namespace,key,type,value
+//   factory,ssid,string,office
+//   factory,boots,i64,-42
+//   factory,calib,blob,0a0b0c0d
+//   other,name,string,abc
+static uint8_t const NVS_IMAGE_TEST_PAGE[] = {
+    0xfe, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0xfe, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x84, 0x2d, 0xba, 0xb9,
+    0xaa, 0xaa, 0xfa, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x01, 0x01, 0xff, 0x44, 0x88, 0xf0, 0x1f, 0x66, 0x61, 0x63, 0x74, 0x6f, 0x72, 0x79, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x01, 0x21, 0x02, 0xff, 0x88, 0x97, 0x1c, 0xd0, 0x73, 0x73, 0x69, 0x64, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x00, 0xff, 0xff, 0x4b, 0xff, 0xeb, 0x5e,
+    0x6f, 0x66, 0x66, 0x69, 0x63, 0x65, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x01, 0x18, 0x01, 0xff, 0x6d, 0xcb, 0x91, 0x8f, 0x62, 0x6f, 0x6f, 0x74, 0x73, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x01, 0x42, 0x02, 0x00, 0x74, 0xe8, 0xcf, 0x7b, 0x63, 0x61, 0x6c, 0x69, 0x62, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0xff, 0xff, 0xcb, 0xc3, 0x13, 0x4e,
+    0x0a, 0x0b, 0x0c, 0x0d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x01, 0x48, 0x01, 0xff, 0xa2, 0x3c, 0x73, 0x60, 0x63, 0x61, 0x6c, 0x69, 0x62, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x01, 0x00, 0xff, 0xff,
+    0x00, 0x01, 0x01, 0xff, 0xed, 0x87, 0x89, 0x67, 0x6f, 0x74, 0x68, 0x65, 0x72, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x02, 0x21, 0x02, 0xff, 0x77, 0x77, 0xf0, 0xa5, 0x6e, 0x61, 0x6d, 0x65, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0xff, 0xff, 0xb3, 0x48, 0xe6, 0x79,
+    0x61, 0x62, 0x63, 0x00,
+};
+
+// setup test suite
+class NVSImageDelegateTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        // The rest of the partition is erased flash
+        image = static_cast<uint8_t *>(malloc(NVS_IMAGE_TEST_PAGES * NVS_IMAGE_DELEGATE_PAGE_SIZE));
+        memset(image, 0xFF, NVS_IMAGE_TEST_PAGES * NVS_IMAGE_DELEGATE_PAGE_SIZE);
+        memcpy(image, NVS_IMAGE_TEST_PAGE, sizeof(NVS_IMAGE_TEST_PAGE));
+        nvsImageDelegate = new NVSImageDelegate(image, NVS_IMAGE_TEST_PAGES * NVS_IMAGE_DELEGATE_PAGE_SIZE);
+    }
+
+    void TearDown() override
+    {
+        delete nvsImageDelegate;
+        free(image);
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    static bool countKey(char const *const key, void *context)
+    {
+        (*static_cast<int *>(context))++;
+        return true;
+    }
+
+    NVSImageDelegate *nvsImageDelegate;
+    uint8_t *image;
+};
+
+/** Testing reads of NVSImageDelegate class
+ * @brief Every value of the manifest is read back, with its type and length.
+ */
+
+TEST_F(NVSImageDelegateTest, readsGeneratedValues)
+{
+    // arrange
+    NVSDelegateHandle_t handle;
+    char value[16];
+    size_t length = sizeof(value);
+    size_t queried = 0;
+    int64_t number = 0;
+    uint8_t blob[8];
+    size_t blobLength = sizeof(blob);
+    uint8_t const expectedBlob[] = {0x0a, 0x0b, 0x0c, 0x0d};
+
+    // act
+    ASSERT_EQ(nvsImageDelegate->open("factory", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle), NVS_DELEGATE_OK);
+    NVSDelegateError_t const queryErr = nvsImageDelegate->get_str(handle, "ssid", nullptr, &queried);
+    NVSDelegateError_t const strErr = nvsImageDelegate->get_str(handle, "ssid", value, &length);
+    NVSDelegateError_t const i64Err = nvsImageDelegate->get_i64(handle, "boots", &number);
+    NVSDelegateError_t const blobErr = nvsImageDelegate->get_blob(handle, "calib", blob, &blobLength);
+    NVSDelegateError_t const wrongTypeErr = nvsImageDelegate->get_i64(handle, "ssid", &number);
+    NVSDelegateError_t const otherNamespaceErr = nvsImageDelegate->get_str(handle, "name", value, &length);
+    nvsImageDelegate->close(handle);
+
+    // assert
+    EXPECT_EQ(queryErr, NVS_DELEGATE_OK);
+    EXPECT_EQ(queried, 7u);
+    EXPECT_EQ(strErr, NVS_DELEGATE_OK);
+    EXPECT_STREQ(value, "office");
+    EXPECT_EQ(i64Err, NVS_DELEGATE_OK);
+    EXPECT_EQ(number, -42);
+    EXPECT_EQ(blobErr, NVS_DELEGATE_OK);
+    EXPECT_EQ(blobLength, sizeof(expectedBlob));
+    EXPECT_EQ(memcmp(blob, expectedBlob, sizeof(expectedBlob)), 0);
+    EXPECT_EQ(wrongTypeErr, NVS_DELEGATE_KEY_NOT_FOUND);
+    EXPECT_EQ(otherNamespaceErr, NVS_DELEGATE_KEY_NOT_FOUND);
+}
+
+/** Testing writes of NVSImageDelegate class
+ * @brief The image cannot be opened for writing, nor written through a handle.
+ */
+
+TEST_F(NVSImageDelegateTest, rejectsWrites)
+{
+    // arrange
+    NVSDelegateHandle_t handle;
+
+    // act
+    NVSDelegateError_t const openErr = nvsImageDelegate->open("factory", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle);
+    ASSERT_EQ(nvsImageDelegate->open("factory", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle), NVS_DELEGATE_OK);
+    NVSDelegateError_t const setErr = nvsImageDelegate->set_str(handle, "ssid", "home");
+    NVSDelegateError_t const eraseErr = nvsImageDelegate->erase_all(handle);
+    NVSDelegateError_t const missingErr = nvsImageDelegate->open("missing", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle);
+
+    // assert
+    EXPECT_EQ(openErr, NVS_DELEGATE_READONLY);
+    EXPECT_EQ(setErr, NVS_DELEGATE_READONLY);
+    EXPECT_EQ(eraseErr, NVS_DELEGATE_READONLY);
+    EXPECT_EQ(missingErr, NVS_DELEGATE_KEY_NOT_FOUND);
+}
+
+/** Testing list_keys Method of NVSImageDelegate class
+ * @brief Keys of a namespace are listed once, a blob included.
+ */
+
+TEST_F(NVSImageDelegateTest, listKeys)
+{
+    // arrange
+    int factoryCount = 0;
+    int otherCount = 0;
+
+    // act
+    NVSDelegateError_t const factoryErr = nvsImageDelegate->list_keys("factory", countKey, &factoryCount);
+    NVSDelegateError_t const otherErr = nvsImageDelegate->list_keys("other", countKey, &otherCount);
+
+    // assert
+    EXPECT_EQ(factoryErr, NVS_DELEGATE_OK);
+    EXPECT_EQ(factoryCount, 3);
+    EXPECT_EQ(otherErr, NVS_DELEGATE_OK);
+    EXPECT_EQ(otherCount, 1);
+}
+
+/** Testing get_stats Method of NVSImageDelegate class
+ * @brief Entries are counted from the state bitmaps, the erased pages as free.
+ */
+
+TEST_F(NVSImageDelegateTest, getStats)
+{
+    // arrange
+    NVSDelegateStats_t stats;
+
+    // act
+    NVSDelegateError_t const err = nvsImageDelegate->get_stats(&stats);
+
+    // assert
+    EXPECT_EQ(err, NVS_DELEGATE_OK);
+    EXPECT_EQ(stats.usedEntries, 10u);
+    EXPECT_EQ(stats.freeEntries, 116u + 2 * 126u);
+    EXPECT_EQ(stats.totalEntries, NVS_IMAGE_TEST_PAGES * 126u);
+    EXPECT_EQ(stats.namespaceCount, 2u);
+    EXPECT_EQ(nvsImageDelegate->get_stats(nullptr), NVS_DELEGATE_VALUE_INVALID);
+}
+
+/** Testing CRC checks of NVSImageDelegate class
+ * @brief An item whose bytes changed is ignored, the others are still read.
+ */
+
+TEST_F(NVSImageDelegateTest, ignoresCorruptItem)
+{
+    // arrange
+    NVSDelegateHandle_t handle;
+    char value[16];
+    size_t length = sizeof(value);
+    int64_t number = 0;
+    image[64 + 2 * 32] ^= 0x01; // first byte of "office", following its item
+
+    // act
+    ASSERT_EQ(nvsImageDelegate->open("factory", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle), NVS_DELEGATE_OK);
+    NVSDelegateError_t const strErr = nvsImageDelegate->get_str(handle, "ssid", value, &length);
+    NVSDelegateError_t const i64Err = nvsImageDelegate->get_i64(handle, "boots", &number);
+
+    // assert
+    EXPECT_EQ(strErr, NVS_DELEGATE_KEY_NOT_FOUND);
+    EXPECT_EQ(i64Err, NVS_DELEGATE_OK);
+    EXPECT_EQ(number, -42);
+}
+
+/** Testing DatabaseAPI over NVSImageDelegate
+ * @brief A generated image is read through DatabaseAPI as the device would.
+ */
+
+TEST_F(NVSImageDelegateTest, readThroughDatabaseAPI)
+{
+    // arrange
+    DatabaseAPI database(nvsImageDelegate, "factory");
+    char value[16];
+
+    // act
+    DatabaseError_t const getErr = database.get("ssid", value, sizeof(value));
+    DatabaseError_t const setErr = database.set("ssid", "home");
+
+    // assert
+    EXPECT_EQ(getErr, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "office");
+    EXPECT_NE(setErr, DatabaseError_t::DATABASE_OK);
+}
+
+#endif // UNIT_NVS_IMAGE_DELEGATE_TEST_HPP
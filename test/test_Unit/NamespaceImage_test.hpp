@@ -0,0 +1,182 @@
+#ifndef UNIT_NAMESPACE_IMAGE_TEST_HPP
+#define UNIT_NAMESPACE_IMAGE_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "MemoryNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseImage.hpp"
+
+// Image held in RAM, written and read back through DatabaseImageWriter_t and DatabaseImageReader_t
+struct ImageBuffer
+{
+    uint8_t data[512];
+    size_t length;
+    size_t position;
+};
+
+// setup test suite
+class NamespaceImageTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        memoryNVSDelegate = new MemoryNVSDelegate();
+        databaseAPI = new DatabaseAPI(memoryNVSDelegate, "TEST_NVS");
+        buffer.length = 0;
+        buffer.position = 0;
+
+        ASSERT_EQ(databaseAPI->set("ssid", "office"), DatabaseError_t::DATABASE_OK);
+        ASSERT_EQ(databaseAPI->set("password", "secret"), DatabaseError_t::DATABASE_OK);
+        ASSERT_EQ(databaseAPI->increment("boots"), DatabaseError_t::DATABASE_OK);
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete memoryNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    static bool writeBuffer(uint8_t const *const data, size_t const length, void *context)
+    {
+        ImageBuffer *const image = static_cast<ImageBuffer *>(context);
+        if (image->length + length > sizeof(image->data))
+            return false;
+        memcpy(image->data + image->length, data, length);
+        image->length += length;
+        return true;
+    }
+
+    static bool readBuffer(uint8_t *data, size_t const length, void *context)
+    {
+        ImageBuffer *const image = static_cast<ImageBuffer *>(context);
+        if (image->position + length > image->length)
+            return false;
+        memcpy(data, image->data + image->position, length);
+        image->position += length;
+        return true;
+    }
+
+    // Imports the exported image into a new namespace
+    DatabaseError_t importInto(DatabaseAPI *target, bool replace = false)
+    {
+        buffer.position = 0;
+        return target->importNamespace(readBuffer, &buffer, replace);
+    }
+
+    DatabaseAPI *databaseAPI;
+    MemoryNVSDelegate *memoryNVSDelegate;
+    ImageBuffer buffer;
+};
+
+/** Testing exportNamespace and importNamespace Methods of DatabaseAPI class
+ * @brief An exported image restores the string values of the namespace, and a damaged one nothing.
+ */
+
+TEST_F(NamespaceImageTest, export_Import_RoundTrip)
+{
+    // arrange
+    char ssid[16];
+    char password[16];
+    DatabaseAPI target(memoryNVSDelegate, "TARGET");
+
+    // act
+    DatabaseError_t err1 = databaseAPI->exportNamespace(writeBuffer, &buffer);
+    DatabaseError_t err2 = importInto(&target);
+    DatabaseError_t err3 = target.get("ssid", ssid, sizeof(ssid));
+    DatabaseError_t err4 = target.get("password", password, sizeof(password));
+    DatabaseError_t err5 = target.isExist("boots");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(buffer.length, 4u + (1 + 4 + 2 + 6) + (1 + 8 + 2 + 6) + 7); // header, 2 values, trailer
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssid, "office");
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(password, "secret");
+    EXPECT_EQ(err5, DatabaseError_t::DATABASE_KEY_NOT_FOUND); // counters are not exported
+}
+
+TEST_F(NamespaceImageTest, import_CorruptedOrTruncated_NothingWritten)
+{
+    // arrange
+    DatabaseAPI target(memoryNVSDelegate, "TARGET");
+    ASSERT_EQ(databaseAPI->exportNamespace(writeBuffer, &buffer), DatabaseError_t::DATABASE_OK);
+
+    // act
+    buffer.data[10] ^= 0x01;
+    DatabaseError_t err1 = importInto(&target);
+    buffer.data[10] ^= 0x01;
+    buffer.length -= 1;
+    DatabaseError_t err2 = importInto(&target);
+    buffer.data[3] = DATABASE_IMAGE_VERSION + 1;
+    buffer.length += 1;
+    DatabaseError_t err3 = importInto(&target);
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_VALUE_INVALID);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_VALUE_INVALID);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_VALUE_INVALID);
+    EXPECT_EQ(target.isExist("ssid"), DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+}
+
+TEST_F(NamespaceImageTest, import_Replace_WholeNamespaceReplaced)
+{
+    // arrange
+    char ssid[16];
+    DatabaseAPI target(memoryNVSDelegate, "TARGET");
+    ASSERT_EQ(target.set("legacy", "1"), DatabaseError_t::DATABASE_OK);
+    ASSERT_EQ(databaseAPI->exportNamespace(writeBuffer, &buffer), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = importInto(&target, true);
+    DatabaseError_t err2 = target.get("ssid", ssid, sizeof(ssid));
+    DatabaseError_t err3 = target.isExist("legacy");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssid, "office");
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+}
+
+TEST_F(NamespaceImageTest, export_WriterFails_Error)
+{
+    // arrange
+    buffer.length = sizeof(buffer.data) - 10; // room for the header only
+
+    // act
+    DatabaseError_t err = databaseAPI->exportNamespace(writeBuffer, &buffer);
+
+    // assert
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_ERROR);
+}
+
+TEST_F(NamespaceImageTest, DatabaseImage_KnownCrc)
+{
+    // arrange
+    uint8_t const data[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+    // act
+    uint32_t const whole = DatabaseImage::crc32(0, data, sizeof(data));
+    uint32_t const split = DatabaseImage::crc32(DatabaseImage::crc32(0, data, 4), data + 4, sizeof(data) - 4);
+
+    // assert
+    EXPECT_EQ(whole, 0xCBF43926u); // check value of CRC-32/IEEE
+    EXPECT_EQ(split, whole);
+}
+
+#endif // UNIT_NAMESPACE_IMAGE_TEST_HPP
@@ -0,0 +1,257 @@
+#ifndef UNIT_NAMESPACE_SWAP_TEST_HPP
+#define UNIT_NAMESPACE_SWAP_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "FaultInjectingNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseBatch.hpp"
+
+// setup test suite
+class NamespaceSwapTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        faultInjectingNVSDelegate = new FaultInjectingNVSDelegate();
+        databaseAPI = new DatabaseAPI(faultInjectingNVSDelegate, "TEST_NVS");
+
+        ASSERT_EQ(databaseAPI->set("ssid", "home"), DatabaseError_t::DATABASE_OK);
+        ASSERT_EQ(databaseAPI->set("password", "old secret"), DatabaseError_t::DATABASE_OK);
+        ASSERT_EQ(generation.set("ssid", "office"), DatabaseError_t::DATABASE_OK);
+        ASSERT_EQ(generation.set("ip", "10.0.0.7"), DatabaseError_t::DATABASE_OK);
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete faultInjectingNVSDelegate;
+        generation.clear();
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Reboots: a new DatabaseAPI over the same storage
+    void reboot()
+    {
+        delete databaseAPI;
+        faultInjectingNVSDelegate->failingKey = nullptr;
+        databaseAPI = new DatabaseAPI(faultInjectingNVSDelegate, "TEST_NVS");
+    }
+
+    // Counts the keys passed to a list_keys callback
+    static bool countKey(char const *const key, void *context)
+    {
+        (*static_cast<int *>(context))++;
+        return true;
+    }
+
+    int countKeys(char const *const nvsNamespace)
+    {
+        int count = 0;
+        EXPECT_EQ(faultInjectingNVSDelegate->list_keys(nvsNamespace, countKey, &count), NVSDelegateError_t::NVS_DELEGATE_OK);
+        return count;
+    }
+
+    DatabaseAPI *databaseAPI;
+    FaultInjectingNVSDelegate *faultInjectingNVSDelegate;
+    DatabaseBatch generation;
+};
+
+/** Testing replaceAll Method of DatabaseAPI class
+ * @brief The namespace holds the values of the new generation, and only them, after one flip.
+ */
+
+TEST_F(NamespaceSwapTest, replaceAll_WholeContentReplaced)
+{
+    // arrange
+    char ssid[16];
+    int64_t count;
+    ASSERT_EQ(databaseAPI->increment("boots"), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->replaceAll(generation);
+    DatabaseError_t err2 = databaseAPI->get("ssid", ssid, sizeof(ssid));
+    DatabaseError_t err3 = databaseAPI->isExist("ip");
+    DatabaseError_t err4 = databaseAPI->isExist("password");
+    DatabaseError_t err5 = databaseAPI->getCounter("boots", &count);
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssid, "office");
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(err5, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+}
+
+TEST_F(NamespaceSwapTest, replaceAll_Twice_SelectedAfterReboot)
+{
+    // arrange
+    char ssid[16];
+    DatabaseBatch next;
+    ASSERT_EQ(next.set("ssid", "lab"), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->replaceAll(generation);
+    reboot();
+    DatabaseError_t err2 = databaseAPI->get("ssid", ssid, sizeof(ssid));
+    DatabaseError_t err3 = databaseAPI->replaceAll(next);
+    reboot();
+    DatabaseError_t err4 = databaseAPI->isExist("ip");
+    DatabaseError_t err5 = databaseAPI->isExist("password");
+    DatabaseError_t err6 = databaseAPI->set("mode", "auto");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssid, "office");
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(err5, DatabaseError_t::DATABASE_KEY_NOT_FOUND); // the base namespace was cleared first
+    EXPECT_EQ(err6, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(databaseAPI->get("ssid", ssid, sizeof(ssid)), DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssid, "lab");
+}
+
+TEST_F(NamespaceSwapTest, replaceAll_PowerLossBeforeFlip_PreviousKept)
+{
+    // arrange
+    char ssid[16];
+    DatabaseBatch next;
+    ASSERT_EQ(next.set("mode", "eco"), DatabaseError_t::DATABASE_OK);
+    faultInjectingNVSDelegate->failingKey = DATABASE_GENERATION_KEY;
+
+    // act
+    DatabaseError_t err1 = databaseAPI->replaceAll(generation);
+    reboot();
+    DatabaseError_t err2 = databaseAPI->get("ssid", ssid, sizeof(ssid));
+    DatabaseError_t err3 = databaseAPI->isExist("ip");
+    DatabaseError_t err4 = databaseAPI->replaceAll(next);
+    DatabaseError_t err5 = databaseAPI->isExist("ip");
+
+    // assert
+    EXPECT_NE(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssid, "home");
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err5, DatabaseError_t::DATABASE_KEY_NOT_FOUND); // leftovers of the interrupted replacement
+}
+
+TEST_F(NamespaceSwapTest, eraseStaleGeneration_PreviousErased)
+{
+    // arrange
+    char shadowNamespace[NVS_DELEGATE_MAX_NAMESPACE_LENGTH];
+    strcpy(shadowNamespace, "TEST_NVS");
+    strcat(shadowNamespace, DATABASE_SHADOW_SUFFIX);
+    ASSERT_EQ(databaseAPI->replaceAll(generation), DatabaseError_t::DATABASE_OK);
+    int const keysBefore = countKeys("TEST_NVS");
+
+    // act
+    DatabaseError_t err1 = databaseAPI->eraseStaleGeneration();
+    int const keysAfter = countKeys("TEST_NVS");
+    DatabaseError_t err2 = databaseAPI->replaceAll(generation);
+    DatabaseError_t err3 = databaseAPI->eraseStaleGeneration();
+    DatabaseError_t err4 = databaseAPI->eraseStaleGeneration();
+
+    // assert
+    EXPECT_EQ(keysBefore, 3); // ssid, password and the generation pointer
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(keysAfter, 1);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(countKeys(shadowNamespace), 0);
+    EXPECT_EQ(countKeys("TEST_NVS"), 3); // ssid, ip and the generation pointer
+}
+
+TEST_F(NamespaceSwapTest, replaceAll_SnapshotEnabled_NewGenerationServed)
+{
+    // arrange
+    char ssid[16];
+    ASSERT_EQ(databaseAPI->enableSnapshot(), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->replaceAll(generation);
+    DatabaseError_t err2 = databaseAPI->get("ssid", ssid, sizeof(ssid));
+    DatabaseError_t err3 = databaseAPI->isExist("password");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_TRUE(databaseAPI->isSnapshotEnabled());
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssid, "office");
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+}
+
+TEST_F(NamespaceSwapTest, replaceAll_LongNamespacesSharingPrefix_Isolated)
+{
+    // arrange
+    DatabaseAPI first(faultInjectingNVSDelegate, "settings_devic1");
+    DatabaseAPI second(faultInjectingNVSDelegate, "settings_devic2");
+    DatabaseBatch other;
+    ASSERT_EQ(other.set("ssid", "lab"), DatabaseError_t::DATABASE_OK);
+    char ssid[16];
+
+    // act
+    DatabaseError_t err1 = first.replaceAll(generation);
+    DatabaseError_t err2 = second.replaceAll(other);
+    DatabaseError_t err3 = second.replaceAll(other);
+    DatabaseError_t err4 = second.eraseStaleGeneration();
+    DatabaseError_t err5 = first.get("ssid", ssid, sizeof(ssid));
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err5, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssid, "office");
+    EXPECT_EQ(first.isExist("ip"), DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(countKeys("settings_devic1"), 1); // the generation pointer
+}
+
+/** Testing DatabaseAPI constructor
+ * @brief A namespace is served by one instance per delegate, a second one fails until the first is destroyed.
+ */
+
+TEST_F(NamespaceSwapTest, constructor_NamespaceAlreadyOpen_Refused)
+{
+    // arrange
+    char ssid[16];
+    DatabaseAPI *const second = new DatabaseAPI(faultInjectingNVSDelegate, "TEST_NVS");
+    MemoryNVSDelegate otherDelegate;
+    DatabaseAPI otherStorage(&otherDelegate, "TEST_NVS");
+
+    // act
+    DatabaseError_t err1 = second->replaceAll(generation);
+    DatabaseError_t err2 = second->get("ssid", ssid, sizeof(ssid));
+    DatabaseError_t err3 = otherStorage.set("ssid", "lab");
+    delete second;
+    DatabaseAPI *const third = new DatabaseAPI(faultInjectingNVSDelegate, "TEST_NVS");
+    DatabaseError_t err4 = third->isExist("ssid");
+    delete third;
+    reboot();
+    DatabaseError_t err5 = databaseAPI->get("ssid", ssid, sizeof(ssid));
+
+    // assert
+    EXPECT_NE(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_NE(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_NE(err4, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err5, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssid, "home");
+}
+
+#endif // UNIT_NAMESPACE_SWAP_TEST_HPP
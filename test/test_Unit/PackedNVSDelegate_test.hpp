@@ -0,0 +1,267 @@
+#ifndef UNIT_PACKED_NVS_DELEGATE_TEST_HPP
+#define UNIT_PACKED_NVS_DELEGATE_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "FaultInjectingNVSDelegate.hpp"
+#include "PackedNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+
+// setup test suite
+class PackedNVSDelegateTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        memoryNVSDelegate = new FaultInjectingNVSDelegate();
+        memoryNVSDelegate->readPrefix = PACKED_NVS_DELEGATE_BUCKET_PREFIX;
+        packedNVSDelegate = new PackedNVSDelegate(memoryNVSDelegate);
+        databaseAPI = new DatabaseAPI(packedNVSDelegate, "TEST_NVS");
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete packedNVSDelegate;
+        delete memoryNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Checks if a key is stored on its own by the wrapped delegate
+    bool isStoredAlone(char const *const key)
+    {
+        NVSDelegateHandle_t handle;
+        size_t length = 0;
+        if (memoryNVSDelegate->open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle) != NVSDelegateError_t::NVS_DELEGATE_OK)
+            return false;
+        return memoryNVSDelegate->get_str(handle, key, nullptr, &length) == NVSDelegateError_t::NVS_DELEGATE_OK;
+    }
+
+    static bool countKey(char const *const key, void *context)
+    {
+        (*static_cast<int *>(context))++;
+        return true;
+    }
+
+    DatabaseAPI *databaseAPI;
+    PackedNVSDelegate *packedNVSDelegate;
+    FaultInjectingNVSDelegate *memoryNVSDelegate;
+};
+
+/** Testing PackedNVSDelegate class
+ * @brief Short values are packed into bucket blobs and keep the semantics of single entries.
+ */
+
+TEST_F(PackedNVSDelegateTest, set_ShortValue_Packed)
+{
+    // arrange
+    char value[16];
+    size_t length = 0;
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("flag", "on");
+    DatabaseError_t err2 = databaseAPI->get("flag", value, sizeof(value));
+    DatabaseError_t err3 = databaseAPI->getValueLength("flag", &length);
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "on");
+    EXPECT_EQ(length, 3u);
+    EXPECT_FALSE(isStoredAlone("flag"));
+}
+
+TEST_F(PackedNVSDelegateTest, set_GrowingValue_MovedOutOfBucket)
+{
+    // arrange
+    char value[64];
+    ASSERT_EQ(databaseAPI->set("name", "dev"), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("name", "a much longer device name");
+    DatabaseError_t err2 = databaseAPI->get("name", value, sizeof(value));
+    bool aloneWhenLong = isStoredAlone("name");
+    DatabaseError_t err3 = databaseAPI->set("name", "dev2");
+    bool aloneWhenShort = isStoredAlone("name");
+    DatabaseError_t err4 = databaseAPI->get("name", value, sizeof(value));
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_OK);
+    EXPECT_TRUE(aloneWhenLong);
+    EXPECT_FALSE(aloneWhenShort);
+    EXPECT_STREQ(value, "dev2");
+}
+
+TEST_F(PackedNVSDelegateTest, remove_PackedKey_Removed)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->set("flag", "on"), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->remove("flag");
+    DatabaseError_t err2 = databaseAPI->isExist("flag");
+    DatabaseError_t err3 = databaseAPI->remove("flag");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+}
+
+TEST_F(PackedNVSDelegateTest, set_ManyKeys_BucketsOverflowToSingleEntries)
+{
+    // arrange
+    char key[16];
+    char value[16];
+    char expected[16];
+    int listed = 0;
+    PackedNVSDelegateReport_t report;
+
+    // act
+    for (int i = 0; i < 700; i++)
+    {
+        snprintf(key, sizeof(key), "flag_%03d", i);
+        snprintf(value, sizeof(value), "v%d", i);
+        ASSERT_EQ(databaseAPI->set(key, value), DatabaseError_t::DATABASE_OK);
+    }
+    ASSERT_EQ(packedNVSDelegate->list_keys("TEST_NVS", countKey, &listed), NVSDelegateError_t::NVS_DELEGATE_OK);
+    ASSERT_EQ(packedNVSDelegate->getSpaceReport("TEST_NVS", &report), NVSDelegateError_t::NVS_DELEGATE_OK);
+
+    // assert
+    EXPECT_EQ(listed, 700);
+    EXPECT_EQ(report.logicalKeys, 700u);
+    EXPECT_LT(report.packedKeys, 700u); // full buckets sent some keys to single entries
+    for (int i = 0; i < 700; i++)
+    {
+        snprintf(key, sizeof(key), "flag_%03d", i);
+        snprintf(expected, sizeof(expected), "v%d", i);
+        ASSERT_EQ(databaseAPI->get(key, value, sizeof(value)), DatabaseError_t::DATABASE_OK);
+        EXPECT_STREQ(value, expected);
+    }
+}
+
+TEST_F(PackedNVSDelegateTest, enableSnapshot_PackedKeys_Loaded)
+{
+    // arrange
+    char value[16];
+    ASSERT_EQ(databaseAPI->set("flag", "on"), DatabaseError_t::DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("long", "a value stored on its own"), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->enableSnapshot();
+    DatabaseError_t err2 = databaseAPI->get("flag", value, sizeof(value));
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "on");
+}
+
+TEST_F(PackedNVSDelegateTest, getSpaceReport_FewerEntriesThanUnpacked)
+{
+    // arrange
+    char key[16];
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf(key, sizeof(key), "flag_%03d", i);
+        ASSERT_EQ(databaseAPI->set(key, "1"), DatabaseError_t::DATABASE_OK);
+    }
+    ASSERT_EQ(databaseAPI->set("long", "a value stored on its own, 2 spans"), DatabaseError_t::DATABASE_OK);
+    PackedNVSDelegateReport_t report;
+
+    // act
+    NVSDelegateError_t err = packedNVSDelegate->getSpaceReport("TEST_NVS", &report);
+
+    // assert
+    EXPECT_EQ(err, NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(report.logicalKeys, 101u);
+    EXPECT_EQ(report.packedKeys, 100u);
+    EXPECT_EQ(report.unpackedEntries, 100u * 2 + 3);
+    EXPECT_LE(report.buckets, (size_t)PACKED_NVS_DELEGATE_BUCKET_COUNT);
+    EXPECT_LT(report.entries, report.unpackedEntries / 2);
+}
+
+TEST_F(PackedNVSDelegateTest, constructor_BucketCount_Used)
+{
+    // arrange
+    PackedNVSDelegate fewBuckets(memoryNVSDelegate, 4);
+    PackedNVSDelegate invalidCount(memoryNVSDelegate, PACKED_NVS_DELEGATE_MAX_BUCKET_COUNT + 1);
+    NVSDelegateHandle_t handle;
+    ASSERT_EQ(fewBuckets.open("FEW", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle), NVSDelegateError_t::NVS_DELEGATE_OK);
+    char key[16];
+    char value[16];
+    size_t length;
+    PackedNVSDelegateReport_t report;
+    PackedNVSDelegateReport_t defaultReport;
+
+    // act
+    for (int i = 0; i < 40; i++)
+    {
+        snprintf(key, sizeof(key), "flag_%02d", i);
+        ASSERT_EQ(fewBuckets.set_str(handle, key, "1"), NVSDelegateError_t::NVS_DELEGATE_OK);
+        ASSERT_EQ(databaseAPI->set(key, "1"), DatabaseError_t::DATABASE_OK);
+    }
+    length = sizeof(value);
+    NVSDelegateError_t err = fewBuckets.get_str(handle, "flag_07", value, &length);
+    fewBuckets.close(handle);
+    ASSERT_EQ(fewBuckets.getSpaceReport("FEW", &report), NVSDelegateError_t::NVS_DELEGATE_OK);
+    ASSERT_EQ(invalidCount.getSpaceReport("TEST_NVS", &defaultReport), NVSDelegateError_t::NVS_DELEGATE_OK);
+
+    // assert
+    EXPECT_EQ(err, NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_STREQ(value, "1");
+    EXPECT_EQ(report.packedKeys, 40u);
+    EXPECT_EQ(report.buckets, 4u);
+    EXPECT_EQ(defaultReport.packedKeys, 40u); // read with the default count, as written
+    EXPECT_GT(defaultReport.buckets, 4u);
+}
+
+TEST_F(PackedNVSDelegateTest, get_KeyOutsideBucket_BucketNotRead)
+{
+    // arrange
+    NVSDelegateHandle_t handle;
+    ASSERT_EQ(packedNVSDelegate->open("RAW", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle), NVSDelegateError_t::NVS_DELEGATE_OK);
+    ASSERT_EQ(packedNVSDelegate->set_str(handle, "flag", "on"), NVSDelegateError_t::NVS_DELEGATE_OK);
+    ASSERT_EQ(packedNVSDelegate->set_str(handle, "long", "a value stored on its own"), NVSDelegateError_t::NVS_DELEGATE_OK);
+    char value[32];
+    size_t length;
+
+    // act
+    memoryNVSDelegate->reads = 0;
+    length = sizeof(value);
+    NVSDelegateError_t err1 = packedNVSDelegate->get_str(handle, "long", value, &length);
+    length = sizeof(value);
+    NVSDelegateError_t err2 = packedNVSDelegate->get_str(handle, "missing", value, &length);
+    NVSDelegateError_t err3 = packedNVSDelegate->erase_key(handle, "long");
+    unsigned long const missReads = memoryNVSDelegate->reads;
+    length = sizeof(value);
+    NVSDelegateError_t err4 = packedNVSDelegate->get_str(handle, "flag", value, &length);
+    unsigned long const hitReads = memoryNVSDelegate->reads - missReads;
+    packedNVSDelegate->close(handle);
+
+    // assert
+    EXPECT_EQ(err1, NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(err2, NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND);
+    EXPECT_EQ(err3, NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(err4, NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_STREQ(value, "on");
+    EXPECT_EQ(missReads, 0u);
+    EXPECT_EQ(hitReads, 1u);
+}
+
+#endif // UNIT_PACKED_NVS_DELEGATE_TEST_HPP
@@ -0,0 +1,219 @@
+#ifndef UNIT_QUEUE_TEST_HPP
+#define UNIT_QUEUE_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "FaultInjectingNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseQueue.hpp"
+
+// Consumer handling a number of messages, then refusing the next one
+struct QueueConsumer
+{
+    char messages[8][32];
+    size_t count = 0;
+    size_t accept = 8;
+
+    static bool consume(char const *const message, void *context)
+    {
+        QueueConsumer *const consumer = static_cast<QueueConsumer *>(context);
+        if (consumer->count == consumer->accept)
+            return false;
+        strcpy(consumer->messages[consumer->count++], message);
+        return true;
+    }
+};
+
+// setup test suite
+class QueueTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        faultInjectingNVSDelegate = new FaultInjectingNVSDelegate();
+        databaseAPI = new DatabaseAPI(faultInjectingNVSDelegate, "TEST_NVS");
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete faultInjectingNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    DatabaseAPI *databaseAPI;
+    FaultInjectingNVSDelegate *faultInjectingNVSDelegate;
+};
+
+/** Testing enqueue and peek
+ * @brief Messages are peeked in the order they were enqueued, without being removed.
+ */
+TEST_F(QueueTest, peeksInOrder)
+{
+    // arrange
+    DatabaseQueue queue(databaseAPI, "mq", 8, 32);
+    ASSERT_EQ(queue.begin(), DATABASE_OK);
+
+    // act
+    ASSERT_EQ(queue.enqueue("first"), DATABASE_OK);
+    ASSERT_EQ(queue.enqueue("second"), DATABASE_OK);
+    ASSERT_EQ(queue.enqueue("third: with a colon"), DATABASE_OK);
+    char message[32] = {0};
+    DatabaseError_t const err = queue.peek(2, message, sizeof(message));
+
+    // assert
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_STREQ(message, "third: with a colon");
+    ASSERT_EQ(queue.peek(0, message, sizeof(message)), DATABASE_OK);
+    EXPECT_STREQ(message, "first");
+    EXPECT_EQ(queue.peek(3, message, sizeof(message)), DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(queue.peek(0, message, 3), DATABASE_VALUE_INVALID);
+    EXPECT_EQ(queue.size(), 3u);
+}
+
+/** Testing dequeue
+ * @brief The messages the consumer handled are removed; the one it refused stays at the head.
+ */
+TEST_F(QueueTest, dequeueAcksHandledMessages)
+{
+    // arrange
+    DatabaseQueue queue(databaseAPI, "mq", 8, 32);
+    ASSERT_EQ(queue.begin(), DATABASE_OK);
+    char const *const messages[] = {"a", "b", "c"};
+    ASSERT_EQ(queue.enqueue(messages, 3), DATABASE_OK);
+    QueueConsumer consumer;
+    consumer.accept = 2;
+
+    // act
+    size_t removed = 0;
+    DatabaseError_t const err = queue.dequeue(QueueConsumer::consume, &consumer, 8, &removed);
+
+    // assert
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_EQ(removed, 2u);
+    EXPECT_STREQ(consumer.messages[0], "a");
+    EXPECT_STREQ(consumer.messages[1], "b");
+    EXPECT_EQ(queue.size(), 1u);
+    EXPECT_EQ(databaseAPI->isExist("mq0"), DATABASE_KEY_NOT_FOUND);
+    char message[32] = {0};
+    ASSERT_EQ(queue.peek(0, message, sizeof(message)), DATABASE_OK);
+    EXPECT_STREQ(message, "c");
+}
+
+/** Testing dequeue
+ * @brief A failed read stops the hand-over and is returned, the messages handled before it are still removed.
+ */
+TEST_F(QueueTest, dequeueReturnsReadError)
+{
+    // arrange
+    DatabaseQueue queue(databaseAPI, "mq", 8, 32);
+    ASSERT_EQ(queue.begin(), DATABASE_OK);
+    char const *const messages[] = {"a", "b", "c"};
+    ASSERT_EQ(queue.enqueue(messages, 3), DATABASE_OK);
+    QueueConsumer consumer;
+    faultInjectingNVSDelegate->failingReadKey = "mq1";
+
+    // act
+    size_t removed = 0;
+    DatabaseError_t const err = queue.dequeue(QueueConsumer::consume, &consumer, 8, &removed);
+    faultInjectingNVSDelegate->failingReadKey = nullptr;
+
+    // assert
+    EXPECT_EQ(err, DATABASE_ERROR);
+    EXPECT_EQ(removed, 1u);
+    EXPECT_EQ(consumer.count, 1u);
+    EXPECT_STREQ(consumer.messages[0], "a");
+    EXPECT_EQ(queue.size(), 2u);
+    char message[32] = {0};
+    ASSERT_EQ(queue.peek(0, message, sizeof(message)), DATABASE_OK);
+    EXPECT_STREQ(message, "b");
+}
+
+/** Testing begin
+ * @brief Head and tail are recovered by scanning the slots, also once the queue wrapped around.
+ */
+TEST_F(QueueTest, recoversAfterRestart)
+{
+    // arrange
+    {
+        DatabaseQueue queue(databaseAPI, "mq", 4, 32);
+        ASSERT_EQ(queue.begin(), DATABASE_OK);
+        char const *const first[] = {"m0", "m1", "m2"};
+        char const *const second[] = {"m3", "m4", "m5"};
+        ASSERT_EQ(queue.enqueue(first, 3), DATABASE_OK);
+        ASSERT_EQ(queue.ack(2), DATABASE_OK);
+        ASSERT_EQ(queue.enqueue(second, 3), DATABASE_OK);
+    }
+    DatabaseQueue queue(databaseAPI, "mq", 4, 32);
+
+    // act
+    DatabaseError_t const err = queue.begin();
+    QueueConsumer consumer;
+    ASSERT_EQ(queue.dequeue(QueueConsumer::consume, &consumer, 8), DATABASE_OK);
+
+    // assert
+    EXPECT_EQ(err, DATABASE_OK);
+    ASSERT_EQ(consumer.count, 4u);
+    EXPECT_STREQ(consumer.messages[0], "m2");
+    EXPECT_STREQ(consumer.messages[3], "m5");
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+/** Testing enqueue
+ * @brief A full queue rejects messages, and a batch without room for all of its messages writes none.
+ */
+TEST_F(QueueTest, DATABASE_NOT_ENOUGH_SPACE)
+{
+    // arrange
+    DatabaseQueue queue(databaseAPI, "mq", 2, 8);
+    ASSERT_EQ(queue.begin(), DATABASE_OK);
+    ASSERT_EQ(queue.enqueue("a"), DATABASE_OK);
+    char const *const messages[] = {"b", "c"};
+
+    // act
+    DatabaseError_t const batchErr = queue.enqueue(messages, 2);
+    ASSERT_EQ(queue.enqueue("b"), DATABASE_OK);
+    DatabaseError_t const fullErr = queue.enqueue("c");
+
+    // assert
+    EXPECT_EQ(batchErr, DATABASE_NOT_ENOUGH_SPACE);
+    EXPECT_EQ(fullErr, DATABASE_NOT_ENOUGH_SPACE);
+    EXPECT_EQ(queue.size(), 2u);
+    EXPECT_EQ(queue.enqueue("too long message"), DATABASE_VALUE_INVALID);
+}
+
+/** Testing begin
+ * @brief Invalid configurations are rejected, and nothing is enqueued before begin().
+ */
+TEST_F(QueueTest, invalidConfiguration)
+{
+    // arrange
+    DatabaseQueue longPrefix(databaseAPI, "a_long_prefix", 8);
+    DatabaseQueue reservedPrefix(databaseAPI, "~mq", 8);
+    DatabaseQueue noCapacity(databaseAPI, "mq", 0);
+    DatabaseQueue tooLarge(databaseAPI, "mq", DATABASE_QUEUE_MAX_CAPACITY + 1);
+    DatabaseQueue longMessages(databaseAPI, "mq", 8, NVS_DELEGATE_MAX_VALUE_LENGTH);
+    DatabaseQueue notStarted(databaseAPI, "mq", 8);
+
+    // act & assert
+    EXPECT_EQ(longPrefix.begin(), DATABASE_KEY_INVALID);
+    EXPECT_EQ(reservedPrefix.begin(), DATABASE_KEY_INVALID);
+    EXPECT_EQ(noCapacity.begin(), DATABASE_VALUE_INVALID);
+    EXPECT_EQ(tooLarge.begin(), DATABASE_VALUE_INVALID);
+    EXPECT_EQ(longMessages.begin(), DATABASE_VALUE_INVALID);
+    EXPECT_EQ(notStarted.enqueue("a"), DATABASE_ERROR);
+    EXPECT_EQ(notStarted.ack(0), DATABASE_ERROR);
+}
+
+#endif // UNIT_QUEUE_TEST_HPP
@@ -0,0 +1,213 @@
+#ifndef UNIT_RING_BUFFER_TEST_HPP
+#define UNIT_RING_BUFFER_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "MemoryNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseRingBuffer.hpp"
+
+// Collects the records visited by forEachNewest
+struct RingBufferVisit
+{
+    uint32_t sequences[64];
+    int32_t values[64];
+    size_t count = 0;
+    size_t limit = 64;
+
+    static bool visit(uint32_t const sequence, int32_t const value, void *context)
+    {
+        RingBufferVisit *const visit = static_cast<RingBufferVisit *>(context);
+        visit->sequences[visit->count] = sequence;
+        visit->values[visit->count] = value;
+        return ++visit->count < visit->limit;
+    }
+};
+
+// setup test suite
+class RingBufferTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        memoryNVSDelegate = new MemoryNVSDelegate();
+        databaseAPI = new DatabaseAPI(memoryNVSDelegate, "TEST_NVS");
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete memoryNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    DatabaseAPI *databaseAPI;
+    MemoryNVSDelegate *memoryNVSDelegate;
+};
+
+/** Testing append and forEachNewest
+ * @brief Records are visited newest first; once every slot is used the oldest slot is overwritten.
+ */
+TEST_F(RingBufferTest, rotatesAndVisitsNewestFirst)
+{
+    // arrange
+    DatabaseRingBuffer ring(databaseAPI, "log", 3, 4);
+    ASSERT_EQ(ring.begin(), DATABASE_OK);
+
+    // act
+    for (int32_t i = 0; i < 22; ++i)
+        ASSERT_EQ(ring.append(100 + i), DATABASE_OK);
+    RingBufferVisit visit;
+    DatabaseError_t const err = ring.forEachNewest(RingBufferVisit::visit, &visit);
+
+    // assert: slots 3 and 4 are full, slot 5 holds two records in RAM
+    EXPECT_EQ(err, DATABASE_OK);
+    ASSERT_EQ(visit.count, 10u);
+    for (size_t i = 0; i < visit.count; ++i)
+    {
+        EXPECT_EQ(visit.sequences[i], 21u - i);
+        EXPECT_EQ(visit.values[i], static_cast<int32_t>(121 - i));
+    }
+    EXPECT_EQ(ring.nextSequence(), 22u);
+    EXPECT_EQ(ring.capacity(), 12u);
+}
+
+/** Testing append
+ * @brief A slot is written once, when full, not once per record.
+ */
+TEST_F(RingBufferTest, writesFullSlotsOnly)
+{
+    // arrange
+    DatabaseRingBuffer ring(databaseAPI, "log", 2, 4);
+    ASSERT_EQ(ring.begin(), DATABASE_OK);
+
+    // act
+    for (int32_t i = 0; i < 3; ++i)
+        ASSERT_EQ(ring.append(i), DATABASE_OK);
+    DatabaseError_t const existsPartial = databaseAPI->isExist("log0");
+    ASSERT_EQ(ring.append(3), DATABASE_OK);
+    char value[64] = {0};
+    DatabaseError_t const err = databaseAPI->get("log0", value, sizeof(value));
+
+    // assert
+    EXPECT_EQ(existsPartial, DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_STREQ(value, "0:0,1,2,3");
+}
+
+/** Testing begin
+ * @brief The slot being filled is found again by scanning the slots, with no index key.
+ */
+TEST_F(RingBufferTest, recoversHeadByScan)
+{
+    // arrange
+    {
+        DatabaseRingBuffer ring(databaseAPI, "log", 3, 4);
+        ASSERT_EQ(ring.begin(), DATABASE_OK);
+        for (int32_t i = 0; i < 18; ++i)
+            ASSERT_EQ(ring.append(i), DATABASE_OK);
+        ASSERT_EQ(ring.flush(), DATABASE_OK);
+    }
+    DatabaseRingBuffer ring(databaseAPI, "log", 3, 4);
+
+    // act
+    DatabaseError_t const err = ring.begin();
+    uint32_t sequence = 0;
+    ASSERT_EQ(ring.append(18, &sequence), DATABASE_OK);
+    int32_t values[16] = {0};
+    size_t count = 0;
+    ASSERT_EQ(ring.read(0, values, 16, &count), DATABASE_OK);
+
+    // assert: records 8 to 18 remain, the oldest slot was overwritten by the fifth
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_EQ(sequence, 18u);
+    ASSERT_EQ(count, 11u);
+    for (size_t i = 0; i < count; ++i)
+        EXPECT_EQ(values[i], static_cast<int32_t>(8 + i));
+}
+
+/** Testing read
+ * @brief Reads from a sequence number on, up to the size of the buffer.
+ */
+TEST_F(RingBufferTest, readsRange)
+{
+    // arrange
+    DatabaseRingBuffer ring(databaseAPI, "log", 4, 3);
+    ASSERT_EQ(ring.begin(), DATABASE_OK);
+    for (int32_t i = 0; i < 10; ++i)
+        ASSERT_EQ(ring.append(i * 10), DATABASE_OK);
+
+    // act
+    int32_t values[4] = {0};
+    size_t count = 0;
+    DatabaseError_t const err = ring.read(5, values, 4, &count);
+
+    // assert
+    EXPECT_EQ(err, DATABASE_OK);
+    ASSERT_EQ(count, 4u);
+    EXPECT_EQ(values[0], 50);
+    EXPECT_EQ(values[3], 80);
+    EXPECT_EQ(ring.read(5, nullptr, 4, &count), DATABASE_VALUE_INVALID);
+}
+
+/** Testing delta encoding
+ * @brief Records after the first of a slot are stored as differences and read back unchanged.
+ */
+TEST_F(RingBufferTest, deltaEncoding)
+{
+    // arrange
+    DatabaseRingBuffer ring(databaseAPI, "temp", 2, 4, true);
+    ASSERT_EQ(ring.begin(), DATABASE_OK);
+
+    // act
+    ASSERT_EQ(ring.append(2150), DATABASE_OK);
+    ASSERT_EQ(ring.append(2151), DATABASE_OK);
+    ASSERT_EQ(ring.append(2149), DATABASE_OK);
+    ASSERT_EQ(ring.append(INT32_MIN), DATABASE_OK);
+    char value[64] = {0};
+    ASSERT_EQ(databaseAPI->get("temp0", value, sizeof(value)), DATABASE_OK);
+    DatabaseRingBuffer reopened(databaseAPI, "temp", 2, 4, true);
+    ASSERT_EQ(reopened.begin(), DATABASE_OK);
+    int32_t values[4] = {0};
+    size_t count = 0;
+    ASSERT_EQ(reopened.read(0, values, 4, &count), DATABASE_OK);
+
+    // assert
+    EXPECT_STREQ(value, "0:d2150,1,-2,-2147485797");
+    ASSERT_EQ(count, 4u);
+    EXPECT_EQ(values[0], 2150);
+    EXPECT_EQ(values[1], 2151);
+    EXPECT_EQ(values[2], 2149);
+    EXPECT_EQ(values[3], INT32_MIN);
+}
+
+/** Testing begin
+ * @brief Invalid configurations are rejected, and nothing is appended before begin().
+ */
+TEST_F(RingBufferTest, invalidConfiguration)
+{
+    // arrange
+    DatabaseRingBuffer longPrefix(databaseAPI, "a_long_prefix", 4, 4);
+    DatabaseRingBuffer oneSlot(databaseAPI, "log", 1, 4);
+    DatabaseRingBuffer tooManyRecords(databaseAPI, "log", 4, DATABASE_RING_BUFFER_MAX_RECORDS_PER_SLOT + 1);
+    DatabaseRingBuffer notStarted(databaseAPI, "log", 4, 4);
+
+    // act & assert
+    EXPECT_EQ(longPrefix.begin(), DATABASE_KEY_INVALID);
+    EXPECT_EQ(oneSlot.begin(), DATABASE_VALUE_INVALID);
+    EXPECT_EQ(tooManyRecords.begin(), DATABASE_VALUE_INVALID);
+    EXPECT_EQ(notStarted.append(1), DATABASE_ERROR);
+}
+
+#endif // UNIT_RING_BUFFER_TEST_HPP
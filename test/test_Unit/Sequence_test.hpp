@@ -0,0 +1,148 @@
+#ifndef UNIT_SEQUENCE_TEST_HPP
+#define UNIT_SEQUENCE_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "MemoryNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseSequence.hpp"
+
+// setup test suite
+class SequenceTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        memoryNVSDelegate = new MemoryNVSDelegate();
+        databaseAPI = new DatabaseAPI(memoryNVSDelegate, "TEST_NVS");
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete memoryNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Reads the persisted end of the reserved block
+    int64_t storedLimit(char const *const key)
+    {
+        NVSDelegateHandle_t handle;
+        int64_t limit = -1;
+        if (memoryNVSDelegate->open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle) == NVSDelegateError_t::NVS_DELEGATE_OK)
+            memoryNVSDelegate->get_i64(handle, key, &limit);
+        return limit;
+    }
+
+    DatabaseAPI *databaseAPI;
+    MemoryNVSDelegate *memoryNVSDelegate;
+};
+
+/** Testing DatabaseSequence class
+ * @brief IDs are served from RAM and the end of each reserved block is persisted once.
+ */
+
+TEST_F(SequenceTest, next_WithinBlock_PersistsOncePerBlock)
+{
+    // arrange
+    DatabaseSequence sequence(databaseAPI, "msgId", 100);
+    uint32_t id = 0;
+
+    // act & assert
+    for (uint32_t i = 0; i < 250; i++)
+    {
+        ASSERT_EQ(sequence.next(&id), DatabaseError_t::DATABASE_OK);
+        ASSERT_EQ(id, i);
+        if (i == 0)
+        {
+            EXPECT_EQ(storedLimit("msgId"), 100);
+        }
+    }
+    EXPECT_EQ(storedLimit("msgId"), 300);
+}
+
+TEST_F(SequenceTest, next_AfterRestart_SkipsToNextBlock)
+{
+    // arrange
+    DatabaseSequence *before = new DatabaseSequence(databaseAPI, "msgId", 100);
+    uint32_t id = 0;
+    for (int i = 0; i < 5; i++)
+        ASSERT_EQ(before->next(&id), DatabaseError_t::DATABASE_OK);
+    delete before;
+    delete databaseAPI;
+    databaseAPI = new DatabaseAPI(memoryNVSDelegate, "TEST_NVS");
+    DatabaseSequence after(databaseAPI, "msgId", 100);
+
+    // act
+    DatabaseError_t err = after.next(&id);
+
+    // assert
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(id, 100);
+    EXPECT_EQ(storedLimit("msgId"), 200);
+}
+
+TEST_F(SequenceTest, next_InvalidArguments_Rejected)
+{
+    // arrange
+    DatabaseSequence invalidKey(databaseAPI, "");
+    DatabaseSequence emptyBlock(databaseAPI, "msgId", 0);
+    uint32_t id = 0;
+
+    // act
+    DatabaseError_t err1 = invalidKey.next(&id);
+    DatabaseError_t err2 = emptyBlock.next(&id);
+    DatabaseError_t err3 = invalidKey.next(nullptr);
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_KEY_INVALID);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_VALUE_INVALID);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_VALUE_INVALID);
+}
+
+TEST_F(SequenceTest, next_ConcurrentThreads_Unique)
+{
+    // arrange
+    DatabaseSequence sequence(databaseAPI, "msgId", 64);
+    std::vector<uint32_t> ids[4];
+    std::thread threads[4];
+
+    // act
+    for (int t = 0; t < 4; t++)
+        threads[t] = std::thread([&sequence, &ids, t]()
+                                 {
+                                     uint32_t id = 0;
+                                     for (int i = 0; i < 500; i++)
+                                         if (sequence.next(&id) == DatabaseError_t::DATABASE_OK)
+                                             ids[t].push_back(id); });
+    for (int t = 0; t < 4; t++)
+        threads[t].join();
+
+    // assert
+    std::vector<uint32_t> all;
+    for (int t = 0; t < 4; t++)
+    {
+        EXPECT_EQ(ids[t].size(), 500u);
+        EXPECT_TRUE(std::is_sorted(ids[t].begin(), ids[t].end()));
+        all.insert(all.end(), ids[t].begin(), ids[t].end());
+    }
+    std::sort(all.begin(), all.end());
+    EXPECT_EQ(std::adjacent_find(all.begin(), all.end()), all.end());
+    EXPECT_EQ(all.back(), 1999u);
+}
+
+#endif // UNIT_SEQUENCE_TEST_HPP
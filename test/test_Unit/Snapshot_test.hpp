@@ -0,0 +1,263 @@
+#ifndef UNIT_SNAPSHOT_TEST_HPP
+#define UNIT_SNAPSHOT_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <atomic>
+#include <thread>
+
+#include "MockingClass.hpp"
+#include "DatabaseAPI.hpp"
+#include "NVSDelegateInterface.hpp"
+
+// setup test suite
+class SnapshotTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        // setup mock
+        mockNVSDelegate = new MockNVSDelegate();
+        databaseAPI = new DatabaseAPI(mockNVSDelegate, "TEST_NVS");
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete mockNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Expects one load of a namespace holding "ssid" = "home" and "port" = "1883"
+    void expectLoad()
+    {
+        EXPECT_CALL(*mockNVSDelegate, open(testing::StrEq("TEST_NVS"), NVSDelegateOpenMode_t::NVSDelegate_READONLY, ::testing::_))
+            .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+
+        EXPECT_CALL(*mockNVSDelegate, list_keys(testing::StrEq("TEST_NVS"), ::testing::NotNull(), ::testing::_))
+            .Times(2)
+            .WillRepeatedly(::testing::Invoke(
+                [](char const *const, NVSDelegateKeyCallback_t callback, void *context)
+                {
+                    callback("ssid", context) && callback("port", context);
+                    return NVSDelegateError_t::NVS_DELEGATE_OK;
+                }));
+
+        EXPECT_CALL(*mockNVSDelegate, get_str(::testing::_, testing::StrEq("ssid"), nullptr, ::testing::NotNull()))
+            .Times(2)
+            .WillRepeatedly(::testing::DoAll(::testing::SetArgPointee<3>(strlen("home") + 1), ::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK)));
+        EXPECT_CALL(*mockNVSDelegate, get_str(::testing::_, testing::StrEq("ssid"), ::testing::NotNull(), ::testing::NotNull()))
+            .WillOnce(::testing::DoAll(::testing::SetArrayArgument<2>("home", "home" + strlen("home") + 1), ::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK)));
+
+        EXPECT_CALL(*mockNVSDelegate, get_str(::testing::_, testing::StrEq("port"), nullptr, ::testing::NotNull()))
+            .Times(2)
+            .WillRepeatedly(::testing::DoAll(::testing::SetArgPointee<3>(strlen("1883") + 1), ::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK)));
+        EXPECT_CALL(*mockNVSDelegate, get_str(::testing::_, testing::StrEq("port"), ::testing::NotNull(), ::testing::NotNull()))
+            .WillOnce(::testing::DoAll(::testing::SetArrayArgument<2>("1883", "1883" + strlen("1883") + 1), ::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK)));
+
+        EXPECT_CALL(*mockNVSDelegate, close(::testing::_)).Times(1);
+    }
+
+    DatabaseAPI *databaseAPI;
+    MockNVSDelegate *mockNVSDelegate;
+};
+
+/** Testing snapshot mode of DatabaseAPI class
+ * @brief Reads are served from an immutable in-RAM snapshot, writes go through and publish a new one.
+ */
+
+TEST_F(SnapshotTest, get_ServedFromSnapshot)
+{
+    // arrange
+    expectLoad();
+    char value[16];
+    size_t length = 0;
+
+    // act
+    DatabaseError_t err = databaseAPI->enableSnapshot();
+    ::testing::Mock::VerifyAndClearExpectations(mockNVSDelegate);
+
+    // assert, no further delegate call is expected
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_OK);
+    EXPECT_TRUE(databaseAPI->isSnapshotEnabled());
+    EXPECT_EQ(databaseAPI->get("ssid", value, sizeof(value)), DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "home");
+    EXPECT_EQ(databaseAPI->get("port", value, sizeof(value)), DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "1883");
+    EXPECT_EQ(databaseAPI->get("port", value, 2), DatabaseError_t::DATABASE_VALUE_INVALID);
+    EXPECT_EQ(databaseAPI->get("missing", value, sizeof(value)), DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(databaseAPI->isExist("ssid"), DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(databaseAPI->isExist("missing"), DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(databaseAPI->getValueLength("ssid", &length), DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(length, strlen("home") + 1);
+}
+
+TEST_F(SnapshotTest, set_remove_PublishNewSnapshot)
+{
+    // arrange
+    expectLoad();
+    ASSERT_EQ(databaseAPI->enableSnapshot(), DatabaseError_t::DATABASE_OK);
+    ::testing::Mock::VerifyAndClearExpectations(mockNVSDelegate);
+    char value[16];
+
+    EXPECT_CALL(*mockNVSDelegate, open(testing::StrEq("TEST_NVS"), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, ::testing::_))
+        .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, set_str(::testing::_, testing::StrEq("host"), testing::StrEq("broker")))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, erase_key(::testing::_, testing::StrEq("ssid")))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, commit(::testing::_))
+        .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, close(::testing::_))
+        .WillRepeatedly(::testing::Return());
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("host", "broker");
+    DatabaseError_t err2 = databaseAPI->remove("ssid");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(databaseAPI->get("host", value, sizeof(value)), DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "broker");
+    EXPECT_EQ(databaseAPI->get("ssid", value, sizeof(value)), DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(databaseAPI->get("port", value, sizeof(value)), DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "1883");
+}
+
+TEST_F(SnapshotTest, disableSnapshot_ReadsFromNVS)
+{
+    // arrange
+    expectLoad();
+    ASSERT_EQ(databaseAPI->enableSnapshot(), DatabaseError_t::DATABASE_OK);
+    ::testing::Mock::VerifyAndClearExpectations(mockNVSDelegate);
+
+    EXPECT_CALL(*mockNVSDelegate, open(testing::StrEq("TEST_NVS"), NVSDelegateOpenMode_t::NVSDelegate_READONLY, ::testing::_))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, get_str(::testing::_, testing::StrEq("ssid"), nullptr, ::testing::NotNull()))
+        .WillOnce(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND));
+    EXPECT_CALL(*mockNVSDelegate, close(::testing::_)).Times(1);
+
+    // act
+    databaseAPI->disableSnapshot();
+    DatabaseError_t err = databaseAPI->isExist("ssid");
+
+    // assert
+    EXPECT_FALSE(databaseAPI->isSnapshotEnabled());
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+}
+
+/**
+ * @brief Readers on another thread always see a complete snapshot while a writer publishes new ones.
+ */
+TEST_F(SnapshotTest, get_ConcurrentWithSet)
+{
+    // arrange
+    expectLoad();
+    ASSERT_EQ(databaseAPI->enableSnapshot(), DatabaseError_t::DATABASE_OK);
+    ::testing::Mock::VerifyAndClearExpectations(mockNVSDelegate);
+
+    EXPECT_CALL(*mockNVSDelegate, open(testing::StrEq("TEST_NVS"), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, ::testing::_))
+        .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, set_str(::testing::_, testing::StrEq("port"), ::testing::NotNull()))
+        .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, commit(::testing::_))
+        .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, close(::testing::_))
+        .WillRepeatedly(::testing::Return());
+
+    std::atomic<bool> done(false);
+    std::atomic<int> failures(0);
+
+    // act
+    std::thread reader(
+        [this, &done, &failures]()
+        {
+            char value[16];
+            while (!done.load())
+            {
+                if (databaseAPI->get("ssid", value, sizeof(value)) != DATABASE_OK || strcmp(value, "home") != 0)
+                    failures++;
+                if (databaseAPI->get("port", value, sizeof(value)) != DATABASE_OK || strlen(value) != 4)
+                    failures++;
+            }
+        });
+    char port[8];
+    for (int i = 0; i < 200; i++)
+    {
+        snprintf(port, sizeof(port), "%d", 1000 + i);
+        ASSERT_EQ(databaseAPI->set("port", port), DatabaseError_t::DATABASE_OK);
+    }
+    done.store(true);
+    reader.join();
+
+    // assert
+    EXPECT_EQ(failures.load(), 0);
+}
+
+/**
+ * @brief A writer publishes while readers on several threads keep overlapping, without waiting for them to pause.
+ */
+TEST_F(SnapshotTest, set_OverlappingReaders_NotStarved)
+{
+    // arrange
+    expectLoad();
+    ASSERT_EQ(databaseAPI->enableSnapshot(), DatabaseError_t::DATABASE_OK);
+    ::testing::Mock::VerifyAndClearExpectations(mockNVSDelegate);
+
+    EXPECT_CALL(*mockNVSDelegate, open(testing::StrEq("TEST_NVS"), NVSDelegateOpenMode_t::NVSDelegate_READWRITE, ::testing::_))
+        .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, set_str(::testing::_, testing::StrEq("port"), ::testing::NotNull()))
+        .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, commit(::testing::_))
+        .WillRepeatedly(::testing::Return(NVSDelegateError_t::NVS_DELEGATE_OK));
+    EXPECT_CALL(*mockNVSDelegate, close(::testing::_))
+        .WillRepeatedly(::testing::Return());
+
+    std::atomic<bool> done(false);
+    std::atomic<int> failures(0);
+    std::thread readers[4];
+
+    // act
+    for (std::thread &reader : readers)
+    {
+        reader = std::thread(
+            [this, &done, &failures]()
+            {
+                char value[16];
+                while (!done.load())
+                {
+                    if (databaseAPI->get("ssid", value, sizeof(value)) != DATABASE_OK || strcmp(value, "home") != 0)
+                        failures++;
+                }
+            });
+    }
+    char port[8];
+    unsigned long const start = millis();
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf(port, sizeof(port), "%d", 1000 + i);
+        ASSERT_EQ(databaseAPI->set("port", port), DatabaseError_t::DATABASE_OK);
+    }
+    unsigned long const elapsed = millis() - start;
+    done.store(true);
+    for (std::thread &reader : readers)
+        reader.join();
+
+    // assert
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_LT(elapsed, 2000UL);
+}
+
+#endif // UNIT_SNAPSHOT_TEST_HPP
@@ -0,0 +1,199 @@
+#ifndef UNIT_SUBSCRIPTION_TEST_HPP
+#define UNIT_SUBSCRIPTION_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <mutex>
+#include <string.h>
+
+#include "MemoryNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseSubscriptions.hpp"
+
+// Changes received by a subscriber, in delivery order
+struct SubscriptionRecorder
+{
+    std::mutex mutex;
+    char keys[64][NVS_DELEGATE_MAX_KEY_LENGTH];
+    DatabaseChange_t changes[64];
+    std::atomic<size_t> count{0};
+    std::atomic<bool> hold{false};
+
+    static void record(char const *const key, DatabaseChange_t const change, void *context)
+    {
+        SubscriptionRecorder *const recorder = static_cast<SubscriptionRecorder *>(context);
+        while (recorder->hold.load())
+            delay(1);
+
+        std::lock_guard<std::mutex> guard(recorder->mutex);
+        size_t const index = recorder->count.load();
+        if (index >= 64)
+            return;
+        strcpy(recorder->keys[index], key);
+        recorder->changes[index] = change;
+        recorder->count.store(index + 1);
+    }
+
+    // Waits up to a second for a number of changes
+    bool waitFor(size_t const expected)
+    {
+        for (int i = 0; i < 1000 && count.load() < expected; ++i)
+            delay(1);
+        return count.load() >= expected;
+    }
+};
+
+// setup test suite
+class SubscriptionTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        memoryNVSDelegate = new MemoryNVSDelegate();
+        databaseAPI = new DatabaseAPI(memoryNVSDelegate, "TEST_NVS");
+        recorder = new SubscriptionRecorder();
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete memoryNVSDelegate;
+        delete recorder;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    DatabaseAPI *databaseAPI;
+    MemoryNVSDelegate *memoryNVSDelegate;
+    SubscriptionRecorder *recorder;
+};
+
+/** Testing subscribe
+ * @brief A subscription to a key receives its sets and removes, in order.
+ */
+TEST_F(SubscriptionTest, keyReceivesSetAndRemove)
+{
+    // arrange
+    uint32_t id = 0;
+    ASSERT_EQ(databaseAPI->subscribe("ssid", SubscriptionRecorder::record, recorder, &id), DATABASE_OK);
+
+    // act
+    ASSERT_EQ(databaseAPI->set("ssid", "office"), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("mode", "auto"), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->remove("ssid"), DATABASE_OK);
+
+    // assert
+    ASSERT_TRUE(recorder->waitFor(2));
+    delay(20);
+    EXPECT_EQ(recorder->count.load(), 2u);
+    EXPECT_STREQ(recorder->keys[0], "ssid");
+    EXPECT_EQ(recorder->changes[0], DATABASE_CHANGE_SET);
+    EXPECT_STREQ(recorder->keys[1], "ssid");
+    EXPECT_EQ(recorder->changes[1], DATABASE_CHANGE_REMOVED);
+    EXPECT_NE(id, 0u);
+}
+
+/** Testing subscribe
+ * @brief A prefix subscription receives the keys starting with the prefix, including commits of a batch.
+ */
+TEST_F(SubscriptionTest, prefixMatchesKeysAndBatches)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->subscribe("wifi.*", SubscriptionRecorder::record, recorder), DATABASE_OK);
+    DatabaseBatch batch;
+    ASSERT_EQ(batch.set("wifi.pass", "secret"), DATABASE_OK);
+    ASSERT_EQ(batch.set("mqtt.host", "broker"), DATABASE_OK);
+
+    // act
+    ASSERT_EQ(databaseAPI->set("wifi.ssid", "office"), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("mqtt.port", "1883"), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->commit(batch), DATABASE_OK);
+
+    // assert
+    ASSERT_TRUE(recorder->waitFor(2));
+    delay(20);
+    EXPECT_EQ(recorder->count.load(), 2u);
+    EXPECT_STREQ(recorder->keys[0], "wifi.ssid");
+    EXPECT_STREQ(recorder->keys[1], "wifi.pass");
+}
+
+/** Testing subscribe
+ * @brief eraseAll reaches every subscription as DATABASE_CHANGE_ERASED with an empty key.
+ */
+TEST_F(SubscriptionTest, eraseAllReachesEverySubscription)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->subscribe("ssid", SubscriptionRecorder::record, recorder), DATABASE_OK);
+
+    // act
+    ASSERT_EQ(databaseAPI->eraseAll(), DATABASE_OK);
+
+    // assert
+    ASSERT_TRUE(recorder->waitFor(1));
+    EXPECT_STREQ(recorder->keys[0], "");
+    EXPECT_EQ(recorder->changes[0], DATABASE_CHANGE_ERASED);
+}
+
+/** Testing subscribe
+ * @brief A blocked subscriber does not block the writer; dropped changes are reported as an overflow.
+ */
+TEST_F(SubscriptionTest, slowSubscriberDoesNotBlockWriter)
+{
+    // arrange
+    recorder->hold.store(true);
+    ASSERT_EQ(databaseAPI->subscribe("*", SubscriptionRecorder::record, recorder), DATABASE_OK);
+    char key[NVS_DELEGATE_MAX_KEY_LENGTH];
+
+    // act
+    for (int i = 0; i < 3 * DATABASE_SUBSCRIPTION_QUEUE_LENGTH; ++i)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        ASSERT_EQ(databaseAPI->set(key, "1"), DATABASE_OK);
+    }
+    uint32_t const dropped = databaseAPI->droppedChanges();
+    recorder->hold.store(false);
+
+    // assert
+    EXPECT_GT(dropped, 0u);
+    ASSERT_TRUE(recorder->waitFor(3 * DATABASE_SUBSCRIPTION_QUEUE_LENGTH - dropped + 1));
+    delay(20);
+    size_t overflows = 0;
+    for (size_t i = 0; i < recorder->count.load(); ++i)
+        overflows += recorder->changes[i] == DATABASE_CHANGE_OVERFLOW;
+    EXPECT_EQ(overflows, 1u);
+}
+
+/** Testing unsubscribe
+ * @brief After unsubscribe returns the callback is not called again; invalid arguments are rejected.
+ */
+TEST_F(SubscriptionTest, unsubscribeAndInvalidArguments)
+{
+    // arrange
+    uint32_t id = 0;
+    ASSERT_EQ(databaseAPI->subscribe("ssid", SubscriptionRecorder::record, recorder, &id), DATABASE_OK);
+
+    // act
+    DatabaseError_t const err = databaseAPI->unsubscribe(id);
+    ASSERT_EQ(databaseAPI->set("ssid", "office"), DATABASE_OK);
+    delay(20);
+
+    // assert
+    EXPECT_EQ(err, DATABASE_OK);
+    EXPECT_EQ(recorder->count.load(), 0u);
+    EXPECT_EQ(databaseAPI->unsubscribe(id), DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(databaseAPI->subscribe("", SubscriptionRecorder::record, recorder), DATABASE_KEY_INVALID);
+    EXPECT_EQ(databaseAPI->subscribe("a_key_that_is_too_long", SubscriptionRecorder::record, recorder), DATABASE_KEY_INVALID);
+    EXPECT_EQ(databaseAPI->subscribe("ssid", nullptr, recorder), DATABASE_VALUE_INVALID);
+}
+
+#endif // UNIT_SUBSCRIPTION_TEST_HPP
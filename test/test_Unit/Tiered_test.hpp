@@ -0,0 +1,343 @@
+#ifndef UNIT_TIERED_TEST_HPP
+#define UNIT_TIERED_TEST_HPP
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <dirent.h>
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+#include "FaultInjectingNVSDelegate.hpp"
+#include "TieredNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+
+#ifndef TIERED_TEST_DIRECTORY
+#define TIERED_TEST_DIRECTORY "/littlefs/tier"
+#endif
+
+#define TIERED_TEST_THRESHOLD 256
+
+// setup test suite
+class TieredNVSDelegateTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+
+    // Mounted once, before any heap is measured
+    static void SetUpTestSuite()
+    {
+        LittleFS.begin(true);
+    }
+
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        memoryNVSDelegate = new MemoryNVSDelegate();
+        tieredNVSDelegate = new TieredNVSDelegate(memoryNVSDelegate, TIERED_TEST_DIRECTORY, TIERED_TEST_THRESHOLD);
+        databaseAPI = new DatabaseAPI(tieredNVSDelegate, "TEST_NVS");
+
+        memset(large, 'L', sizeof(large) - 1);
+        large[sizeof(large) - 1] = '\0';
+    }
+
+    void TearDown() override
+    {
+        tieredNVSDelegate->erase_flash_all();
+        delete databaseAPI;
+        delete tieredNVSDelegate;
+        delete memoryNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Number of files in the directory
+    size_t fileCount()
+    {
+        DIR *const directory = opendir(TIERED_TEST_DIRECTORY);
+        if (directory == nullptr)
+            return 0;
+        size_t count = 0;
+        struct dirent *entry;
+        while ((entry = readdir(directory)) != nullptr)
+            if (entry->d_name[0] != '.')
+                count++;
+        closedir(directory);
+        return count;
+    }
+
+    // Length of a key as stored by the wrapped delegate, 0 if it is not stored with that type
+    size_t storedLength(char const *const key, bool blob)
+    {
+        NVSDelegateHandle_t handle;
+        size_t length = 0;
+        if (memoryNVSDelegate->open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle) != NVSDelegateError_t::NVS_DELEGATE_OK)
+            return 0;
+        NVSDelegateError_t err = blob ? memoryNVSDelegate->get_blob(handle, key, nullptr, &length)
+                                      : memoryNVSDelegate->get_str(handle, key, nullptr, &length);
+        memoryNVSDelegate->close(handle);
+        return err == NVSDelegateError_t::NVS_DELEGATE_OK ? length : 0;
+    }
+
+    DatabaseAPI *databaseAPI;
+    TieredNVSDelegate *tieredNVSDelegate;
+    MemoryNVSDelegate *memoryNVSDelegate;
+    char large[TIERED_TEST_THRESHOLD * 3];
+};
+
+/** Testing TieredNVSDelegate class
+ * @brief Values below the threshold stay in NVS, longer ones go to a file behind a pointer record.
+ */
+
+TEST_F(TieredNVSDelegateTest, set_SplitsByThreshold)
+{
+    // arrange
+    char value[sizeof(large)] = {0};
+    char small[TIERED_TEST_THRESHOLD] = {0};
+    memset(small, 's', TIERED_TEST_THRESHOLD - 1);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("small", small);
+    DatabaseError_t err2 = databaseAPI->set("large", large);
+
+    // assert
+    EXPECT_EQ(err1, DATABASE_OK);
+    EXPECT_EQ(err2, DATABASE_OK);
+    EXPECT_EQ(storedLength("small", false), (size_t)TIERED_TEST_THRESHOLD);
+    EXPECT_EQ(storedLength("large", false), 0u);
+    EXPECT_EQ(storedLength("large", true), (size_t)TIERED_NVS_DELEGATE_POINTER_LENGTH);
+    EXPECT_EQ(fileCount(), 1u);
+    ASSERT_EQ(databaseAPI->get("large", value, sizeof(value)), DATABASE_OK);
+    EXPECT_STREQ(value, large);
+    ASSERT_EQ(databaseAPI->get("small", value, sizeof(value)), DATABASE_OK);
+    EXPECT_STREQ(value, small);
+}
+
+/** Testing TieredNVSDelegate class
+ * @brief A value in a file reports its length, and is not read into a buffer too small for it.
+ */
+
+TEST_F(TieredNVSDelegateTest, get_FileValueLengthAndBuffer)
+{
+    // arrange
+    char value[TIERED_TEST_THRESHOLD] = {0};
+    size_t length = 0;
+    ASSERT_EQ(databaseAPI->set("large", large), DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->getValueLength("large", &length);
+    DatabaseError_t err2 = databaseAPI->get("large", value, sizeof(value));
+
+    // assert
+    EXPECT_EQ(err1, DATABASE_OK);
+    EXPECT_EQ(length, strlen(large) + 1);
+    EXPECT_EQ(err2, DATABASE_VALUE_INVALID);
+    EXPECT_EQ(databaseAPI->isExist("large"), DATABASE_OK);
+}
+
+/** Testing TieredNVSDelegate class
+ * @brief Overwriting moves a key between the tiers, leaving a single copy and no stale file.
+ */
+
+TEST_F(TieredNVSDelegateTest, set_OverwriteSwitchesTier)
+{
+    // arrange
+    char value[sizeof(large)] = {0};
+    ASSERT_EQ(databaseAPI->set("key", "short"), DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("key", large);
+    size_t const stringAfterLarge = storedLength("key", false);
+    large[0] = 'X';
+    DatabaseError_t err2 = databaseAPI->set("key", large);
+    size_t const filesAfterOverwrite = fileCount();
+    DatabaseError_t err3 = databaseAPI->set("key", "short again");
+
+    // assert
+    EXPECT_EQ(err1, DATABASE_OK);
+    EXPECT_EQ(err2, DATABASE_OK);
+    EXPECT_EQ(err3, DATABASE_OK);
+    EXPECT_EQ(stringAfterLarge, 0u);
+    EXPECT_EQ(filesAfterOverwrite, 1u);
+    EXPECT_EQ(fileCount(), 0u);
+    EXPECT_EQ(storedLength("key", true), 0u);
+    ASSERT_EQ(databaseAPI->get("key", value, sizeof(value)), DATABASE_OK);
+    EXPECT_STREQ(value, "short again");
+}
+
+TEST_F(TieredNVSDelegateTest, set_ShortWriteFails_FileValueKept)
+{
+    // arrange
+    FaultInjectingNVSDelegate faultInjectingNVSDelegate;
+    TieredNVSDelegate tiered(&faultInjectingNVSDelegate, TIERED_TEST_DIRECTORY, TIERED_TEST_THRESHOLD);
+    DatabaseAPI database(&tiered, "TEST_NVS");
+    ASSERT_EQ(database.set("key", large), DATABASE_OK);
+    faultInjectingNVSDelegate.failStrings = true;
+    char value[sizeof(large)] = {0};
+
+    // act
+    DatabaseError_t err1 = database.set("key", "short");
+    DatabaseError_t err2 = database.get("key", value, sizeof(value));
+    size_t const files = fileCount();
+    tiered.erase_flash_all();
+
+    // assert
+    EXPECT_NE(err1, DATABASE_OK);
+    EXPECT_EQ(err2, DATABASE_OK);
+    EXPECT_STREQ(value, large);
+    EXPECT_EQ(files, 1u);
+}
+
+TEST_F(TieredNVSDelegateTest, set_SwitchingTier_NoStaleEntry)
+{
+    for (int blobFirst = 0; blobFirst < 2; blobFirst++)
+    {
+        // arrange
+        FaultInjectingNVSDelegate faultInjectingNVSDelegate;
+        faultInjectingNVSDelegate.separateTypes = true;
+        faultInjectingNVSDelegate.eraseBlobFirst = blobFirst == 1;
+        TieredNVSDelegate tiered(&faultInjectingNVSDelegate, TIERED_TEST_DIRECTORY, TIERED_TEST_THRESHOLD);
+        NVSDelegateHandle_t handle;
+        ASSERT_EQ(tiered.open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle), NVSDelegateError_t::NVS_DELEGATE_OK);
+        char value[sizeof(large)] = {0};
+        size_t length = sizeof(value);
+        size_t stringLength = 0;
+        size_t blobLength = 0;
+
+        // act
+        NVSDelegateError_t err1 = tiered.set_str(handle, "key", "short");
+        NVSDelegateError_t err2 = tiered.set_str(handle, "key", large);
+        NVSDelegateError_t err3 = faultInjectingNVSDelegate.get_str(handle, "key", nullptr, &stringLength);
+        NVSDelegateError_t err4 = tiered.get_str(handle, "key", value, &length);
+        NVSDelegateError_t err5 = tiered.set_str(handle, "key", "short again");
+        NVSDelegateError_t err6 = faultInjectingNVSDelegate.get_blob(handle, "key", nullptr, &blobLength);
+        size_t const files = fileCount();
+        tiered.close(handle);
+        tiered.erase_flash_all();
+
+        // assert
+        EXPECT_EQ(err1, NVSDelegateError_t::NVS_DELEGATE_OK);
+        EXPECT_EQ(err2, NVSDelegateError_t::NVS_DELEGATE_OK);
+        EXPECT_EQ(err3, NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND);
+        EXPECT_EQ(err4, NVSDelegateError_t::NVS_DELEGATE_OK);
+        EXPECT_STREQ(value, large);
+        EXPECT_EQ(err5, NVSDelegateError_t::NVS_DELEGATE_OK);
+        EXPECT_EQ(err6, NVSDelegateError_t::NVS_DELEGATE_KEY_NOT_FOUND);
+        EXPECT_EQ(files, 0u);
+    }
+}
+
+TEST_F(TieredNVSDelegateTest, set_SwitchingTier_PointerWrittenOnce)
+{
+    // arrange
+    FaultInjectingNVSDelegate faultInjectingNVSDelegate;
+    faultInjectingNVSDelegate.separateTypes = true;
+    TieredNVSDelegate tiered(&faultInjectingNVSDelegate, TIERED_TEST_DIRECTORY, TIERED_TEST_THRESHOLD);
+    NVSDelegateHandle_t handle;
+    ASSERT_EQ(tiered.open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle), NVSDelegateError_t::NVS_DELEGATE_OK);
+    ASSERT_EQ(tiered.set_str(handle, "key", "short"), NVSDelegateError_t::NVS_DELEGATE_OK);
+    faultInjectingNVSDelegate.writes = 0;
+
+    // act
+    NVSDelegateError_t err = tiered.set_str(handle, "key", large);
+    tiered.close(handle);
+    tiered.erase_flash_all();
+
+    // assert
+    EXPECT_EQ(err, NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(faultInjectingNVSDelegate.writes, 2u); // the pointer record, then the erase of the string
+}
+
+/** Testing TieredNVSDelegate class
+ * @brief Removing a key, or erasing the namespace, removes the files of its values.
+ */
+
+TEST_F(TieredNVSDelegateTest, remove_RemovesFile)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->set("large1", large), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("large2", large), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("large3", large), DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->remove("large1");
+    size_t const filesAfterRemove = fileCount();
+    DatabaseError_t err2 = databaseAPI->eraseAll();
+
+    // assert
+    EXPECT_EQ(err1, DATABASE_OK);
+    EXPECT_EQ(err2, DATABASE_OK);
+    EXPECT_EQ(filesAfterRemove, 2u);
+    EXPECT_EQ(fileCount(), 0u);
+    EXPECT_EQ(databaseAPI->isExist("large2"), DATABASE_KEY_NOT_FOUND);
+}
+
+/** Testing TieredNVSDelegate class
+ * @brief Files left behind by an interrupted write are removed, the ones in use are kept.
+ */
+
+TEST_F(TieredNVSDelegateTest, removeOrphans_KeepsReferencedFiles)
+{
+    // arrange
+    char value[sizeof(large)] = {0};
+    ASSERT_EQ(databaseAPI->set("kept", large), DATABASE_OK);
+    ASSERT_EQ(databaseAPI->set("lost", large), DATABASE_OK);
+    NVSDelegateHandle_t handle;
+    ASSERT_EQ(memoryNVSDelegate->open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle), NVSDelegateError_t::NVS_DELEGATE_OK);
+    ASSERT_EQ(memoryNVSDelegate->erase_key(handle, "lost"), NVSDelegateError_t::NVS_DELEGATE_OK); // the reset came before the pointer record
+    memoryNVSDelegate->close(handle);
+    FILE *const partial = fopen(TIERED_TEST_DIRECTORY "/00000100", "wb");
+    ASSERT_NE(partial, nullptr);
+    fputs("NV", partial); // the reset came before the header was written
+    fclose(partial);
+
+    // act
+    size_t removed = 0;
+    NVSDelegateError_t err = tieredNVSDelegate->removeOrphans(&removed);
+
+    // assert
+    EXPECT_EQ(err, NVSDelegateError_t::NVS_DELEGATE_OK);
+    EXPECT_EQ(removed, 2u);
+    EXPECT_EQ(fileCount(), 1u);
+    ASSERT_EQ(databaseAPI->get("kept", value, sizeof(value)), DATABASE_OK);
+    EXPECT_STREQ(value, large);
+}
+
+/** Testing TieredNVSDelegate class
+ * @brief A file changed behind the delegate's back fails its CRC and is not returned.
+ */
+
+TEST_F(TieredNVSDelegateTest, get_CorruptedFile)
+{
+    // arrange
+    char value[sizeof(large)] = {0};
+    ASSERT_EQ(databaseAPI->set("large", large), DATABASE_OK);
+    DIR *const directory = opendir(TIERED_TEST_DIRECTORY);
+    ASSERT_NE(directory, nullptr);
+    struct dirent *entry;
+    char path[sizeof(TIERED_TEST_DIRECTORY) + sizeof(entry->d_name)] = {0};
+    while ((entry = readdir(directory)) != nullptr)
+        if (entry->d_name[0] != '.')
+            snprintf(path, sizeof(path), "%s/%s", TIERED_TEST_DIRECTORY, entry->d_name);
+    closedir(directory);
+    FILE *const file = fopen(path, "r+b");
+    ASSERT_NE(file, nullptr);
+    fseek(file, -1, SEEK_END);
+    fputc('x', file);
+    fclose(file);
+
+    // act
+    DatabaseError_t err = databaseAPI->get("large", value, sizeof(value));
+
+    // assert
+    EXPECT_EQ(err, DATABASE_ERROR);
+    EXPECT_STREQ(value, "");
+}
+
+#endif // UNIT_TIERED_TEST_HPP
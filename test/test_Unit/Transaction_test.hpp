@@ -0,0 +1,276 @@
+#ifndef UNIT_TRANSACTION_TEST_HPP
+#define UNIT_TRANSACTION_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "FaultInjectingNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+#include "DatabaseBatch.hpp"
+
+// setup test suite
+class TransactionTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        faultInjectingNVSDelegate = new FaultInjectingNVSDelegate();
+        databaseAPI = new DatabaseAPI(faultInjectingNVSDelegate, "TEST_NVS");
+
+        ASSERT_EQ(databaseAPI->set("ssid", "home"), DatabaseError_t::DATABASE_OK);
+        ASSERT_EQ(databaseAPI->set("password", "old secret"), DatabaseError_t::DATABASE_OK);
+        ASSERT_EQ(batch.set("ssid", "office"), DatabaseError_t::DATABASE_OK);
+        ASSERT_EQ(batch.set("password", "new secret"), DatabaseError_t::DATABASE_OK);
+        ASSERT_EQ(batch.set("ip", "10.0.0.7"), DatabaseError_t::DATABASE_OK);
+        faultInjectingNVSDelegate->commits = 0;
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete faultInjectingNVSDelegate;
+        batch.clear();
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    // Reboots: a new DatabaseAPI over the same storage, with the power back
+    void reboot()
+    {
+        delete databaseAPI;
+        faultInjectingNVSDelegate->writesLeft = -1;
+        faultInjectingNVSDelegate->failingKey = nullptr;
+        databaseAPI = new DatabaseAPI(faultInjectingNVSDelegate, "TEST_NVS");
+    }
+
+    bool isJournalStored()
+    {
+        NVSDelegateHandle_t handle;
+        size_t length = 0;
+        if (faultInjectingNVSDelegate->open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READONLY, &handle) != NVSDelegateError_t::NVS_DELEGATE_OK)
+            return false;
+        return faultInjectingNVSDelegate->get_blob(handle, DATABASE_JOURNAL_KEY, nullptr, &length) == NVSDelegateError_t::NVS_DELEGATE_OK;
+    }
+
+    DatabaseAPI *databaseAPI;
+    FaultInjectingNVSDelegate *faultInjectingNVSDelegate;
+    DatabaseBatch batch;
+};
+
+/** Testing commit Method of DatabaseAPI class
+ * @brief The operations of a batch are applied all together or, after a reset, none.
+ */
+
+TEST_F(TransactionTest, commit_Batch_AllApplied)
+{
+    // arrange
+    char value[16];
+    ASSERT_EQ(batch.remove("password"), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->commit(batch);
+    DatabaseError_t err2 = databaseAPI->get("ssid", value, sizeof(value));
+    DatabaseError_t err3 = databaseAPI->isExist("password");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "office");
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+    EXPECT_FALSE(isJournalStored());
+    EXPECT_EQ(faultInjectingNVSDelegate->commits, 3u); // journal, values, journal erased
+}
+
+TEST_F(TransactionTest, commit_PowerLossWhileApplying_ReplayedOnConstruction)
+{
+    // arrange
+    char ssid[16];
+    char password[16];
+    char ip[16];
+    faultInjectingNVSDelegate->writesLeft = 2; // the journal and the first value
+
+    // act
+    DatabaseError_t err1 = databaseAPI->commit(batch);
+    bool const journalLeft = isJournalStored();
+    reboot();
+    DatabaseError_t err2 = databaseAPI->get("ssid", ssid, sizeof(ssid));
+    DatabaseError_t err3 = databaseAPI->get("password", password, sizeof(password));
+    DatabaseError_t err4 = databaseAPI->get("ip", ip, sizeof(ip));
+
+    // assert
+    EXPECT_NE(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_TRUE(journalLeft);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssid, "office");
+    EXPECT_STREQ(password, "new secret");
+    EXPECT_STREQ(ip, "10.0.0.7");
+    EXPECT_FALSE(isJournalStored());
+}
+
+TEST_F(TransactionTest, commit_WriteFailsOnce_RolledForward)
+{
+    // arrange
+    char password[16];
+    faultInjectingNVSDelegate->failingKey = "password";
+    faultInjectingNVSDelegate->keyFailures = 1;
+
+    // act
+    DatabaseError_t err1 = databaseAPI->commit(batch);
+    DatabaseError_t err2 = databaseAPI->get("password", password, sizeof(password));
+    DatabaseError_t err3 = databaseAPI->isExist("ip");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(password, "new secret");
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_FALSE(isJournalStored());
+}
+
+TEST_F(TransactionTest, commit_WriteKeepsFailing_JournalDroppedAndSnapshotReloaded)
+{
+    // arrange
+    char ssid[16];
+    char password[16];
+    char ssidAfterReboot[16];
+    ASSERT_EQ(databaseAPI->enableSnapshot(), DatabaseError_t::DATABASE_OK);
+    faultInjectingNVSDelegate->failingKey = "password";
+    faultInjectingNVSDelegate->keyFailures = -1;
+
+    // act
+    DatabaseError_t err1 = databaseAPI->commit(batch);
+    bool const journalLeft = isJournalStored();
+    DatabaseError_t err2 = databaseAPI->get("ssid", ssid, sizeof(ssid));
+    DatabaseError_t err3 = databaseAPI->get("password", password, sizeof(password));
+    DatabaseError_t err4 = databaseAPI->isExist("ip");
+    ASSERT_EQ(databaseAPI->set("ssid", "lab"), DatabaseError_t::DATABASE_OK);
+    reboot();
+    DatabaseError_t err5 = databaseAPI->get("ssid", ssidAfterReboot, sizeof(ssidAfterReboot));
+
+    // assert
+    EXPECT_NE(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_FALSE(journalLeft);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssid, "office"); // written before the failing key
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(password, "old secret");
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+    EXPECT_EQ(err5, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssidAfterReboot, "lab"); // the batch is not replayed over the later set
+}
+
+TEST_F(TransactionTest, commit_PowerLossWritingJournal_Unchanged)
+{
+    // arrange
+    char ssid[16];
+    faultInjectingNVSDelegate->writesLeft = 0;
+
+    // act
+    DatabaseError_t err1 = databaseAPI->commit(batch);
+    reboot();
+    DatabaseError_t err2 = databaseAPI->get("ssid", ssid, sizeof(ssid));
+    DatabaseError_t err3 = databaseAPI->isExist("ip");
+
+    // assert
+    EXPECT_NE(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssid, "home");
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_KEY_NOT_FOUND);
+}
+
+TEST_F(TransactionTest, constructor_MalformedJournal_Discarded)
+{
+    // arrange
+    char ssid[16];
+    NVSDelegateHandle_t handle;
+    uint8_t const garbage[] = {'S', 's', 's', 'i', 'd'}; // key not terminated
+    ASSERT_EQ(faultInjectingNVSDelegate->open("TEST_NVS", NVSDelegateOpenMode_t::NVSDelegate_READWRITE, &handle), NVSDelegateError_t::NVS_DELEGATE_OK);
+    ASSERT_EQ(faultInjectingNVSDelegate->set_blob(handle, DATABASE_JOURNAL_KEY, garbage, sizeof(garbage)), NVSDelegateError_t::NVS_DELEGATE_OK);
+
+    // act
+    reboot();
+    DatabaseError_t err = databaseAPI->get("ssid", ssid, sizeof(ssid));
+
+    // assert
+    EXPECT_EQ(err, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssid, "home");
+    EXPECT_FALSE(isJournalStored());
+}
+
+TEST_F(TransactionTest, commit_NotAtomic_SingleCommit)
+{
+    // arrange
+    char ip[16];
+
+    // act
+    DatabaseError_t err1 = databaseAPI->commit(batch, false);
+    DatabaseError_t err2 = databaseAPI->get("ip", ip, sizeof(ip));
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ip, "10.0.0.7");
+    EXPECT_EQ(faultInjectingNVSDelegate->commits, 1u);
+}
+
+TEST_F(TransactionTest, commit_SnapshotEnabled_Updated)
+{
+    // arrange
+    char ssid[16];
+    ASSERT_EQ(databaseAPI->enableSnapshot(), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->commit(batch);
+    DatabaseError_t err2 = databaseAPI->get("ssid", ssid, sizeof(ssid));
+    DatabaseError_t err3 = databaseAPI->isExist("ip");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(ssid, "office");
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+}
+
+TEST_F(TransactionTest, DatabaseBatch_StageAndSerialize)
+{
+    // arrange
+    DatabaseBatch loaded;
+    uint8_t data[128];
+
+    // act
+    DatabaseError_t err1 = batch.set("~jnl", "x");
+    DatabaseError_t err2 = batch.set("ssid", "");
+    DatabaseError_t err3 = batch.set("ssid", "lab");
+    DatabaseError_t err4 = batch.remove("ip");
+    size_t const length = batch.serializedLength();
+    ASSERT_LE(length, sizeof(data));
+    batch.serialize(data);
+    bool const ok = loaded.deserialize(data, length);
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_KEY_INVALID);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_VALUE_INVALID);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err4, DatabaseError_t::DATABASE_OK);
+    EXPECT_TRUE(ok);
+    ASSERT_EQ(loaded.count(), 3u);
+    EXPECT_STREQ(loaded.at(0).key, "ssid");
+    EXPECT_STREQ(loaded.at(0).value, "lab");
+    EXPECT_STREQ(loaded.at(2).key, "ip");
+    EXPECT_EQ(loaded.at(2).value, nullptr);
+    EXPECT_FALSE(loaded.deserialize(data, length - 1));
+    EXPECT_EQ(loaded.count(), 0u);
+}
+
+#endif // UNIT_TRANSACTION_TEST_HPP
@@ -0,0 +1,140 @@
+#ifndef UNIT_WRITE_ELISION_TEST_HPP
+#define UNIT_WRITE_ELISION_TEST_HPP
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+
+#include "FaultInjectingNVSDelegate.hpp"
+#include "DatabaseAPI.hpp"
+
+// setup test suite
+class WriteElisionTest : public ::testing::Test
+{
+protected:
+    int _startFreeHeap;
+    int _endFreeHeap;
+    void SetUp() override
+    {
+        delay(10);
+        _startFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        faultInjectingNVSDelegate = new FaultInjectingNVSDelegate();
+        databaseAPI = new DatabaseAPI(faultInjectingNVSDelegate, "TEST_NVS");
+        databaseAPI->enableWriteElision();
+    }
+
+    void TearDown() override
+    {
+        delete databaseAPI;
+        delete faultInjectingNVSDelegate;
+
+        delay(10);
+        _endFreeHeap = ESP.getFreeHeap();
+        delay(10);
+        if (_startFreeHeap != _endFreeHeap)
+            FAIL() << "Memory leak of " << (_startFreeHeap - _endFreeHeap) << " bytes"; // Fail the test if there is a memory leak
+    }
+
+    DatabaseAPI *databaseAPI;
+    FaultInjectingNVSDelegate *faultInjectingNVSDelegate;
+};
+
+/** Testing write elision of DatabaseAPI class
+ * @brief set skips the write and the commit of a value already stored.
+ */
+
+TEST_F(WriteElisionTest, set_SameValue_Elided)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->set("mode", "auto"), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("mode", "auto");
+    DatabaseError_t err2 = databaseAPI->set("mode", "auto");
+    DatabaseError_t err3 = databaseAPI->set("mode", "manual");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(databaseAPI->getElidedWriteCount(), 2u);
+    EXPECT_EQ(faultInjectingNVSDelegate->writes, 2u);
+    EXPECT_EQ(faultInjectingNVSDelegate->commits, 2u);
+}
+
+TEST_F(WriteElisionTest, set_AfterRestart_FingerprintTakenLazily)
+{
+    // arrange
+    char value[16];
+    ASSERT_EQ(databaseAPI->set("mode", "auto"), DatabaseError_t::DATABASE_OK);
+    delete databaseAPI;
+    databaseAPI = new DatabaseAPI(faultInjectingNVSDelegate, "TEST_NVS");
+    databaseAPI->enableWriteElision();
+    faultInjectingNVSDelegate->writes = 0;
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("mode", "auto");
+    DatabaseError_t err2 = databaseAPI->set("mode", "eco");
+    DatabaseError_t err3 = databaseAPI->get("mode", value, sizeof(value));
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_STREQ(value, "eco");
+    EXPECT_EQ(databaseAPI->getElidedWriteCount(), 1u);
+    EXPECT_EQ(faultInjectingNVSDelegate->writes, 1u);
+}
+
+TEST_F(WriteElisionTest, set_Disabled_AlwaysWritten)
+{
+    // arrange
+    databaseAPI->disableWriteElision();
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("mode", "auto");
+    DatabaseError_t err2 = databaseAPI->set("mode", "auto");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(databaseAPI->getElidedWriteCount(), 0u);
+    EXPECT_EQ(faultInjectingNVSDelegate->writes, 2u);
+}
+
+TEST_F(WriteElisionTest, set_ExpiryOrRemoval_NotElided)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->set("token", "abc", 60), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("token", "abc"); // clears the expiry
+    DatabaseError_t err2 = databaseAPI->remove("token");
+    DatabaseError_t err3 = databaseAPI->set("token", "abc");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err3, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(databaseAPI->getElidedWriteCount(), 0u);
+    EXPECT_EQ(faultInjectingNVSDelegate->writes, 6u); // 3 values, the removal and 2 of the expiry table
+}
+
+TEST_F(WriteElisionTest, set_AfterCompareAndSet_Elided)
+{
+    // arrange
+    ASSERT_EQ(databaseAPI->set("mode", "auto"), DatabaseError_t::DATABASE_OK);
+    ASSERT_EQ(databaseAPI->compareAndSet("mode", "auto", "eco"), DatabaseError_t::DATABASE_OK);
+
+    // act
+    DatabaseError_t err1 = databaseAPI->set("mode", "eco");
+    DatabaseError_t err2 = databaseAPI->set("mode", "auto");
+
+    // assert
+    EXPECT_EQ(err1, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(err2, DatabaseError_t::DATABASE_OK);
+    EXPECT_EQ(databaseAPI->getElidedWriteCount(), 1u);
+    EXPECT_EQ(faultInjectingNVSDelegate->writes, 3u);
+}
+
+#endif // UNIT_WRITE_ELISION_TEST_HPP
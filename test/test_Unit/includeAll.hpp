@@ -4,4 +4,29 @@
 #include "IsExist_test.hpp"
 #include "GetValueLength_test.hpp"
 #include "EraseAll_test.hpp"
-#include "Heap_test.hpp"
\ No newline at end of file
+#include "Heap_test.hpp"
+#include "ISRQueue_test.hpp"
+#include "Snapshot_test.hpp"
+#include "MemoryNVSDelegate_test.hpp"
+#include "ConditionalWrite_test.hpp"
+#include "Counter_test.hpp"
+#include "Sequence_test.hpp"
+#include "Expiry_test.hpp"
+#include "PackedNVSDelegate_test.hpp"
+#include "CompressedNVSDelegate_test.hpp"
+#include "WriteElision_test.hpp"
+#include "Transaction_test.hpp"
+#include "NamespaceSwap_test.hpp"
+#include "NamespaceImage_test.hpp"
+#include "NVSImageDelegate_test.hpp"
+#include "Defaults_test.hpp"
+#include "Subscription_test.hpp"
+#include "RingBuffer_test.hpp"
+#include "Queue_test.hpp"
+#include "Tiered_test.hpp"
+#include "MappedImage_test.hpp"
+#include "Job_test.hpp"
+#include "Deadline_test.hpp"
+#include "Maintenance_test.hpp"
+#include "Capacity_test.hpp"
+#include "KeyMap_test.hpp"
\ No newline at end of file
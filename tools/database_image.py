@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""Builds and inspects namespace images of DatabaseAPI::importNamespace / exportNamespace.
+
+The format is described in lib/DatabaseAPI/include/DatabaseImage.hpp.
+
+    database_image.py build values.txt image.bin   # one key=value per line, '#' for comments
+    database_image.py inspect image.bin
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+MAGIC = b"DBI"
+VERSION = 1
+MAX_KEY_LENGTH = 16     # NVS_DELEGATE_MAX_KEY_LENGTH, terminator included
+MAX_VALUE_LENGTH = 4096 # NVS_DELEGATE_MAX_VALUE_LENGTH, terminator included
+
+
+def build(values):
+    """Returns the image of a list of (key, value) string pairs."""
+    out = bytearray(MAGIC + bytes([VERSION]))
+    for key, value in values:
+        key_bytes = key.encode("utf-8")
+        value_bytes = value.encode("utf-8")
+        if not 0 < len(key_bytes) < MAX_KEY_LENGTH or key.startswith("~"):
+            raise ValueError("invalid key %r" % key)
+        if not 0 < len(value_bytes) < MAX_VALUE_LENGTH:
+            raise ValueError("invalid value for key %r" % key)
+        out += struct.pack("<B", len(key_bytes)) + key_bytes
+        out += struct.pack("<H", len(value_bytes)) + value_bytes
+    out += struct.pack("<BH", 0, len(values))
+    out += struct.pack("<I", zlib.crc32(bytes(out)) & 0xFFFFFFFF)
+    return bytes(out)
+
+
+def parse(image):
+    """Returns the (key, value) pairs of an image, raises ValueError if it is not valid."""
+    if len(image) < 11 or image[:3] != MAGIC:
+        raise ValueError("not an image")
+    if image[3] != VERSION:
+        raise ValueError("unsupported version %d" % image[3])
+
+    values = []
+    position = 4
+    try:
+        while True:
+            key_length = image[position]
+            position += 1
+            if key_length == 0:
+                break
+            key = image[position:position + key_length].decode("utf-8")
+            position += key_length
+            (value_length,) = struct.unpack_from("<H", image, position)
+            position += 2
+            value = image[position:position + value_length].decode("utf-8")
+            if len(value.encode("utf-8")) != value_length:
+                raise ValueError("truncated image")
+            position += value_length
+            values.append((key, value))
+        count, crc = struct.unpack_from("<HI", image, position)
+    except (IndexError, struct.error):
+        raise ValueError("truncated image")
+
+    if position + 6 != len(image):
+        raise ValueError("%d bytes after the end of the image" % (len(image) - position - 6))
+    if count != len(values):
+        raise ValueError("count %d does not match %d values" % (count, len(values)))
+    if crc != zlib.crc32(image[:position + 2]) & 0xFFFFFFFF:
+        raise ValueError("CRC mismatch")
+    return values
+
+
+def read_values(path):
+    values = []
+    with open(path, encoding="utf-8") as manifest:
+        for number, line in enumerate(manifest, 1):
+            line = line.rstrip("\n")
+            if not line.strip() or line.lstrip().startswith("#"):
+                continue
+            if "=" not in line:
+                raise ValueError("%s:%d: expected key=value" % (path, number))
+            key, value = line.split("=", 1)
+            values.append((key.strip(), value))
+    return values
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+    build_command = commands.add_parser("build", help="build an image from key=value lines")
+    build_command.add_argument("values")
+    build_command.add_argument("image")
+    inspect_command = commands.add_parser("inspect", help="check an image and list its values")
+    inspect_command.add_argument("image")
+    arguments = parser.parse_args()
+
+    try:
+        if arguments.command == "build":
+            values = read_values(arguments.values)
+            image = build(values)
+            with open(arguments.image, "wb") as out:
+                out.write(image)
+            print("%d values, %d bytes" % (len(values), len(image)))
+        else:
+            with open(arguments.image, "rb") as source:
+                image = source.read()
+            values = parse(image)
+            for key, value in values:
+                print("%-15s %s" % (key, value))
+            print("%d values, %d bytes, CRC ok" % (len(values), len(image)))
+    except ValueError as error:
+        print("error: %s" % error, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,212 @@
+#!/usr/bin/env python3
+"""Builds ready-to-flash NVS partition images from a manifest, and inspects them.
+
+The manifest is a CSV file with a header line and one namespace,key,type,value row per value:
+
+    namespace,key,type,value
+    config,ssid,string,office
+    config,boots,i64,0
+    config,calibration,blob,0a0b0c0d
+
+Types are string, i64 and blob (hex). The image uses the page format of ESP-IDF NVS
+(version 2), so NVSDelegate and DatabaseAPI read it unchanged, and NVSImageDelegate
+reads it on the host.
+
+    nvs_partition.py build manifest.csv nvs.bin --size 0x5000
+    nvs_partition.py inspect nvs.bin
+"""
+
+import argparse
+import csv
+import struct
+import sys
+import zlib
+
+PAGE_SIZE = 4096
+ENTRY_SIZE = 32
+ENTRIES_PER_PAGE = 126
+FIRST_ENTRY_OFFSET = 64
+PAGE_ACTIVE = 0xFFFFFFFE
+PAGE_FULL = 0xFFFFFFFC
+PAGE_EMPTY = 0xFFFFFFFF
+PAGE_VERSION = 0xFE
+TYPE_U8 = 0x01
+TYPE_I64 = 0x18
+TYPE_STRING = 0x21
+TYPE_BLOB_DATA = 0x42
+TYPE_BLOB_INDEX = 0x48
+CHUNK_ANY = 0xFF
+MAX_KEY_LENGTH = 15
+MAX_VARIABLE_LENGTH = (ENTRIES_PER_PAGE - 1) * ENTRY_SIZE
+
+
+def crc32(data):
+    """CRC-32 of NVS, esp_rom_crc32_le seeded with 0xFFFFFFFF."""
+    return zlib.crc32(bytes(data), 0xFFFFFFFF) & 0xFFFFFFFF
+
+
+class Partition:
+    """NVS partition written page by page, the last page is left empty for NVS to reclaim space."""
+
+    def __init__(self, size):
+        if size % PAGE_SIZE or size < 3 * PAGE_SIZE:
+            raise ValueError("size must be a multiple of 0x1000, at least 0x3000")
+        self.data = bytearray(b"\xff" * size)
+        self.page_count = size // PAGE_SIZE
+        self.page = -1
+        self.entry = ENTRIES_PER_PAGE
+        self.namespaces = {}
+
+    def new_page(self):
+        if self.page >= 0:
+            struct.pack_into("<I", self.data, self.page * PAGE_SIZE, PAGE_FULL)
+        self.page += 1
+        if self.page >= self.page_count - 1:
+            raise ValueError("values do not fit, the last page must stay empty")
+        header = struct.pack("<IIB", PAGE_ACTIVE, self.page, PAGE_VERSION) + b"\xff" * 19
+        header += struct.pack("<I", crc32(header[4:28]))
+        self.data[self.page * PAGE_SIZE:self.page * PAGE_SIZE + 32] = header
+        self.entry = 0
+
+    def write_item(self, namespace_index, item_type, key, data, payload=b"", chunk=CHUNK_ANY):
+        # An item and its payload never cross a page
+        span = 1 + (len(payload) + ENTRY_SIZE - 1) // ENTRY_SIZE
+        if self.entry + span > ENTRIES_PER_PAGE:
+            self.new_page()
+        base = self.page * PAGE_SIZE
+        for index in range(self.entry, self.entry + span):
+            self.data[base + 32 + index // 4] &= ~(1 << ((index % 4) * 2)) & 0xFF  # EMPTY (11) to WRITTEN (10)
+
+        item = bytearray(struct.pack("<BBBB", namespace_index, item_type, span, chunk))
+        item += b"\0" * 4 + key.encode("ascii").ljust(16, b"\0") + data
+        struct.pack_into("<I", item, 4, crc32(item[0:4] + item[8:32]))
+        offset = base + FIRST_ENTRY_OFFSET + self.entry * ENTRY_SIZE
+        self.data[offset:offset + ENTRY_SIZE] = item
+        self.data[offset + ENTRY_SIZE:offset + ENTRY_SIZE + len(payload)] = payload
+        self.entry += span
+
+    def namespace_index(self, name):
+        if name not in self.namespaces:
+            if len(self.namespaces) == 254:
+                raise ValueError("too many namespaces")
+            self.namespaces[name] = len(self.namespaces) + 1
+            self.write_item(0, TYPE_U8, name, bytes([self.namespaces[name]]) + b"\xff" * 7)
+        return self.namespaces[name]
+
+    def add(self, namespace, key, value_type, value):
+        for name in (namespace, key):
+            if not 0 < len(name) <= MAX_KEY_LENGTH or not name.isascii():
+                raise ValueError("invalid name %r" % name)
+        index = self.namespace_index(namespace)
+
+        if value_type == "i64":
+            self.write_item(index, TYPE_I64, key, struct.pack("<q", int(value, 0)))
+        elif value_type in ("string", "blob"):
+            payload = value.encode("utf-8") + b"\0" if value_type == "string" else bytes.fromhex(value)
+            if not 0 < len(payload) <= MAX_VARIABLE_LENGTH:
+                raise ValueError("value of %r is too long" % key)
+            data = struct.pack("<HHI", len(payload), 0xFFFF, crc32(payload))
+            if value_type == "string":
+                self.write_item(index, TYPE_STRING, key, data, payload)
+            else:
+                # A single chunk, then the index pointing to it
+                self.write_item(index, TYPE_BLOB_DATA, key, data, payload, chunk=0)
+                self.write_item(index, TYPE_BLOB_INDEX, key, struct.pack("<IBBH", len(payload), 1, 0, 0xFFFF))
+        else:
+            raise ValueError("unknown type %r of %r" % (value_type, key))
+
+
+def items(image):
+    """Yields (namespace index, type, chunk, key, data, payload) of the written items, checking CRCs."""
+    if len(image) % PAGE_SIZE:
+        raise ValueError("image size is not a multiple of 0x1000")
+    for page in range(len(image) // PAGE_SIZE):
+        base = page * PAGE_SIZE
+        (state,) = struct.unpack_from("<I", image, base)
+        if state in (PAGE_EMPTY, 0):
+            continue
+        if crc32(image[base + 4:base + 28]) != struct.unpack_from("<I", image, base + 28)[0]:
+            raise ValueError("page %d: header CRC mismatch" % page)
+        entry = 0
+        while entry < ENTRIES_PER_PAGE:
+            if (image[base + 32 + entry // 4] >> ((entry % 4) * 2)) & 3 != 2:
+                entry += 1
+                continue
+            offset = base + FIRST_ENTRY_OFFSET + entry * ENTRY_SIZE
+            item = image[offset:offset + ENTRY_SIZE]
+            namespace_index, item_type, span, chunk = struct.unpack_from("<BBBB", item)
+            if crc32(item[0:4] + item[8:32]) != struct.unpack_from("<I", item, 4)[0]:
+                raise ValueError("page %d, entry %d: item CRC mismatch" % (page, entry))
+            key = item[8:24].split(b"\0")[0].decode("ascii")
+            payload = b""
+            if item_type in (TYPE_STRING, TYPE_BLOB_DATA):
+                size, _, data_crc = struct.unpack_from("<HHI", item, 24)
+                payload = image[offset + ENTRY_SIZE:offset + ENTRY_SIZE + size]
+                if crc32(payload) != data_crc:
+                    raise ValueError("page %d, entry %d: data CRC mismatch" % (page, entry))
+            yield namespace_index, item_type, chunk, key, item[24:32], payload
+            entry += max(span, 1)
+
+
+def inspect(image):
+    """Returns the namespace, key, type, value rows of an image."""
+    all_items = list(items(image))
+    names = {item[4][0]: item[3] for item in all_items if item[0] == 0}
+    chunks = {(item[0], item[3], item[2]): item[5] for item in all_items if item[1] == TYPE_BLOB_DATA}
+    rows = []
+    for namespace_index, item_type, chunk, key, data, payload in all_items:
+        namespace = names.get(namespace_index, "#%d" % namespace_index)
+        if namespace_index == 0 or item_type == TYPE_BLOB_DATA:
+            continue
+        if item_type == TYPE_I64:
+            rows.append((namespace, key, "i64", str(struct.unpack("<q", data)[0])))
+        elif item_type == TYPE_STRING:
+            rows.append((namespace, key, "string", payload[:-1].decode("utf-8")))
+        elif item_type == TYPE_BLOB_INDEX:
+            size, count, start, _ = struct.unpack("<IBBH", data)
+            blob = b"".join(chunks.get((namespace_index, key, start + i), b"") for i in range(count))
+            if len(blob) != size:
+                raise ValueError("blob %r is missing chunks" % key)
+            rows.append((namespace, key, "blob", blob.hex()))
+        else:
+            rows.append((namespace, key, "type 0x%02x" % item_type, data.hex()))
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+    build_command = commands.add_parser("build", help="build a partition image from a manifest")
+    build_command.add_argument("manifest")
+    build_command.add_argument("image")
+    build_command.add_argument("--size", default="0x5000", help="partition size, 0x5000 by default")
+    inspect_command = commands.add_parser("inspect", help="check a partition image and list its values")
+    inspect_command.add_argument("image")
+    arguments = parser.parse_args()
+
+    try:
+        if arguments.command == "build":
+            partition = Partition(int(arguments.size, 0))
+            count = 0
+            with open(arguments.manifest, newline="", encoding="utf-8") as manifest:
+                for row in csv.DictReader(manifest):
+                    partition.add(row["namespace"], row["key"], row["type"], row["value"])
+                    count += 1
+            with open(arguments.image, "wb") as out:
+                out.write(partition.data)
+            print("%d values in %d namespaces, %d of %d pages used"
+                  % (count, len(partition.namespaces), partition.page + 1, partition.page_count))
+        else:
+            with open(arguments.image, "rb") as source:
+                rows = inspect(source.read())
+            for row in rows:
+                print("%-15s %-15s %-7s %s" % row)
+            print("%d values, CRCs ok" % len(rows))
+    except (ValueError, KeyError) as error:
+        print("error: %s" % error, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,55 @@
+"""PlatformIO extra script building an NVS partition image from a manifest, and flashing it.
+
+    [env:embeded_env]
+    extra_scripts = tools/platformio_nvs_image.py
+    custom_nvs_manifest = nvs.csv    ; see tools/nvs_partition.py
+    custom_nvs_size = 0x5000         ; size of the nvs partition, 0x5000 by default
+    custom_nvs_offset = 0x9000       ; offset of the nvs partition, 0x9000 by default
+
+    pio run -t nvs_image             ; writes .pio/build/<env>/nvs.bin
+    pio run -t upload_nvs            ; builds it and writes it to the nvs partition
+"""
+
+Import("env")  # noqa: F821, provided by PlatformIO
+
+import csv
+import os
+import sys
+
+sys.path.insert(0, os.path.join(env.subst("$PROJECT_DIR"), "tools"))  # noqa: F821
+import nvs_partition  # noqa: E402
+
+NVS_IMAGE = os.path.join(env.subst("$BUILD_DIR"), "nvs.bin")  # noqa: F821
+
+
+def build_nvs_image(target, source, env):
+    manifest = env.GetProjectOption("custom_nvs_manifest")
+    partition = nvs_partition.Partition(int(env.GetProjectOption("custom_nvs_size", "0x5000"), 0))
+    with open(os.path.join(env.subst("$PROJECT_DIR"), manifest), newline="", encoding="utf-8") as rows:
+        for row in csv.DictReader(rows):
+            partition.add(row["namespace"], row["key"], row["type"], row["value"])
+    os.makedirs(os.path.dirname(NVS_IMAGE), exist_ok=True)
+    with open(NVS_IMAGE, "wb") as out:
+        out.write(partition.data)
+    print("NVS image %s: %d of %d pages used" % (NVS_IMAGE, partition.page + 1, partition.page_count))
+
+
+env.AddCustomTarget(  # noqa: F821
+    name="nvs_image",
+    dependencies=None,
+    actions=[build_nvs_image],
+    title="Build NVS Image",
+    description="Build the NVS partition image from custom_nvs_manifest",
+)
+
+env.AddCustomTarget(  # noqa: F821
+    name="upload_nvs",
+    dependencies=None,
+    actions=[
+        build_nvs_image,
+        '"$PYTHONEXE" "$UPLOADER" --chip esp32 --port "$UPLOAD_PORT" write_flash %s "%s"'
+        % (env.GetProjectOption("custom_nvs_offset", "0x9000"), NVS_IMAGE),  # noqa: F821
+    ],
+    title="Upload NVS Image",
+    description="Build the NVS partition image and write it to the nvs partition",
+)